@@ -6,10 +6,11 @@
 /* --------------------------------------------------------------------------------------------- */
 
 /****************************************   INCLUDES   *******************************************/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "app_util_platform.h"
 #include "AppMgr.h"
-
-/************************************   PRIVATE DEFINES   ****************************************/
-#define APP_MANAGER_POWER_BASE 2U
+#include "Trace.h"
 
 /*************************************   PRIVATE MACROS   ****************************************/
 #define APPMGR_ASSERT_EVENT(ARG)        \
@@ -18,6 +19,21 @@
     ( (ARG) < AppMgr_UpperBoundEvt )    \
 )
 
+/* Trigger value an event is handed to applications as, the one their state machines match on
+   (APP_*_ trigger defines). Events are numbered from 1 */
+#define APPMGR_TRIGGER(evt) (1UL << ((uint32_t)(evt) - 1))
+
+/* Subscriber mask bit of an application */
+#define APPMGR_SUB(app) (1U << (uint8_t)(app))
+
+/* Routing table entry of an event, located at the event's index */
+#define APPMGR_ROUTE(evt, subs) [evt] = {APPMGR_TRIGGER(evt), (subs)}
+
+/* Subscriber masks must fit in their field */
+#if (APPLICATION_COUNT > 8)
+#error APPLICATION_COUNT exceeds the subscriber mask width.
+#endif
+
 /************************************   PRIVATE VARIABLES   **************************************/
 /* Applications' public interface list */
 static const AppMgr_tstrInterface strApplicationList[] =
@@ -27,44 +43,120 @@ static const AppMgr_tstrInterface strApplicationList[] =
     {enuDisplay_Init     , enuDisplay_GetNotified     }
 };
 
-/* Dispatchable events' pub/sub scheme list
+static TaskHandle_t pvAppMgrTaskHandle;                                 /* Application Manager task */
+static AppMgr_tstrMessage strKeyAttMessages[APP_KEYATT_QUEUE_LENGTH];   /* Attribution's messages   */
+static AppMgr_tstrMessage strUseRegMessages[APP_USEREG_QUEUE_LENGTH];   /* Registration's messages  */
+static AppMgr_tstrMessage strDisplayMessages[APP_DISPLAY_QUEUE_LENGTH]; /* Display's messages       */
+
+/* Applications' message handling state, in application ID order */
+static AppMgr_tstrActor strActorList[APPLICATION_COUNT] =
+{
+    {NULL, strKeyAttMessages , APP_KEYATT_QUEUE_LENGTH , APP_KEYATT_PRIORITY , 0, 0},
+    {NULL, strUseRegMessages , APP_USEREG_QUEUE_LENGTH , APP_USEREG_PRIORITY , 0, 0},
+    {NULL, strDisplayMessages, APP_DISPLAY_QUEUE_LENGTH, APP_DISPLAY_PRIORITY, 0, 0}
+};
+
+/* Dispatchable events' pub/sub scheme, as a routing table indexed by event
  *
  * Note: An application is said to be subscribed to an event if it requires being notified as soon
  *       as that event is dispatched to the Application Manager.
  */
-static const AppMgr_tstrEventSub strEventSubscriptionList[] =
+static const AppMgr_tstrEventRoute strEventRouteTable[AppMgr_UpperBoundEvt] =
 {
-    {AppMgr_DisplayAdvertising   , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayConnected     , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayDisconnected  , {App_DisplayId, App_RegistrationId, App_AttributionId}, 3},
-    {AppMgr_DisplayValidInput    , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayInvalidInput  , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayAccessGranted , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayAccessDenied  , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayAdminAdd      , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayAdminCheck    , {App_DisplayId                                       }, 1},
-    {AppMgr_DisplayNotifsDisabled, {App_DisplayId                                       }, 1},
-    {AppMgr_RegNotifEnabled      , {App_RegistrationId                                  }, 1},
-    {AppMgr_RegNotifDisabled     , {App_RegistrationId                                  }, 1},
-    {AppMgr_RegUsrInputRx        , {App_RegistrationId                                  }, 1},
-    {AppMgr_AdmNotifEnabled      , {App_RegistrationId                                  }, 1},
-    {AppMgr_AdmNotifDisabled     , {App_RegistrationId                                  }, 1},
-    {AppMgr_AdmUsrInputRx        , {App_RegistrationId                                  }, 1},
-    {AppMgr_AdmUsrAddedToNvm     , {App_RegistrationId                                  }, 1},
-    {AppMgr_RegPasswordUpdated   , {App_RegistrationId                                  }, 1},
-    {AppMgr_AttNotifEnabled      , {App_AttributionId                                   }, 1},
-    {AppMgr_AttNotifDisabled     , {App_AttributionId                                   }, 1},
-    {AppMgr_AttUserSignedIn      , {App_AttributionId                                   }, 1},
-    {AppMgr_AttInputRx           , {App_AttributionId                                   }, 1}
+    APPMGR_ROUTE(AppMgr_DisplayAdvertising   , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayConnected     , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayDisconnected  , APPMGR_SUB(App_DisplayId) | APPMGR_SUB(App_RegistrationId) | APPMGR_SUB(App_AttributionId)),
+    APPMGR_ROUTE(AppMgr_DisplayValidInput    , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayInvalidInput  , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayAccessGranted , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayAccessDenied  , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayAdminAdd      , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayAdminCheck    , APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_DisplayNotifsDisabled, APPMGR_SUB(App_DisplayId)),
+    APPMGR_ROUTE(AppMgr_RegNotifEnabled      , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_RegNotifDisabled     , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_RegUsrInputRx        , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AdmNotifEnabled      , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AdmNotifDisabled     , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AdmUsrInputRx        , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AdmUsrAddedToNvm     , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_RegPasswordUpdated   , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AttNotifEnabled      , APPMGR_SUB(App_AttributionId)),
+    APPMGR_ROUTE(AppMgr_AttNotifDisabled     , APPMGR_SUB(App_AttributionId)),
+    APPMGR_ROUTE(AppMgr_AttUserSignedIn      , APPMGR_SUB(App_AttributionId)),
+    APPMGR_ROUTE(AppMgr_AttInputRx           , APPMGR_SUB(App_AttributionId)),
+    APPMGR_ROUTE(AppMgr_AdmExportRequest     , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_AdmProvisionRequest  , APPMGR_SUB(App_RegistrationId)),
+    APPMGR_ROUTE(AppMgr_NvmHousekeeping      , APPMGR_SUB(App_RegistrationId))
 };
 
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static AppMgr_tstrActor *pstrTakeNextMessage(AppMgr_tstrMessage *pstrMessage)
+{
+    AppMgr_tstrActor *pstrRetVal = NULL;
+
+    CRITICAL_REGION_ENTER();
+
+    /* Pick the highest priority application with messages pending, the lowest ID among equals */
+    for(uint8_t u8Index = 0; u8Index < APPLICATION_COUNT; u8Index++)
+    {
+        if(strActorList[u8Index].u8Count &&
+           ((NULL == pstrRetVal) || (strActorList[u8Index].u8Priority > pstrRetVal->u8Priority)))
+        {
+            pstrRetVal = &strActorList[u8Index];
+        }
+    }
+
+    /* Take its oldest message */
+    if(pstrRetVal)
+    {
+        *pstrMessage = pstrRetVal->pstrMessages[pstrRetVal->u8Head];
+        pstrRetVal->u8Head = (pstrRetVal->u8Head + 1) % pstrRetVal->u8Size;
+        pstrRetVal->u8Count--;
+    }
+
+    CRITICAL_REGION_EXIT();
+
+    return pstrRetVal;
+}
+
+static void vidAppMgrTaskFunction(void *pvArg)
+{
+    AppMgr_tstrActor *pstrActor;
+    AppMgr_tstrMessage strMessage;
+
+    /* Application Manager task's main polling loop */
+    while(1)
+    {
+        /* Run every pending message to completion, one at a time. Messages posted meanwhile are
+           picked up in the same pass, highest priority application first */
+        while(NULL != (pstrActor = pstrTakeNextMessage(&strMessage)))
+        {
+            pstrActor->pfHandler(strMessage.u32Event, strMessage.pvData);
+        }
+
+        /* Clear notifications after messages have been processed and put task in blocked state */
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
 /*************************************   PUBLIC FUNCTIONS   **************************************/
 App_tenuStatus AppMgr_enuInit(void)
 {
-    App_tenuStatus enuRetVal = Application_Success;
+    App_tenuStatus enuRetVal = Application_Failure;
 
-    /* Initialize all applications */
-    for(uint8_t u8Index = 0; u8Index < APPLICATION_COUNT; u8Index++)
+    /* Create the task all applications run on, then initialize all applications */
+    if(pdPASS == xTaskCreate(vidAppMgrTaskFunction,
+                             "APP_Mgr_Task",
+                             APP_MGR_TASK_STACK_SIZE,
+                             NULL,
+                             APP_MGR_TASK_PRIORITY,
+                             &pvAppMgrTaskHandle))
+    {
+        enuRetVal = Application_Success;
+    }
+
+    for(uint8_t u8Index = 0; (u8Index < APPLICATION_COUNT) && (Application_Success == enuRetVal); u8Index++)
     {
         if(Application_Failure == strApplicationList[u8Index].pfInit())
         {
@@ -81,33 +173,70 @@ extern App_tenuStatus AppMgr_enuDispatchEvent(uint32_t u32Event, void *pvData)
     App_tenuStatus enuRetVal = Application_Failure;
 
     /* Make sure argument is a valid dispatched event */
-    if(APPMGR_ASSERT_EVENT(u32Event))
+    if(APPMGR_ASSERT_EVENT(u32Event) && strEventRouteTable[u32Event].u8Subscribers)
     {
-        for(const AppMgr_tstrEventSub *pstrEvent = strEventSubscriptionList;
-            pstrEvent < strEventSubscriptionList + (sizeof(strEventSubscriptionList) / sizeof(AppMgr_tstrEventSub));
-            pstrEvent++)
+        AppMgr_tstrEventRoute const *pstrRoute = &strEventRouteTable[u32Event];
+
+        TRACE_POINT(Trace_AppMgrDispatch, u32Event);
+
+        /* Event located in event pub/sub scheme */
+        enuRetVal = Application_Success;
+
+        /* Notify all subscribed applications */
+        for(uint8_t u8Index = 0; u8Index < APPLICATION_COUNT; u8Index++)
         {
-            if(u32Event == (uint32_t)pstrEvent->enuPublishedEvent)
+            if((pstrRoute->u8Subscribers & APPMGR_SUB(u8Index)) && strApplicationList[u8Index].pfNotif)
             {
-                /* Event located in event pub/sub scheme list */
-                enuRetVal = Application_Success;
-
-                /* Notify all subscribed applications */
-                for(uint8_t u8Index = 0; u8Index < pstrEvent->u8SubCnt; u8Index++)
-                {
-                    if(strApplicationList[pstrEvent->enuSubscribedApps[u8Index]].pfNotif)
-                    {
-                        strApplicationList[pstrEvent->enuSubscribedApps[u8Index]].pfNotif((uint32_t)s32Power(APP_MANAGER_POWER_BASE,
-                                                                                                             u32Event-1),
-                                                                                                             pvData);
-                    }
-                }
-
-                /* No need to keep going through event scheme list */
-                break;
+                strApplicationList[u8Index].pfNotif(pstrRoute->u32Trigger, pvData);
             }
         }
     }
 
+    return enuRetVal;
+}
+
+App_tenuStatus AppMgr_enuPostMessage(AppMgr_tenuAppId enuApp, uint32_t u32Event, void *pvData)
+{
+    App_tenuStatus enuRetVal = Application_Failure;
+
+    if((enuApp < APPLICATION_COUNT) && strActorList[enuApp].pfHandler)
+    {
+        AppMgr_tstrActor *pstrActor = &strActorList[enuApp];
+
+        CRITICAL_REGION_ENTER();
+
+        /* Event and data are queued together as a single item, so they can never get out of step */
+        if(pstrActor->u8Count < pstrActor->u8Size)
+        {
+            AppMgr_tstrMessage *pstrMessage = &pstrActor->pstrMessages[(pstrActor->u8Head + pstrActor->u8Count) %
+                                                                       pstrActor->u8Size];
+            pstrMessage->u32Event = u32Event;
+            pstrMessage->pvData = pvData;
+            pstrActor->u8Count++;
+            enuRetVal = Application_Success;
+        }
+
+        CRITICAL_REGION_EXIT();
+
+        /* Unblock Application Manager task, unless message was posted from one of its handlers */
+        if((Application_Success == enuRetVal) && (xTaskGetCurrentTaskHandle() != pvAppMgrTaskHandle))
+        {
+            xTaskNotifyGive(pvAppMgrTaskHandle);
+        }
+    }
+
+    return enuRetVal;
+}
+
+App_tenuStatus AppMgr_enuRegisterHandler(AppMgr_tenuAppId enuApp, AppMgrHandler pfHandler)
+{
+    App_tenuStatus enuRetVal = Application_Failure;
+
+    if((enuApp < APPLICATION_COUNT) && pfHandler)
+    {
+        strActorList[enuApp].pfHandler = pfHandler;
+        enuRetVal = Application_Success;
+    }
+
     return enuRetVal;
 }
\ No newline at end of file
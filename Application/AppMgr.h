@@ -53,6 +53,9 @@ typedef enum
     AppMgr_AttNotifDisabled,      /* Peer disabled notifications on Key Attribution service       */
     AppMgr_AttUserSignedIn,       /* Active user successfully went through authentication process */
     AppMgr_AttInputRx,            /* Received user input on Key Activation characteristic         */
+    AppMgr_AdmExportRequest,      /* Received export request on Export characteristic             */
+    AppMgr_AdmProvisionRequest,   /* Received list of users to add on Provision characteristic    */
+    AppMgr_NvmHousekeeping,       /* All tasks idle, NVM housekeeping may run                     */
     AppMgr_UpperBoundEvt
 }AppMgr_tenuEvents;
 
@@ -73,7 +76,7 @@ typedef App_tenuStatus (*AppMgrInitialize)(void);
  *
  * @note This function prototype is used to define a notification function for each application
  *       responsible for posting external events dispatched from other applications and middleware
- *       tasks to the local event group.
+ *       tasks to the application's message queue.
  *
  * @note Functions of this type take two parameters:
  *  - uint32_t u32Event: Event to be posted and processed by local task.
@@ -81,6 +84,19 @@ typedef App_tenuStatus (*AppMgrInitialize)(void);
 */
 typedef App_tenuStatus (*AppMgrGetNotified)(uint32_t u32Event, void *pvData);
 
+/**
+ * AppMgrHandler Application message handler function prototype.
+ *
+ * @note This function prototype is used to define the function each application registers to
+ *       process the messages posted to it. Handlers are run to completion one message at a time
+ *       on the Application Manager's task, they must therefore never block.
+ *
+ * @note Functions of this type take two parameters:
+ *  - uint32_t u32Event: Event to be processed, as posted.
+ *  - void *pvData: Pointer to event-related data, NULL if none.
+*/
+typedef void (*AppMgrHandler)(uint32_t u32Event, void *pvData);
+
 /**
  * AppMgr_tstrInterface Application's public interface definition structure outlining the public
  *                      functions exposed to the Application Manager.
@@ -93,23 +109,51 @@ typedef struct
 }AppMgr_tstrInterface;
 
 /**
- * AppMgr_tstrEventSub Application Manager's dispatchable events database structure.
+ * AppMgr_tstrMessage Message posted to an application, one per notified event.
+*/
+typedef struct
+{
+    uint32_t u32Event; /* Event, as posted to the application's notification function */
+    void *pvData;      /* Pointer to event-related data, NULL if none                  */
+}AppMgr_tstrMessage;
+
+/**
+ * AppMgr_tstrActor Application's message handling state, as seen by the Application Manager.
+ *
+ * @note Each application owns a ring of pending messages. Whenever several applications have
+ *       messages pending, the one with the highest priority is served first, the lowest ID first
+ *       among equals.
+*/
+typedef struct
+{
+    AppMgrHandler pfHandler;          /* Registered message handler, NULL if none */
+    AppMgr_tstrMessage *pstrMessages; /* Pending messages ring buffer             */
+    uint8_t u8Size;                   /* Number of messages the ring holds        */
+    uint8_t u8Priority;               /* Priority, higher values served first     */
+    uint8_t u8Head;                   /* Oldest pending message's index           */
+    uint8_t u8Count;                  /* Number of messages pending               */
+}AppMgr_tstrActor;
+
+/**
+ * AppMgr_tstrEventRoute Application Manager's dispatchable events routing table entry.
  *
- * @note This structure type maps every application/middleware dispatchable event to a list
- *       of subscribed applications.
+ * @note Entries are laid out in a table indexed by event, which maps every application/middleware
+ *       dispatchable event to the applications subscribed to it. Everything dispatching needs is
+ *       computed at build time.
 */
 typedef struct
 {
-    AppMgr_tenuEvents enuPublishedEvent;                   /* Dispatched event                  */
-    AppMgr_tenuAppId enuSubscribedApps[APPLICATION_COUNT]; /* List of subscribed applications   */
-    uint8_t u8SubCnt;                                      /* Number of subscribed applications */
-}AppMgr_tstrEventSub;
+    uint32_t u32Trigger;   /* Trigger value subscribed applications' state machines match */
+    uint8_t u8Subscribers; /* Subscribed applications, one bit per AppMgr_tenuAppId       */
+}AppMgr_tstrEventRoute;
 
 /*************************************   PUBLIC FUNCTIONS   **************************************/
 /**
  * @brief AppMgr_enuInit Initializes all applications.
  *
- * @note This function is invoked by the Main function.
+ * @note This function is invoked by the Main function. The Application Manager's task, on which
+ *       all applications run, is created first so that applications may register their message
+ *       handlers as soon as they're initialized.
  *
  * @pre This function requires no prerequisites.
  *
@@ -125,6 +169,8 @@ App_tenuStatus AppMgr_enuInit(void);
  * @note This function is invoked from within the context of application and middleware
  *       tasks that request notifying a thirdparty application of a new event.
  *
+ * @note Events are looked up directly in the routing table, whatever their number.
+ *
  * @param u32Event Event to be dispatched.
  * @param pvData Pointer to event-related data.
  *
@@ -133,4 +179,36 @@ App_tenuStatus AppMgr_enuInit(void);
  */
 extern App_tenuStatus AppMgr_enuDispatchEvent(uint32_t u32Event, void *pvData);
 
+/**
+ * @brief AppMgr_enuPostMessage Posts an event and its data to an application's message queue.
+ *
+ * @note Applications' notification functions post the events they're notified of through this
+ *       function. Events and their data travel together and are handled in the order they were
+ *       posted, without waiting for room in the queue. Messages posted from within a handler are
+ *       handled once it returns, without any context switch.
+ *
+ * @param enuApp Application the message is posted to.
+ * @param u32Event Event to be posted.
+ * @param pvData Pointer to event-related data, NULL if none.
+ *
+ * @return App_tenuStatus Application_Success if message was posted, Application_Failure if the
+ *         queue is full or no handler is registered, in which case event-related data remains
+ *         the caller's.
+ */
+App_tenuStatus AppMgr_enuPostMessage(AppMgr_tenuAppId enuApp, uint32_t u32Event, void *pvData);
+
+/**
+ * @brief AppMgr_enuRegisterHandler Registers the function processing an application's messages.
+ *
+ * @note Applications register their handler from their initialization function. Messages posted
+ *       to an application without a handler are turned down.
+ *
+ * @param enuApp Application the handler belongs to.
+ * @param pfHandler Message handler.
+ *
+ * @return App_tenuStatus Application_Success if handler was registered, Application_Failure
+ *         otherwise.
+ */
+App_tenuStatus AppMgr_enuRegisterHandler(AppMgr_tenuAppId enuApp, AppMgrHandler pfHandler);
+
 #endif /* _APP_MGR_H_ */
\ No newline at end of file
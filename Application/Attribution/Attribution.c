@@ -7,23 +7,16 @@
 
 /****************************************   INCLUDES   *******************************************/
 #include "FreeRTOS.h"
-#include "task.h"
-#include "queue.h"
-#include "event_groups.h"
 #include "Time.h"
-#include "Attribution.h"
+#include "AppMgr.h"
 #include "BLE_Service.h"
 #include "NVM_Service.h"
+#include "Audit_Service.h"
+#include "Pool.h"
+#include "Trace.h"
 
 /************************************   PRIVATE DEFINES   ****************************************/
-#define APP_KEYATT_PUSH_IMMEDIATELY 0U
-#define APP_KEYATT_POP_IMMEDIATELY  0U
 #define APP_KEYATT_ACTIVATION_TOKEN 1U
-#define APP_KEYATT_EVENT_MASK       (APP_KEYATT_DISCONNECTION  | \
-                                     APP_KEYATT_NOTIF_ENABLED  | \
-                                     APP_KEYATT_NOTIF_DISABLED | \
-                                     APP_KEYATT_USER_SIGNED_IN | \
-                                     APP_KEYATT_USR_INPUT_RX     )
 
 /************************************   PRIVATE MACROS   *****************************************/
 /* Compute state machine trigger count */
@@ -35,16 +28,10 @@
 /* Converts time in seconds to time in minutes */
 #define APP_KEYATT_SECS_TO_MINS(SEC) (SEC/60)
 
-/************************************   GLOBAL VARIABLES   ***************************************/
-/* Global function used to propagate dispatchable events to other tasks */
-extern App_tenuStatus AppMgr_enuDispatchEvent(uint32_t u32Event, void *pvData);
-
 /************************************   PRIVATE VARIABLES   **************************************/
-static TaskHandle_t pvKeyAttTaskHandle;             /* Attribution task handle                   */
-static QueueHandle_t pvKeyAttQueueHandle;           /* Attribution queue handle                  */
-static EventGroupHandle_t pvKeyAttEventGroupHandle; /* Attribution event group handle            */
 static volatile bool bAttNotifEnabled = false;      /* Notifications enabled/disabled on ble_att */
 static volatile bool bAttUserSignedIn = false;      /* Active user has/hasn't already signed in  */
+static bool bAttGrantPending = false;               /* Granted access awaiting its audit entry   */
 static void vidKeyAttDisconnected(void *pvArg);     /* Disconnection function prototype          */
 static void vidKeyAttNotifEnabled(void *pvArg);     /* Notifs enabled on ble_att func prototype  */
 static void vidKeyAttNotifDisabled(void *pvArg);    /* Notifs disabled on ble_att func prototype */
@@ -64,6 +51,13 @@ static const Attribution_tstrState strKeyAttStateMachine[] =
 };
 
 /************************************   PRIVATE FUNCTIONS   **************************************/
+static void vidActiveUserAudit(Audit_tenuOutcome enuOutcome)
+{
+    /* Record access attempt in audit journal. Failing to do so mustn't stand in the way of the
+       user */
+    (void)enuAudit_Append(strActiveRecord.u8Id, strActiveRecord.enuKeyType, enuOutcome);
+}
+
 static void vidUserKeyNotify(Nvm_tstrRecord *pstrRecord)
 {
     /* Make sure valid arguments are passed */
@@ -149,7 +143,14 @@ static void vidUserKeyNotify(Nvm_tstrRecord *pstrRecord)
 
 static void vidKeyAttDisconnected(void *pvArg)
 {
+    /* Peer left before providing a time reading. Audit granted access with estimated time */
+    if(bAttGrantPending)
+    {
+        vidActiveUserAudit(Audit_AccessGranted);
+    }
+
     /* Reset all global variables */
+    bAttGrantPending = false;
     bAttNotifEnabled = false;
     bAttUserSignedIn = false;
     memset(&strActiveRecordDesc, 0, sizeof(strActiveRecordDesc));
@@ -181,16 +182,20 @@ static void vidKeyAttUserSignedIn(void *pvArg)
     /* Make sure valid parameters are passed */
     if(pvArg)
     {
-        /* Extract received data */
-        Nvm_tstrRecordDispatch *pstrActiveRecord = (Nvm_tstrRecordDispatch *)pvArg;
-        /* Store received data record and record descriptor */
-        memcpy(&strActiveRecordDesc, pstrActiveRecord->pstrRecordDesc, sizeof(fds_record_desc_t));
-        memcpy(&strActiveRecord, pstrActiveRecord->pstrRecord, sizeof(Nvm_tstrRecord));
+        /* Store received record descriptor and read the record it points to */
+        fds_flash_record_t strFdsRecord = {0};
+        memcpy(&strActiveRecordDesc, pvArg, sizeof(fds_record_desc_t));
 
         /* Toggle user signed in flag */
-        bAttUserSignedIn = true;
+        bAttUserSignedIn = (Middleware_Success == enuNVM_ReadSignedInRecord(&strActiveRecordDesc,
+                                                                            &strFdsRecord,
+                                                                            &strActiveRecord));
 
-        if(bAttNotifEnabled)
+        if(!bAttUserSignedIn)
+        {
+            /* Record went away in the meantime. Nothing to attribute */
+        }
+        else if(bAttNotifEnabled)
         {
             /* Notify user of their key type */
             vidUserKeyNotify(&strActiveRecord);
@@ -202,10 +207,8 @@ static void vidKeyAttUserSignedIn(void *pvArg)
             (void)AppMgr_enuDispatchEvent(BLE_KEYATT_NOTIF_DISABLED, NULL);
         }
 
-        /* Free allocated memory */
-        free((void *)((Nvm_tstrRecordDispatch *)pvArg)->pstrRecordDesc);
-        free((void *)((Nvm_tstrRecordDispatch *)pvArg)->pstrRecord);
-        free((void *)(Nvm_tstrRecordDispatch *)pvArg);
+        /* Give record descriptor's block back to its pool */
+        vidPoolFree(pvArg);
     }
 }
 
@@ -245,6 +248,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                             (void)enuTransferNotification(Ble_Attribution,
                                                           u8NotificationBuffer,
                                                           &u16NotificationSize);
+                            /* Audit entry is timestamped once current time is received */
+                            bAttGrantPending = true;
+
                             /* Request current time */
                             vidBleGetCurrentTime();
                         }
@@ -259,6 +265,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                             /* Display rejection pattern */
                             (void)AppMgr_enuDispatchEvent(BLE_KEYATT_ACCESS_DENIED, NULL);
 
+                            /* Audit denied access */
+                            vidActiveUserAudit(Audit_KeyExpired);
+
                             /* Delete user entry from NVM */
                             (void)enuNVM_DeleteRecord(&strActiveRecordDesc);
                         }
@@ -291,6 +300,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                             /* Transfer notification to peer */
                             (void)enuTransferNotification(Ble_Attribution, u8NotificationBuffer, &u16NotificationSize);
 
+                            /* Audit entry is timestamped once current time is received */
+                            bAttGrantPending = true;
+
                             /* Request current time */
                             vidBleGetCurrentTime();
                         }
@@ -305,6 +317,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                             /* Display rejection pattern */
                             (void)AppMgr_enuDispatchEvent(BLE_KEYATT_ACCESS_DENIED, NULL);
 
+                            /* Audit denied access */
+                            vidActiveUserAudit(Audit_KeyExpired);
+
                             /* Delete user entry from NVM */
                             (void)enuNVM_DeleteRecord(&strActiveRecordDesc);
                         }
@@ -322,6 +337,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                         /* Grant access */
                         (void)AppMgr_enuDispatchEvent(BLE_KEYATT_GRANT_ACCESS, NULL);
 
+                        /* Audit entry is timestamped once current time is received */
+                        bAttGrantPending = true;
+
                         /* Request current time */
                         vidBleGetCurrentTime();
                     }
@@ -345,6 +363,9 @@ static void vidKeyAttInputReceived(void *pvArg)
                         /* Grant access */
                         (void)AppMgr_enuDispatchEvent(BLE_KEYATT_GRANT_ACCESS, NULL);
 
+                        /* Audit entry is timestamped once current time is received */
+                        bAttGrantPending = true;
+
                         /* Request current time */
                         vidBleGetCurrentTime();
                     }
@@ -377,9 +398,8 @@ static void vidKeyAttInputReceived(void *pvArg)
                                               &u16NotificationSize);
             }
 
-            /* Free allocated memory */
-            free((void *)((Ble_tstrRxData *)pvArg)->pu8Data);
-            free((void *)(Ble_tstrRxData *)pvArg);
+            /* Give Rx data's block back to its pool */
+            vidPoolFree(pvArg);
         }
     }
     else
@@ -390,41 +410,55 @@ static void vidKeyAttInputReceived(void *pvArg)
     }
 }
 
+static void vidActiveRecordSave(Nvm_tenuFiles enuFile, bool bDeferrable)
+{
+    /* Changes that can afford being lost on reset are coalesced in NVM_Service's write-behind
+       cache. Anything else, or anything the cache can't take in, is written right away. */
+    if(!bDeferrable ||
+       (Middleware_Success != enuNVM_DeferRecordUpdate(&strActiveRecordDesc, &strActiveRecord, enuFile)))
+    {
+        (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
+                                  &strActiveRecord,
+                                  enuFile);
+    }
+}
+
 static void vidCurrentTimeCallback(exact_time_256_t *pstrCurrentTime)
 {
     /* Update key's last known use time */
-    memcpy(&strActiveRecord.strLastKnownUse, pstrCurrentTime, sizeof(exact_time_256_t));
+    strActiveRecord.u32LastKnownUse = u32TimeToEpoch(pstrCurrentTime);
+
+    /* Keep audit journal's time in step and record access granted while waiting for it */
+    vidAudit_SetTime(strActiveRecord.u32LastKnownUse);
+
+    if(bAttGrantPending)
+    {
+        bAttGrantPending = false;
+        vidActiveUserAudit(Audit_AccessGranted);
+    }
 
     /* Check key type */
     switch(strActiveRecord.enuKeyType)
     {
     case App_OneTimeKey:
     {
-        /* Update NVM record */
-        (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                  &strActiveRecord,
-                                  Nvm_ExpirableKeys,
-                                  false);
+        /* One-time key consumed. Update NVM record right away */
+        vidActiveRecordSave(Nvm_ExpirableKeys, false);
     }
     break;
 
     case App_CountRestrictedKey:
     {
-        /* Update NVM record */
-        (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                  &strActiveRecord,
-                                  Nvm_ExpirableKeys,
-                                  false);
+        /* Use count increments cost a single word write in the user's usage counter slot. Last
+           known use is left to the next record rewrite, the audit journal has every use's time */
+        (void)enuNVM_CountUse(&strActiveRecordDesc, &strActiveRecord);
     }
     break;
 
     case App_UnlimitedKey:
     {
-        /* Update NVM record */
-        (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                  &strActiveRecord,
-                                  Nvm_PersistentKeys,
-                                  false);
+        /* Only last known use changed. Defer NVM record update */
+        vidActiveRecordSave(Nvm_PersistentKeys, true);
     }
     break;
 
@@ -448,6 +482,9 @@ static void vidCurrentTimeCallback(exact_time_256_t *pstrCurrentTime)
                 /* Display rejection pattern */
                 (void)AppMgr_enuDispatchEvent(BLE_KEYATT_ACCESS_DENIED, NULL);
 
+                /* Audit denied access */
+                vidActiveUserAudit(Audit_KeyExpired);
+
                 /* Delete user entry from NVM */
                 (void)enuNVM_DeleteRecord(&strActiveRecordDesc);
             }
@@ -469,11 +506,8 @@ static void vidCurrentTimeCallback(exact_time_256_t *pstrCurrentTime)
                 /* Transfer notification to peer */
                 (void)enuTransferNotification(Ble_Attribution, u8NotificationBuffer, &u16NotificationSize);
 
-                /* Update NVM record */
-                (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                          &strActiveRecord,
-                                          Nvm_ExpirableKeys,
-                                          false);
+                /* Only last known use changed. Defer NVM record update */
+                vidActiveRecordSave(Nvm_ExpirableKeys, true);
             }
         }
         else
@@ -490,28 +524,25 @@ static void vidCurrentTimeCallback(exact_time_256_t *pstrCurrentTime)
             /* Grant access */
             (void)AppMgr_enuDispatchEvent(BLE_KEYATT_GRANT_ACCESS, NULL);
 
+            /* Audit granted access */
+            vidActiveUserAudit(Audit_AccessGranted);
+
             /* Toggle key activation state */
             strActiveRecord.uKeyQuantifier.strTimeRes.bIsKeyActive = true;
 
             /* Store key activation time */
             strActiveRecord.uKeyQuantifier.strTimeRes.u32ActivationTime = u32TimeToEpoch(pstrCurrentTime);
 
-            /* Update user entry record in NVM */
-            (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                      &strActiveRecord,
-                                      Nvm_ExpirableKeys,
-                                      false);
+            /* Key activation starts its life span. Update user entry record in NVM right away */
+            vidActiveRecordSave(Nvm_ExpirableKeys, false);
         }
     }
     break;
 
     case App_AdminKey:
     {
-        /* Update NVM record */
-        (void)enuNVM_UpdateRecord(&strActiveRecordDesc,
-                                  &strActiveRecord,
-                                  Nvm_PersistentKeys,
-                                  false);
+        /* Only last known use changed. Defer NVM record update */
+        vidActiveRecordSave(Nvm_PersistentKeys, true);
     }
     break;
 
@@ -523,6 +554,8 @@ static void vidCurrentTimeCallback(exact_time_256_t *pstrCurrentTime)
 
 static void vidAttributionEvent_Process(uint32_t u32Trigger, void *pvData)
 {
+    TRACE_POINT(Trace_AttributionProcess, u32Trigger);
+
     /* Go through trigger list to find trigger.
        Note: We use a while loop as we require that no two distinct actions have the
        same trigger in a State trigger listing */
@@ -540,102 +573,26 @@ static void vidAttributionEvent_Process(uint32_t u32Trigger, void *pvData)
     }
 }
 
-static void vidKeyAttTaskFunction(void *pvArg)
-{
-    uint32_t u32Event;
-    void *pvData;
-
-    /* Register current time data callback */
-    vidRegisterCtsCallback(vidCurrentTimeCallback);
-
-    /* Key Attribution task's main polling loop */
-    while(1)
-    {
-        /* Task will remain blocked until an event is set in event group */
-        u32Event = xEventGroupWaitBits(pvKeyAttEventGroupHandle,
-                                       APP_KEYATT_EVENT_MASK,
-                                       pdTRUE,
-                                       pdFALSE,
-                                       portMAX_DELAY);
-        if(u32Event)
-        {
-            /* Check whether queue holds any data */
-            if(uxQueueMessagesWaiting(pvKeyAttQueueHandle))
-            {
-                /* We have no tasks of higher priority so we're guaranteed that no other
-                   message will be received in the queue until this message is processed */
-                xQueueReceive(pvKeyAttQueueHandle, &pvData, APP_KEYATT_POP_IMMEDIATELY);
-            }
-
-            /* Process received event */
-            vidAttributionEvent_Process(u32Event, pvData);
-        }
-    }
-}
-
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 App_tenuStatus enuAttribution_Init(void)
 {
-    App_tenuStatus enuRetVal = Application_Failure;
-
-    /* Create task for Key Attribution application */
-    if(pdPASS == xTaskCreate(vidKeyAttTaskFunction,
-                             "APP_KeyAtt_Task",
-                             APP_KEYATT_TASK_STACK_SIZE,
-                             NULL,
-                             APP_KEYATT_TASK_PRIORITY,
-                             &pvKeyAttTaskHandle))
-    {
-        /* Create message queue for Key Attribution application */
-        pvKeyAttQueueHandle = xQueueCreate(APP_KEYATT_QUEUE_LENGTH, sizeof(void *));
-
-        if(pvKeyAttQueueHandle)
-        {
-            /* Create event group for Key Attribution application */
-            pvKeyAttEventGroupHandle = xEventGroupCreate();
-            enuRetVal = (NULL != pvKeyAttEventGroupHandle)?Application_Success:Application_Failure;
-        }
-    }
+    /* Register current time data callback */
+    vidRegisterCtsCallback(vidCurrentTimeCallback);
 
-    return enuRetVal;
+    /* Messages posted to Key Attribution application are processed on the Application Manager's
+       task */
+    return AppMgr_enuRegisterHandler(App_AttributionId, vidAttributionEvent_Process);
 }
 
 App_tenuStatus enuAttribution_GetNotified(uint32_t u32Event, void *pvData)
 {
-    App_tenuStatus enuRetVal = Application_Success;
-
-    if(pvData)
-    {
-        /* Push event-related data to local message queue */
-        enuRetVal = (pdTRUE == xQueueSend(pvKeyAttQueueHandle,
-                                          &pvData,
-                                          APP_KEYATT_PUSH_IMMEDIATELY))
-                                          ?Application_Success
-                                          :Application_Failure;
-        if(Application_Failure == enuRetVal)
-        {
-            if(BLE_ATT_USER_INPUT_RECEIVED == u32Event)
-            {
-                /* Free allocated memory */
-                free((void *)((Ble_tstrRxData *)pvData)->pu8Data);
-                free((void *)(Ble_tstrRxData *)pvData);
-            }
-            else
-            {
-                /* Free allocated memory */
-                free((void *)((Nvm_tstrRecordDispatch *)pvData)->pstrRecordDesc);
-                free((void *)((Nvm_tstrRecordDispatch *)pvData)->pstrRecord);
-                free((void *)(Nvm_tstrRecordDispatch *)pvData);
-            }
-        }
-    }
+    /* Post event along with its data to local message queue, to be processed once its turn comes */
+    App_tenuStatus enuRetVal = AppMgr_enuPostMessage(App_AttributionId, u32Event, pvData);
 
-    if(Application_Success == enuRetVal)
+    if((Application_Failure == enuRetVal) && pvData)
     {
-        /* Unblock Key Attribution task by setting event in local event group */
-        enuRetVal = xEventGroupSetBits(pvKeyAttEventGroupHandle, u32Event)
-                                       ?Application_Success
-                                       :Application_Failure;
+        /* Give event-related data's block back to its pool, whichever event it came with */
+        vidPoolFree(pvData);
     }
 
     return enuRetVal;
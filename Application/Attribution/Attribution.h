@@ -49,8 +49,8 @@ typedef struct
 
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 /**
- * @brief enuAttribution_Init Creates Key Attribution task, event group to receive notifications
- *        from other tasks and message queue to hold data potentially accompanying incoming events.
+ * @brief enuAttribution_Init Initializes Key Attribution application and registers its message
+ *        handler with the Application Manager, on whose task it runs.
  *
  * @note This function is invoked by the Application Manager.
  *
@@ -62,16 +62,15 @@ typedef struct
 App_tenuStatus enuAttribution_Init(void);
 
 /**
- * @brief enuAttribution_GetNotified Notifies Key Attribution task of an incoming event by
- *        setting it in local event group and setting its accompanying data in local
- *        message queue.
+ * @brief enuAttribution_GetNotified Notifies Key Attribution application of an incoming event
+ *        by posting it along with its accompanying data to its message queue.
  *
  * @note This function is invoked by the Application Manager signaling that another task
- *       wants to communicate with the Key Attribution task.
+ *       wants to communicate with the Key Attribution application.
  *
- * @pre This function can't be called unless the Key Attribution task is initialized and running.
+ * @pre This function can't be called unless the Key Attribution application is initialized.
  *
- * @param u32Event Event to be posted in local event group.
+ * @param u32Event Trigger value to be matched by the application's state machine.
  * @param pvData Pointer to event-related data.
  *
  * @return App_tenuStatus Application_Success if notification was posted successfully,
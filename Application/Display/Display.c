@@ -7,11 +7,11 @@
 
 /****************************************   INCLUDES   *******************************************/
 #include "FreeRTOS.h"
-#include "task.h"
-#include "queue.h"
-#include "event_groups.h"
+#include "timers.h"
 #include "Display.h"
+#include "AppMgr.h"
 #include "nrf_gpio.h"
+#include "Trace.h"
 
 /************************************   PRIVATE DEFINES   ****************************************/
 #define APP_DISPLAY_LED_COUNT           4U
@@ -19,16 +19,6 @@
 #define APP_DISPLAY_LED_SWITCH_ON       0U
 #define APP_DISPLAY_LED_SWITCH_OFF      1U
 #define APP_DISPLAY_TIMER_NO_WAIT       0U
-#define APP_DISPLAY_EVENT_MASK          (APP_DISPLAY_ADVERTISING_START         | \
-                                         APP_DISPLAY_PEER_CONNECTION           | \
-                                         APP_DISPLAY_PEER_DISCONNECTION        | \
-                                         APP_DISPLAY_VALID_USER_INPUT          | \
-                                         APP_DISPLAY_INVALID_USER_INPUT        | \
-                                         APP_DISPLAY_ACCESS_GRANTED            | \
-                                         APP_DISPLAY_ACCESS_DENIED             | \
-                                         APP_DISPLAY_ADMIN_SUCCESSFUL_ADD_OP   | \
-                                         APP_DISPLAY_ADMIN_SUCCESSFUL_CHECK_OP | \
-                                         APP_DISPLAY_DISABLED_NOTIFICATIONS      )
 
 /************************************   PRIVATE MACROS   *****************************************/
 /* Compute state machine trigger count */
@@ -41,9 +31,6 @@
 #define APP_DISPLAY_PENULTIMATE_LED(arg) ((arg-(arg/LED_2)+3*(LED_1/arg)))
 
 /************************************   PRIVATE VARIABLES   **************************************/
-static TaskHandle_t pvDisplayTaskHandle;             /* Display task handle                      */
-static QueueHandle_t pvDisplayQueueHandle;           /* Display queue handle                     */
-static EventGroupHandle_t pvDisplayEventGroupHandle; /* Display event group handle               */
 static TimerHandle_t pvDisplayTimerHandle;           /* Display timer handle                     */
 static volatile uint8_t u8LedCounter;                /* Current LED's rank in pattern            */
 static volatile uint8_t u8CycleCounter;              /* Current cycle in display pattern         */
@@ -217,6 +204,8 @@ static void vidDisplayTimerCallback(TimerHandle_t pvTimerHandle)
 
 static void vidDisplayEvent_Process(uint32_t u32Trigger)
 {
+    TRACE_POINT(Trace_DisplayProcess, u32Trigger);
+
     /* Go through trigger list to find trigger.
        Note: We use a while loop as we require that no two distinct actions have the
        same trigger in a State trigger listing */
@@ -234,29 +223,14 @@ static void vidDisplayEvent_Process(uint32_t u32Trigger)
     }
 }
 
-static void vidDisplayTaskFunction(void *pvArg)
+static void vidDisplayMessageHandler(uint32_t u32Event, void *pvData)
 {
-    uint32_t u32Event;
-
-    /* Display task's main polling loop */
-    while(1)
-    {
-        /* Task will remain blocked until an event is set in event group */
-        u32Event = xEventGroupWaitBits(pvDisplayEventGroupHandle,
-                                       APP_DISPLAY_EVENT_MASK,
-                                       pdTRUE,
-                                       pdFALSE,
-                                       portMAX_DELAY);
-        if(u32Event)
-        {
-            /* Reset LED counter */
-            u8LedCounter = LED_1;
-            /* Reset cycle counter */
-            u8CycleCounter = APP_DISPLAY_DEFAULT_CYCLE_COUNT;
-            /* Process received event */
-            vidDisplayEvent_Process(u32Event);
-        }
-    }
+    /* Reset LED counter */
+    u8LedCounter = LED_1;
+    /* Reset cycle counter */
+    u8CycleCounter = APP_DISPLAY_DEFAULT_CYCLE_COUNT;
+    /* Process received event */
+    vidDisplayEvent_Process(u32Event);
 }
 
 /************************************   PUBLIC FUNCTIONS   ***************************************/
@@ -273,33 +247,16 @@ App_tenuStatus enuDisplay_Init(void)
         nrf_gpio_pin_write((uint32_t)u8Index, APP_DISPLAY_LED_SWITCH_OFF);
     }
 
-    /* Create task for LED application */
-    if(pdTRUE == xTaskCreate(vidDisplayTaskFunction,
-                             "APP_Display_Task",
-                             APP_DISPLAY_TASK_STACK_SIZE,
-                             NULL,
-                             APP_DISPLAY_TASK_PRIORITY,
-                             &pvDisplayTaskHandle))
+    /* Messages posted to Display application are processed on the Application Manager's task */
+    if(Application_Success == AppMgr_enuRegisterHandler(App_DisplayId, vidDisplayMessageHandler))
     {
-        /* Create message queue for Display application */
-        pvDisplayQueueHandle = xQueueCreate(APP_DISPLAY_QUEUE_LENGTH, sizeof(uint32_t));
-
-        if(pvDisplayQueueHandle)
-        {
-            /* Create event group for Display application */
-            pvDisplayEventGroupHandle = xEventGroupCreate();
-
-            if(pvDisplayEventGroupHandle)
-            {
-                /* Create software timer for Display application */
-                pvDisplayTimerHandle = xTimerCreate("APP_Display_Timer",
-                                                    pdMS_TO_TICKS(400),
-                                                    pdTRUE,
-                                                    NULL,
-                                                    vidDisplayTimerCallback);
-                enuRetVal = (pvDisplayTimerHandle)?Application_Success:Application_Failure;
-            }
-        }
+        /* Create software timer for Display application */
+        pvDisplayTimerHandle = xTimerCreate("APP_Display_Timer",
+                                            pdMS_TO_TICKS(400),
+                                            pdTRUE,
+                                            NULL,
+                                            vidDisplayTimerCallback);
+        enuRetVal = (pvDisplayTimerHandle)?Application_Success:Application_Failure;
     }
 
     return enuRetVal;
@@ -307,8 +264,6 @@ App_tenuStatus enuDisplay_Init(void)
 
 App_tenuStatus enuDisplay_GetNotified(uint32_t u32Event, void *pvData)
 {
-    /* Unblock Display task by setting event in local event group */
-    return (xEventGroupSetBits(pvDisplayEventGroupHandle, u32Event))
-                               ?Application_Success
-                               :Application_Failure;
+    /* Post event to local message queue, to be processed once its turn comes */
+    return AppMgr_enuPostMessage(App_DisplayId, u32Event, pvData);
 }
\ No newline at end of file
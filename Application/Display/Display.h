@@ -232,8 +232,8 @@ static inline uint32_t u32LedPattern4321(uint8_t u8Index)
 
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 /**
- * @brief enuDisplay_Init Creates Display task and event group to receive notifications
- *        from other tasks.
+ * @brief enuDisplay_Init Initializes Display application and registers its message handler
+ *        with the Application Manager, on whose task it runs.
  *
  * @note This function is invoked by the Application Manager.
  *
@@ -245,15 +245,15 @@ static inline uint32_t u32LedPattern4321(uint8_t u8Index)
 App_tenuStatus enuDisplay_Init(void);
 
 /**
- * @brief enuDisplay_GetNotified Notifies Display task of an incoming event by
- *        setting it in local event group.
+ * @brief enuDisplay_GetNotified Notifies Display application of an incoming event by posting
+ *        it to its message queue.
  *
  * @note This function is invoked by the Application Manager signaling that another task
- *       wants to communicate with the Display task.
+ *       wants to communicate with the Display application.
  *
- * @pre This function can't be called unless Display task is initialized and running.
+ * @pre This function can't be called unless the Display application is initialized.
  *
- * @param u32Event Event to be posted in local event group.
+ * @param u32Event Trigger value to be matched by the application's state machine.
  * @param pvData Unused parameter.
  *
  * @return App_tenuStatus Application_Success if notification was posted successfully,
@@ -7,30 +7,25 @@
 
 /****************************************   INCLUDES   *******************************************/
 #include "FreeRTOS.h"
-#include "task.h"
-#include "queue.h"
-#include "event_groups.h"
-#include "Registration.h"
+#include "AppMgr.h"
 #include "BLE_Service.h"
 #include "NVM_Service.h"
+#include "Audit_Service.h"
+#include "Time.h"
+#include "Pool.h"
+#include "Trace.h"
 
 /************************************   PRIVATE DEFINES   ****************************************/
-#define APP_USEREG_PUSH_IMMEDIATELY     0U
-#define APP_USEREG_POP_IMMEDIATELY      0U
 #define APP_USEREG_KEY_PARAMETER_LENGTH 4U
 #define APP_USEREG_ID_LENGTH            8U
 #define APP_USEREG_MIN_PASSWORD_LENGTH  8U
 #define APP_USEREG_MAX_PASSWORD_LENGTH  12U
 #define APP_USEREG_MAX_COMMAND_LENGTH   20U
-#define APP_USEREG_EVENT_MASK           (APP_USEREG_PEER_DISCONNECTION | \
-                                         APP_USEREG_NOTIF_ENABLED      | \
-                                         APP_USEREG_NOTIF_DISABLED     | \
-                                         APP_USEREG_USR_INPUT_RX       | \
-                                         APP_USEADM_NOTIF_ENABLED      | \
-                                         APP_USEADM_NOTIF_DISABLED     | \
-                                         APP_USEADM_USR_INPUT_RX       | \
-                                         APP_USEADM_USR_ADDED_TO_NVM   | \
-                                         APP_USEADM_PASSWORD_UPDATED     )
+#define APP_USEREG_SECS_IN_MINUTE       60U
+#define APP_USEREG_SECS_IN_HOUR         3600U
+#define APP_USEREG_SECS_IN_DAY          86400U
+#define APP_USEREG_PROVISION_TUPLE_SIZE 7U
+#define APP_USEREG_MAX_SUMMARY_LENGTH   24U
 
 /************************************   PRIVATE MACROS   *****************************************/
 /* Compute state machine trigger count */
@@ -41,8 +36,6 @@
 (                                 \
     (RCD->pu8Id)               && \
     (RCD->pstrRecordDesc)      && \
-    (RCD->pstrPersistentToken) && \
-    (RCD->pstrExpirableToken)  && \
     (RCD->pstrFdsRecord)       && \
     (RCD->pstrAppRecord)          \
 )
@@ -53,23 +46,13 @@
 */
 typedef struct
 {
-    uint8_t const *pu8Id;                  /* Provided user Id                           */
-    uint16_t u16RecordKey;                 /* Record key                                 */
-    fds_record_desc_t *pstrRecordDesc;     /* Record descriptor                          */
-    fds_find_token_t *pstrPersistentToken; /* Record find token for persistent keys file */
-    fds_find_token_t *pstrExpirableToken;  /* Record find token for expirable keys file  */
-    fds_flash_record_t *pstrFdsRecord;     /* Record as seen by FDS                      */
-    Nvm_tstrRecord *pstrAppRecord;         /* Record as seen by the application          */
+    uint8_t const *pu8Id;              /* Provided user Id                  */
+    fds_record_desc_t *pstrRecordDesc; /* Record descriptor                 */
+    fds_flash_record_t *pstrFdsRecord; /* Record as seen by FDS             */
+    Nvm_tstrRecord *pstrAppRecord;     /* Record as seen by the application */
 }App_tstrRecordSearch;
 
-/************************************   GLOBAL VARIABLES   ***************************************/
-/* Global function used to propagate dispatchable events to other tasks */
-extern App_tenuStatus AppMgr_enuDispatchEvent(uint32_t u32Event, void *pvData);
-
 /************************************   PRIVATE VARIABLES   **************************************/
-static TaskHandle_t pvUseRegTaskHandle;             /* Registration task handle                  */
-static QueueHandle_t pvUseRegQueueHandle;           /* Registration queue handle                 */
-static EventGroupHandle_t pvUseRegEventGroupHandle; /* Registration event group handle           */
 static volatile bool bRegNotifEnabled = false;      /* Notifications enabled/disabled on ble_reg */
 static volatile bool bAdmNotifEnabled = false;      /* Notifications enabled/disabled on ble_adm */
 static volatile bool bExpectingPwd = false;         /* Next input should be Id/Pwd on ble_reg    */
@@ -84,12 +67,21 @@ static void vidUseAdmNotifDisabled(void *pvArg);    /* Notifs disabled on ble_ad
 static void vidUseAdmInputReceived(void *pvArg);    /* Input received on ble_adm func prototype  */
 static void vidUseAdmAddedToNvm(void *pvArg);       /* New entry added to NVM func prototype     */
 static void vidUserPasswordUpdated(void *pvArg);    /* User password updated func prototype      */
+static void vidUseAdmExportRequest(void *pvArg);    /* Export request on ble_adm func prototype  */
+static void vidUseAdmProvisionRequest(void *pvArg); /* Provisioning on ble_adm func prototype    */
+static void vidUseRegHousekeeping(void *pvArg);     /* NVM housekeeping func prototype           */
 static uint8_t u8AddUsrCmd[] = "mkusi";             /* Add user command base                     */
 static uint8_t u8UsrDataCmd[] = "mkud -i ";         /* Extract user data command base            */
+static uint8_t u8AuditLogCmd[] = "mkal -f ";        /* Audit log query command base              */
 static uint8_t u8InvalidPasswordBase[8];            /* Invalid pwd base for unregistered users   */
 static uint8_t u8CurrentUserPwd[12];                /* Active user's password extracted from NVM */
 static fds_record_desc_t strActiveRecordDesc = {0}; /* Active NVM record's descriptor            */
-static Nvm_tstrRecord strActiveRecord = {0};        /* Active NVM record data content            */
+static uint8_t u8ActiveUserId[8];                   /* Active user's Id                          */
+static uint16_t u16BatchStaged = 0;                 /* Users staged by the last batch            */
+static uint16_t u16BatchExisting = 0;               /* Last batch's users already registered     */
+static volatile bool bBatchComplete = false;        /* Provisioning batch done being written     */
+static volatile uint16_t u16BatchAdded = 0;         /* Users provisioned by the last batch       */
+static volatile uint16_t u16BatchFailed = 0;        /* Users the last batch couldn't provision   */
 
 /* Registration state machine's entry list */
 static const Registration_tstrState strUseRegStateMachine[] =
@@ -102,7 +94,10 @@ static const Registration_tstrState strUseRegStateMachine[] =
     {APP_USEADM_NOTIF_DISABLED    , vidUseAdmNotifDisabled}, /* Notifications disabled on ble_adm */
     {APP_USEADM_USR_INPUT_RX      , vidUseAdmInputReceived}, /* Input received on ble_adm         */
     {APP_USEADM_USR_ADDED_TO_NVM  , vidUseAdmAddedToNvm   }, /* New user added to NVM             */
-    {APP_USEADM_PASSWORD_UPDATED  , vidUserPasswordUpdated}  /* User password updated             */
+    {APP_USEADM_PASSWORD_UPDATED  , vidUserPasswordUpdated}, /* User password updated             */
+    {APP_USEADM_EXPORT_REQUEST    , vidUseAdmExportRequest}, /* Export requested on ble_adm       */
+    {APP_USEADM_PROVISION_REQUEST , vidUseAdmProvisionRequest}, /* Provisioning on ble_adm        */
+    {APP_USEREG_NVM_HOUSEKEEPING  , vidUseRegHousekeeping }  /* NVM housekeeping                  */
 };
 
 /************************************   PRIVATE FUNCTIONS   **************************************/
@@ -113,38 +108,20 @@ static bool bUserRecordFound(App_tstrRecordSearch *pstrRecordFind)
     /* Make sure valid arguments are passed */
     if(pstrRecordFind && APP_RECORD_ASSERT(pstrRecordFind))
     {
-        uint8_t u8Retries = APP_USEREG_MAX_CROSS_IDS;
-
-        while((!bRetVal) && (u8Retries--))
+        /* NVM_Service resolves the full user Id to its record through its RAM index, so there's
+           no need to go through flash storage looking for candidate records */
+        if(Middleware_Success == enuNVM_FindUser(pstrRecordFind->pu8Id,
+                                                 pstrRecordFind->pstrRecordDesc))
         {
-            /* We use the first 4 numbers of a user Id as a key for that user's entire NVM record.
-               This leaves a slight margin of chance for 2 users having the same first 4 numbers of
-               their Ids to have the same record key. If they also happen to have similar keys (as
-               in both expirable or both persistent), they will be indiscernible. */
-            if(Middleware_Success == enuNVM_FindRecord(pstrRecordFind->u16RecordKey,
-                                                       pstrRecordFind->pstrRecordDesc,
-                                                       pstrRecordFind->pstrPersistentToken,
-                                                       pstrRecordFind->pstrExpirableToken))
+            /* Read record content */
+            if(Middleware_Success == enuNVM_ReadRecord(pstrRecordFind->pstrRecordDesc,
+                                                       pstrRecordFind->pstrFdsRecord,
+                                                       pstrRecordFind->pstrAppRecord))
             {
-                /* Read record content */
-                if(Middleware_Success == enuNVM_ReadRecord(pstrRecordFind->pstrRecordDesc,
-                                                           pstrRecordFind->pstrFdsRecord,
-                                                           pstrRecordFind->pstrAppRecord))
-                {
-                    /* Once we locate the user record using the first 4 numbers of their Id, we
-                       compare that record's Id against the record we're actively looking for
-                       to account for the possibility of more than one user having the same first 4
-                       Id numbers. If more than APP_USEREG_MAX_CROSS_IDS users share those same
-                       first 4 numbers, this function will fail. */
-                    bRetVal = (0 == s8StringCompare(&pstrRecordFind->pstrAppRecord->u8Id[0],
-                                                    &pstrRecordFind->pu8Id[0],
-                                                    APP_USEREG_ID_LENGTH));
-                    if(bRetVal)
-                    {
-                        /* Record located in NVM */
-                        break;
-                    }
-                }
+                /* Make sure record's Id matches the one we're actively looking for */
+                bRetVal = (0 == s8StringCompare(&pstrRecordFind->pstrAppRecord->u8Id[0],
+                                                &pstrRecordFind->pu8Id[0],
+                                                APP_USEREG_ID_LENGTH));
             }
         }
     }
@@ -152,8 +129,75 @@ static bool bUserRecordFound(App_tstrRecordSearch *pstrRecordFind)
     return bRetVal;
 }
 
+static bool bUserIdFound(uint8_t const *pu8Id, fds_record_desc_t *pstrRecordDesc)
+{
+    bool bRetVal = false;
+    Nvm_tstrRecordView strView;
+
+    /* Locate record through NVM_Service's RAM index then make sure its Id matches the one we're
+       actively looking for, right in flash */
+    if((Middleware_Success == enuNVM_FindUser(pu8Id, pstrRecordDesc)) &&
+       (Middleware_Success == enuNVM_OpenView(pstrRecordDesc, &strView)))
+    {
+        bRetVal = bNVM_ViewIdMatches(&strView, pu8Id);
+        (void)enuNVM_CloseView(&strView);
+    }
+
+    return bRetVal;
+}
+
+static void vidSignedInDispatch(void)
+{
+    /* Notify attribution application. Only the record descriptor is handed over, Attribution
+       reads the record itself.
+       Note: Data must be preserved until the Attribution application receives and processes it. */
+    fds_record_desc_t *pstrRecordDesc = (fds_record_desc_t *)pvPoolAlloc(sizeof(fds_record_desc_t));
+
+    /* Successfully allocated memory for data pointer */
+    if(pstrRecordDesc)
+    {
+        memcpy(pstrRecordDesc, &strActiveRecordDesc, sizeof(fds_record_desc_t));
+
+        /* Dispatch descriptor to the Attribution application */
+        (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_SIGNED_IN, (void *)pstrRecordDesc);
+    }
+}
+
+static void vidEntryAddedCallback(uint16_t u16Request, Mid_tenuStatus enuResult, void *pvContext)
+{
+    /* Notify Registration application of successful operation */
+    if(Middleware_Success == enuResult)
+    {
+        (void)AppMgr_enuDispatchEvent(BLE_USEREG_ENTRY_ADDED, NULL);
+    }
+}
+
+static void vidBatchAddedCallback(Mid_tenuStatus enuResult, void *pvContext)
+{
+    /* Keep batch outcome for the Registration task to report, it's no message queue payload. A
+       batch is applied as a whole, one that fell through is only finished on next boot if ever */
+    u16BatchAdded = (Middleware_Success == enuResult)?u16BatchStaged:0;
+    u16BatchFailed = u16BatchStaged + u16BatchExisting - u16BatchAdded;
+    bBatchComplete = true;
+
+    /* Notify Registration application of batch completion */
+    (void)AppMgr_enuDispatchEvent(BLE_USEREG_ENTRY_ADDED, NULL);
+}
+
+static void vidPasswordRegisteredCallback(uint16_t u16Request, Mid_tenuStatus enuResult, void *pvContext)
+{
+    /* Notify Registration application of successful operation */
+    if(Middleware_Success == enuResult)
+    {
+        (void)AppMgr_enuDispatchEvent(BLE_USEREG_PWD_REGISTERED, NULL);
+    }
+}
+
 static void vidUseRegDisconnected(void *pvArg)
 {
+    /* Write back record updates coalesced during this connection */
+    (void)enuNVM_FlushRecords(true);
+
     /* Reset all global variables */
     bRegNotifEnabled = false;
     bAdmNotifEnabled = false;
@@ -161,7 +205,7 @@ static void vidUseRegDisconnected(void *pvArg)
     bUseSignedIn = false;
     bAdmSignedIn = false;
     memset(&strActiveRecordDesc, 0, sizeof(strActiveRecordDesc));
-    memset(&strActiveRecord, 0, sizeof(strActiveRecord));
+    memset(u8ActiveUserId, 0, APP_USEREG_ID_LENGTH);
     memset(u8InvalidPasswordBase, 0xFF, APP_USEREG_MIN_PASSWORD_LENGTH);
     memset(u8CurrentUserPwd, 0xFF, APP_USEREG_MAX_PASSWORD_LENGTH);
 }
@@ -207,26 +251,62 @@ static void vidUseRegInputReceived(void *pvArg)
                        (pstrInput->u16Length <= APP_USEREG_MAX_PASSWORD_LENGTH) &&
                        (pstrInput->u16Length >= APP_USEREG_MIN_PASSWORD_LENGTH))
                     {
-                        if(0 == s8StringCompare(&strActiveRecord.u8Password[0],
-                                                &u8InvalidPasswordBase[0],
-                                                APP_USEREG_MIN_PASSWORD_LENGTH))
+                        /* Compare password right where the record sits in flash, without copying
+                           the record out */
+                        Nvm_tstrRecordView strView;
+                        App_tenuKeyTypes enuKeyType = App_KeyLowerBound;
+                        bool bUnregistered = false;
+                        bool bMatch = false;
+                        bool bFound = (Middleware_Success == enuNVM_OpenView(&strActiveRecordDesc, &strView));
+
+                        if(bFound)
+                        {
+                            enuKeyType = enuNVM_ViewKeyType(&strView);
+                            bUnregistered = bNVM_ViewPasswordMatches(&strView,
+                                                                     &u8InvalidPasswordBase[0],
+                                                                     APP_USEREG_MIN_PASSWORD_LENGTH);
+                            bMatch = bNVM_ViewPasswordMatches(&strView,
+                                                              &pstrInput->pu8Data[0],
+                                                              (uint8_t)pstrInput->u16Length);
+                            (void)enuNVM_CloseView(&strView);
+                        }
+
+                        if(!bFound)
+                        {
+                            /* Record went away since user input their Id, e.g. their key expired.
+                               Start over */
+                            bExpectingPwd = false;
+                            uint8_t u8NotificationBuffer[] = "Unregistered Id";
+                            uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                            (void)enuTransferNotification(Ble_Registration,
+                                                          u8NotificationBuffer,
+                                                          &u16NotificationSize);
+                            /* Display visual cue */
+                            (void)AppMgr_enuDispatchEvent(BLE_USEREG_INVALID_INPUT, NULL);
+                        }
+                        else if(bUnregistered)
                         {
                             /* No prior password registered for this user. Register a new one by
                                updating invalid password stored in NVM record */
-                            memcpy(&strActiveRecord.u8Password[0], &pstrInput->pu8Data[0], pstrInput->u16Length);
-                            Nvm_tenuFiles enuFile = ((App_CountRestrictedKey == strActiveRecord.enuKeyType) ||
-                                                     (App_TimeRestrictedKey == strActiveRecord.enuKeyType) ||
-                                                     (App_OneTimeKey == strActiveRecord.enuKeyType))
-                                                    ?Nvm_ExpirableKeys
-                                                    :Nvm_PersistentKeys;
-                            /* Update NVM record */
-                            (void)enuNVM_UpdateRecord(&strActiveRecordDesc, &strActiveRecord, enuFile, true);
+                            fds_flash_record_t strFdsRecord = {0};
+                            Nvm_tstrRecord strRecord;
+
+                            if(Middleware_Success == enuNVM_ReadRecord(&strActiveRecordDesc, &strFdsRecord, &strRecord))
+                            {
+                                memcpy(&strRecord.u8Password[0], &pstrInput->pu8Data[0], pstrInput->u16Length);
+                                Nvm_tenuFiles enuFile = ((App_CountRestrictedKey == strRecord.enuKeyType) ||
+                                                         (App_TimeRestrictedKey == strRecord.enuKeyType) ||
+                                                         (App_OneTimeKey == strRecord.enuKeyType))
+                                                        ?Nvm_ExpirableKeys
+                                                        :Nvm_PersistentKeys;
+                                /* Update NVM record */
+                                (void)u16NVM_RequestUpdate(&strActiveRecordDesc, &strRecord, enuFile,
+                                                           vidPasswordRegisteredCallback, NULL);
+                            }
                         }
-                        else if(0 == s8StringCompare(&pstrInput->pu8Data[0],
-                                                     &strActiveRecord.u8Password[0],
-                                                     pstrInput->u16Length))
+                        else if(bMatch)
                         {
-                            if(App_AdminKey == strActiveRecord.enuKeyType)
+                            if(App_AdminKey == enuKeyType)
                             {
                                 /* Admin successfully logged in. Toggle admin signed-in flag */
                                 bAdmSignedIn = true;
@@ -257,42 +337,8 @@ static void vidUseRegInputReceived(void *pvArg)
                                                               &u16NotificationSize);
                             }
 
-                            /* Notify attribution application
-                               Note: Data must be preserved until the Attribution application
-                               receives and processes it. */
-                            Nvm_tstrRecordDispatch *pstrRecordDispatch = (Nvm_tstrRecordDispatch *)malloc(sizeof(Nvm_tstrRecordDispatch));
-
-                            /* Successfully allocated memory for data pointer */
-                            if(pstrRecordDispatch)
-                            {
-                                pstrRecordDispatch->pstrRecordDesc = (fds_record_desc_t *)malloc(sizeof(fds_record_desc_t));
-
-                                if(NULL == pstrRecordDispatch->pstrRecordDesc)
-                                {
-                                    free(pstrRecordDispatch);
-                                }
-                                else
-                                {
-                                    pstrRecordDispatch->pstrRecord = (Nvm_tstrRecord *)malloc(sizeof(Nvm_tstrRecord));
-
-                                    if(NULL == pstrRecordDispatch->pstrRecord)
-                                    {
-                                        free(pstrRecordDispatch->pstrRecordDesc);
-                                    }
-                                }
-
-                                /* Copy data into dispatchable structure */
-                                memcpy((void *)pstrRecordDispatch->pstrRecordDesc,
-                                        (void *)&strActiveRecordDesc,
-                                        sizeof(strActiveRecordDesc));
-                                memcpy((void *)pstrRecordDispatch->pstrRecord,
-                                       (void *)&strActiveRecord,
-                                       sizeof(strActiveRecord));
-
-                                /* Dispatch structure to the Attribution application */
-                                (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_SIGNED_IN,
-                                                              (void *)pstrRecordDispatch);
-                            }
+                            /* Notify attribution application */
+                            vidSignedInDispatch();
                         }
                         else
                         {
@@ -304,6 +350,9 @@ static void vidUseRegInputReceived(void *pvArg)
                                                           &u16NotificationSize);
                             /* Display visual cue */
                             (void)AppMgr_enuDispatchEvent(BLE_USEREG_INVALID_INPUT, NULL);
+
+                            /* Audit denied access */
+                            (void)enuAudit_Append(u8ActiveUserId, enuKeyType, Audit_WrongPassword);
                         }
                     }
                     else
@@ -324,35 +373,18 @@ static void vidUseRegInputReceived(void *pvArg)
                     if(bIsAllNumerals(pstrInput->pu8Data, APP_USEREG_ID_LENGTH) &&
                        (APP_USEREG_ID_LENGTH == pstrInput->u16Length))
                     {
-                        /* Extract record key from Id */
+                        /* Find record in NVM */
                         fds_record_desc_t strRecordDesc = {0};
-                        fds_find_token_t strPersistentToken = {0};
-                        fds_find_token_t strExpirableToken = {0};
-                        char *pchRecordKey = (char *)malloc((APP_USEREG_ID_LENGTH/2)+1);
-                        memcpy(pchRecordKey, &pstrInput->pu8Data[4], (APP_USEREG_ID_LENGTH/2));
-                        pchRecordKey[(APP_USEREG_ID_LENGTH/2)] = '\0';
-                        free(pchRecordKey);
 
-                        /* Find record in NVM */
-                        fds_flash_record_t strFdsRecord = {0};
-                        Nvm_tstrRecord strRecord;
-                        App_tstrRecordSearch strRecordSearch;
-                        strRecordSearch.pu8Id = &pstrInput->pu8Data[0];
-                        strRecordSearch.u16RecordKey = (uint16_t)atoi(pchRecordKey);
-                        strRecordSearch.pstrRecordDesc = &strRecordDesc;
-                        strRecordSearch.pstrPersistentToken = &strPersistentToken;
-                        strRecordSearch.pstrExpirableToken = &strExpirableToken;
-                        strRecordSearch.pstrFdsRecord = &strFdsRecord;
-                        strRecordSearch.pstrAppRecord = &strRecord;
-
-                        if(bUserRecordFound(&strRecordSearch))
+                        if(bUserIdFound(&pstrInput->pu8Data[0], &strRecordDesc))
                         {
                             /* Id located in NVM. Toggle expecting password flag */
                             bExpectingPwd = true;
 
-                            /* Store record descriptor and record content */
+                            /* Store record descriptor and user Id. Record content is only looked
+                               at in place, once password is input */
                             memcpy(&strActiveRecordDesc, &strRecordDesc, sizeof(fds_record_desc_t));
-                            memcpy(&strActiveRecord, &strRecord, sizeof(Nvm_tstrRecord));
+                            memcpy(u8ActiveUserId, &pstrInput->pu8Data[0], APP_USEREG_ID_LENGTH);
 
                             /* Ask user to input their password */
                             uint8_t u8NotificationBuffer[] = "Please type password";
@@ -373,6 +405,9 @@ static void vidUseRegInputReceived(void *pvArg)
                                                           &u16NotificationSize);
                             /* Display visual cue */
                             (void)AppMgr_enuDispatchEvent(BLE_USEREG_INVALID_INPUT, NULL);
+
+                            /* Audit denied access */
+                            (void)enuAudit_Append(&pstrInput->pu8Data[0], App_KeyLowerBound, Audit_UnknownUser);
                         }
                     }
                     else
@@ -398,9 +433,8 @@ static void vidUseRegInputReceived(void *pvArg)
                                               &u16NotificationSize);
             }
 
-            /* Free allocated memory */
-            free((void *)((Ble_tstrRxData *)pvArg)->pu8Data);
-            free((void *)(Ble_tstrRxData *)pvArg);
+            /* Give Rx data's block back to its pool */
+            vidPoolFree(pvArg);
         }
     }
     else
@@ -427,6 +461,113 @@ static void vidUseAdmNotifDisabled(void *pvArg)
     bAdmNotifEnabled = false;
 }
 
+static bool bIsTimeOfDay(const uint8_t *pu8Data)
+{
+    /* Time of day is given as HHMM, 24-hour clock */
+    return bIsAllNumerals(pu8Data, 4) &&
+           ((((pu8Data[0] - '0') * 10) + (pu8Data[1] - '0')) < 24) &&
+           ((pu8Data[2] - '0') < 6);
+}
+
+static uint32_t u32DecodeTimeOfDay(const uint8_t *pu8Data)
+{
+    /* Convert HHMM into seconds since midnight */
+    return ((((pu8Data[0] - '0') * 10) + (pu8Data[1] - '0')) * APP_USEREG_SECS_IN_HOUR) +
+           ((((pu8Data[2] - '0') * 10) + (pu8Data[3] - '0')) * APP_USEREG_SECS_IN_MINUTE);
+}
+
+static uint32_t u32DecodeLittleEndian(const uint8_t *pu8Data)
+{
+    return ((uint32_t)pu8Data[0])       |
+           ((uint32_t)pu8Data[1] << 8)  |
+           ((uint32_t)pu8Data[2] << 16) |
+           ((uint32_t)pu8Data[3] << 24);
+}
+
+static Nvm_tenuFiles enuNewRecordFill(Nvm_tstrRecord *pstrRecord, uint8_t const *pu8Id,
+                                      App_tenuKeyTypes enuKeyType, uint16_t u16Argument)
+{
+    Nvm_tenuFiles enuRetVal;
+
+    /* Set Id, invalid password and key type in NVM entry */
+    memcpy(pstrRecord->u8Id, pu8Id, APP_USEREG_ID_LENGTH);
+    memset(pstrRecord->u8Password, 0xFF, APP_USEREG_MAX_PASSWORD_LENGTH);
+    pstrRecord->u32LastKnownUse = 0;
+    pstrRecord->enuKeyType = enuKeyType;
+    if(App_CountRestrictedKey == enuKeyType)
+    {
+        /* Set count-restricted key's count-limit */
+        pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit = u16Argument;
+        pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount = 0;
+        enuRetVal = Nvm_ExpirableKeys;
+    }
+    else if(App_TimeRestrictedKey == enuKeyType)
+    {
+        /* Set time-restricted key's timeout */
+        pstrRecord->uKeyQuantifier.strTimeRes.bIsKeyActive = false;
+        pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout = u16Argument;
+        enuRetVal = Nvm_ExpirableKeys;
+    }
+    else if(App_OneTimeKey == enuKeyType)
+    {
+        /* Clear one-time key expiration flag */
+        pstrRecord->uKeyQuantifier.bOneTimeExpired = false;
+        enuRetVal = Nvm_ExpirableKeys;
+    }
+    else
+    {
+        enuRetVal = Nvm_PersistentKeys;
+    }
+
+    return enuRetVal;
+}
+
+static bool bDecodeProvisionTuple(const uint8_t *pu8Tuple, Nvm_tstrRecord *pstrRecord)
+{
+    bool bRetVal = true;
+    uint8_t u8Id[APP_USEREG_ID_LENGTH];
+    uint32_t u32IdBcd = u32DecodeLittleEndian(pu8Tuple);
+    App_tenuKeyTypes enuKeyType = (App_tenuKeyTypes)pu8Tuple[4];
+    uint16_t u16Argument = ((uint16_t)pu8Tuple[5]) | ((uint16_t)pu8Tuple[6] << 8);
+
+    /* Unpack BCD-encoded Id, most significant nibble first, and make sure every digit is valid */
+    for(uint8_t u8Index = 0; u8Index < APP_USEREG_ID_LENGTH; u8Index++)
+    {
+        uint8_t u8Digit = (u32IdBcd >> (4 * (APP_USEREG_ID_LENGTH - 1 - u8Index))) & 0x0F;
+        bRetVal = bRetVal && (u8Digit <= 9);
+        u8Id[u8Index] = '0' + u8Digit;
+    }
+
+    /* Make sure key type is valid */
+    bRetVal = bRetVal && (App_KeyLowerBound < enuKeyType) && (enuKeyType < App_KeyUpperBound);
+
+    if(bRetVal)
+    {
+        (void)enuNewRecordFill(pstrRecord, u8Id, enuKeyType, u16Argument);
+    }
+
+    return bRetVal;
+}
+
+static bool bProvisionIdsDistinct(const uint8_t *pu8Tuples, uint16_t u16Count)
+{
+    bool bRetVal = true;
+
+    /* Compare BCD-encoded Ids as they're received, every pair once. Batches are small enough for
+       it not to matter */
+    for(uint16_t u16Index = 1; bRetVal && (u16Index < u16Count); u16Index++)
+    {
+        uint32_t u32IdBcd = u32DecodeLittleEndian(&pu8Tuples[u16Index * APP_USEREG_PROVISION_TUPLE_SIZE]);
+
+        for(uint16_t u16Other = 0; bRetVal && (u16Other < u16Index); u16Other++)
+        {
+            bRetVal = (u32IdBcd != u32DecodeLittleEndian(&pu8Tuples[u16Other * APP_USEREG_PROVISION_TUPLE_SIZE]));
+        }
+    }
+
+    return bRetVal;
+}
+
 static Registration_tenuAdmCmdType enuExtractCommandType(const uint8_t *pu8Data, uint8_t u8Length)
 {
     Registration_tenuAdmCmdType enuRetVal = Adm_InvalidCmd;
@@ -436,7 +577,7 @@ static Registration_tenuAdmCmdType enuExtractCommandType(const uint8_t *pu8Data,
     {
         /* Only accept 15, 16 and 20 character-long commands (Add user with persistant key, get
            user data and add user with expirable key commands are 15, 16 and 20 characters long
-           respectively). */
+           respectively, audit log query commands are 20 characters long as well). */
         if((15 == u8Length) || (20 == u8Length))
         {
             /* Compare received input against the Add user command base */
@@ -475,6 +616,16 @@ static Registration_tenuAdmCmdType enuExtractCommandType(const uint8_t *pu8Data,
                     }
                 }
             }
+            /* Compare received input against the Audit log command base */
+            else if((20 == u8Length) && (0 == s8StringCompare(pu8Data, u8AuditLogCmd, 8)))
+            {
+                /* Audit log command received. Check whether input contains a valid time range */
+                if(bIsTimeOfDay(&pu8Data[8]) && (0 == s8StringCompare(&pu8Data[12], " -t ", 4)) &&
+                   bIsTimeOfDay(&pu8Data[16]))
+                {
+                    enuRetVal = Adm_AuditLog;
+                }
+            }
         }
         else if(16 == u8Length)
         {
@@ -657,65 +808,39 @@ static void vidUseAdmInputReceived(void *pvArg)
                     App_tenuKeyTypes enuKeyType = enuDecodeAddCommand(pstrCommand->pu8Data,
                                                                       pstrCommand->u16Length,
                                                                       &u16Argument);
-                    /* Create new NVM entry */
-                    Nvm_tenuFiles enuNvmFile;
+                    /* Create new NVM entry with Id extracted from command */
                     fds_record_desc_t strRecordDesc = {0};
                     Nvm_tstrRecord strRecord;
-
-                    /* Set Id extracted from command, invalid password and key type in NVM entry */
-                    memcpy(strRecord.u8Id, &pstrCommand->pu8Data[5], APP_USEREG_ID_LENGTH);
-                    memset(strRecord.u8Password, 0xFF, APP_USEREG_MAX_PASSWORD_LENGTH);
-                    memset(&strRecord.strLastKnownUse, 0, sizeof(exact_time_256_t));
-                    strRecord.enuKeyType = enuKeyType;
-                    if(App_CountRestrictedKey == enuKeyType)
-                    {
-                        /* Set count-restricted key's count-limit */
-                        strRecord.uKeyQuantifier.strCountRes.u16CountLimit = u16Argument;
-                        strRecord.uKeyQuantifier.strCountRes.u16UsedCount = 0;
-                        enuNvmFile = Nvm_ExpirableKeys;
-                    }
-                    else if(App_TimeRestrictedKey == enuKeyType)
-                    {
-                        /* Set time-restricted key's timeout */
-                        strRecord.uKeyQuantifier.strTimeRes.bIsKeyActive = false;
-                        strRecord.uKeyQuantifier.strTimeRes.u16Timeout = u16Argument;
-                        enuNvmFile = Nvm_ExpirableKeys;
-                    }
-                    else if(App_OneTimeKey == enuKeyType)
+                    Nvm_tenuFiles enuNvmFile = enuNewRecordFill(&strRecord,
+                                                                &pstrCommand->pu8Data[5],
+                                                                enuKeyType,
+                                                                u16Argument);
+                    /* Add new NVM entry unless Id is already taken, NVM_Service turns it down anyway */
+                    if(Middleware_Success == enuNVM_FindUser(strRecord.u8Id, &strRecordDesc))
                     {
-                        /* Clear one-time key expiration flag */
-                        strRecord.uKeyQuantifier.bOneTimeExpired = false;
-                        enuNvmFile = Nvm_ExpirableKeys;
+                        /* Notify user that Id is already registered */
+                        uint8_t u8NotificationBuffer[] = "Id already exists";
+                        uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                        (void)enuTransferNotification(Ble_Admin,
+                                                      u8NotificationBuffer,
+                                                      &u16NotificationSize);
                     }
                     else
                     {
-                        enuNvmFile = Nvm_PersistentKeys;
+                        (void)u16NVM_RequestAdd(&strRecordDesc, &strRecord, enuNvmFile, vidEntryAddedCallback, NULL);
                     }
-                    /* Add new NVM entry */
-                    (void)enuNVM_AddNewRecord(&strRecordDesc, &strRecord, enuNvmFile);
                 }
                 break;
 
                 case Adm_UserData:
                 {
-                    /* Extract record key from command */
-                    fds_record_desc_t strRecordDesc = {0};
-                    fds_find_token_t strPersistentToken = {0};
-                    fds_find_token_t strExpirableToken = {0};
-                    char *pchRecordKey = (char *)malloc((APP_USEREG_ID_LENGTH/2)+1);
-                    memcpy(pchRecordKey, &pstrCommand->pu8Data[12], (APP_USEREG_ID_LENGTH/2));
-                    pchRecordKey[(APP_USEREG_ID_LENGTH/2)] = '\0';
-                    free(pchRecordKey);
-
                     /* Find record in NVM */
+                    fds_record_desc_t strRecordDesc = {0};
                     fds_flash_record_t strFdsRecord = {0};
                     Nvm_tstrRecord strRecord;
                     App_tstrRecordSearch strRecordSearch;
                     strRecordSearch.pu8Id = &pstrCommand->pu8Data[8];
-                    strRecordSearch.u16RecordKey = (uint16_t)atoi(pchRecordKey);
                     strRecordSearch.pstrRecordDesc = &strRecordDesc;
-                    strRecordSearch.pstrPersistentToken = &strPersistentToken;
-                    strRecordSearch.pstrExpirableToken = &strExpirableToken;
                     strRecordSearch.pstrFdsRecord = &strFdsRecord;
                     strRecordSearch.pstrAppRecord = &strRecord;
 
@@ -738,6 +863,71 @@ static void vidUseAdmInputReceived(void *pvArg)
                 }
                 break;
 
+                case Adm_AuditLog:
+                {
+                    uint32_t u32Now = u32Audit_GetTime();
+
+                    if(u32Now)
+                    {
+                        /* Times are local and refer to the latest such time range to have started.
+                           A range ending earlier than it starts spans midnight */
+                        uint32_t u32DayStart = u32TimeLocalDayStart(u32Now);
+                        uint32_t u32From = u32DayStart + u32DecodeTimeOfDay(&pstrCommand->pu8Data[8]);
+                        uint32_t u32To = u32DayStart + u32DecodeTimeOfDay(&pstrCommand->pu8Data[16]) +
+                                         APP_USEREG_SECS_IN_MINUTE - 1;
+
+                        if(u32To < u32From)
+                        {
+                            /* Range started yesterday unless it has already started today, in
+                               which case it ends tomorrow */
+                            if(u32From > u32Now)
+                            {
+                                u32From -= APP_USEREG_SECS_IN_DAY;
+                            }
+                            else
+                            {
+                                u32To += APP_USEREG_SECS_IN_DAY;
+                            }
+                        }
+                        else if(u32From > u32Now)
+                        {
+                            u32From -= APP_USEREG_SECS_IN_DAY;
+                            u32To -= APP_USEREG_SECS_IN_DAY;
+                        }
+
+                        /* Let user know how many entries to expect, entries are streamed over the
+                           Export characteristic. snprintf returns the untruncated length, which
+                           is clamped to what the buffer holds */
+                        char chNotification[APP_USEREG_MAX_COMMAND_LENGTH + 1];
+                        int32_t s32Length = snprintf(chNotification, sizeof(chNotification),
+                                                     "%lu entries found",
+                                                     (unsigned long)u32Audit_CountBetween(u32From, u32To));
+                        uint16_t u16NotificationSize = (uint16_t)MIN((uint32_t)MAX(s32Length, 0),
+                                                                     sizeof(chNotification) - 1);
+                        (void)enuTransferNotification(Ble_Admin,
+                                                      (uint8_t *)chNotification,
+                                                      &u16NotificationSize);
+
+                        /* Display visual cue */
+                        (void)AppMgr_enuDispatchEvent((Middleware_Success ==
+                                                       enuBleStartAuditExport(u32Audit_FindSequence(u32From),
+                                                                              u32From, u32To))
+                                                      ?BLE_USEREG_USER_DATA
+                                                      :BLE_USEREG_INVALID_INPUT,
+                                                      NULL);
+                    }
+                    else
+                    {
+                        /* Entries can't be matched against local time before time is known */
+                        uint8_t u8NotificationBuffer[] = "Time unknown";
+                        uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                        (void)enuTransferNotification(Ble_Admin,
+                                                      u8NotificationBuffer,
+                                                      &u16NotificationSize);
+                    }
+                }
+                break;
+
                 case Adm_InvalidCmd:
                 {
                     /* Notify user of invalid input */
@@ -766,9 +956,8 @@ static void vidUseAdmInputReceived(void *pvArg)
                                               &u16NotificationSize);
             }
 
-            /* Free allocated memory */
-            free((void *)((Ble_tstrRxData *)pvArg)->pu8Data);
-            free((void *)(Ble_tstrRxData *)pvArg);
+            /* Give Rx data's block back to its pool */
+            vidPoolFree(pvArg);
         }
     }
     else
@@ -780,13 +969,38 @@ static void vidUseAdmInputReceived(void *pvArg)
 
 static void vidUseAdmAddedToNvm(void *pvArg)
 {
-    /* Send notification to peer */
-    uint8_t u8NotificationBuffer[] = "User added";
-    uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
-    (void)enuTransferNotification(Ble_Admin, u8NotificationBuffer, &u16NotificationSize);
+    if(bBatchComplete)
+    {
+        /* Provisioning batch completed. Send a single summary notification to peer, its length
+           clamped to what the buffer holds */
+        uint8_t u8NotificationBuffer[APP_USEREG_MAX_SUMMARY_LENGTH];
+        int32_t s32Length = snprintf((char *)u8NotificationBuffer,
+                                     sizeof(u8NotificationBuffer),
+                                     "%u added, %u failed",
+                                     u16BatchAdded,
+                                     u16BatchFailed);
+        uint16_t u16NotificationSize = (uint16_t)MIN((uint32_t)MAX(s32Length, 0),
+                                                     sizeof(u8NotificationBuffer) - 1);
+        (void)enuTransferNotification(Ble_Admin, u8NotificationBuffer, &u16NotificationSize);
+
+        bBatchComplete = false;
+
+        /* New users successfully added to NVM */
+        if(u16BatchAdded)
+        {
+            (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_ADDED, NULL);
+        }
+    }
+    else
+    {
+        /* Send notification to peer */
+        uint8_t u8NotificationBuffer[] = "User added";
+        uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+        (void)enuTransferNotification(Ble_Admin, u8NotificationBuffer, &u16NotificationSize);
 
-    /* New user successfully added to NVM */
-    (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_ADDED, NULL);
+        /* New user successfully added to NVM */
+        (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_ADDED, NULL);
+    }
 }
 
 static void vidUserPasswordUpdated(void *pvArg)
@@ -800,46 +1014,196 @@ static void vidUserPasswordUpdated(void *pvArg)
     /* Toggle user signed-in flag */
     bUseSignedIn = true;
 
-    /* Notify attribution application.
-       Note: Data must be preserved until the Attribution application
-       receives and processes it. */
-    Nvm_tstrRecordDispatch *pstrRecordDispatch = (Nvm_tstrRecordDispatch *)malloc(sizeof(Nvm_tstrRecordDispatch));
+    /* Notify attribution application */
+    vidSignedInDispatch();
+}
 
-    /* Successfully allocated memory for data pointer */
-    if(pstrRecordDispatch)
+static void vidUseAdmExportRequest(void *pvArg)
+{
+    /* Make sure valid parameters are passed */
+    if(pvArg)
     {
-        pstrRecordDispatch->pstrRecordDesc = (fds_record_desc_t *)malloc(sizeof(fds_record_desc_t));
+        Ble_tstrRxData *pstrRequest = (Ble_tstrRxData *)pvArg;
+        uint32_t u32Sequence = 0;
+        uint32_t u32From = 0;
+        uint32_t u32To = UINT32_MAX;
 
-        if(NULL == pstrRecordDispatch->pstrRecordDesc)
+        /* Only Admin gets to read the audit journal */
+        if(bAdmSignedIn)
         {
-            free(pstrRecordDispatch);
+            /* Request holds either the little-endian sequence number to resume from or the
+               little-endian start and end times of the range to export. Anything else exports
+               the whole journal */
+            if(sizeof(uint32_t) == pstrRequest->u16Length)
+            {
+                u32Sequence = u32DecodeLittleEndian(pstrRequest->pu8Data);
+            }
+            else if((2 * sizeof(uint32_t)) == pstrRequest->u16Length)
+            {
+                u32From = u32DecodeLittleEndian(pstrRequest->pu8Data);
+                u32To = u32DecodeLittleEndian(&pstrRequest->pu8Data[sizeof(uint32_t)]);
+                u32Sequence = u32Audit_FindSequence(u32From);
+            }
+
+            /* Display visual cue */
+            (void)AppMgr_enuDispatchEvent((Middleware_Success ==
+                                           enuBleStartAuditExport(u32Sequence, u32From, u32To))
+                                          ?BLE_USEREG_USER_DATA
+                                          :BLE_USEREG_INVALID_INPUT,
+                                          NULL);
         }
         else
         {
-            pstrRecordDispatch->pstrRecord = (Nvm_tstrRecord *)malloc(sizeof(Nvm_tstrRecord));
+            /* User hasn't signed in as Admin yet. Prompt them to do so */
+            uint8_t u8NotificationBuffer[] = "Please sign in first";
+            uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+            (void)enuTransferNotification(Ble_Admin,
+                                          u8NotificationBuffer,
+                                          &u16NotificationSize);
+        }
 
-            if(NULL == pstrRecordDispatch->pstrRecord)
+        /* Give Rx data's block back to its pool */
+        vidPoolFree((void *)pstrRequest);
+    }
+}
+
+static void vidUseAdmProvisionRequest(void *pvArg)
+{
+    /* Make sure valid parameters are passed */
+    if(pvArg)
+    {
+        Ble_tstrRxData *pstrRequest = (Ble_tstrRxData *)pvArg;
+        uint16_t u16Count = pstrRequest->u16Length / APP_USEREG_PROVISION_TUPLE_SIZE;
+        uint16_t u16Index = 0;
+        Nvm_tstrRecord strRecord;
+
+        /* Only Admin gets to provision users */
+        if(bAdmSignedIn)
+        {
+            if(Middleware_Success != enuNVM_BeginTransaction())
             {
-                free(pstrRecordDispatch->pstrRecordDesc);
+                /* Previous batch is still being written */
+                uint8_t u8NotificationBuffer[] = "Busy";
+                uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                (void)enuTransferNotification(Ble_Admin,
+                                              u8NotificationBuffer,
+                                              &u16NotificationSize);
             }
+            else
+            {
+                /* Request holds back to back 7-byte tuples: little-endian BCD-encoded Id, key type
+                   and little-endian key parameter. No Id may show up twice */
+                bool bValid = u16Count && (u16Count <= MID_NVM_BATCH_SIZE) &&
+                              (0 == (pstrRequest->u16Length % APP_USEREG_PROVISION_TUPLE_SIZE)) &&
+                              bProvisionIdsDistinct(pstrRequest->pu8Data, u16Count);
+                uint16_t u16Existing = 0;
+                fds_record_desc_t strRecordDesc;
+
+                /* Decode every tuple and stage it as part of a transaction. Staged users are
+                   copied, so tuples are decoded one at a time and nothing is written before all
+                   of them are. A batch is either wholly valid or turned down. Users already
+                   registered are left untouched and reported as failures */
+                while(bValid && (u16Index < u16Count))
+                {
+                    bValid = bDecodeProvisionTuple(&pstrRequest->pu8Data[u16Index * APP_USEREG_PROVISION_TUPLE_SIZE],
+                                                   &strRecord);
+                    if(bValid && (Middleware_Success == enuNVM_FindUser(strRecord.u8Id, &strRecordDesc)))
+                    {
+                        u16Existing++;
+                    }
+                    else if(bValid)
+                    {
+                        bValid = (Middleware_Success == enuNVM_StageRecord(&strRecord));
+                    }
+                    u16Index++;
+                }
+
+                if(bValid && (u16Existing == u16Count))
+                {
+                    /* Nothing left to write. Report batch right away */
+                    (void)enuNVM_AbortTransaction();
+                    u16BatchAdded = 0;
+                    u16BatchFailed = u16Count;
+                    bBatchComplete = true;
+                    vidUseAdmAddedToNvm(NULL);
+                }
+                else if(bValid)
+                {
+                    /* Commit the whole batch, space being reserved for it up front. It makes it
+                       to flash storage as a whole or not at all, even across a reset */
+                    u16BatchStaged = u16Count - u16Existing;
+                    u16BatchExisting = u16Existing;
+                    if(Middleware_Success == enuNVM_CommitTransaction(vidBatchAddedCallback, NULL))
+                    {
+                        /* Display visual cue */
+                        (void)AppMgr_enuDispatchEvent(BLE_USEREG_VALID_INPUT, NULL);
+                    }
+                    else
+                    {
+                        /* Batch doesn't fit in flash storage */
+                        uint8_t u8NotificationBuffer[] = "Not enough space";
+                        uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                        (void)enuNVM_AbortTransaction();
+                        (void)enuTransferNotification(Ble_Admin,
+                                                      u8NotificationBuffer,
+                                                      &u16NotificationSize);
+                    }
+                }
+                else
+                {
+                    /* Invalid batch. Drop whatever was staged and notify user */
+                    uint8_t u8NotificationBuffer[] = "Invalid! Try again";
+                    uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+                    (void)enuNVM_AbortTransaction();
+                    (void)enuTransferNotification(Ble_Admin,
+                                                  u8NotificationBuffer,
+                                                  &u16NotificationSize);
+                    /* Display visual cue */
+                    (void)AppMgr_enuDispatchEvent(BLE_USEREG_INVALID_INPUT, NULL);
+                }
+            }
+        }
+        else
+        {
+            /* User hasn't signed in as Admin yet. Prompt them to do so */
+            uint8_t u8NotificationBuffer[] = "Please sign in first";
+            uint16_t u16NotificationSize = sizeof(u8NotificationBuffer)-1;
+            (void)enuTransferNotification(Ble_Admin,
+                                          u8NotificationBuffer,
+                                          &u16NotificationSize);
         }
 
-        /* Copy data into dispatchable structure */
-        memcpy((void *)pstrRecordDispatch->pstrRecordDesc,
-               (void *)&strActiveRecordDesc,
-               sizeof(strActiveRecordDesc));
-        memcpy((void *)pstrRecordDispatch->pstrRecord,
-               (void *)&strActiveRecord,
-        sizeof(strActiveRecord));
-
-        /* Dispatch structure to the Attribution application */
-        (void)AppMgr_enuDispatchEvent(BLE_USEREG_USER_SIGNED_IN,
-                                      (void *)pstrRecordDispatch);
+        /* Give Rx data's block back to its pool */
+        vidPoolFree((void *)pstrRequest);
+    }
+}
+
+static void vidUseRegHousekeeping(void *pvArg)
+{
+    /* Runs on the Application Manager's task like every other NVM_Service call applications
+       make, so it never interleaves with them. No event-related data is passed along */
+    (void)pvArg;
+
+    /* Write back cached record updates left untouched for a while */
+    (void)enuNVM_FlushRecords(false);
+
+    /* Fold exhausted usage counter slots back into their owners' records */
+    (void)enuNVM_CompactCounters();
+
+    /* Delete expired keys and reclaim flash storage space while no peer is being served. Time is
+       the audit journal's, carried forward from the last Current Time Service reading or from
+       before System OFF. It may lag behind, keys are then only deleted later */
+    if(!bBleIsConnected())
+    {
+        (void)enuNVM_ReapExpiredKeys(u32Audit_GetMinimumTime());
+        (void)enuNVM_CollectGarbage();
     }
 }
 
 static void vidRegistrationEvent_Process(uint32_t u32Trigger, void *pvData)
 {
+    TRACE_POINT(Trace_RegistrationProcess, u32Trigger);
+
     /* Go through trigger list to find trigger.
        Note: We use a while loop as we require that no two distinct actions have the
        same trigger in a State trigger listing */
@@ -857,11 +1221,9 @@ static void vidRegistrationEvent_Process(uint32_t u32Trigger, void *pvData)
     }
 }
 
-static void vidUseRegTaskFunction(void *pvArg)
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+App_tenuStatus enuRegistration_Init(void)
 {
-    uint32_t u32Event;
-    void *pvData;
-
     /* Initialize invalid and active user password arrays.
        Note: Passwords are handled as strings and should therefore only contain characters with
        ASCII values in the ASCII range (0 - 0x7F). We use 0xFF to initialize these arrays as this
@@ -869,84 +1231,20 @@ static void vidUseRegTaskFunction(void *pvArg)
     memset(u8InvalidPasswordBase, 0xFF, APP_USEREG_MIN_PASSWORD_LENGTH);
     memset(u8CurrentUserPwd, 0xFF, APP_USEREG_MAX_PASSWORD_LENGTH);
 
-    /* User Registration task's main polling loop */
-    while(1)
-    {
-        /* Task will remain blocked until an event is set in event group */
-        u32Event = xEventGroupWaitBits(pvUseRegEventGroupHandle,
-                                       APP_USEREG_EVENT_MASK,
-                                       pdTRUE,
-                                       pdFALSE,
-                                       portMAX_DELAY);
-        if(u32Event)
-        {
-            /* Check whether queue holds any data */
-            if(uxQueueMessagesWaiting(pvUseRegQueueHandle))
-            {
-                /* We have no tasks of higher priority so we're guaranteed that no other
-                   message will be received in the queue until this message is processed */
-                xQueueReceive(pvUseRegQueueHandle, &pvData, APP_USEREG_POP_IMMEDIATELY);
-            }
-
-            /* Process received event */
-            vidRegistrationEvent_Process(u32Event, pvData);
-        }
-    }
-}
-
-/************************************   PUBLIC FUNCTIONS   ***************************************/
-App_tenuStatus enuRegistration_Init(void)
-{
-    App_tenuStatus enuRetVal = Application_Failure;
-
-    /* Create task for User Registration application */
-    if(pdPASS == xTaskCreate(vidUseRegTaskFunction,
-                             "APP_UseReg_Task",
-                             APP_USEREG_TASK_STACK_SIZE,
-                             NULL,
-                             APP_USEREG_TASK_PRIORITY,
-                             &pvUseRegTaskHandle))
-    {
-        /* Create message queue for User Registration application */
-        pvUseRegQueueHandle = xQueueCreate(APP_USEREG_QUEUE_LENGTH, sizeof(void *));
-
-        if(pvUseRegQueueHandle)
-        {
-            /* Create event group for User Registration application */
-            pvUseRegEventGroupHandle = xEventGroupCreate();
-            enuRetVal = (NULL != pvUseRegEventGroupHandle)?Application_Success:Application_Failure;
-        }
-    }
-
-    return enuRetVal;
+    /* Messages posted to User Registration application are processed on the Application
+       Manager's task */
+    return AppMgr_enuRegisterHandler(App_RegistrationId, vidRegistrationEvent_Process);
 }
 
 App_tenuStatus enuRegistration_GetNotified(uint32_t u32Event, void *pvData)
 {
-    App_tenuStatus enuRetVal = Application_Success;
-
-    if(pvData)
-    {
-        /* Push event-related data to local message queue */
-        enuRetVal = (pdTRUE == xQueueSend(pvUseRegQueueHandle,
-                                          &pvData,
-                                          APP_USEREG_PUSH_IMMEDIATELY))
-                                          ?Application_Success
-                                          :Application_Failure;
-        if(Application_Failure == enuRetVal)
-        {
-            /* Free allocated memory */
-            free((void *)((Ble_tstrRxData *)pvData)->pu8Data);
-            free((void *)(Ble_tstrRxData *)pvData);
-        }
-    }
+    /* Post event along with its data to local message queue, to be processed once its turn comes */
+    App_tenuStatus enuRetVal = AppMgr_enuPostMessage(App_RegistrationId, u32Event, pvData);
 
-    if(Application_Success == enuRetVal)
+    if((Application_Failure == enuRetVal) && pvData)
     {
-        /* Unblock Registration task by setting event in local event group */
-        enuRetVal = xEventGroupSetBits(pvUseRegEventGroupHandle, u32Event)
-                                       ?Application_Success
-                                       :Application_Failure;
+        /* Give event-related data's block back to its pool */
+        vidPoolFree(pvData);
     }
 
     return enuRetVal;
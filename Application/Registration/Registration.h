@@ -23,6 +23,9 @@
 #define APP_USEADM_USR_INPUT_RX       (1 << 15)     /* Received data from peer on command charac */
 #define APP_USEADM_USR_ADDED_TO_NVM   (1 << 16)     /* New user added to NVM                     */
 #define APP_USEADM_PASSWORD_UPDATED   (1 << 17)     /* User password updated                     */
+#define APP_USEADM_EXPORT_REQUEST     (1 << 22)     /* Received data from peer on export charac  */
+#define APP_USEADM_PROVISION_REQUEST  (1 << 23)     /* Received data from peer on provision char */
+#define APP_USEREG_NVM_HOUSEKEEPING   (1 << 24)     /* All tasks idle, NVM housekeeping may run  */
 
 /* Dispatchable events */
 #define BLE_USEREG_VALID_INPUT    4U       /* User entered a valid input display pattern         */
@@ -30,6 +33,8 @@
 #define BLE_USEREG_USER_ADDED     8U       /* User added successfully to NVM display pattern     */
 #define BLE_USEREG_USER_DATA      9U       /* User data extracted successfully display pattern   */
 #define BLE_USEREG_NOTIF_DISABLED 10U      /* Received data with notifs disabled display pattern */
+#define BLE_USEREG_ENTRY_ADDED    17U      /* New user entry written to NVM                      */
+#define BLE_USEREG_PWD_REGISTERED 18U      /* User password written to NVM                       */
 #define BLE_USEREG_USER_SIGNED_IN 21U      /* Notify attribution of user signing in successfully */
 
 /**************************************   PUBLIC TYPES   *****************************************/
@@ -51,6 +56,7 @@ typedef enum
 {
     Adm_AddUser = 0, /* Admin add user command  */
     Adm_UserData,    /* Admin user data command */
+    Adm_AuditLog,    /* Admin audit log command */
     Adm_InvalidCmd   /* Admin invalid command   */
 }Registration_tenuAdmCmdType;
 
@@ -65,8 +71,8 @@ typedef struct
 
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 /**
- * @brief enuRegistration_Init Creates User Registration task, event group to receive notifications
- *        from other tasks and message queue to hold data potentially accompanying incoming events.
+ * @brief enuRegistration_Init Initializes User Registration application and registers its
+ *        message handler with the Application Manager, on whose task it runs.
  *
  * @note This function is invoked by the Application Manager.
  *
@@ -78,16 +84,15 @@ typedef struct
 App_tenuStatus enuRegistration_Init(void);
 
 /**
- * @brief enuRegistration_GetNotified Notifies User Registration task of an incoming event by
- *        setting it in local event group and setting its accompanying data in local message
- *        queue.
+ * @brief enuRegistration_GetNotified Notifies User Registration application of an incoming
+ *        event by posting it along with its accompanying data to its message queue.
  *
  * @note This function is invoked by the Application Manager signaling that another task
- *       wants to communicate with the User Registration task.
+ *       wants to communicate with the User Registration application.
  *
- * @pre This function can't be called unless User Registration task is initialized and running.
+ * @pre This function can't be called unless the User Registration application is initialized.
  *
- * @param u32Event Event to be posted in local event group.
+ * @param u32Event Trigger value to be matched by the application's state machine.
  * @param pvData Pointer to event-related data.
  *
  * @return App_tenuStatus Application_Success if notification was posted successfully,
@@ -203,7 +203,7 @@
 #endif
 // <o> NRF_BLE_QWR_MAX_ATTR - Maximum number of attribute handles that can be registered. This number must be adjusted according to the number of attributes for which Queued Writes will be enabled. If it is zero, the module will reject all Queued Write requests.
 #ifndef NRF_BLE_QWR_MAX_ATTR
-#define NRF_BLE_QWR_MAX_ATTR 0
+#define NRF_BLE_QWR_MAX_ATTR 1
 #endif
 
 // </e>
@@ -6709,8 +6709,10 @@
 
 // <i> NRF_FSTORAGE_SD uses the nrf_fstorage_sd backend implementation using the SoftDevice API. Use this if you have a SoftDevice present.
 // <i> NRF_FSTORAGE_NVMC uses the nrf_fstorage_nvmc implementation. Use this setting if you don't use the SoftDevice.
+// <i> NRF_FSTORAGE_HOST uses the nrf_fstorage_host implementation, a flash image file for host-side builds only.
 // <1=> NRF_FSTORAGE_NVMC
 // <2=> NRF_FSTORAGE_SD
+// <3=> NRF_FSTORAGE_HOST
 
 #ifndef FDS_BACKEND
 #define FDS_BACKEND 2
@@ -11,20 +11,25 @@
 /************************************   APPLICATION DEFINES   ************************************/
 #define APPLICATION_COUNT 3
 
-/* User Registration application */
-#define APP_USEREG_TASK_STACK_SIZE 256
-#define APP_USEREG_TASK_PRIORITY 2
+/* Application Manager. All applications run to completion on its task, whose stack must fit the
+   deepest application event handler */
+#define APP_MGR_TASK_STACK_SIZE 288
+#define APP_MGR_TASK_PRIORITY 2
+
+/* User Registration application. Applications with higher priorities get their pending messages
+   handled first */
+#define APP_USEREG_PRIORITY 2
 #define APP_USEREG_QUEUE_LENGTH 5
-#define APP_USEREG_MAX_CROSS_IDS 3
+
+/* NVM housekeeping, run by User Registration on the idle hook's request at most once per period */
+#define APP_USEREG_HOUSEKEEPING_PERIOD_MS 1000
 
 /* Key Attribution application */
-#define APP_KEYATT_TASK_STACK_SIZE 256
-#define APP_KEYATT_TASK_PRIORITY 2
+#define APP_KEYATT_PRIORITY 2
 #define APP_KEYATT_QUEUE_LENGTH 5
 
 /* Display application */
-#define APP_DISPLAY_TASK_STACK_SIZE 256
-#define APP_DISPLAY_TASK_PRIORITY 2
+#define APP_DISPLAY_PRIORITY 3
 #define APP_DISPLAY_QUEUE_LENGTH 5
 
 /*************************************   MIDDLEWARE DEFINES   ************************************/
@@ -33,10 +38,72 @@
 #define MID_BLE_TASK_PRIORITY 2
 #define MID_BLE_TASK_QUEUE_LENGTH 5
 
+/* Notifications the Softdevice can queue per link. Each one takes Softdevice RAM */
+#define MID_BLE_HVN_TX_QUEUE_SIZE 8
+
+/* NVM Middleware Service. Index size and Bloom filter bit count must be powers of 2. Unless set
+   through MID_NVM_INDEX_SIZE, the index is sized after FDS's data pages (see NVM_Service.c) */
+#ifndef MID_NVM_BLOOM_BITS
+#define MID_NVM_BLOOM_BITS 4096
+#endif
+#define MID_NVM_CACHE_SIZE 4
+#define MID_NVM_CACHE_FLUSH_DELAY_MS 10000
+
+/* NVM recently signed-in users, served out of RAM and retained across System OFF */
+#define MID_NVM_RECENT_USERS 4
+
+/* NVM expiry reaper. Expirable keys are checked in batches of MID_NVM_REAP_BATCH records, one
+   pass through flash storage every MID_NVM_REAP_PERIOD_MS at most */
+#define MID_NVM_REAP_BATCH 8
+#define MID_NVM_REAP_PERIOD_MS 600000
+
+/* NVM usage counters of count-restricted keys. Counter pages sit right below FDS's pages */
+#ifndef MID_NVM_COUNTER_PAGES
+#define MID_NVM_COUNTER_PAGES 1
+#endif
+
+/* NVM batch writes. Flash space is reserved for up to MID_NVM_BATCH_SIZE new records at once,
+   as many as a full write to ble_adm's Provision characteristic holds */
+#define MID_NVM_BATCH_SIZE 73
+
+/* NVM transactions. Up to MID_NVM_TXN_SIZE users are staged in RAM and written to a single intent
+   record taking 7 words per user, which must fit in an FDS page. Provisioning batches are written
+   as transactions */
+#define MID_NVM_TXN_SIZE MID_NVM_BATCH_SIZE
+
+/* NVM garbage collection thresholds, in percent of data pages reclaimable */
+#define MID_NVM_GC_IDLE_THRESHOLD 25
+#define MID_NVM_GC_SLEEP_THRESHOLD 66
+
+/* Audit Middleware Service. Journal pages sit right below the usage counter pages. Code must be
+   kept out of FDS's, counter and journal pages through the linker's ROM region */
+#ifndef MID_AUDIT_PAGES
+#define MID_AUDIT_PAGES 8
+#endif
+#define MID_AUDIT_QUEUE_SIZE 2
+
 /***************************************   UTILITY DEFINES   *************************************/
 /* Time utility. Define UTC+n as n and UTC-n as 24-n */
 #define UTIL_UTC_TIME_ZONE 1
 
+/* Pool utility. Small blocks carry BLE inputs and record descriptors, one per pending message.
+   Large blocks carry full writes to ble_adm's Provision characteristic */
+#define UTIL_POOL_SMALL_BLOCK_SIZE 32
+#define UTIL_POOL_SMALL_BLOCK_COUNT (APP_USEREG_QUEUE_LENGTH + APP_KEYATT_QUEUE_LENGTH + 2)
+#define UTIL_POOL_LARGE_BLOCK_SIZE 524
+#define UTIL_POOL_LARGE_BLOCK_COUNT 2
+
+/* Trace utility. Trace points compile to nothing unless enabled. Ring size must be a power of 2.
+   Host builds stamp points with the monotonic clock, scaled to the core's clock frequency */
+#ifndef UTIL_TRACE_ENABLED
+#define UTIL_TRACE_ENABLED 0
+#endif
+#ifndef UTIL_TRACE_HOST_CLOCK
+#define UTIL_TRACE_HOST_CLOCK 0
+#endif
+#define UTIL_TRACE_SIZE 64
+#define UTIL_TRACE_CLOCK_HZ 64000000UL
+
 /*************************************   PERIPHERAL DEFINES   ************************************/
 /* LEDS */
 #define LED_1 17
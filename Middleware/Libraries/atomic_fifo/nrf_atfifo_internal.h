@@ -347,6 +347,127 @@ nrf_atfifo_space_clear_head_test_skip
     bx      lr
 }
 
+#elif defined ( __GNUC__ ) && !defined ( __arm__ )
+
+/* Host builds (see Project/Host) run on a core without LDREX/STREX.
+ * Every exclusive access sequence above is a read-modify-write of one 32-bit tag,
+ * so it maps onto a compare-and-swap loop. */
+
+static uint16_t nrf_atfifo_pos_inc(nrf_atfifo_t const * const p_fifo, uint16_t pos)
+{
+    uint32_t new_pos = (uint32_t)pos + p_fifo->item_size;
+    if (new_pos >= p_fifo->buf_size)
+    {
+        new_pos -= p_fifo->buf_size;
+    }
+    return (uint16_t)new_pos;
+}
+
+
+static bool nrf_atfifo_wspace_req(nrf_atfifo_t * const p_fifo, nrf_atfifo_postag_t * const p_old_tail)
+{
+    bool ret;
+    nrf_atfifo_postag_t old_tail;
+    nrf_atfifo_postag_t new_tail;
+
+    old_tail.tag = __atomic_load_n(&p_fifo->tail.tag, __ATOMIC_ACQUIRE);
+    do
+    {
+        new_tail        = old_tail;
+        new_tail.pos.wr = nrf_atfifo_pos_inc(p_fifo, old_tail.pos.wr);
+
+        ret = (new_tail.pos.wr != __atomic_load_n(&p_fifo->head.pos.wr, __ATOMIC_ACQUIRE));
+    } while (ret && !__atomic_compare_exchange_n(&p_fifo->tail.tag, &old_tail.tag, new_tail.tag,
+                                                 false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    *p_old_tail = old_tail;
+    return ret;
+}
+
+
+static void nrf_atfifo_wspace_close(nrf_atfifo_t * const p_fifo)
+{
+    nrf_atfifo_postag_t old_tail;
+    nrf_atfifo_postag_t new_tail;
+
+    old_tail.tag = __atomic_load_n(&p_fifo->tail.tag, __ATOMIC_ACQUIRE);
+    do
+    {
+        new_tail        = old_tail;
+        new_tail.pos.rd = old_tail.pos.wr;
+    } while (!__atomic_compare_exchange_n(&p_fifo->tail.tag, &old_tail.tag, new_tail.tag,
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+
+static bool nrf_atfifo_rspace_req(nrf_atfifo_t * const p_fifo, nrf_atfifo_postag_t * const p_old_head)
+{
+    bool ret;
+    nrf_atfifo_postag_t old_head;
+    nrf_atfifo_postag_t new_head;
+
+    old_head.tag = __atomic_load_n(&p_fifo->head.tag, __ATOMIC_ACQUIRE);
+    do
+    {
+        new_head = old_head;
+
+        ret = (old_head.pos.rd != __atomic_load_n(&p_fifo->tail.pos.rd, __ATOMIC_ACQUIRE));
+        if (ret)
+        {
+            new_head.pos.rd = nrf_atfifo_pos_inc(p_fifo, old_head.pos.rd);
+        }
+    } while (ret && !__atomic_compare_exchange_n(&p_fifo->head.tag, &old_head.tag, new_head.tag,
+                                                 false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    *p_old_head = old_head;
+    return ret;
+}
+
+
+static void nrf_atfifo_rspace_close(nrf_atfifo_t * const p_fifo)
+{
+    nrf_atfifo_postag_t old_head;
+    nrf_atfifo_postag_t new_head;
+
+    old_head.tag = __atomic_load_n(&p_fifo->head.tag, __ATOMIC_ACQUIRE);
+    do
+    {
+        new_head        = old_head;
+        new_head.pos.wr = old_head.pos.rd;
+    } while (!__atomic_compare_exchange_n(&p_fifo->head.tag, &old_head.tag, new_head.tag,
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+
+static bool nrf_atfifo_space_clear(nrf_atfifo_t * const p_fifo)
+{
+    bool ret;
+    nrf_atfifo_postag_t old_head;
+    nrf_atfifo_postag_t new_head;
+    nrf_atfifo_postag_t tail;
+
+    old_head.tag = __atomic_load_n(&p_fifo->head.tag, __ATOMIC_ACQUIRE);
+    do
+    {
+        tail.tag        = __atomic_load_n(&p_fifo->tail.tag, __ATOMIC_ACQUIRE);
+        new_head.pos.rd = tail.pos.rd;
+        if (old_head.pos.wr == old_head.pos.rd)
+        {
+            /* No read in progress, release everything up to the read tail */
+            new_head.pos.wr = tail.pos.rd;
+            ret = (tail.pos.wr == tail.pos.rd);
+        }
+        else
+        {
+            new_head.pos.wr = old_head.pos.wr;
+            ret = false;
+        }
+    } while (!__atomic_compare_exchange_n(&p_fifo->head.tag, &old_head.tag, new_head.tag,
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return ret;
+}
+
 #elif defined ( __ICCARM__ ) || defined ( __GNUC__ )
 
 bool nrf_atfifo_wspace_req(nrf_atfifo_t * const p_fifo, nrf_atfifo_postag_t * const p_old_tail)
@@ -54,6 +54,8 @@
 #include "nrf_fstorage_sd.h"
 #elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
 #include "nrf_fstorage_nvmc.h"
+#elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+#include "nrf_fstorage_host.h"
 #else
 #error Invalid FDS backend.
 #endif
@@ -1658,6 +1660,10 @@ ret_code_t fds_register(fds_cb_t cb)
 
 static uint32_t flash_end_addr(void)
 {
+#if (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    // The host image only holds the FDS and reserved pages, there is no code or bootloader to skip.
+    return nrf_fstorage_host_end_addr() - (FDS_PHY_PAGES_RESERVED * FDS_PHY_PAGE_SIZE * sizeof(uint32_t));
+#else
     uint32_t const bootloader_addr = BOOTLOADER_ADDRESS;
     uint32_t const page_sz         = NRF_FICR->CODEPAGESIZE;
 
@@ -1673,6 +1679,7 @@ static uint32_t flash_end_addr(void)
     uint32_t end_addr = (bootloader_addr != 0xFFFFFFFF) ? bootloader_addr : (code_sz * page_sz);
 
     return end_addr - (FDS_PHY_PAGES_RESERVED * FDS_PHY_PAGE_SIZE * sizeof(uint32_t));
+#endif
 }
 
 
@@ -1692,6 +1699,8 @@ static ret_code_t flash_subsystem_init(void)
         return nrf_fstorage_init(&m_fs, &nrf_fstorage_sd, NULL);
     #elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
         return nrf_fstorage_init(&m_fs, &nrf_fstorage_nvmc, NULL);
+    #elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+        return nrf_fstorage_init(&m_fs, &nrf_fstorage_host, NULL);
     #else
         #error Invalid FDS_BACKEND.
     #endif
@@ -2149,6 +2158,24 @@ ret_code_t fds_record_id_from_desc(fds_record_desc_t const * const p_desc,
 }
 
 
+ret_code_t fds_latest_record_id_get(uint32_t * const p_record_id)
+{
+    if (!m_flags.initialized)
+    {
+        return FDS_ERR_NOT_INITIALIZED;
+    }
+
+    if (p_record_id == NULL)
+    {
+        return FDS_ERR_NULL_ARG;
+    }
+
+    *p_record_id = m_latest_rec_id;
+
+    return NRF_SUCCESS;
+}
+
+
 ret_code_t fds_stat(fds_stat_t * const p_stat)
 {
     uint16_t const words_in_page = FDS_PAGE_SIZE;
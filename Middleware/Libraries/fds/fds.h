@@ -679,6 +679,21 @@ ret_code_t fds_record_id_from_desc(fds_record_desc_t const * p_desc,
                                    uint32_t                * p_record_id);
 
 
+/**@brief   Function for retrieving the latest record ID issued.
+ *
+ * Record IDs are issued in increasing order. Comparing the latest record ID to one obtained
+ * earlier tells whether any record was written since, and which records are newer.
+ *
+ * @param[out]  p_record_id     The latest record ID issued, as found during initialization
+ *                              and updated by every write since.
+ *
+ * @retval  NRF_SUCCESS                 If the record ID was returned successfully.
+ * @retval  FDS_ERR_NOT_INITIALIZED     If the module is not initialized.
+ * @retval  FDS_ERR_NULL_ARG            If @p p_record_id is NULL.
+ */
+ret_code_t fds_latest_record_id_get(uint32_t * p_record_id);
+
+
 /**@brief   Function for retrieving file system statistics.
  *
  * This function retrieves file system statistics, such as the number of open records, the space
@@ -78,6 +78,7 @@ extern "C" {
 
 #define NRF_FSTORAGE_NVMC       1
 #define NRF_FSTORAGE_SD         2
+#define NRF_FSTORAGE_HOST       3
 
 // The size of a physical page, in 4-byte words.
 #if defined(NRF51)
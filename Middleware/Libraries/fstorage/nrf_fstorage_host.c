@@ -0,0 +1,359 @@
+/* ---------------------------   fstorage host backend for Linux   ----------------------------- */
+/*  File      -  fstorage memory-mapped image backend source file                                */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include "sdk_common.h"
+
+#if NRF_MODULE_ENABLED(NRF_FSTORAGE)
+
+#include "nrf_fstorage_host.h"
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "nrf_atomic.h"
+
+
+/* Same geometry as the nRF52 flash. */
+static nrf_fstorage_info_t m_flash_info =
+{
+    .erase_unit   = 4096,
+    .program_unit = 4,
+    .rmap         = true,
+    .wmap         = false,
+};
+
+
+/* Mapped image. */
+static int       m_image_fd = -1;
+static uint32_t  m_image_addr;
+static uint32_t  m_image_size;
+
+/* Operation counters. */
+static nrf_fstorage_host_stats_t m_stats;
+
+/* An operation initiated by fstorage is ongoing. */
+static nrf_atomic_flag_t m_flash_operation_ongoing;
+
+
+/* Send event to the event handler. */
+static void event_send(nrf_fstorage_t        const * p_fs,
+                       nrf_fstorage_evt_id_t         evt_id,
+                       void const *                  p_src,
+                       uint32_t                      addr,
+                       uint32_t                      len,
+                       void                        * p_param)
+{
+    if (p_fs->evt_handler == NULL)
+    {
+        /* Nothing to do. */
+        return;
+    }
+
+    nrf_fstorage_evt_t evt =
+    {
+        .result  = NRF_SUCCESS,
+        .id      = evt_id,
+        .addr    = addr,
+        .p_src   = p_src,
+        .len     = len,
+        .p_param = p_param,
+    };
+
+    p_fs->evt_handler(&evt);
+}
+
+
+/* Open up the pages spanning [addr, addr + len) for writing, or seal them again. */
+static void image_unlock(uint32_t addr, uint32_t len, bool unlock)
+{
+    uint32_t const first = addr & ~(m_flash_info.erase_unit - 1);
+    uint32_t const last  = (addr + len + m_flash_info.erase_unit - 1) & ~(m_flash_info.erase_unit - 1);
+
+    (void) mprotect((void *)(uintptr_t)first,
+                    last - first,
+                    unlock ? (PROT_READ | PROT_WRITE) : PROT_READ);
+}
+
+
+static bool in_image(uint32_t addr, uint32_t len)
+{
+    return (m_image_fd >= 0)
+        && (addr >= m_image_addr)
+        && ((uint64_t)addr + len <= (uint64_t)m_image_addr + m_image_size);
+}
+
+
+static ret_code_t init(nrf_fstorage_t * p_fs, void * p_param)
+{
+    UNUSED_PARAMETER(p_param);
+
+    if (!in_image(p_fs->start_addr, p_fs->end_addr - p_fs->start_addr))
+    {
+        /* The image must be opened first and cover the whole instance. */
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    p_fs->p_flash_info = &m_flash_info;
+
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t uninit(nrf_fstorage_t * p_fs, void * p_param)
+{
+    UNUSED_PARAMETER(p_fs);
+    UNUSED_PARAMETER(p_param);
+
+    (void) nrf_atomic_flag_clear(&m_flash_operation_ongoing);
+
+    return NRF_SUCCESS;
+}
+
+
+/* Named after the image so they don't clash with read() and write() from unistd.h. */
+static ret_code_t image_read(nrf_fstorage_t const * p_fs, uint32_t src, void * p_dest, uint32_t len)
+{
+    UNUSED_PARAMETER(p_fs);
+
+    memcpy(p_dest, (uint32_t *)(uintptr_t)src, len);
+
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t image_write(nrf_fstorage_t const * p_fs,
+                              uint32_t               dest,
+                              void           const * p_src,
+                              uint32_t               len,
+                              void                 * p_param)
+{
+    if (!in_image(dest, len))
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+
+    if (nrf_atomic_flag_set_fetch(&m_flash_operation_ongoing))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    uint32_t       * p_dest = (uint32_t *)(uintptr_t)dest;
+    uint8_t  const * p_data = (uint8_t const *)p_src;
+
+    image_unlock(dest, len, true);
+
+    for (uint32_t i = 0; i < (len / m_flash_info.program_unit); i++)
+    {
+        uint32_t word;
+
+        /* Source buffers don't have to be word-aligned. */
+        memcpy(&word, p_data + (i * sizeof(uint32_t)), sizeof(uint32_t));
+
+        /* The NVMC only allows a limited number of writes to a word between erases. */
+        if (p_dest[i] != 0xFFFFFFFF)
+        {
+            m_stats.words_overwritten++;
+        }
+
+        /* Programming can only clear bits. */
+        p_dest[i] &= word;
+        m_stats.words_written++;
+    }
+
+    image_unlock(dest, len, false);
+
+    /* Clear the flag before sending the event, to allow API calls in the event context. */
+    (void) nrf_atomic_flag_clear(&m_flash_operation_ongoing);
+
+    event_send(p_fs, NRF_FSTORAGE_EVT_WRITE_RESULT, p_src, dest, len, p_param);
+
+    return NRF_SUCCESS;
+}
+
+
+static ret_code_t erase(nrf_fstorage_t const * p_fs,
+                        uint32_t               page_addr,
+                        uint32_t               len,
+                        void                 * p_param)
+{
+    if (!in_image(page_addr, len * m_flash_info.erase_unit))
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+
+    if (nrf_atomic_flag_set_fetch(&m_flash_operation_ongoing))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    image_unlock(page_addr, len * m_flash_info.erase_unit, true);
+    memset((void *)(uintptr_t)page_addr, 0xFF, len * m_flash_info.erase_unit);
+    image_unlock(page_addr, len * m_flash_info.erase_unit, false);
+
+    m_stats.pages_erased += len;
+
+    /* Clear the flag before sending the event, to allow API calls in the event context. */
+    (void) nrf_atomic_flag_clear(&m_flash_operation_ongoing);
+
+    event_send(p_fs, NRF_FSTORAGE_EVT_ERASE_RESULT, NULL, page_addr, len, p_param);
+
+    return NRF_SUCCESS;
+}
+
+
+static uint8_t const * rmap(nrf_fstorage_t const * p_fs, uint32_t addr)
+{
+    UNUSED_PARAMETER(p_fs);
+
+    return (uint8_t *)(uintptr_t)addr;
+}
+
+
+static uint8_t * wmap(nrf_fstorage_t const * p_fs, uint32_t addr)
+{
+    UNUSED_PARAMETER(p_fs);
+    UNUSED_PARAMETER(addr);
+
+    /* Not supported. */
+    return NULL;
+}
+
+
+static bool is_busy(nrf_fstorage_t const * p_fs)
+{
+    UNUSED_PARAMETER(p_fs);
+
+    return m_flash_operation_ongoing;
+}
+
+
+ret_code_t nrf_fstorage_host_image_open(char const * p_path, uint32_t addr, uint32_t size)
+{
+    struct stat st;
+    void      * p_map;
+
+    if (m_image_fd >= 0)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if ((addr % m_flash_info.erase_unit) || (size % m_flash_info.erase_unit) || (size == 0))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    int fd = open(p_path, O_RDWR | O_CREAT, 0644);
+    if ((fd < 0) || (fstat(fd, &st) != 0))
+    {
+        if (fd >= 0)
+        {
+            (void) close(fd);
+        }
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    /* Grow the image with erased pages. */
+    if (st.st_size < (off_t)size)
+    {
+        uint8_t erased[256];
+        off_t   offset = st.st_size;
+
+        memset(erased, 0xFF, sizeof(erased));
+        while (offset < (off_t)size)
+        {
+            size_t  chunk   = ((off_t)size - offset < (off_t)sizeof(erased)) ? (size_t)((off_t)size - offset)
+                                                                             : sizeof(erased);
+            ssize_t written = pwrite(fd, erased, chunk, offset);
+            if (written <= 0)
+            {
+                (void) close(fd);
+                return NRF_ERROR_NOT_FOUND;
+            }
+            offset += written;
+        }
+    }
+
+    /* The image must live at the requested address for flash addresses to be valid pointers. */
+#ifdef MAP_FIXED_NOREPLACE
+    p_map = mmap((void *)(uintptr_t)addr, size, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+#else
+    p_map = mmap((void *)(uintptr_t)addr, size, PROT_READ, MAP_SHARED, fd, 0);
+#endif
+    if ((p_map == MAP_FAILED) || (p_map != (void *)(uintptr_t)addr))
+    {
+        if (p_map != MAP_FAILED)
+        {
+            (void) munmap(p_map, size);
+        }
+        (void) close(fd);
+        return NRF_ERROR_NO_MEM;
+    }
+
+    m_image_fd   = fd;
+    m_image_addr = addr;
+    m_image_size = size;
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    return NRF_SUCCESS;
+}
+
+
+void nrf_fstorage_host_image_close(void)
+{
+    if (m_image_fd < 0)
+    {
+        return;
+    }
+
+    (void) msync((void *)(uintptr_t)m_image_addr, m_image_size, MS_SYNC);
+    (void) munmap((void *)(uintptr_t)m_image_addr, m_image_size);
+    (void) close(m_image_fd);
+
+    m_image_fd   = -1;
+    m_image_addr = 0;
+    m_image_size = 0;
+}
+
+
+uint32_t nrf_fstorage_host_end_addr(void)
+{
+    return (m_image_fd >= 0) ? (m_image_addr + m_image_size) : 0;
+}
+
+
+void nrf_fstorage_host_stats_get(nrf_fstorage_host_stats_t * p_stats)
+{
+    *p_stats = m_stats;
+}
+
+
+void nrf_fstorage_host_stats_reset(void)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+/* The exported API. */
+nrf_fstorage_api_t nrf_fstorage_host =
+{
+    .init    = init,
+    .uninit  = uninit,
+    .read    = image_read,
+    .write   = image_write,
+    .erase   = erase,
+    .rmap    = rmap,
+    .wmap    = wmap,
+    .is_busy = is_busy
+};
+
+
+#endif // NRF_FSTORAGE_ENABLED
@@ -0,0 +1,109 @@
+/* ---------------------------   fstorage host backend for Linux   ----------------------------- */
+/*  File      -  fstorage memory-mapped image backend header file                                */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * @file
+ *
+ * @defgroup nrf_fstorage_host Host implementation
+ * @ingroup nrf_fstorage
+ * @{
+ *
+ * @brief API implementation of fstorage that emulates the non-volatile memory controller (NVMC)
+ *        on a memory-mapped image file, so FDS and NVM_Service can run on a development machine.
+ *
+ * @details The image is mapped read-only at a fixed address below 4 GB, normally the address the
+ *          FDS area occupies in the device's flash, so that the 32-bit flash addresses FDS works
+ *          with are valid pointers on the host and image files are byte-for-byte identical to a
+ *          flash dump. Like the NVMC:
+ *            - Writes are word-aligned and can only clear bits. Bits written as 1 over a 0 stay 0.
+ *              Words written again before being erased are counted, as the NVMC only allows a
+ *              limited number of writes to a word between erases.
+ *            - Erasing a page sets all its bits back to 1.
+ *            - Flash can only be modified through this API. Stray stores into the mapped image
+ *              fault, much like they would on the device.
+ *          Operations complete synchronously and their events are sent before returning, like
+ *          with @ref nrf_fstorage_nvmc.
+ *
+ *          Host builds select this backend with -DFDS_BACKEND=3, use the compiler builtins for
+ *          nrf_atomic with -DNRF_ATOMIC_USE_BUILD_IN=1, put Project/Host first in the include path
+ *          and link with -no-pie and Project/Host/host_sections.ld.
+ */
+
+#ifndef NRF_FSTORAGE_HOST_H__
+#define NRF_FSTORAGE_HOST_H__
+
+#include "nrf_fstorage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**@brief   Operation counters, used to measure flash wear and write amplification. */
+typedef struct
+{
+    uint32_t words_written;         //!< Number of words programmed.
+    uint32_t pages_erased;          //!< Number of pages erased.
+    uint32_t words_overwritten;     //!< Number of words programmed again before being erased.
+} nrf_fstorage_host_stats_t;
+
+
+/**@brief   API implementation that emulates the non-volatile memory controller on an image file.
+ *
+ * @details An fstorage instance with this API implementation can be initialized by providing
+ *          this structure as a parameter to @ref nrf_fstorage_init, once an image has been
+ *          opened with @ref nrf_fstorage_host_image_open.
+ *          The structure is defined in @c nrf_fstorage_host.c.
+ */
+extern nrf_fstorage_api_t nrf_fstorage_host;
+
+
+/**@brief   Open a flash image file and map it into the address space.
+ *
+ * @details The file is created if it doesn't exist, and grown to @p size bytes if it is smaller.
+ *          Added space reads as erased flash (all bits set). Changes are written back to the file
+ *          as they're made, so images persist between runs.
+ *
+ * @param[in]   p_path  Path to the image file.
+ * @param[in]   addr    Flash address the first byte of the image is mapped to. Must be aligned to
+ *                      a flash page and lie below 4 GB.
+ * @param[in]   size    Size of the image, in bytes. Must be a multiple of the flash page size.
+ *
+ * @retval  NRF_SUCCESS             If the image was mapped successfully.
+ * @retval  NRF_ERROR_INVALID_STATE If an image is already open.
+ * @retval  NRF_ERROR_INVALID_PARAM If @p addr or @p size isn't aligned to a flash page.
+ * @retval  NRF_ERROR_NOT_FOUND     If the image file couldn't be opened or grown.
+ * @retval  NRF_ERROR_NO_MEM        If the image couldn't be mapped at @p addr.
+ */
+ret_code_t nrf_fstorage_host_image_open(char const * p_path, uint32_t addr, uint32_t size);
+
+
+/**@brief   Write back and unmap the image opened with @ref nrf_fstorage_host_image_open. */
+void nrf_fstorage_host_image_close(void);
+
+
+/**@brief   Get the flash address right after the end of the open image, or 0 if none is open. */
+uint32_t nrf_fstorage_host_end_addr(void);
+
+
+/**@brief   Copy operation counters accumulated since the image was opened or last reset.
+ *
+ * @param[out]  p_stats Operation counters.
+ */
+void nrf_fstorage_host_stats_get(nrf_fstorage_host_stats_t * p_stats);
+
+
+/**@brief   Reset operation counters. */
+void nrf_fstorage_host_stats_reset(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NRF_FSTORAGE_HOST_H__
+/** @} */
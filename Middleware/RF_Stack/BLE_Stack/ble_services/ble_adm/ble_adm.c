@@ -14,6 +14,9 @@
 #define BLE_ADM_COMMAND_CHAR_WRITE_REQUEST 1U
 #define BLE_ADM_COMMAND_CHAR_WRITE_COMMAND 1U
 #define BLE_ADM_STATUS_CHAR_NOTIFY         1U
+#define BLE_ADM_EXPORT_CHAR_NOTIFY         1U
+#define BLE_ADM_EXPORT_CHAR_WRITE_REQUEST  1U
+#define BLE_ADM_PROVISION_CHAR_WRITE_REQUEST 1U
 #define BLE_ADM_CCCD_SIZE                  2U
 #define BLE_ADM_NOTIF_EVT_LENGTH           2U
 #define BLE_ADM_GATTS_EVT_OFFSET           0U
@@ -36,6 +39,12 @@
     (CLIENT->bNotificationEnabled)    \
 )
 
+/* Export characteristic notification enabled assertion macro */
+#define BLE_ADM_EXPORT_NOTIF_ENABLED(CLIENT) \
+(                                            \
+    (CLIENT->bExportNotificationEnabled)     \
+)
+
 /* Data transfer length assertion macro */
 #define BLE_ADM_TX_LENGTH_ASSERT(DATA_LENGTH) \
 (                                             \
@@ -50,6 +59,14 @@
     BLE_ADM_TX_LENGTH_ASSERT(DATA_LENGTH)                        \
 )
 
+/* Valid bulk data transfer assertion macro */
+#define BLE_ADM_VALID_EXPORT(CLIENT, CONN_HANDLE, DATA_LENGTH) \
+(                                                              \
+    BLE_ADM_VALID_CONN_HANDLE(CLIENT, CONN_HANDLE) &&          \
+    BLE_ADM_EXPORT_NOTIF_ENABLED(CLIENT)           &&          \
+    BLE_ADM_TX_LENGTH_ASSERT(DATA_LENGTH)                      \
+)
+
 /************************************   PRIVATE FUNCTIONS   **************************************/
 static void vidPeerConnectedCallback(ble_adm_t *pstrAdmInstance, ble_evt_t const *pstrEvent)
 {
@@ -147,6 +164,42 @@ static void vidCharWrittenCallback(ble_adm_t *pstrAdmInstance, ble_evt_t const *
                     }
                 }
             }
+            else if((pstrWriteEvent->handle == pstrAdmInstance->strExportChar.cccd_handle) &&
+                    (pstrWriteEvent->len == BLE_ADM_NOTIF_EVT_LENGTH))
+            {
+                /* Gatts write event corresponds to notifications being enabled on the Export
+                   characteristic */
+                if (pstrClient)
+                {
+                    if (ble_srv_is_notification_enabled(pstrWriteEvent->data))
+                    {
+                        pstrClient->bExportNotificationEnabled = true;
+                        strEvent.enuEventType = BLE_ADM_EXPORT_NOTIF_ENABLED;
+                    }
+                    else
+                    {
+                        pstrClient->bExportNotificationEnabled = false;
+                        strEvent.enuEventType = BLE_ADM_EXPORT_NOTIF_DISABLED;
+                    }
+
+                    /* Invoke Admin User service's application-registered event handler */
+                    if (pstrAdmInstance->pfAdmEvtHandler)
+                    {
+                        pstrAdmInstance->pfAdmEvtHandler(&strEvent);
+                    }
+                }
+            }
+            else if((pstrWriteEvent->handle == pstrAdmInstance->strExportChar.value_handle) &&
+                    (pstrAdmInstance->pfAdmEvtHandler))
+            {
+                /* Gatts write event corresponds to an export request written to the Export
+                   characteristic. Invoke Admin User service's application-registered event
+                   handler */
+                strEvent.enuEventType = BLE_ADM_EXPORT_RX;
+                strEvent.strRxData.pu8Data = pstrWriteEvent->data;
+                strEvent.strRxData.u16Length = pstrWriteEvent->len;
+                pstrAdmInstance->pfAdmEvtHandler(&strEvent);
+            }
             else if((pstrWriteEvent->handle == pstrAdmInstance->strCmdChar.value_handle) &&
                     (pstrAdmInstance->pfAdmEvtHandler))
             {
@@ -162,6 +215,39 @@ static void vidCharWrittenCallback(ble_adm_t *pstrAdmInstance, ble_evt_t const *
     }
 }
 
+static void vidWriteAuthorizeCallback(ble_adm_t *pstrAdmInstance, ble_evt_t const *pstrEvent)
+{
+    /* Make sure valid arguments are passed */
+    if(pstrAdmInstance && pstrEvent)
+    {
+        ble_gatts_evt_rw_authorize_request_t const *pstrRequest = &pstrEvent->evt.gatts_evt.params.authorize_request;
+
+        /* Only single writes to the Provision characteristic are authorized here. Queued writes
+           are handled by the Queued Writes module */
+        if((BLE_GATTS_AUTHORIZE_TYPE_WRITE == pstrRequest->type) &&
+           (BLE_GATTS_OP_WRITE_REQ == pstrRequest->request.write.op) &&
+           (pstrRequest->request.write.handle == pstrAdmInstance->strProvisionChar.value_handle))
+        {
+            ble_gatts_rw_authorize_reply_params_t strReply;
+
+            memset(&strReply, 0, sizeof(strReply));
+            strReply.type = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+            strReply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+            strReply.params.write.update = 1;
+            strReply.params.write.offset = pstrRequest->request.write.offset;
+            strReply.params.write.len = pstrRequest->request.write.len;
+            strReply.params.write.p_data = pstrRequest->request.write.data;
+            if(NRF_SUCCESS == sd_ble_gatts_rw_authorize_reply(pstrEvent->evt.gatts_evt.conn_handle, &strReply))
+            {
+                vidBleAdmProvisionReceived(pstrAdmInstance,
+                                           pstrEvent->evt.gatts_evt.conn_handle,
+                                           pstrRequest->request.write.data,
+                                           pstrRequest->request.write.len);
+            }
+        }
+    }
+}
+
 static void vidNotificationSentCallback(ble_adm_t *pstrAdmInstance, ble_evt_t const *pstrEvent)
 {
     /* Make sure valid arguments are passed */
@@ -184,6 +270,21 @@ static void vidNotificationSentCallback(ble_adm_t *pstrAdmInstance, ble_evt_t co
                 strEvent.pstrLinkCtx = pstrClient;
                 pstrAdmInstance->pfAdmEvtHandler(&strEvent);
             }
+
+            if((pstrClient->bExportNotificationEnabled) && (pstrAdmInstance->pfAdmEvtHandler))
+            {
+                /* Notification queue room was freed. The Softdevice reports completed
+                   notifications per link rather than per characteristic, so the count may include
+                   other services' notifications */
+                BleAdm_tstrEvent strEvent;
+                memset(&strEvent, 0, sizeof(BleAdm_tstrEvent));
+                strEvent.enuEventType = BLE_ADM_EXPORT_TX;
+                strEvent.pstrAdmInstance = pstrAdmInstance;
+                strEvent.u16ConnHandle = pstrEvent->evt.gatts_evt.conn_handle;
+                strEvent.pstrLinkCtx = pstrClient;
+                strEvent.u8TxCount = pstrEvent->evt.gatts_evt.params.hvn_tx_complete.count;
+                pstrAdmInstance->pfAdmEvtHandler(&strEvent);
+            }
         }
     }
 }
@@ -216,6 +317,12 @@ void vidBleAdmEventHandler(ble_evt_t const *pstrEvent, void *pvArg)
         }
         break;
 
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+        {
+            vidWriteAuthorizeCallback(pstrAdmInstance, pstrEvent);
+        }
+        break;
+
         default:
             /* Nothing to do */
             break;
@@ -256,6 +363,62 @@ Mid_tenuStatus enuBleAdmTransferData(ble_adm_t *pstrAdmInstance, uint8_t *pu8Dat
     return enuRetVal;
 }
 
+Mid_tenuStatus enuBleAdmExportData(ble_adm_t *pstrAdmInstance, uint8_t *pu8Data, uint16_t *pu16DataLength, uint16_t u16ConnHandle)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    /* Make sure valid arguments are passed */
+    if(pstrAdmInstance && pu8Data && pu16DataLength)
+    {
+        BleAdm_tstrClientCtx *pstrClient;
+        ble_gatts_hvx_params_t strHvxParams;
+
+        /* Fetch link context from link registry based on connection handle */
+        if(NRF_SUCCESS == blcm_link_ctx_get(pstrAdmInstance->pstrLinkCtx, u16ConnHandle, (void *)&pstrClient))
+        {
+            /* Ensure connection handle and data validity */
+            if(BLE_ADM_VALID_EXPORT(pstrClient, u16ConnHandle, *pu16DataLength))
+            {
+                /* Send notification to Export characteristic */
+                memset(&strHvxParams, 0, sizeof(strHvxParams));
+                strHvxParams.handle = pstrAdmInstance->strExportChar.value_handle;
+                strHvxParams.p_data = pu8Data;
+                strHvxParams.p_len = pu16DataLength;
+                strHvxParams.type = BLE_GATT_HVX_NOTIFICATION;
+                enuRetVal = (NRF_SUCCESS == sd_ble_gatts_hvx(u16ConnHandle,
+                                                             &strHvxParams))
+                                                             ?Middleware_Success
+                                                             :Middleware_Failure;
+            }
+        }
+    }
+
+    return enuRetVal;
+}
+
+void vidBleAdmProvisionReceived(ble_adm_t *pstrAdmInstance, uint16_t u16ConnHandle, uint8_t const *pu8Data, uint16_t u16Length)
+{
+    /* Make sure valid arguments are passed */
+    if(pstrAdmInstance && pu8Data && (pstrAdmInstance->pfAdmEvtHandler))
+    {
+        /* Fetch link context from link registry based on connection handle */
+        BleAdm_tstrClientCtx *pstrClient;
+        if(NRF_SUCCESS == blcm_link_ctx_get(pstrAdmInstance->pstrLinkCtx, u16ConnHandle, (void *)&pstrClient))
+        {
+            /* Invoke Admin User service's application-registered event handler */
+            BleAdm_tstrEvent strEvent;
+            memset(&strEvent, 0, sizeof(BleAdm_tstrEvent));
+            strEvent.enuEventType = BLE_ADM_PROVISION_RX;
+            strEvent.pstrAdmInstance = pstrAdmInstance;
+            strEvent.u16ConnHandle = u16ConnHandle;
+            strEvent.pstrLinkCtx = pstrClient;
+            strEvent.strRxData.pu8Data = pu8Data;
+            strEvent.strRxData.u16Length = u16Length;
+            pstrAdmInstance->pfAdmEvtHandler(&strEvent);
+        }
+    }
+}
+
 Mid_tenuStatus enuBleAdmInit(ble_adm_t *pstrAdmInstance, BleAdm_tstrInit const *pstrAdmInit)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
@@ -306,11 +469,48 @@ Mid_tenuStatus enuBleAdmInit(ble_adm_t *pstrAdmInstance, BleAdm_tstrInit const *
                     strCharacteristic.read_access = SEC_OPEN;
                     strCharacteristic.write_access = SEC_OPEN;
                     strCharacteristic.cccd_write_access = SEC_OPEN;
-                    enuRetVal = (NRF_SUCCESS == characteristic_add(pstrAdmInstance->u16ServiceHandle,
-                                                                   &strCharacteristic,
-                                                                   &pstrAdmInstance->strStatusChar))
-                                                                   ?Middleware_Success
-                                                                   :Middleware_Failure;
+                    if(NRF_SUCCESS == characteristic_add(pstrAdmInstance->u16ServiceHandle,
+                                                         &strCharacteristic,
+                                                         &pstrAdmInstance->strStatusChar))
+                    {
+                        /* Add Export characteristic. Peer writes where to start from and data
+                           is streamed back as notifications */
+                        memset(&strCharacteristic, 0, sizeof(strCharacteristic));
+                        strCharacteristic.uuid = BLE_ADM_EXPORT_CHAR_UUID;
+                        strCharacteristic.uuid_type = pstrAdmInstance->u8UuidType;
+                        strCharacteristic.max_len = BLE_ADM_MAX_DATA_LENGTH;
+                        strCharacteristic.init_len = sizeof(uint8_t);
+                        strCharacteristic.is_var_len = true;
+                        strCharacteristic.char_props.notify = BLE_ADM_EXPORT_CHAR_NOTIFY;
+                        strCharacteristic.char_props.write = BLE_ADM_EXPORT_CHAR_WRITE_REQUEST;
+                        strCharacteristic.read_access = SEC_OPEN;
+                        strCharacteristic.write_access = SEC_OPEN;
+                        strCharacteristic.cccd_write_access = SEC_OPEN;
+                        if(NRF_SUCCESS == characteristic_add(pstrAdmInstance->u16ServiceHandle,
+                                                             &strCharacteristic,
+                                                             &pstrAdmInstance->strExportChar))
+                        {
+                            /* Add Provision characteristic. Peer writes a list of users to add,
+                               usually through queued writes as it exceeds a single write */
+                            memset(&strCharacteristic, 0, sizeof(strCharacteristic));
+                            strCharacteristic.uuid = BLE_ADM_PROVISION_CHAR_UUID;
+                            strCharacteristic.uuid_type = pstrAdmInstance->u8UuidType;
+                            strCharacteristic.max_len = BLE_ADM_PROVISION_MAX_LENGTH;
+                            strCharacteristic.init_len = sizeof(uint8_t);
+                            strCharacteristic.p_init_value = pstrAdmInstance->u8ProvisionValue;
+                            strCharacteristic.is_value_user = true;
+                            strCharacteristic.is_var_len = true;
+                            strCharacteristic.is_defered_write = true;
+                            strCharacteristic.char_props.write = BLE_ADM_PROVISION_CHAR_WRITE_REQUEST;
+                            strCharacteristic.read_access = SEC_OPEN;
+                            strCharacteristic.write_access = SEC_OPEN;
+                            enuRetVal = (NRF_SUCCESS == characteristic_add(pstrAdmInstance->u16ServiceHandle,
+                                                                           &strCharacteristic,
+                                                                           &pstrAdmInstance->strProvisionChar))
+                                                                           ?Middleware_Success
+                                                                           :Middleware_Failure;
+                        }
+                    }
                 }
             }
         }
@@ -20,6 +20,12 @@
 #define BLE_ADM_UUID_SERVICE      0xACDC
 #define BLE_ADM_COMMAND_CHAR_UUID 0xACDD
 #define BLE_ADM_STATUS_CHAR_UUID  0xACDE
+#define BLE_ADM_EXPORT_CHAR_UUID  0xACDF
+#define BLE_ADM_PROVISION_CHAR_UUID 0xACE0
+
+/* Provision characteristic's maximum length. Values this long can only be written through
+   queued writes */
+#define BLE_ADM_PROVISION_MAX_LENGTH BLE_GATTS_VAR_ATTR_LEN_MAX
 
 /**************************************   PUBLIC MACROS   ****************************************/
 #define BLE_ADM_DEF(name, max_clients)                          \
@@ -45,10 +51,15 @@ typedef struct ble_adm_s ble_adm_t;
 */
 typedef enum
 {
-    BLE_ADM_NOTIF_ENABLED = 0, /* Peer enabled notifications on Status characteristic   */
-    BLE_ADM_NOTIF_DISABLED,    /* Peer disabled notifications on Status characteristic  */
-    BLE_ADM_STATUS_TX,         /* Peer notified of service status                       */
-    BLE_ADM_CMD_RX             /* Received data from peer on the command characteristic */
+    BLE_ADM_NOTIF_ENABLED = 0,    /* Peer enabled notifications on Status characteristic   */
+    BLE_ADM_NOTIF_DISABLED,       /* Peer disabled notifications on Status characteristic  */
+    BLE_ADM_STATUS_TX,            /* Peer notified of service status                       */
+    BLE_ADM_CMD_RX,               /* Received data from peer on the command characteristic */
+    BLE_ADM_EXPORT_NOTIF_ENABLED, /* Peer enabled notifications on Export characteristic   */
+    BLE_ADM_EXPORT_NOTIF_DISABLED,/* Peer disabled notifications on Export characteristic  */
+    BLE_ADM_EXPORT_TX,            /* Notifications sent, Export characteristic has room    */
+    BLE_ADM_EXPORT_RX,            /* Received data from peer on the Export characteristic  */
+    BLE_ADM_PROVISION_RX          /* Received data from peer on the Provision charac       */
 }BleAdm_tenuEventType;
 
 /**
@@ -56,7 +67,8 @@ typedef enum
 */
 typedef struct
 {
-    bool bNotificationEnabled; /* Indicates whether peer has enabled notification on Status characteristic */
+    bool bNotificationEnabled;       /* Indicates whether peer has enabled notification on Status characteristic */
+    bool bExportNotificationEnabled; /* Indicates whether peer has enabled notification on Export characteristic */
 }BleAdm_tstrClientCtx;
 
 /**
@@ -78,6 +90,7 @@ typedef struct
     uint16_t u16ConnHandle;            /* Connection Handle                            */
     BleAdm_tstrClientCtx *pstrLinkCtx; /* Pointer to link context                      */
     BleAdm_tstrRxData strRxData;       /* Received data upon a GATT client write event */
+    uint8_t u8TxCount;                 /* Number of notifications sent over the link   */
 }BleAdm_tstrEvent;
 
 /**
@@ -110,6 +123,11 @@ struct ble_adm_s
     uint16_t u16ServiceHandle; /* Admin User service's handle as provided by the BLE stack */
     ble_gatts_char_handles_t strCmdChar;        /* Command characteristic handles          */
     ble_gatts_char_handles_t strStatusChar;     /* Status characteristic handles           */
+    ble_gatts_char_handles_t strExportChar;     /* Export characteristic handles           */
+    ble_gatts_char_handles_t strProvisionChar;  /* Provision characteristic handles        */
+    uint8_t u8ProvisionValue[BLE_ADM_PROVISION_MAX_LENGTH]; /* Provision characteristic value,
+                                                               kept out of the Softdevice's
+                                                               attribute table */
     blcm_link_ctx_storage_t *const pstrLinkCtx; /* Pointer to link context storage         */
     BleAdmEventHandler pfAdmEvtHandler;         /* Admin User service's event handler      */
 };
@@ -145,6 +163,41 @@ void vidBleAdmEventHandler(ble_evt_t const *pstrEvent, void *pvArg);
  */
 Mid_tenuStatus enuBleAdmTransferData(ble_adm_t *pstrAdmInstance, uint8_t *pu8Data, uint16_t *pu16DataLength, uint16_t u16ConnHandle);
 
+/**
+ * @brief enuBleAdmExportData Queues a chunk of bulk data for transfer to peer over BLE.
+ *
+ * @note  This function sends data as a notification to the Admin User service's Export
+ *        characteristic. Unlike Status notifications, chunks are meant to be queued back to back
+ *        until the Softdevice runs out of room, then topped up again upon receiving a
+ *        BLE_ADM_EXPORT_TX event.
+ *
+ * @param pstrAdmInstance Pointer to the Admin User instance structure.
+ * @param pu8Data Pointer to data buffer.
+ * @param pu16DataLength Pointer to data length in bytes.
+ * @param u16ConnHandle Connection Handle of the destination client.
+ *
+ * @return Mid_tenuStatus Middleware_Success if chunk was queued successfully,
+ *         Middleware_Failure otherwise, including when the notification queue is full.
+ */
+Mid_tenuStatus enuBleAdmExportData(ble_adm_t *pstrAdmInstance, uint8_t *pu8Data, uint16_t *pu16DataLength, uint16_t u16ConnHandle);
+
+/**
+ * @brief vidBleAdmProvisionReceived Reports a Provision characteristic value assembled out of
+ *        queued writes.
+ *
+ * @note  Writes to the Provision characteristic need authorizing. Single writes are authorized
+ *        by the service itself, queued writes are left to the Queued Writes module which hands
+ *        over the assembled value through this function once peer executes them.
+ *
+ * @param pstrAdmInstance Pointer to the Admin User instance structure.
+ * @param u16ConnHandle Connection Handle of the writing client.
+ * @param pu8Data Pointer to assembled value.
+ * @param u16Length Length of assembled value in bytes.
+ *
+ * @return nothing.
+ */
+void vidBleAdmProvisionReceived(ble_adm_t *pstrAdmInstance, uint16_t u16ConnHandle, uint8_t const *pu8Data, uint16_t u16Length);
+
 /**
  * @brief enuBleAdmInit Initializes WiPad's Admin user BLE service.
  *
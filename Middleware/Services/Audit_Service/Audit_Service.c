@@ -0,0 +1,687 @@
+/* ----------------------------   Audit Service for nRF52832   --------------------------------- */
+/*  File      -  Audit Service source file                                                       */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/****************************************   INCLUDES   *******************************************/
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Audit_Service.h"
+#include "BLE_Service.h"
+#include "Maths.h"
+#include "sdk_config.h"
+#include "fds.h"
+#include "fds_internal_defs.h"
+#include "nrf_fstorage.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+
+#if   (FDS_BACKEND == NRF_FSTORAGE_SD)
+#include "nrf_fstorage_sd.h"
+#elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
+#include "nrf_fstorage_nvmc.h"
+#elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+#include "nrf_fstorage_host.h"
+#endif
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define AUDIT_PAGE_SIZE          4096U
+#define AUDIT_ENTRIES_PER_PAGE   (AUDIT_PAGE_SIZE / AUDIT_ENTRY_SIZE)
+#define AUDIT_ENTRY_WORDS        (AUDIT_ENTRY_SIZE / sizeof(uint32_t))
+#define AUDIT_ID_LENGTH          8U
+#define AUDIT_ERASED_WORD        0xFFFFFFFF
+#define AUDIT_TIME_MAGIC         0x41544D45
+
+/* Flash space above the journal: FDS's pages, those it is told to leave alone and NVM_Service's
+   usage counter pages */
+#define AUDIT_SPACE_ABOVE        (((FDS_VIRTUAL_PAGES + FDS_VIRTUAL_PAGES_RESERVED) * FDS_VIRTUAL_PAGE_SIZE * 4) + \
+                                  (MID_NVM_COUNTER_PAGES * AUDIT_PAGE_SIZE))
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Audit_tstrPageSummary Journal page summary, kept in RAM.
+ *
+ * @note Entries appended before time was first set carry no timestamp and are left out of the
+ *       time bounds.
+*/
+typedef struct
+{
+    uint32_t u32MinEpoch; /* Earliest entry timestamp in the page, UINT32_MAX if none */
+    uint32_t u32MaxEpoch; /* Latest entry timestamp in the page, 0 if none           */
+    uint16_t u16Count;    /* Number of timestamped entries in the page               */
+}Audit_tstrPageSummary;
+
+/**
+ * Audit_tstrTimeCheckpoint Time reached before entering System OFF, kept in retained RAM.
+*/
+typedef struct
+{
+    uint32_t u32Magic;    /* AUDIT_TIME_MAGIC while valid                  */
+    uint32_t u32Epoch;    /* Time carried forward up to System OFF         */
+    uint32_t u32Check;    /* Check value computed over the other fields    */
+}Audit_tstrTimeCheckpoint;
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Compute journal page holding a given sequence number */
+#define AUDIT_PAGE_OF(sequence) (((sequence) / AUDIT_ENTRIES_PER_PAGE) % MID_AUDIT_PAGES)
+
+/* Compute flash address of the entry holding a given sequence number */
+#define AUDIT_ENTRY_ADDR(sequence)                                                   \
+(                                                                                    \
+    strAuditFs.start_addr + (AUDIT_PAGE_OF(sequence) * AUDIT_PAGE_SIZE) +            \
+    (((sequence) % AUDIT_ENTRIES_PER_PAGE) * AUDIT_ENTRY_SIZE)                       \
+)
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Flag indicating whether Audit_Service is initialized */
+static bool bIsInitialized = false;
+
+/* Sequence number the next appended entry will be given */
+static uint32_t u32NextSequence = 0;
+
+/* Entries below this sequence number have been written to flash and can be read */
+static volatile uint32_t u32CommittedSequence = 0;
+
+/* First sequence number of the last page known to be erased and ready for entries */
+static uint32_t u32ReadyPageBase = 0;
+
+/* Last time reading and the tick count it was taken at */
+static uint32_t u32SyncEpoch = 0;
+static TickType_t xSyncTick = 0;
+
+/* Latest timestamp in the journal, appended entries are never timestamped earlier */
+static uint32_t u32LastEpoch = 0;
+
+/* Time known to have been reached before boot, 0 if none is */
+static uint32_t u32FloorEpoch = 0;
+
+/* Time reached before entering System OFF */
+static MID_RETAINED Audit_tstrTimeCheckpoint strTimeCheckpoint;
+
+/* Summary of every journal page, indexed the same way as flash pages */
+static Audit_tstrPageSummary strPageSummary[MID_AUDIT_PAGES];
+
+/* Entries being written. fstorage requires written data to remain available until the operation
+   completes. Operations are processed in order, so buffers are released in the order they were
+   acquired */
+static Audit_tstrEntry strEntryBuffer[MID_AUDIT_QUEUE_SIZE];
+static uint8_t u8EntryBufferHead = 0;
+static uint8_t u8EntryBufferCount = 0;
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static void vidAuditEventHandler(nrf_fstorage_evt_t *pstrEvent);
+
+/* Journal's flash area. Its bounds are set at initialization time */
+NRF_FSTORAGE_DEF(nrf_fstorage_t strAuditFs) =
+{
+    .evt_handler = vidAuditEventHandler,
+    .start_addr  = 0,
+    .end_addr    = 0
+};
+
+static uint32_t u32IdToBcd(uint8_t const *pu8Id)
+{
+    uint32_t u32RetVal = 0;
+
+    /* One nibble per digit, most significant digit first */
+    for(uint8_t u8Index = 0; u8Index < AUDIT_ID_LENGTH; u8Index++)
+    {
+        u32RetVal = (u32RetVal << 4) | (uint32_t)(pu8Id[u8Index] - '0');
+    }
+
+    return u32RetVal;
+}
+
+static uint16_t u16EntryCheck(Audit_tstrEntry const *pstrEntry)
+{
+    uint32_t u32Fold = pstrEntry->u32Sequence ^ pstrEntry->u32IdBcd ^ pstrEntry->u32Epoch ^
+                       ((uint32_t)pstrEntry->u8KeyType << 8) ^ (uint32_t)pstrEntry->u8Outcome;
+
+    /* Folded and inverted so that neither an erased nor a zeroed entry passes the check */
+    return (uint16_t)~((u32Fold >> 16) ^ (u32Fold & 0xFFFF));
+}
+
+static bool bEntryIsValid(Audit_tstrEntry const *pstrEntry, uint32_t u32Sequence)
+{
+    return (pstrEntry->u32Sequence == u32Sequence) &&
+           (pstrEntry->u8Outcome < Audit_MaxOutcomes) &&
+           (pstrEntry->u16Check == u16EntryCheck(pstrEntry));
+}
+
+static bool bFlashIsErased(uint32_t u32Addr, uint32_t u32Words)
+{
+    bool bRetVal = true;
+    uint32_t const *pu32Word = (uint32_t const *)(uintptr_t)u32Addr;
+
+    for(uint32_t u32Index = 0; bRetVal && (u32Index < u32Words); u32Index++)
+    {
+        bRetVal = (AUDIT_ERASED_WORD == pu32Word[u32Index]);
+    }
+
+    return bRetVal;
+}
+
+static uint32_t u32FlashEndAddr(void)
+{
+#if (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    /* The host image has no code or bootloader to skip */
+    return nrf_fstorage_host_end_addr();
+#else
+    /* Application's flash space ends at the bootloader, if there is one, or at the end of flash */
+    return (BOOTLOADER_ADDRESS != 0xFFFFFFFF)?BOOTLOADER_ADDRESS:(NRF_FICR->CODESIZE * NRF_FICR->CODEPAGESIZE);
+#endif
+}
+
+static uint32_t u32CurrentEpoch(void)
+{
+    uint32_t u32RetVal = 0;
+
+    /* Carry last time reading forward, time remains unknown until a first reading is made */
+    if(u32SyncEpoch)
+    {
+        u32RetVal = u32SyncEpoch + ((xTaskGetTickCount() - xSyncTick) / configTICK_RATE_HZ);
+    }
+
+    return u32RetVal;
+}
+
+static uint32_t u32TimeCheck(void)
+{
+    /* CRC-32 over the fields ahead of the check value */
+    return u32Crc32(&strTimeCheckpoint, offsetof(Audit_tstrTimeCheckpoint, u32Check));
+}
+
+static uint32_t u32OldestSequence(void)
+{
+    uint32_t u32RetVal = 0;
+    uint32_t u32HeadBase;
+
+    /* Oldest page is the one the newest entry's page will be erased to make room for */
+    if(u32NextSequence)
+    {
+        u32HeadBase = ((u32NextSequence - 1) / AUDIT_ENTRIES_PER_PAGE) * AUDIT_ENTRIES_PER_PAGE;
+
+        if(u32HeadBase >= ((MID_AUDIT_PAGES - 1) * AUDIT_ENTRIES_PER_PAGE))
+        {
+            u32RetVal = u32HeadBase - ((MID_AUDIT_PAGES - 1) * AUDIT_ENTRIES_PER_PAGE);
+        }
+    }
+
+    return u32RetVal;
+}
+
+static void vidSummaryReset(uint32_t u32PageBase)
+{
+    Audit_tstrPageSummary *pstrSummary = &strPageSummary[AUDIT_PAGE_OF(u32PageBase)];
+
+    /* Pages must keep time order for lookups. Latest time carries over from the previous page,
+       which places entries timestamped before time is set again after a reset right behind it */
+    pstrSummary->u32MaxEpoch = u32PageBase?strPageSummary[AUDIT_PAGE_OF(u32PageBase - 1)].u32MaxEpoch:0;
+    pstrSummary->u32MinEpoch = UINT32_MAX;
+    pstrSummary->u16Count = 0;
+}
+
+static void vidSummaryAdd(uint32_t u32Page, uint32_t u32Epoch)
+{
+    Audit_tstrPageSummary *pstrSummary = &strPageSummary[u32Page];
+
+    if(u32Epoch)
+    {
+        pstrSummary->u16Count++;
+        pstrSummary->u32MinEpoch = MIN(pstrSummary->u32MinEpoch, u32Epoch);
+        pstrSummary->u32MaxEpoch = MAX(pstrSummary->u32MaxEpoch, u32Epoch);
+    }
+}
+
+static void vidSummaryRebuild(void)
+{
+    Audit_tstrEntry const *pstrEntry;
+    uint32_t u32Oldest = u32OldestSequence();
+
+    /* Summaries aren't kept in flash, entries still in the journal are read back once at boot */
+    for(uint32_t u32Sequence = u32Oldest; u32Sequence < u32NextSequence; u32Sequence++)
+    {
+        pstrEntry = (Audit_tstrEntry const *)(uintptr_t)AUDIT_ENTRY_ADDR(u32Sequence);
+
+        if((u32Sequence % AUDIT_ENTRIES_PER_PAGE) == 0)
+        {
+            vidSummaryReset(u32Sequence);
+
+            /* Oldest page has nothing to carry time over from */
+            if(u32Sequence == u32Oldest)
+            {
+                strPageSummary[AUDIT_PAGE_OF(u32Sequence)].u32MaxEpoch = 0;
+            }
+        }
+
+        if(bEntryIsValid(pstrEntry, u32Sequence))
+        {
+            vidSummaryAdd(AUDIT_PAGE_OF(u32Sequence), pstrEntry->u32Epoch);
+        }
+    }
+}
+
+static void vidJournalRecover(void)
+{
+    Audit_tstrEntry const *pstrFirst;
+    bool bFound = false;
+    uint32_t u32HeadBase = 0;
+    uint32_t u32Slot;
+
+    /* An entry's sequence number is what locates it. The first entry of every page in use tells
+       which part of the journal that page holds, the newest one being the head */
+    for(uint32_t u32Page = 0; u32Page < MID_AUDIT_PAGES; u32Page++)
+    {
+        pstrFirst = (Audit_tstrEntry const *)(uintptr_t)(strAuditFs.start_addr + (u32Page * AUDIT_PAGE_SIZE));
+
+        if(((pstrFirst->u32Sequence % AUDIT_ENTRIES_PER_PAGE) == 0) &&
+           (AUDIT_PAGE_OF(pstrFirst->u32Sequence) == u32Page) &&
+           bEntryIsValid(pstrFirst, pstrFirst->u32Sequence) &&
+           (!bFound || (pstrFirst->u32Sequence > u32HeadBase)))
+        {
+            bFound = true;
+            u32HeadBase = pstrFirst->u32Sequence;
+        }
+    }
+
+    if(bFound)
+    {
+        /* Entries are appended in order, next one goes to the first erased slot. Torn entries
+           aren't erased and are skipped over */
+        for(u32Slot = AUDIT_ENTRIES_PER_PAGE; u32Slot > 1; u32Slot--)
+        {
+            if(!bFlashIsErased(AUDIT_ENTRY_ADDR(u32HeadBase + u32Slot - 1), AUDIT_ENTRY_WORDS))
+            {
+                break;
+            }
+        }
+
+        u32NextSequence = u32HeadBase + u32Slot;
+        u32ReadyPageBase = u32HeadBase;
+    }
+    else
+    {
+        /* Empty journal. First page gets checked for leftovers before the first entry */
+        u32NextSequence = 0;
+        u32ReadyPageBase = AUDIT_ERASED_WORD;
+    }
+
+    u32CommittedSequence = u32NextSequence;
+
+    vidSummaryRebuild();
+}
+
+static void vidAuditEventHandler(nrf_fstorage_evt_t *pstrEvent)
+{
+    /* Make sure valid arguments are passed */
+    if(pstrEvent && (NRF_FSTORAGE_EVT_WRITE_RESULT == pstrEvent->id))
+    {
+        CRITICAL_REGION_ENTER();
+
+        /* Entry data is no longer needed whatever the outcome. Entries that didn't make it to
+           flash fail their check and are skipped by readers */
+        if(u8EntryBufferCount)
+        {
+            u32CommittedSequence = strEntryBuffer[u8EntryBufferHead].u32Sequence + 1;
+            u8EntryBufferHead = (u8EntryBufferHead + 1) % MID_AUDIT_QUEUE_SIZE;
+            u8EntryBufferCount--;
+        }
+
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+Mid_tenuStatus enuAudit_Init(void)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    /* Journal sits right below FDS's pages and the usage counter pages */
+    strAuditFs.end_addr = u32FlashEndAddr() - AUDIT_SPACE_ABOVE;
+    strAuditFs.start_addr = strAuditFs.end_addr - (MID_AUDIT_PAGES * AUDIT_PAGE_SIZE);
+
+#if   (FDS_BACKEND == NRF_FSTORAGE_SD)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strAuditFs, &nrf_fstorage_sd, NULL))
+#elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strAuditFs, &nrf_fstorage_nvmc, NULL))
+#elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strAuditFs, &nrf_fstorage_host, NULL))
+#endif
+    {
+        vidJournalRecover();
+
+        /* Time went on while the device was off, by an unknown amount. What was reached before
+           still bounds it from below: the time saved on entering System OFF, or the latest
+           timestamp in the journal after any other reset */
+        for(uint32_t u32Page = 0; u32Page < MID_AUDIT_PAGES; u32Page++)
+        {
+            u32LastEpoch = MAX(u32LastEpoch, strPageSummary[u32Page].u32MaxEpoch);
+        }
+        u32FloorEpoch = u32LastEpoch;
+        if(bBleWokenFromSystemOff() && (AUDIT_TIME_MAGIC == strTimeCheckpoint.u32Magic) &&
+           (u32TimeCheck() == strTimeCheckpoint.u32Check))
+        {
+            u32FloorEpoch = MAX(u32FloorEpoch, strTimeCheckpoint.u32Epoch);
+        }
+        strTimeCheckpoint.u32Magic = 0;
+
+        bIsInitialized = true;
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuAudit_Append(uint8_t const *pu8Id, App_tenuKeyTypes enuKeyType, Audit_tenuOutcome enuOutcome)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    Audit_tstrEntry *pstrEntry;
+    uint32_t u32PageBase;
+    uint32_t u32PageAddr;
+    bool bReady = true;
+
+    /* Make sure valid arguments are passed */
+    if(bIsInitialized && pu8Id && (enuOutcome < Audit_MaxOutcomes))
+    {
+        /* Sequence numbers must reach flash in the order they're given out */
+        CRITICAL_REGION_ENTER();
+
+        if(u8EntryBufferCount < MID_AUDIT_QUEUE_SIZE)
+        {
+            u32PageBase = (u32NextSequence / AUDIT_ENTRIES_PER_PAGE) * AUDIT_ENTRIES_PER_PAGE;
+            u32PageAddr = AUDIT_ENTRY_ADDR(u32PageBase);
+
+            /* Page the journal moves into drops its oldest entries. The erase is queued ahead of
+               the write, which is enough for it to complete first */
+            if(u32PageBase != u32ReadyPageBase)
+            {
+                if(!bFlashIsErased(u32PageAddr, AUDIT_PAGE_SIZE / sizeof(uint32_t)))
+                {
+                    bReady = (NRF_SUCCESS == nrf_fstorage_erase(&strAuditFs, u32PageAddr, 1, NULL));
+                }
+
+                if(bReady)
+                {
+                    u32ReadyPageBase = u32PageBase;
+                    vidSummaryReset(u32PageBase);
+                }
+            }
+
+            if(bReady)
+            {
+                pstrEntry = &strEntryBuffer[(u8EntryBufferHead + u8EntryBufferCount) % MID_AUDIT_QUEUE_SIZE];
+                u8EntryBufferCount++;
+
+                pstrEntry->u32Sequence = u32NextSequence;
+                pstrEntry->u32IdBcd = u32IdToBcd(pu8Id);
+                /* Time is carried forward from the last reading and a later reading may step it
+                   back. Journal must stay in time order for range queries to stop at the first
+                   later entry, time known to be reached is kept instead */
+                pstrEntry->u32Epoch = u32CurrentEpoch();
+                if(pstrEntry->u32Epoch)
+                {
+                    pstrEntry->u32Epoch = MAX(pstrEntry->u32Epoch, u32LastEpoch);
+                }
+                pstrEntry->u8KeyType = (uint8_t)enuKeyType;
+                pstrEntry->u8Outcome = (uint8_t)enuOutcome;
+                pstrEntry->u16Check = u16EntryCheck(pstrEntry);
+
+                if(NRF_SUCCESS == nrf_fstorage_write(&strAuditFs, AUDIT_ENTRY_ADDR(u32NextSequence),
+                                                     pstrEntry, AUDIT_ENTRY_SIZE, NULL))
+                {
+                    vidSummaryAdd(AUDIT_PAGE_OF(u32NextSequence), pstrEntry->u32Epoch);
+                    u32LastEpoch = MAX(u32LastEpoch, pstrEntry->u32Epoch);
+                    u32NextSequence++;
+                    enuRetVal = Middleware_Success;
+                }
+                else
+                {
+                    /* Buffer was the last one acquired, hand it back */
+                    u8EntryBufferCount--;
+                }
+            }
+        }
+
+        CRITICAL_REGION_EXIT();
+    }
+
+    return enuRetVal;
+}
+
+void vidAudit_SetTime(uint32_t u32Epoch)
+{
+    CRITICAL_REGION_ENTER();
+
+    u32SyncEpoch = u32Epoch;
+    xSyncTick = xTaskGetTickCount();
+
+    CRITICAL_REGION_EXIT();
+}
+
+uint32_t u32Audit_GetTime(void)
+{
+    uint32_t u32RetVal;
+
+    CRITICAL_REGION_ENTER();
+
+    u32RetVal = u32CurrentEpoch();
+
+    CRITICAL_REGION_EXIT();
+
+    return u32RetVal;
+}
+
+uint32_t u32Audit_GetMinimumTime(void)
+{
+    uint32_t u32RetVal;
+
+    CRITICAL_REGION_ENTER();
+
+    /* Time known before boot is carried forward like a reading, until an actual reading is made */
+    u32RetVal = u32CurrentEpoch();
+    if(!u32RetVal && u32FloorEpoch)
+    {
+        u32RetVal = u32FloorEpoch + (xTaskGetTickCount() / configTICK_RATE_HZ);
+    }
+
+    CRITICAL_REGION_EXIT();
+
+    return u32RetVal;
+}
+
+Mid_tenuStatus enuAudit_SaveCheckpoint(void)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    uint32_t u32Epoch = u32Audit_GetMinimumTime();
+
+    /* Nothing worth keeping unless time was known at some point */
+    if(u32Epoch)
+    {
+        CRITICAL_REGION_ENTER();
+
+        strTimeCheckpoint.u32Magic = AUDIT_TIME_MAGIC;
+        strTimeCheckpoint.u32Epoch = u32Epoch;
+        strTimeCheckpoint.u32Check = u32TimeCheck();
+
+        CRITICAL_REGION_EXIT();
+
+        vidBleRetainRam(&strTimeCheckpoint, sizeof(strTimeCheckpoint));
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+uint16_t u16Audit_Read(uint32_t *pu32Sequence, Audit_tstrEntry *pstrEntries, uint16_t u16MaxEntries)
+{
+    return u16Audit_ReadBetween(pu32Sequence, 0, UINT32_MAX, pstrEntries, u16MaxEntries);
+}
+
+uint16_t u16Audit_ReadBetween(uint32_t *pu32Sequence, uint32_t u32FromEpoch, uint32_t u32ToEpoch,
+                              Audit_tstrEntry *pstrEntries, uint16_t u16MaxEntries)
+{
+    uint16_t u16RetVal = 0;
+    uint32_t u32Sequence;
+    uint32_t u32Oldest;
+    uint32_t u32Epoch;
+    bool bPastRange = false;
+
+    /* Make sure valid arguments are passed */
+    if(bIsInitialized && pu32Sequence && pstrEntries)
+    {
+        u32Oldest = u32OldestSequence();
+        u32Sequence = (*pu32Sequence < u32Oldest)?u32Oldest:*pu32Sequence;
+
+        while(!bPastRange && (u16RetVal < u16MaxEntries) && (u32Sequence < u32CommittedSequence))
+        {
+            /* Copy first then check, entry could be erased while being copied */
+            memcpy(&pstrEntries[u16RetVal], (void const *)(uintptr_t)AUDIT_ENTRY_ADDR(u32Sequence), AUDIT_ENTRY_SIZE);
+
+            if(bEntryIsValid(&pstrEntries[u16RetVal], u32Sequence))
+            {
+                u32Epoch = pstrEntries[u16RetVal].u32Epoch;
+
+                /* Journal is in time order, enuAudit_Append never timestamps an entry earlier
+                   than the one before it. The first later entry ends the range. It is left
+                   unread so that the sequence number stays on it */
+                bPastRange = (u32Epoch > u32ToEpoch);
+
+                if(!bPastRange && (u32Epoch >= u32FromEpoch))
+                {
+                    u16RetVal++;
+                }
+            }
+
+            u32Sequence += bPastRange?0:1;
+        }
+
+        *pu32Sequence = u32Sequence;
+    }
+
+    return u16RetVal;
+}
+
+uint32_t u32Audit_FindSequence(uint32_t u32Epoch)
+{
+    uint32_t u32RetVal = 0;
+    uint32_t u32Oldest;
+    uint32_t u32End;
+    uint32_t u32Low = 0;
+    uint32_t u32High;
+    uint32_t u32Middle;
+    Audit_tstrEntry const *pstrEntry;
+
+    /* Make sure valid arguments are passed */
+    if(bIsInitialized)
+    {
+        CRITICAL_REGION_ENTER();
+
+        u32Oldest = u32OldestSequence();
+        u32End = u32CommittedSequence;
+        u32High = (u32End + AUDIT_ENTRIES_PER_PAGE - 1 - u32Oldest) / AUDIT_ENTRIES_PER_PAGE;
+
+        /* Pages are in time order from the oldest one on. Look for the first one holding an entry
+           at or after the requested time */
+        while(u32Low < u32High)
+        {
+            u32Middle = (u32Low + u32High) / 2;
+
+            if(strPageSummary[AUDIT_PAGE_OF(u32Oldest + (u32Middle * AUDIT_ENTRIES_PER_PAGE))].u32MaxEpoch < u32Epoch)
+            {
+                u32Low = u32Middle + 1;
+            }
+            else
+            {
+                u32High = u32Middle;
+            }
+        }
+
+        CRITICAL_REGION_EXIT();
+
+        /* Then for the first such entry within that page */
+        u32RetVal = u32Oldest + (u32Low * AUDIT_ENTRIES_PER_PAGE);
+        u32End = MIN(u32End, u32RetVal + AUDIT_ENTRIES_PER_PAGE);
+
+        for(; u32RetVal < u32End; u32RetVal++)
+        {
+            pstrEntry = (Audit_tstrEntry const *)(uintptr_t)AUDIT_ENTRY_ADDR(u32RetVal);
+
+            if(bEntryIsValid(pstrEntry, u32RetVal) && (pstrEntry->u32Epoch >= u32Epoch))
+            {
+                break;
+            }
+        }
+
+        u32RetVal = MIN(u32RetVal, u32End);
+    }
+
+    return u32RetVal;
+}
+
+uint32_t u32Audit_CountBetween(uint32_t u32FromEpoch, uint32_t u32ToEpoch)
+{
+    uint32_t u32RetVal = 0;
+    uint32_t u32Sequence;
+    uint32_t u32PageEnd;
+    Audit_tstrPageSummary const *pstrSummary;
+    Audit_tstrEntry const *pstrEntry;
+
+    /* Make sure valid arguments are passed */
+    if(bIsInitialized && u32FromEpoch && (u32FromEpoch <= u32ToEpoch))
+    {
+        u32Sequence = u32Audit_FindSequence(u32FromEpoch);
+
+        while(u32Sequence < u32CommittedSequence)
+        {
+            pstrSummary = &strPageSummary[AUDIT_PAGE_OF(u32Sequence)];
+            u32PageEnd = MIN(u32CommittedSequence, ((u32Sequence / AUDIT_ENTRIES_PER_PAGE) + 1) * AUDIT_ENTRIES_PER_PAGE);
+
+            if(pstrSummary->u16Count == 0)
+            {
+                /* Nothing timestamped in this page */
+                u32Sequence = u32PageEnd;
+            }
+            else if(pstrSummary->u32MinEpoch > u32ToEpoch)
+            {
+                /* Range ends before this page */
+                u32Sequence = u32CommittedSequence;
+            }
+            else if(((u32Sequence % AUDIT_ENTRIES_PER_PAGE) == 0) &&
+                    (pstrSummary->u32MinEpoch >= u32FromEpoch) && (pstrSummary->u32MaxEpoch <= u32ToEpoch))
+            {
+                /* Whole page is within range, its summary says how many entries it holds */
+                u32RetVal += pstrSummary->u16Count;
+                u32Sequence = u32PageEnd;
+            }
+            else
+            {
+                /* Range starts or ends within this page, entries are checked one by one */
+                for(; u32Sequence < u32PageEnd; u32Sequence++)
+                {
+                    pstrEntry = (Audit_tstrEntry const *)(uintptr_t)AUDIT_ENTRY_ADDR(u32Sequence);
+
+                    if(bEntryIsValid(pstrEntry, u32Sequence) &&
+                       (pstrEntry->u32Epoch >= u32FromEpoch) && (pstrEntry->u32Epoch <= u32ToEpoch))
+                    {
+                        u32RetVal++;
+                    }
+                }
+            }
+        }
+    }
+
+    return u32RetVal;
+}
+
+uint32_t u32Audit_GetOldestSequence(void)
+{
+    return u32OldestSequence();
+}
+
+uint32_t u32Audit_GetNextSequence(void)
+{
+    return u32NextSequence;
+}
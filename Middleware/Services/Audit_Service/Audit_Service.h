@@ -0,0 +1,219 @@
+/* ----------------------------   Audit Service for nRF52832   --------------------------------- */
+/*  File      -  Audit Service header file                                                       */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+#ifndef _MID_AUDIT_H_
+#define _MID_AUDIT_H_
+
+/****************************************   INCLUDES   *******************************************/
+#include "middleware_utils.h"
+#include "system_config.h"
+#include "App_Types.h"
+
+/*************************************   PUBLIC DEFINES   ****************************************/
+/* Size of a journal entry in flash, in bytes */
+#define AUDIT_ENTRY_SIZE 16U
+
+/**************************************   PUBLIC TYPES   *****************************************/
+/**
+ * Audit_tenuOutcome Enumeration of the different access attempt outcomes.
+*/
+typedef enum
+{
+    Audit_AccessGranted = 0, /* Key accepted, lock opened             */
+    Audit_KeyExpired,        /* Key no longer valid, access denied    */
+    Audit_UnknownUser,       /* Id not registered, access denied      */
+    Audit_WrongPassword,     /* Password mismatch, access denied      */
+    Audit_MaxOutcomes        /* Max number of outcomes                */
+}Audit_tenuOutcome;
+
+/**
+ * Audit_tstrEntry Journal entry, as stored in flash.
+ *
+ * @note Entries carry no header. Their sequence number alone locates them in the journal, and the
+ *       check field lets readers skip entries torn by a reset in the middle of being written.
+*/
+typedef struct
+{
+    uint32_t u32Sequence; /* Journal-wide entry sequence number                    */
+    uint32_t u32IdBcd;    /* BCD-encoded user Id, same encoding as NVM records     */
+    uint32_t u32Epoch;    /* Time of the access attempt, 0 if unknown              */
+    uint8_t u8KeyType;    /* User's key type, App_KeyLowerBound for unknown users  */
+    uint8_t u8Outcome;    /* Access attempt outcome, see Audit_tenuOutcome         */
+    uint16_t u16Check;    /* Check value computed over the other fields            */
+}Audit_tstrEntry;
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+/**
+ * @brief enuAudit_Init Initializes the audit journal and locates its most recent entry.
+ *
+ * @note The journal lives in MID_AUDIT_PAGES flash pages right below FDS's pages and NVM_Service's
+ *       usage counter pages, FDS keeping its place at the end of the application's flash space.
+ *       Pages are used as a ring. Entries are appended one after the other and the oldest page is
+ *       erased whenever the ring wraps around, so the journal never needs garbage collection.
+ *
+ * @note This is a synchronous call. The journal's pages are scanned once to find where the next
+ *       entry goes and to rebuild the per-page time summaries lookups are based on.
+ *
+ * @pre This function must be executed after initializing Softdevice.
+ *
+ * @return Mid_tenuStatus Middleware_Success if journal was successfully initialized,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuAudit_Init(void);
+
+/**
+ * @brief enuAudit_Append Appends an access attempt to the audit journal.
+ *
+ * @note This is an asynchronous call costing a single flash write of AUDIT_ENTRY_SIZE bytes,
+ *       plus a page erase once every time a page is filled up. The entry is timestamped with the
+ *       time last set through vidAudit_SetTime plus the time elapsed since, or with the latest
+ *       timestamp in the journal if that is later. Timestamps never go backwards, time range
+ *       queries rely on it.
+ *
+ * @pre enuAudit_Init must be called before appending any entry.
+ *
+ * @param pu8Id Pointer to 8-digit user Id.
+ * @param enuKeyType User's key type, App_KeyLowerBound if the user isn't registered.
+ * @param enuOutcome Access attempt outcome.
+ *
+ * @return Mid_tenuStatus Middleware_Success if entry was queued for writing, Middleware_Failure
+ *         otherwise.
+ */
+Mid_tenuStatus enuAudit_Append(uint8_t const *pu8Id, App_tenuKeyTypes enuKeyType, Audit_tenuOutcome enuOutcome);
+
+/**
+ * @brief vidAudit_SetTime Sets the current time entries are timestamped with.
+ *
+ * @note WiPad has no wall clock of its own. Time is acquired from peers through the Current Time
+ *       Service and carried forward using kernel ticks until the next reading.
+ *
+ * @param u32Epoch Current time as a Unix epoch.
+ *
+ * @return Nothing.
+ */
+void vidAudit_SetTime(uint32_t u32Epoch);
+
+/**
+ * @brief u32Audit_GetTime Gets the current time, as carried forward from the last time reading.
+ *
+ * @return uint32_t Current time as a Unix epoch, 0 if time was never set since boot.
+ */
+uint32_t u32Audit_GetTime(void);
+
+/**
+ * @brief u32Audit_GetMinimumTime Gets a time the current time is known not to be earlier than.
+ *
+ * @note Same as u32Audit_GetTime once time was set since boot. Until then, the time reached
+ *       before entering System OFF, or the latest timestamp in the journal after any other reset,
+ *       is carried forward instead. The time spent off is unknown, so it falls behind the current
+ *       time. It suits decisions that must never be taken early, such as deleting expired keys,
+ *       and is never used to timestamp entries.
+ *
+ * @pre enuAudit_Init must be called first.
+ *
+ * @return uint32_t Time as a Unix epoch, 0 if time was never known.
+ */
+uint32_t u32Audit_GetMinimumTime(void);
+
+/**
+ * @brief enuAudit_SaveCheckpoint Keeps the time reached so far across System OFF.
+ *
+ * @note The time is saved in RAM retained in System OFF, along with a check value, and is
+ *       restored by enuAudit_Init on wake as the minimum time.
+ *
+ * @pre This function must be invoked right before entering System OFF.
+ *
+ * @return Mid_tenuStatus Middleware_Success if time was saved, Middleware_Failure if it was
+ *         never known.
+ */
+Mid_tenuStatus enuAudit_SaveCheckpoint(void);
+
+/**
+ * @brief u16Audit_Read Reads journal entries sequentially.
+ *
+ * @note This is a synchronous call. Entries are copied out of flash in sequence order, starting
+ *       at the given sequence number or at the oldest entry still in the journal if it's older.
+ *       Torn entries are skipped. Entries still being written are left for the next call.
+ *
+ * @pre enuAudit_Init must be called before reading any entry.
+ *
+ * @param pu32Sequence Pointer to the sequence number to read from. It is advanced past the last
+ *        entry read so that successive calls stream the whole journal.
+ * @param pstrEntries Pointer to the entry array to fill.
+ * @param u16MaxEntries Number of entries the array can hold.
+ *
+ * @return uint16_t Number of entries read, 0 once the end of the journal has been reached.
+ */
+uint16_t u16Audit_Read(uint32_t *pu32Sequence, Audit_tstrEntry *pstrEntries, uint16_t u16MaxEntries);
+
+/**
+ * @brief u16Audit_ReadBetween Reads journal entries timestamped within a given time range.
+ *
+ * @note Works like u16Audit_Read, except entries outside the range are skipped and reading stops
+ *       at the first entry later than the range, the sequence number being left on it. Start
+ *       from u32Audit_FindSequence to skip the part of the journal before the range. Entries
+ *       with an unknown timestamp are only part of ranges starting at 0.
+ *
+ * @pre enuAudit_Init must be called before reading any entry.
+ *
+ * @param pu32Sequence Pointer to the sequence number to read from, advanced as entries are read.
+ * @param u32FromEpoch Start of the time range, inclusive.
+ * @param u32ToEpoch End of the time range, inclusive.
+ * @param pstrEntries Pointer to the entry array to fill.
+ * @param u16MaxEntries Number of entries the array can hold.
+ *
+ * @return uint16_t Number of entries read, 0 once the end of the range has been reached.
+ */
+uint16_t u16Audit_ReadBetween(uint32_t *pu32Sequence, uint32_t u32FromEpoch, uint32_t u32ToEpoch,
+                              Audit_tstrEntry *pstrEntries, uint16_t u16MaxEntries);
+
+/**
+ * @brief u32Audit_FindSequence Finds the first journal entry timestamped at or after a given time.
+ *
+ * @note This is a synchronous call. Each journal page has its earliest and latest timestamps
+ *       summarized in RAM, which allows binary searching pages before scanning a single one.
+ *       Timestamps are assumed to increase along the journal, which holds as long as the clock
+ *       isn't set backwards.
+ *
+ * @pre enuAudit_Init must be called before looking up any entry.
+ *
+ * @param u32Epoch Time to look for, as a Unix epoch.
+ *
+ * @return uint32_t Entry's sequence number, past the last journal entry if there's none.
+ */
+uint32_t u32Audit_FindSequence(uint32_t u32Epoch);
+
+/**
+ * @brief u32Audit_CountBetween Counts journal entries timestamped within a given time range.
+ *
+ * @note This is a synchronous call. Pages entirely within the range are counted from their
+ *       summary, only the pages the range starts and ends in are scanned.
+ *
+ * @pre enuAudit_Init must be called before counting entries.
+ *
+ * @param u32FromEpoch Start of the time range, inclusive. Must not be 0.
+ * @param u32ToEpoch End of the time range, inclusive.
+ *
+ * @return uint32_t Number of entries within the range.
+ */
+uint32_t u32Audit_CountBetween(uint32_t u32FromEpoch, uint32_t u32ToEpoch);
+
+/**
+ * @brief u32Audit_GetOldestSequence Gets the sequence number of the oldest entry in the journal.
+ *
+ * @return uint32_t Oldest entry's sequence number.
+ */
+uint32_t u32Audit_GetOldestSequence(void);
+
+/**
+ * @brief u32Audit_GetNextSequence Gets the sequence number the next appended entry will be given.
+ *
+ * @return uint32_t Next entry's sequence number.
+ */
+uint32_t u32Audit_GetNextSequence(void);
+
+#endif /* _MID_AUDIT_H_ */
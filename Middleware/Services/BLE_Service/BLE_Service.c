@@ -10,6 +10,9 @@
 #include "task.h"
 #include "BLE_Service.h"
 #include "NVM_Service.h"
+#include "Audit_Service.h"
+#include "Pool.h"
+#include "Trace.h"
 #include "nrf_sdh.h"
 #include "nrf_sdh_ble.h"
 #include "ble_gap.h"
@@ -37,6 +40,24 @@
 #define BLE_ADVERTISING_INTERVAL               64U
 #define BLE_ADVERTISING_DURATION               6000U
 #define BLE_PERFORM_BONDING                    1U
+#define BLE_RAM_BASE_ADDR                      0x20000000
+#define BLE_RAM_SECTION_SIZE                   0x1000
+#define BLE_RAM_SECTIONS_PER_BLOCK             2U
+#define BLE_ATT_HVX_HEADER_LENGTH              3U
+#define BLE_ATT_WRITE_HEADER_LENGTH            3U
+#define BLE_RX_DATA_MAX_LENGTH                 (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - BLE_ATT_WRITE_HEADER_LENGTH)
+#define BLE_EXPORT_MAX_ENTRIES                 ((NRF_SDH_BLE_GATT_MAX_MTU_SIZE - BLE_ATT_HVX_HEADER_LENGTH) \
+                                                / AUDIT_ENTRY_SIZE)
+#define BLE_ATT_PREP_WRITE_HEADER_LENGTH       5U
+#define BLE_QWR_CHUNK_HEADER_LENGTH            6U
+#define BLE_QWR_END_MARKER_LENGTH              2U
+#define BLE_QWR_MAX_CHUNKS                     ((BLE_ADM_PROVISION_MAX_LENGTH +                          \
+                                                 NRF_SDH_BLE_GATT_MAX_MTU_SIZE -                         \
+                                                 BLE_ATT_PREP_WRITE_HEADER_LENGTH - 1) /                 \
+                                                (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - BLE_ATT_PREP_WRITE_HEADER_LENGTH))
+#define BLE_QWR_MEM_BUFF_SIZE                  (BLE_ADM_PROVISION_MAX_LENGTH +                         \
+                                                (BLE_QWR_MAX_CHUNKS * BLE_QWR_CHUNK_HEADER_LENGTH) +   \
+                                                BLE_QWR_END_MARKER_LENGTH)
 #define BLE_MITM_PROTECTION_NOT_REQUIRED       0U
 #define BLE_LE_SECURE_CONNECTIONS_DISABLED     0U
 #define BLE_KEYPRESS_NOTIFS_DISABLED           0U
@@ -77,8 +98,22 @@ static TaskHandle_t pvBLETaskHandle;                             /* Ble_Service'
 static uint16_t u16ConnHandle = BLE_CONN_HANDLE_INVALID;         /* Active connection handle     */
 static volatile bool bTimeReadingPossible = false;               /* Is a CTS reading possible    */
 static volatile bool bFirstAdvInCycle = true;         /* Is first time advertising since wake up */
-static volatile bool bFlashStorageCleared = false;    /* Has flash storage been cleared          */
+static volatile bool bSleepRequested = false;        /* Is System OFF waiting on flash storage  */
+static bool bWokeFromSystemOff = false;               /* Was last reset a wake from System OFF   */
 static vidCtsCallback pfCtsCallback = NULL;           /* Placeholder for CTS callback            */
+static volatile bool bExportRequested = false;        /* Is an export waiting to be started      */
+static volatile uint32_t u32ExportRequest = 0;        /* Requested first journal entry to export */
+static volatile uint32_t u32ExportFromRequest = 0;    /* Requested export time range start       */
+static volatile uint32_t u32ExportToRequest = 0;      /* Requested export time range end         */
+static bool bExportActive = false;                    /* Is audit journal being exported         */
+static uint32_t u32ExportSequence = 0;                /* Next journal entry to export            */
+static uint32_t u32ExportFrom = 0;                    /* Exported time range start               */
+static uint32_t u32ExportTo = 0;                      /* Exported time range end                 */
+static uint8_t u8ExportInFlight = 0;                  /* Export notifications not yet sent       */
+static Audit_tstrEntry strExportChunk[BLE_EXPORT_MAX_ENTRIES]; /* Export notification buffer     */
+static uint8_t u8QwrMemBuffer[BLE_QWR_MEM_BUFF_SIZE]; /* Prepared writes, as queued by peer      */
+static uint8_t u8ProvisionBuffer[BLE_ADM_PROVISION_MAX_LENGTH]; /* Assembled Provision value     */
+static uint16_t u16ProvisionLength = 0;               /* Assembled Provision value length        */
 static ble_uuid_t strAdvUuids[] =                     /* Advertised services list                */
 {
     {BLE_KEYATT_UUID_SERVICE, BLE_UUID_TYPE_VENDOR_BEGIN}
@@ -90,6 +125,8 @@ void SD_EVT_IRQHandler(void)
     /* Initialize task yield request to pdFALSE */
     BaseType_t lYieldRequest = pdFALSE;
 
+    TRACE_POINT(Trace_SdEventIrq, 0);
+
     /* Notify Softdevice RTOS task of an incoming event from BLE stack */
     vTaskNotifyGiveFromISR(pvBLETaskHandle, &lYieldRequest);
 
@@ -111,6 +148,85 @@ static void vidBleStartAdvertising(void)
     }
 }
 
+static void vidAuditExportPump(void)
+{
+    uint32_t u32Sequence;
+    uint16_t u16Count;
+    uint16_t u16Length;
+    uint16_t u16MaxEntries = BLE_EXPORT_MAX_ENTRIES;
+    bool bQueueFull = false;
+
+    /* A new request replaces any export in progress */
+    if(bExportRequested)
+    {
+        bExportRequested = false;
+        u32ExportSequence = u32ExportRequest;
+        u32ExportFrom = u32ExportFromRequest;
+        u32ExportTo = u32ExportToRequest;
+        bExportActive = true;
+    }
+
+    /* Fit as many entries per notification as the negotiated MTU allows */
+    if(bExportActive)
+    {
+        u16MaxEntries = MIN(u16MaxEntries, (nrf_ble_gatt_eff_mtu_get(&BleGattInstance, u16ConnHandle) -
+                                            BLE_ATT_HVX_HEADER_LENGTH) / AUDIT_ENTRY_SIZE);
+    }
+
+    /* Keep queueing chunks until the Softdevice runs out of room. Notifications are copied into
+       the Softdevice's queue, so one buffer is enough */
+    while(bExportActive && !bQueueFull)
+    {
+        u32Sequence = u32ExportSequence;
+        u16Count = u16Audit_ReadBetween(&u32Sequence, u32ExportFrom, u32ExportTo, strExportChunk, u16MaxEntries);
+
+        if(u16Count)
+        {
+            u16Length = u16Count * AUDIT_ENTRY_SIZE;
+        }
+        else
+        {
+            /* End of journal or of time range. Let peer know where to resume from */
+            memcpy(strExportChunk, &u32Sequence, sizeof(uint32_t));
+            u16Length = sizeof(uint32_t);
+        }
+
+        if(Middleware_Success == enuBleAdmExportData(&BleAdminInstance,
+                                                     (uint8_t *)strExportChunk,
+                                                     &u16Length,
+                                                     u16ConnHandle))
+        {
+            /* Chunk queued, move on */
+            u32ExportSequence = u32Sequence;
+            u8ExportInFlight++;
+            bExportActive = (u16Count > 0);
+        }
+        else
+        {
+            /* Chunk is read again when room is made. If nothing is in flight, no room will ever
+               be made and export is given up */
+            bQueueFull = true;
+            bExportActive = (u8ExportInFlight > 0);
+        }
+    }
+}
+
+static void vidBleEnterSystemOff(void)
+{
+    /* Keep user index, recently signed-in users and time around for a fast boot on wake.
+       Flash storage is idle by now */
+    (void)enuNVM_SaveCheckpoint();
+    (void)enuAudit_SaveCheckpoint();
+
+    /* Enter system-off mode. Wakeup will only be possible through a reset */
+    (void)sd_power_system_off();
+    /* Empty loop to keep CPU busy in debug mode */
+    while(1)
+    {
+        __NOP();
+    }
+}
+
 static void vidConnParamErrorHandler(uint32_t u32Error)
 {
     APP_ERROR_HANDLER(u32Error);
@@ -121,6 +237,8 @@ static void vidBleEventHandler(ble_evt_t const *pstrEvent, void *pvData)
     /* Make sure valid arguments are passed */
     if(pstrEvent)
     {
+        TRACE_POINT(Trace_BleEvent, pstrEvent->header.evt_id);
+
         /* Secure an established connection */
         pm_handler_secure_on_connection(pstrEvent);
 
@@ -141,6 +259,10 @@ static void vidBleEventHandler(ble_evt_t const *pstrEvent, void *pvData)
         {
             /* Clear connection handle placeholder */
             u16ConnHandle = BLE_CONN_HANDLE_INVALID;
+            /* Abort audit journal export */
+            bExportRequested = false;
+            bExportActive = false;
+            u8ExportInFlight = 0;
             /* Clear connection handle in Current Time Service's instance structure */
             if(BleCtsInstance.conn_handle == pstrEvent->evt.gap_evt.conn_handle)
             {
@@ -156,19 +278,17 @@ static void vidBleEventHandler(ble_evt_t const *pstrEvent, void *pvData)
             /* Advertising timed out. Prepare wakeup buttons and go to sleep */
             if(NRF_SUCCESS == bsp_btn_ble_sleep_mode_prepare())
             {
-                /* Request clearing space in flash storage */
-                if(Middleware_Success == enuNVM_ClearFlashStorage())
-                {
-                    /* Clearing flash storage is an asynchronous operation. Wait for outcome */
-                    while(!bFlashStorageCleared){}
-                }
-
-                /* Enter system-off mode. Wakeup will only be possible through a reset */
-                (void)sd_power_system_off();
-                /* Empty loop to keep CPU busy in debug mode */
-                while(1)
+                /* Write back cached record updates and request clearing space in flash storage */
+                bSleepRequested = true;
+                (void)enuNVM_FlushRecords(true);
+                (void)enuNVM_ClearFlashStorage();
+
+                /* Flash operations complete asynchronously through events handled by this very
+                   task. If any is in flight, System OFF is entered from
+                   vidFlashStorageIdleCallback once they're done. */
+                if(bNVM_IsIdle())
                 {
-                    __NOP();
+                    vidBleEnterSystemOff();
                 }
             }
         }
@@ -181,6 +301,29 @@ static void vidBleEventHandler(ble_evt_t const *pstrEvent, void *pvData)
     }
 }
 
+/* Pool blocks must hold Rx data structures along with the longest data each characteristic takes */
+STATIC_ASSERT((sizeof(Ble_tstrRxData) + BLE_RX_DATA_MAX_LENGTH + 1) <= UTIL_POOL_SMALL_BLOCK_SIZE);
+STATIC_ASSERT((sizeof(Ble_tstrRxData) + BLE_ADM_PROVISION_MAX_LENGTH + 1) <= UTIL_POOL_LARGE_BLOCK_SIZE);
+
+static Ble_tstrRxData *pstrRxDataCopy(uint8_t const *pu8Data, uint16_t u16Length)
+{
+    /* Rx data structure and a NULL-terminated copy of the data share a single pool block, so
+       they're allocated and freed at once */
+    Ble_tstrRxData *pstrRetVal = (Ble_tstrRxData *)pvPoolAlloc(sizeof(Ble_tstrRxData) + u16Length + 1);
+
+    if(pstrRetVal)
+    {
+        uint8_t *pu8Buffer = (uint8_t *)(pstrRetVal + 1);
+
+        memcpy((void *)pu8Buffer, pu8Data, u16Length);
+        pu8Buffer[u16Length] = '\0';
+        pstrRetVal->pu8Data = pu8Buffer;
+        pstrRetVal->u16Length = u16Length;
+    }
+
+    return pstrRetVal;
+}
+
 static void vidUseRegEventHandler(BleReg_tstrEvent *pstrEvent)
 {
     /* Make sure valid arguments are passed */
@@ -207,22 +350,12 @@ static void vidUseRegEventHandler(BleReg_tstrEvent *pstrEvent)
             /* Received user input on Id/Pwd characteristic. Notify Registration application.
                Note: Data must be preserved until the Registration application receives and
                processes it. */
-            Ble_tstrRxData *pstrRxData = (Ble_tstrRxData *)malloc(sizeof(Ble_tstrRxData));
+            Ble_tstrRxData *pstrRxData = pstrRxDataCopy(pstrEvent->strRxData.pu8Data,
+                                                        pstrEvent->strRxData.u16Length);
 
             if(pstrRxData)
             {
-                pstrRxData->pu8Data = (uint8_t *)malloc(pstrEvent->strRxData.u16Length+1);
-                pstrRxData->u16Length = pstrEvent->strRxData.u16Length;
-
-                /* Successfully allocated memory for data pointer */
-                if(NULL == pstrRxData->pu8Data)
-                {
-                    /* Free allocated memory */
-                    free(pstrRxData);
-                }
-
-                /* Copy data into buffer and dispatch it to the Registration application */
-                memcpy((void *)pstrRxData->pu8Data, pstrEvent->strRxData.pu8Data, pstrRxData->u16Length);
+                /* Dispatch data to the Registration application */
                 (void)AppMgr_enuDispatchEvent(BLE_REG_USER_INPUT_RECEIVED, (void *)pstrRxData);
             }
         }
@@ -261,22 +394,11 @@ static void vidKeyAttEventHandler(BleAtt_tstrEvent *pstrEvent)
             /* Received user input on Key Activation characteristic. Notify Attribution application.
                Note: Data must be preserved until the Attribution application receives and
                processes it. */
-            Ble_tstrRxData *pstrRxData = (Ble_tstrRxData *)malloc(sizeof(Ble_tstrRxData));
+            Ble_tstrRxData *pstrRxData = pstrRxDataCopy(&pstrEvent->u8RxByte, sizeof(uint8_t));
 
             if(pstrRxData)
             {
-                pstrRxData->pu8Data = (uint8_t *)malloc(2);
-                pstrRxData->u16Length = 1;
-
-                /* Successfully allocated memory for data pointer */
-                if(NULL == pstrRxData->pu8Data)
-                {
-                    /* Free allocated memory */
-                    free(pstrRxData);
-                }
-
-                /* Copy data into buffer and dispatch it to the Attribution application */
-                memcpy((void *)pstrRxData->pu8Data, &pstrEvent->u8RxByte, pstrRxData->u16Length);
+                /* Dispatch data to the Attribution application */
                 (void)AppMgr_enuDispatchEvent(BLE_ATT_USER_INPUT_RECEIVED, (void *)pstrRxData);
             }
         }
@@ -315,23 +437,65 @@ static void vidAdminEventHandler(BleAdm_tstrEvent *pstrEvent)
             /* Received user input on User Command characteristic. Notify Registration application.
                Note: Data must be preserved until the Registration application receives and
                processes it. */
-            Ble_tstrRxData *pstrRxData = (Ble_tstrRxData *)malloc(sizeof(Ble_tstrRxData));
+            Ble_tstrRxData *pstrRxData = pstrRxDataCopy(pstrEvent->strRxData.pu8Data,
+                                                        pstrEvent->strRxData.u16Length);
 
             if(pstrRxData)
             {
-                pstrRxData->pu8Data = (uint8_t *)malloc(pstrEvent->strRxData.u16Length+1);
-                pstrRxData->u16Length = pstrEvent->strRxData.u16Length;
+                /* Dispatch data to the Registration application */
+                (void)AppMgr_enuDispatchEvent(BLE_ADM_USER_INPUT_RECEIVED, (void *)pstrRxData);
+            }
+        }
+        break;
 
-                /* Successfully allocated memory for data pointer */
-                if(NULL == pstrRxData->pu8Data)
-                {
-                    /* Free allocated memory */
-                    free(pstrRxData);
-                }
+        case BLE_ADM_EXPORT_NOTIF_DISABLED:
+        {
+            /* Peer no longer listens to the Export characteristic. Abort audit journal export */
+            bExportRequested = false;
+            bExportActive = false;
+            u8ExportInFlight = 0;
+        }
+        break;
 
-                /* Copy data into buffer and dispatch it to the Registration application */
-                memcpy((void *)pstrRxData->pu8Data, pstrEvent->strRxData.pu8Data, pstrRxData->u16Length);
-                (void)AppMgr_enuDispatchEvent(BLE_ADM_USER_INPUT_RECEIVED, (void *)pstrRxData);
+        case BLE_ADM_EXPORT_TX:
+        {
+            /* Notifications left the Softdevice's queue. Export is topped up by Ble_Service's task
+               once all pending events are processed */
+            u8ExportInFlight = (pstrEvent->u8TxCount < u8ExportInFlight)
+                               ?(u8ExportInFlight - pstrEvent->u8TxCount)
+                               :0;
+        }
+        break;
+
+        case BLE_ADM_PROVISION_RX:
+        {
+            /* Received list of users to add. Let Registration application check it comes from
+               Admin.
+               Note: Data must be preserved until the Registration application receives and
+               processes it. */
+            Ble_tstrRxData *pstrRxData = pstrRxDataCopy(pstrEvent->strRxData.pu8Data,
+                                                        pstrEvent->strRxData.u16Length);
+
+            if(pstrRxData)
+            {
+                /* Dispatch data to the Registration application */
+                (void)AppMgr_enuDispatchEvent(BLE_ADM_PROVISION_REQUESTED, (void *)pstrRxData);
+            }
+        }
+        break;
+
+        case BLE_ADM_EXPORT_RX:
+        {
+            /* Received export request. Let Registration application check it comes from Admin.
+               Note: Data must be preserved until the Registration application receives and
+               processes it. */
+            Ble_tstrRxData *pstrRxData = pstrRxDataCopy(pstrEvent->strRxData.pu8Data,
+                                                        pstrEvent->strRxData.u16Length);
+
+            if(pstrRxData)
+            {
+                /* Dispatch data to the Registration application */
+                (void)AppMgr_enuDispatchEvent(BLE_ADM_EXPORT_REQUESTED, (void *)pstrRxData);
             }
         }
         break;
@@ -400,6 +564,35 @@ static void vidQwrErrorHandler(uint32_t u32Error)
     APP_ERROR_HANDLER(u32Error);
 }
 
+static uint16_t u16QwrEventHandler(nrf_ble_qwr_t *pstrQwrInstance, nrf_ble_qwr_evt_t *pstrEvent)
+{
+    uint16_t u16RetVal = BLE_GATT_STATUS_SUCCESS;
+
+    /* Provision characteristic is the only one registered for queued writes */
+    if(pstrEvent->attr_handle == BleAdminInstance.strProvisionChar.value_handle)
+    {
+        if(NRF_BLE_QWR_EVT_AUTH_REQUEST == pstrEvent->evt_type)
+        {
+            /* Peer executes its queued writes. Assemble them, turning down values too long for
+               the characteristic */
+            u16ProvisionLength = sizeof(u8ProvisionBuffer);
+            u16RetVal = (NRF_SUCCESS == nrf_ble_qwr_value_get(pstrQwrInstance,
+                                                              pstrEvent->attr_handle,
+                                                              u8ProvisionBuffer,
+                                                              &u16ProvisionLength))
+                                                              ?BLE_GATT_STATUS_SUCCESS
+                                                              :BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+        }
+        else
+        {
+            /* Queued writes executed */
+            vidBleAdmProvisionReceived(&BleAdminInstance, u16ConnHandle, u8ProvisionBuffer, u16ProvisionLength);
+        }
+    }
+
+    return u16RetVal;
+}
+
 static void vidAdvEventHandler(ble_adv_evt_t enuEvent)
 {
     switch (enuEvent)
@@ -467,6 +660,15 @@ static Mid_tenuStatus enuBleStackInit(void)
         uint32_t u32RamStart = BLE_RAM_START_ADDRESS;
         if(NRF_SUCCESS == nrf_sdh_ble_default_cfg_set(BLE_CONN_CFG_TAG, &u32RamStart))
         {
+#if (MID_BLE_HVN_TX_QUEUE_SIZE != BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT)
+            /* Let bulk transfers queue several notifications per connection event */
+            ble_cfg_t strBleCfg;
+            memset(&strBleCfg, 0, sizeof(strBleCfg));
+            strBleCfg.conn_cfg.conn_cfg_tag = BLE_CONN_CFG_TAG;
+            strBleCfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = MID_BLE_HVN_TX_QUEUE_SIZE;
+            (void)sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &strBleCfg, u32RamStart);
+#endif
+
             /* Enable BLE Softdevice */
             enuRetVal = (NRF_SUCCESS == nrf_sdh_ble_enable(&u32RamStart))
                                         ?Middleware_Success
@@ -548,8 +750,12 @@ static Mid_tenuStatus enuBleServicesInit(void)
     ble_cts_c_init_t strCtsInit = {0};
     nrf_ble_qwr_init_t strQwrInit = {0};
 
-    /* Initialize Queued Write Module */
+    /* Initialize Queued Write Module. Prepared writes are held in application memory until peer
+       executes them */
     strQwrInit.error_handler = vidQwrErrorHandler;
+    strQwrInit.mem_buffer.p_mem = u8QwrMemBuffer;
+    strQwrInit.mem_buffer.len = sizeof(u8QwrMemBuffer);
+    strQwrInit.callback = u16QwrEventHandler;
     if(NRF_SUCCESS == nrf_ble_qwr_init(&BleQwrInstance, &strQwrInit))
     {
         /* Initialize User Registration service */
@@ -562,7 +768,9 @@ static Mid_tenuStatus enuBleServicesInit(void)
             {
                 /* Initialize Admin User service */
                 strAdmInit.pfAdmEvtHandler = vidAdminEventHandler;
-                if(Middleware_Success == enuBleAdmInit(&BleAdminInstance, &strAdmInit))
+                if((Middleware_Success == enuBleAdmInit(&BleAdminInstance, &strAdmInit)) &&
+                   (NRF_SUCCESS == nrf_ble_qwr_attr_register(&BleQwrInstance,
+                                                             BleAdminInstance.strProvisionChar.value_handle)))
                 {
                     /* Initialize Current Time service */
                     strCtsInit.evt_handler = vidCtsEventHandler;
@@ -676,6 +884,8 @@ static void vidBleTaskFunction(void *pvArg)
     {
         /* Process events originating from Ble Stack */
         nrf_sdh_evts_poll();
+        /* Top up audit journal export with whatever room events made */
+        vidAuditExportPump();
         /* Clear notifications after they've been processed and put task in blocked state */
         (void) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
@@ -686,6 +896,12 @@ Mid_tenuStatus enuBle_Init(void)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
 
+    /* Reset reasons accumulate until cleared. Take them over while Softdevice doesn't own the
+       POWER peripheral yet */
+    bWokeFromSystemOff = (0 != (NRF_POWER->RESETREAS & POWER_RESETREAS_OFF_Msk)) &&
+                         (0 == (NRF_POWER->RESETREAS & POWER_RESETREAS_DIF_Msk));
+    NRF_POWER->RESETREAS = NRF_POWER->RESETREAS;
+
     /* Create task for BLE service */
     if(pdTRUE == xTaskCreate(vidBleTaskFunction,
                              "BLE_Task",
@@ -729,6 +945,33 @@ Mid_tenuStatus enuBle_Init(void)
     return enuRetVal;
 }
 
+bool bBleIsConnected(void)
+{
+    return (BLE_CONN_HANDLE_INVALID != u16ConnHandle);
+}
+
+bool bBleWokenFromSystemOff(void)
+{
+    return bWokeFromSystemOff;
+}
+
+void vidBleRetainRam(void const *pvAddr, uint32_t u32Size)
+{
+    /* Make sure valid arguments are passed */
+    if(pvAddr && u32Size)
+    {
+        uint32_t u32FirstSection = ((uint32_t)pvAddr - BLE_RAM_BASE_ADDR) / BLE_RAM_SECTION_SIZE;
+        uint32_t u32LastSection = ((uint32_t)pvAddr + u32Size - 1 - BLE_RAM_BASE_ADDR) / BLE_RAM_SECTION_SIZE;
+
+        /* Each RAM block is split in sections retained independently */
+        for(uint32_t u32Section = u32FirstSection; u32Section <= u32LastSection; u32Section++)
+        {
+            (void)sd_power_ram_power_set((uint8_t)(u32Section / BLE_RAM_SECTIONS_PER_BLOCK),
+                                         POWER_RAM_POWER_S0RETENTION_Msk << (u32Section % BLE_RAM_SECTIONS_PER_BLOCK));
+        }
+    }
+}
+
 void vidBleGetCurrentTime(void)
 {
     if(bTimeReadingPossible)
@@ -748,6 +991,8 @@ Mid_tenuStatus enuTransferNotification(Ble_tenuServices enuService, uint8_t *pu8
     /* Make sure valid arguments are passed */
     if(BLE_SERVICE_ASSERT(enuService) && pu8Data && pu16Length && (*pu16Length > 0))
     {
+        TRACE_POINT(Trace_BleNotify, enuService);
+
         switch(enuService)
         {
         case Ble_Registration:
@@ -780,14 +1025,35 @@ Mid_tenuStatus enuTransferNotification(Ble_tenuServices enuService, uint8_t *pu8
     return enuRetVal;
 }
 
+Mid_tenuStatus enuBleStartAuditExport(uint32_t u32Sequence, uint32_t u32FromEpoch, uint32_t u32ToEpoch)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    if(bBleIsConnected())
+    {
+        /* Hand export over to Ble_Service's task, which owns the notification queue */
+        u32ExportRequest = u32Sequence;
+        u32ExportFromRequest = u32FromEpoch;
+        u32ExportToRequest = u32ToEpoch;
+        bExportRequested = true;
+        xTaskNotifyGive(pvBLETaskHandle);
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
 void vidRegisterCtsCallback(vidCtsCallback pfCallback)
 {
     /* Register Attribution application's current time data callback */
     pfCtsCallback = pfCallback;
 }
 
-void vidFlashStorageClearCallback(void)
+void vidFlashStorageIdleCallback(void)
 {
-    /* Set flash storage cleared flag */
-    bFlashStorageCleared = true;
+    /* Going to sleep was only held back by flash operations in flight */
+    if(bSleepRequested)
+    {
+        vidBleEnterSystemOff();
+    }
 }
\ No newline at end of file
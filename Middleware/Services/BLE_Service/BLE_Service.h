@@ -9,7 +9,7 @@
 #define _MID_BLE_H_
 
 /****************************************   INCLUDES   *******************************************/
-#include <String.h>
+#include <string.h>
 #include "Strings.h"
 #include "middleware_utils.h"
 #include "system_config.h"
@@ -29,6 +29,8 @@
 #define BLE_ADM_NOTIF_ENABLED_HEADSUP  14U /* Peer enabled notifications on ble_adm             */
 #define BLE_ADM_NOTIF_DISABLED_HEADSUP 15U /* Peer disabled notifications on ble_adm            */
 #define BLE_ADM_USER_INPUT_RECEIVED    16U /* Received data from peer on command characteristic */
+#define BLE_ADM_EXPORT_REQUESTED       23U /* Received data from peer on Export characteristic  */
+#define BLE_ADM_PROVISION_REQUESTED    24U /* Received data from peer on Provision charac       */
 #define BLE_ATT_NOTIF_ENABLED_HEADSUP  19U /* Peer enabled notifications on ble_att             */
 #define BLE_ATT_NOTIF_DISABLED_HEADSUP 20U /* Peer disabled notifications on ble_att            */
 #define BLE_ATT_USER_INPUT_RECEIVED    22U /* Received data from peer on Key activation char    */
@@ -46,6 +48,9 @@ typedef enum
 
 /**
  * Rx data structure upon being on the receiving end of a GATT client write event for all services.
+ *
+ * @note Rx data is handed over to applications in a single pool block, the data right after the
+ *       structure. Applications give the whole block back at once through vidPoolFree.
 */
 typedef struct
 {
@@ -113,6 +118,40 @@ Mid_tenuStatus enuBle_Init(void);
  */
 void vidBleGetCurrentTime(void);
 
+/**
+ * @brief bBleIsConnected Checks whether a peer is currently connected.
+ *
+ * @return bool true if a connection is active, false otherwise.
+ */
+bool bBleIsConnected(void);
+
+/**
+ * @brief bBleWokenFromSystemOff Checks whether the last reset was a wake from System OFF.
+ *
+ * @note Only RAM retained through vidBleRetainRam is known to hold what it held before entering
+ *       System OFF then. Entering debug interface mode may come with the application being
+ *       replaced, it doesn't count as a wake.
+ *
+ * @pre enuBle_Init must be called first, it takes the reset reason over.
+ *
+ * @return bool true if RAM sections retained before entering System OFF kept their content,
+ *         false otherwise.
+ */
+bool bBleWokenFromSystemOff(void);
+
+/**
+ * @brief vidBleRetainRam Keeps RAM sections holding a memory area powered in System OFF.
+ *
+ * @note RAM is retained in 4 kB sections. Each retained section slightly increases System OFF
+ *       current, areas meant to survive it should be kept small and placed with MID_RETAINED.
+ *
+ * @param pvAddr Pointer to the memory area to retain.
+ * @param u32Size Size of the memory area, in bytes.
+ *
+ * @return Nothing.
+ */
+void vidBleRetainRam(void const *pvAddr, uint32_t u32Size);
+
 /**
  * @brief enuTransferNotification Relays notification data from application to peer by calling
  *        the data transfer function of the destination Ble service.
@@ -126,6 +165,33 @@ void vidBleGetCurrentTime(void);
  */
 Mid_tenuStatus enuTransferNotification(Ble_tenuServices enuService, uint8_t *pu8Data, uint16_t *pu16Length);
 
+/**
+ * @brief enuBleStartAuditExport Starts streaming the audit journal to peer over ble_adm's Export
+ *        characteristic.
+ *
+ * @note Entries are sent in binary form, as many per notification as the negotiated MTU allows.
+ *       A notification holding a multiple of AUDIT_ENTRY_SIZE bytes carries entries, in the
+ *       little-endian Audit_tstrEntry layout. The stream ends with a 4-byte notification holding
+ *       the sequence number an export should be resumed from to get subsequent entries.
+ *
+ * @note Only entries timestamped within the given time range are sent. The stream ends at the
+ *       first entry later than the range, pass 0 and UINT32_MAX to stream the whole journal.
+ *
+ * @note Streaming is driven by Ble_Service's task. The Softdevice's notification queue is kept
+ *       full and topped up as notifications are sent. A new request replaces any export in
+ *       progress.
+ *
+ * @pre Peer must have enabled notifications on the Export characteristic.
+ *
+ * @param u32Sequence Sequence number of the first entry to send. Entries no longer in the
+ *        journal are skipped.
+ * @param u32FromEpoch Start of the time range to send, inclusive.
+ * @param u32ToEpoch End of the time range to send, inclusive.
+ *
+ * @return Mid_tenuStatus Middleware_Success if export was started, Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuBleStartAuditExport(uint32_t u32Sequence, uint32_t u32FromEpoch, uint32_t u32ToEpoch);
+
 /**
  * @brief vidRegisterCtsCallback Registers a callback to be invoked upon obtaining a current time
  *        reading.
@@ -139,11 +205,11 @@ Mid_tenuStatus enuTransferNotification(Ble_tenuServices enuService, uint8_t *pu8
 void vidRegisterCtsCallback(vidCtsCallback pfCallback);
 
 /**
- * @brief vidFlashStorageClearCallback Called by the NVM_Service when flash storage has been
- *        cleared successfully.
+ * @brief vidFlashStorageIdleCallback Called by the NVM_Service when the last flash operation it
+ *        had in flight has completed.
  *
  * @return Nothing.
  */
-void vidFlashStorageClearCallback(void);
+void vidFlashStorageIdleCallback(void);
 
 #endif /* _MID_BLE_H_ */
\ No newline at end of file
@@ -6,31 +6,1910 @@
 /* --------------------------------------------------------------------------------------------- */
 
 /****************************************   INCLUDES   *******************************************/
+#include "FreeRTOS.h"
+#include "task.h"
 #include "NVM_Service.h"
 #include "BLE_Service.h"
+#include "Time.h"
+#include "Trace.h"
+#include "Maths.h"
+#include "sdk_config.h"
+#include "fds_internal_defs.h"
+#include "nrf_fstorage.h"
+#include "app_util_platform.h"
+
+#if   (FDS_BACKEND == NRF_FSTORAGE_SD)
+#include "nrf_fstorage_sd.h"
+#elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
+#include "nrf_fstorage_nvmc.h"
+#elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+#include <time.h>
+#include "nrf_fstorage_host.h"
+#endif
 
 /************************************   PRIVATE DEFINES   ****************************************/
-#define NVM_PERSISTENT_KEYS_FILE_ID 0x8010
-#define NVM_EXPIRABLE_KEYS_FILE_ID  0x9010
-#define NVM_PEER_MANAGER_ADDR_START 0xC000
-#define NVM_ID_LENGTH               8U
+#define NVM_LEGACY_PERSISTENT_FILE_ID 0x8010
+#define NVM_LEGACY_EXPIRABLE_FILE_ID  0x9010
+#define NVM_PERSISTENT_KEYS_FILE_BASE 0x2000
+#define NVM_EXPIRABLE_KEYS_FILE_BASE  0x4000
+#define NVM_FILE_BASE_MASK            0xE000
+#define NVM_RECORD_KEY_BITS           14U
+#define NVM_RECORD_KEY_MASK           0x3FFF
+#define NVM_ID_LENGTH                 8U
+#define NVM_WRITE_BUFFER_COUNT        FDS_OP_QUEUE_SIZE
+#define NVM_REQUEST_QUEUE_SIZE        FDS_OP_QUEUE_SIZE
+#define NVM_BATCH_IN_FLIGHT           (NVM_REQUEST_QUEUE_SIZE - 1)
+#define NVM_DATA_WORDS                ((FDS_VIRTUAL_PAGES - 1) * FDS_VIRTUAL_PAGE_SIZE)
+#define NVM_INDEX_EMPTY_SLOT          0xFFFFFFFF
+#define NVM_INDEX_DELETED_SLOT        0xFFFFFFFE
+#define NVM_INDEX_HASH_MULTIPLIER     0x9E3779B1
+#define NVM_BLOOM_HASH_MULTIPLIER     0x85EBCA6B
+#define NVM_BLOOM_HASH_COUNT          3U
+#define NVM_BLOOM_WORDS               (MID_NVM_BLOOM_BITS / 32)
+#define NVM_SECS_IN_MINUTE            60U
+#define NVM_COUNTER_PAGE_SIZE         4096U
+#define NVM_COUNTER_SLOT_SIZE         64U
+#define NVM_COUNTER_SLOTS             ((MID_NVM_COUNTER_PAGES * NVM_COUNTER_PAGE_SIZE) / NVM_COUNTER_SLOT_SIZE)
+#define NVM_COUNTER_USE_WORDS         ((NVM_COUNTER_SLOT_SIZE / sizeof(uint32_t)) - 2)
+#define NVM_COUNTER_SLOT_USES         (NVM_COUNTER_USE_WORDS * 2)
+#define NVM_COUNTER_NO_SLOT           0xFFFF
+#define NVM_COUNTER_ERASED_WORD       0xFFFFFFFF
+#define NVM_COUNTER_HALF_WORD         0xFFFF0000
+#define NVM_COUNTER_CLEARED_WORD      0x00000000
+#define NVM_CHECKPOINT_MAGIC          0x4E564D43
+#define NVM_US_IN_SECOND              1000000U
+#define NVM_TXN_FILE_ID               0x6000
+#define NVM_TXN_RECORD_KEY            0x0001
+#define NVM_TXN_DELETE_VERSION        0U
+
+/* Flash space taken by FDS's pages and those it is told to leave alone. Counter pages sit right
+   below it, so that FDS stays where it is whatever else is stored */
+#define NVM_FDS_AREA_SIZE ((FDS_VIRTUAL_PAGES + FDS_VIRTUAL_PAGES_RESERVED) * FDS_VIRTUAL_PAGE_SIZE * 4)
+
+/* Intent record takes a word plus 7 per user, which must fit in an FDS page along with the page
+   tag and the record header */
+#if ((1 + (MID_NVM_TXN_SIZE * 7)) > (FDS_VIRTUAL_PAGE_SIZE - FDS_PAGE_TAG_SIZE - FDS_HEADER_SIZE))
+#error MID_NVM_TXN_SIZE is too large for an FDS page.
+#endif
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Compute share of data pages, in percent, that garbage collection would reclaim.
+   Note: One of the virtual pages is reserved by FDS as swap page and never holds records. */
+#define NVM_DIRTY_RATIO(freeable_words) ((uint8_t)(((uint32_t)(freeable_words) * 100) / NVM_DATA_WORDS))
+
+/* Compute size in 4-byte words of a record structure */
+#define NVM_RECORD_WORDS(record) ((sizeof(record)+3) / sizeof(uint32_t))
+
+/* Round a 16-bit value up to a power of 2 */
+#define NVM_POW2_SMEAR(value, shift) ((value) | ((value) >> (shift)))
+#define NVM_POW2_CEIL(value) \
+    (NVM_POW2_SMEAR(NVM_POW2_SMEAR(NVM_POW2_SMEAR(NVM_POW2_SMEAR((value) - 1, 1), 2), 4), 8) + 1)
+
+/* User index holds every record FDS's data pages fit, header included, at 75% load at most. Probe
+   sequences stay short and the index never overflows however many users are registered */
+#ifndef MID_NVM_INDEX_SIZE
+#define MID_NVM_INDEX_SIZE \
+    NVM_POW2_CEIL((NVM_DATA_WORDS / (NVM_RECORD_WORDS(Nvm_tstrFlashRecord) + FDS_HEADER_SIZE)) * 4 / 3)
+#endif
+
+/* File a user's record goes to, depending on their key type */
+#define NVM_KEY_TYPE_FILE(type)                 \
+(                                               \
+    ( (App_OneTimeKey         == (type)) ||     \
+      (App_CountRestrictedKey == (type)) ||     \
+      (App_TimeRestrictedKey  == (type)) )      \
+    ?Nvm_ExpirableKeys                          \
+    :Nvm_PersistentKeys                         \
+)
+
+/* Compute FDS file Id holding a given user Id. Upper Id bits are carried by the file Id */
+#define NVM_FILE_ID(file_base, id) ((uint16_t)((file_base) + ((id) >> NVM_RECORD_KEY_BITS)))
+
+/* Compute FDS record key of a given user Id. Lower Id bits are carried by the record key which
+   can't be 0x0000 */
+#define NVM_RECORD_KEY(id) ((uint16_t)(((id) & NVM_RECORD_KEY_MASK) + 1))
+
+/* Rebuild user Id out of the FDS file Id and record key it was stored under */
+#define NVM_ID_FROM_KEYS(file_id, key)                                                     \
+(                                                                                          \
+    ((uint32_t)((file_id) & ~NVM_FILE_BASE_MASK) << NVM_RECORD_KEY_BITS) |                 \
+    ((uint32_t)(key) - 1)                                                                  \
+)
+
+/* Check whether file Id belongs to one of NVM_Service's files */
+#define NVM_IS_APP_FILE(file_id)                                       \
+(                                                                      \
+    ( ((file_id) & NVM_FILE_BASE_MASK) == NVM_PERSISTENT_KEYS_FILE_BASE ) || \
+    ( ((file_id) & NVM_FILE_BASE_MASK) == NVM_EXPIRABLE_KEYS_FILE_BASE  )    \
+)
+
+/* Check whether file Id belongs to the expirable keys file */
+#define NVM_IS_EXPIRABLE_FILE(file_id)                                          \
+(                                                                               \
+    ( ((file_id) & NVM_FILE_BASE_MASK) == NVM_EXPIRABLE_KEYS_FILE_BASE ) ||     \
+    ( (file_id) == NVM_LEGACY_EXPIRABLE_FILE_ID )                               \
+)
+
+/* Compute flash address of a usage counter slot */
+#define NVM_COUNTER_SLOT_ADDR(slot) (strCounterFs.start_addr + ((uint32_t)(slot) * NVM_COUNTER_SLOT_SIZE))
+
+/* Check whether file Id belongs to one of the files used before Ids were fully encoded in keys */
+#define NVM_IS_LEGACY_FILE(file_id)                    \
+(                                                      \
+    ( (file_id) == NVM_LEGACY_PERSISTENT_FILE_ID ) ||  \
+    ( (file_id) == NVM_LEGACY_EXPIRABLE_FILE_ID  )     \
+)
+
+/* Timestamp units per microsecond, cycles on target */
+#if (FDS_BACKEND == NRF_FSTORAGE_HOST)
+#define NVM_TIMESTAMP_PER_US 1U
+#else
+#define NVM_TIMESTAMP_PER_US (SystemCoreClock / NVM_US_IN_SECOND)
+#endif
+
+/* Size in 4-byte words of a transaction's intent record */
+#define NVM_TXN_JOURNAL_WORDS(op_count) (1U + ((op_count) * NVM_RECORD_WORDS(Nvm_tstrFlashRecord)))
+
+/* Check whether a transaction holds onto flash storage */
+#define NVM_TXN_IN_FLIGHT(state) (((state) >= Nvm_TxnJournaling) && ((state) <= Nvm_TxnClosing))
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Nvm_tstrIndexEntry User index entry mapping a user Id to the FDS record holding its data.
+*/
+typedef struct
+{
+    uint32_t u32Id;       /* User Id in its integer form */
+    uint32_t u32RecordId; /* FDS record Id               */
+}Nvm_tstrIndexEntry;
+
+/**
+ * Nvm_tstrRecordV1 FDS record-defining structure used before records were packed (format
+ *                  version 1). Only kept around to read and migrate such records.
+*/
+typedef struct
+{
+    uint8_t u8Id[NVM_ID_SIZE];           /* User Id                         */
+    uint8_t u8Password[NVM_PWD_SIZE];    /* User password                   */
+    exact_time_256_t strLastKnownUse;    /* Last time this key was used     */
+    App_tenuKeyTypes enuKeyType;         /* User's key type                 */
+    union{
+        Nvm_tstrCountResKey strCountRes; /* Count-restricted key quantifier */
+        Nvm_tstrTimeResKey strTimeRes;   /* Time-restricted key quantifier  */
+        bool bOneTimeExpired;            /* One-time key used               */
+    }uKeyQuantifier;
+}Nvm_tstrRecordV1;
+
+/**
+ * Nvm_tenuBufferState Enumeration of the different states of a write buffer.
+*/
+typedef enum
+{
+    Nvm_BufferFree = 0, /* Buffer available                                  */
+    Nvm_BufferPending,  /* Buffer held until its FDS operation completes     */
+    Nvm_BufferAbandoned /* FDS operation couldn't be queued, buffer unneeded */
+}Nvm_tenuBufferState;
+
+/**
+ * Nvm_tstrCacheEntry Write-behind cache entry holding a record update yet to be written to flash.
+*/
+typedef struct
+{
+    Nvm_tstrRecord strRecord;          /* Latest record content                   */
+    fds_record_desc_t *pstrRcDesc;     /* Owner's descriptor, refreshed on flush  */
+    Nvm_tenuFiles enuFile;             /* File to be used for storage             */
+    TickType_t xLastChange;            /* Tick count of the latest change         */
+    bool bDirty;                       /* Entry holds an unwritten update         */
+}Nvm_tstrCacheEntry;
+
+/**
+ * Nvm_tstrRequest Record add, update or delete request awaiting completion.
+*/
+typedef struct
+{
+    uint16_t u16Request;               /* Request handle given to the requester  */
+    Nvm_tpfRequestComplete pfComplete; /* Completion callback, NULL if none      */
+    void *pvContext;                   /* Requester's context, passed back as is */
+}Nvm_tstrRequest;
+
+/**
+ * Nvm_tstrFlashCounter Usage counter slot, as stored in the counter pages.
+ *
+ * @note The NVMC allows a word to be written twice between erases. Each use word therefore
+ *       counts two uses: its lower half is cleared by the first one, the whole word by the next.
+*/
+typedef struct
+{
+    uint32_t u32OwnerBcd;                          /* BCD-encoded owner Id, erased if slot free  */
+    uint32_t u32Folded;                            /* Cleared once uses are held by owner record */
+    uint32_t u32Uses[NVM_COUNTER_USE_WORDS];       /* Use words                                  */
+}Nvm_tstrFlashCounter;
+
+/**
+ * Nvm_tenuCounterState Enumeration of the different states of a usage counter slot.
+*/
+typedef enum
+{
+    Nvm_CounterFree = 0, /* Slot erased, available                               */
+    Nvm_CounterLive,     /* Slot holds uses its owner's record doesn't           */
+    Nvm_CounterFolding,  /* Owner's record is being rewritten to take uses in    */
+    Nvm_CounterFolded    /* Owner's record holds slot's uses, slot awaits erase  */
+}Nvm_tenuCounterState;
+
+/**
+ * Nvm_tstrCounterSlot Usage counter slot, as mirrored in RAM.
+*/
+typedef struct
+{
+    uint32_t u32OwnerBcd;             /* BCD-encoded owner Id, also the data written to flash */
+    uint8_t u8Uses;                   /* Number of uses counted in the slot                   */
+    Nvm_tenuCounterState enuState;    /* Slot state                                           */
+}Nvm_tstrCounterSlot;
+
+/**
+ * Nvm_tstrRecentUser Recently signed-in user's record, as packed in flash.
+*/
+typedef struct
+{
+    uint32_t u32Id;                   /* User Id in its integer form            */
+    uint32_t u32RecordId;             /* FDS record Id, 0 if entry is free      */
+    Nvm_tstrFlashRecord strRecord;    /* Record content when it was last read   */
+}Nvm_tstrRecentUser;
+
+/**
+ * Nvm_tstrCheckpoint User index checkpoint, kept in retained RAM across System OFF.
+*/
+typedef struct
+{
+    uint32_t u32Magic;                                      /* NVM_CHECKPOINT_MAGIC while valid   */
+    uint32_t u32LatestRecordId;                             /* Latest FDS record Id when taken    */
+    uint32_t u32IndexOverflow;                              /* Index overflow flag when taken     */
+    Nvm_tstrIndexEntry strUserIndex[MID_NVM_INDEX_SIZE];    /* User index                         */
+    uint32_t u32UserFilter[NVM_BLOOM_WORDS];                /* Bloom filter over registered users */
+    Nvm_tstrRecentUser strRecentUsers[MID_NVM_RECENT_USERS];/* Recently signed-in users           */
+    uint32_t u32Check;                                      /* Check value over the fields above  */
+}Nvm_tstrCheckpoint;
+
+/**
+ * Nvm_tstrTxnJournal Transaction's staged changes, also the data of its intent record.
+ *
+ * @note Changes are records packed as they're written to flash, except count-restricted keys
+ *       hold their total use count. Deletions only carry the user's Id and the
+ *       NVM_TXN_DELETE_VERSION tag. Only the changes staged are part of the intent record.
+*/
+typedef struct
+{
+    uint32_t u32OpCount;                               /* Number of changes staged */
+    Nvm_tstrFlashRecord strOps[MID_NVM_TXN_SIZE];      /* One change per user      */
+}Nvm_tstrTxnJournal;
+
+/**
+ * Nvm_tenuTxnState Enumeration of the different states of a transaction.
+*/
+typedef enum
+{
+    Nvm_TxnIdle = 0,    /* No transaction under way                                    */
+    Nvm_TxnStaging,     /* Changes being staged in RAM                                 */
+    Nvm_TxnJournaling,  /* Intent record being written                                 */
+    Nvm_TxnApplying,    /* Committed, changes being applied                            */
+    Nvm_TxnClosing,     /* Changes applied, intent record being deleted                */
+    Nvm_TxnStalled      /* Intent record left to be rolled forward on next boot        */
+}Nvm_tenuTxnState;
+
+/**
+ * Nvm_tenuTxnStep Enumeration of the different outcomes of applying a staged change.
+*/
+typedef enum
+{
+    Nvm_TxnOpQueued = 0, /* Operation queued, completion follows             */
+    Nvm_TxnOpSkipped,    /* Flash storage already holds the change           */
+    Nvm_TxnOpRejected    /* Operation couldn't be queued                     */
+}Nvm_tenuTxnStep;
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Flag indicating whether NVM_Service is initialized */
+static bool bIsInitialized = false;
+
+/* Flag indicating whether a user couldn't be added to the index because it was full */
+static bool bIndexOverflow = false;
+
+/* Open-addressing hash index mapping user Ids to FDS record Ids */
+static Nvm_tstrIndexEntry strUserIndex[MID_NVM_INDEX_SIZE];
+
+/* Bloom filter over registered user Ids. Ids it doesn't hold are definitely not registered */
+static uint32_t u32UserFilter[NVM_BLOOM_WORDS];
+
+/* Recently signed-in users' records, most recent first */
+static Nvm_tstrRecentUser strRecentUsers[MID_NVM_RECENT_USERS];
+
+/* Checkpoint of the user index taken right before entering System OFF */
+static MID_RETAINED Nvm_tstrCheckpoint strCheckpoint;
+
+/* Flag indicating whether the checkpoint survived the last reset and may be restored */
+static bool bCheckpointUsable = false;
+
+/* Figures on how the index was made ready, and when enuNvm_Init started making it ready */
+static Nvm_tstrBootStats strBootStats = {0};
+static bool bBootStatsReady = false;
+static uint32_t u32BootStart = 0;
+
+/* Flag indicating whether a legacy record is being moved to its collision-free keys */
+static bool bMigrationInFlight = false;
+
+/* Flag indicating whether the last search for legacy records found one */
+static bool bLegacyRecordsLeft = true;
+
+/* Keys the legacy record currently being migrated is rewritten under */
+static uint16_t u16MigrationFileId;
+static uint16_t u16MigrationRecordKey;
+
+/* Packed records being written. FDS requires written data to remain available until the
+   operation completes. FDS processes operations in order, so buffers are released in the order
+   they were acquired */
+static Nvm_tstrFlashRecord strWriteBuffer[NVM_WRITE_BUFFER_COUNT];
+static Nvm_tenuBufferState enuWriteBufferState[NVM_WRITE_BUFFER_COUNT];
+static uint8_t u8WriteBufferHead = 0;
+static uint8_t u8WriteBufferCount = 0;
+
+/* Record requests in the order they were queued. FDS completes operations in order, so every
+   completion event of NVM_Service's files belongs to the oldest request */
+static Nvm_tstrRequest strRequestQueue[NVM_REQUEST_QUEUE_SIZE];
+static uint8_t u8RequestHead = 0;
+static uint8_t u8RequestCount = 0;
+static uint16_t u16LastRequest = NVM_INVALID_REQUEST;
+
+/* Batch of new records written into flash space reserved for all of them up front. Batch writes
+   leave one request to other requesters */
+static Nvm_tstrRecord const *pstrBatchRecords = NULL;
+static fds_reserve_token_t strBatchTokens[MID_NVM_BATCH_SIZE];
+static uint16_t u16BatchCount = 0;
+static uint16_t u16BatchNext = 0;
+static uint16_t u16BatchAdded = 0;
+static uint16_t u16BatchFailed = 0;
+static uint8_t u8BatchInFlight = 0;
+static bool bBatchPumping = false;
+static Nvm_tpfBatchComplete pfBatchComplete = NULL;
+static void *pvBatchContext = NULL;
+
+/* Transaction staged, committed through its intent record or rolled forward from it on boot.
+   Flash space is reserved for the intent record and every record written up front */
+static Nvm_tstrTxnJournal strTxnJournal;
+static Nvm_tenuTxnState enuTxnState = Nvm_TxnIdle;
+static fds_reserve_token_t strTxnTokens[MID_NVM_TXN_SIZE];
+static fds_reserve_token_t strTxnIntentToken;
+static fds_record_desc_t strTxnIntentDesc;
+static uint16_t u16TxnNext = 0;
+static uint16_t u16TxnDone = 0;
+static uint16_t u16TxnFailed = 0;
+static uint8_t u8TxnInFlight = 0;
+static bool bTxnPumping = false;
+static bool bTxnRecovering = false;
+static Nvm_tpfTransactionComplete pfTxnComplete = NULL;
+static void *pvTxnContext = NULL;
+
+/* Write-behind cache coalescing record updates that don't need to reach flash right away */
+static Nvm_tstrCacheEntry strRecordCache[MID_NVM_CACHE_SIZE];
+static volatile uint8_t u8CacheDirtyCount = 0;
+
+/* Number of flash operations queued by NVM_Service that haven't completed yet */
+static volatile uint8_t u8PendingOps = 0;
+
+/* Flag indicating whether garbage collection was requested by NVM_Service */
+static volatile bool bGcRequested = false;
+
+/* Flag indicating whether records were invalidated since flash storage statistics were checked */
+static volatile bool bDirtinessChanged = true;
+
+/* Number of record views currently open. Garbage collection is held back while there's any */
+static volatile uint8_t u8OpenViews = 0;
+
+/* Expiry reaper's position in flash storage and tick count its last pass was completed at */
+static fds_find_token_t strReapToken = {0};
+static bool bReapPassActive = false;
+static TickType_t xLastReapPass = 0;
+
+/* Usage counter slots of count-restricted keys. Slots are handed out in order and all of them
+   are erased at once after their uses were folded back into their owners' records */
+static Nvm_tstrCounterSlot strCounterSlot[NVM_COUNTER_SLOTS];
+static uint16_t u16CounterNextFree = 0;
+static uint16_t u16CounterFolding = NVM_COUNTER_NO_SLOT;
+static volatile uint8_t u8CounterPendingOps = 0;
+static bool bCounterReady = false;
+static volatile bool bCounterErasing = false;
+
+/* Use and fold words written to the counter pages. fstorage requires written data to remain
+   available until the operation completes. Indexed by the number of uses a word already holds */
+static uint32_t u32CounterWord[2] = {NVM_COUNTER_HALF_WORD, NVM_COUNTER_CLEARED_WORD};
+
+/* Garbage collection progress and completion hooks */
+static Nvm_tpfGcProgress pfGcProgress = NULL;
+static Nvm_tpfGcComplete pfGcComplete = NULL;
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static void vidCounterEventHandler(nrf_fstorage_evt_t *pstrEvent);
+
+/* Usage counters' flash area. Its bounds are set at initialization time */
+NRF_FSTORAGE_DEF(nrf_fstorage_t strCounterFs) =
+{
+    .evt_handler = vidCounterEventHandler,
+    .start_addr  = 0,
+    .end_addr    = 0
+};
+
+static uint32_t u32IdToInteger(uint8_t const *pu8Id)
+{
+    uint32_t u32RetVal = 0;
+
+    /* User Ids are 8 ASCII digits long which always fits in 27 bits */
+    for(uint8_t u8Index = 0; u8Index < NVM_ID_LENGTH; u8Index++)
+    {
+        u32RetVal = (u32RetVal * 10) + (uint32_t)(pu8Id[u8Index] - '0');
+    }
+
+    return u32RetVal;
+}
+
+static uint32_t u32IdToBcd(uint8_t const *pu8Id)
+{
+    uint32_t u32RetVal = 0;
+
+    /* One nibble per digit, most significant digit first */
+    for(uint8_t u8Index = 0; u8Index < NVM_ID_LENGTH; u8Index++)
+    {
+        u32RetVal = (u32RetVal << 4) | (uint32_t)(pu8Id[u8Index] - '0');
+    }
+
+    return u32RetVal;
+}
+
+static uint32_t u32BcdToInteger(uint32_t u32Bcd)
+{
+    uint32_t u32RetVal = 0;
+
+    for(uint8_t u8Index = 0; u8Index < NVM_ID_LENGTH; u8Index++)
+    {
+        u32RetVal = (u32RetVal * 10) + ((u32Bcd >> (4 * (NVM_ID_LENGTH - 1 - u8Index))) & 0x0F);
+    }
+
+    return u32RetVal;
+}
+
+static void vidBcdToId(uint32_t u32Bcd, uint8_t *pu8Id)
+{
+    for(uint8_t u8Index = 0; u8Index < NVM_ID_LENGTH; u8Index++)
+    {
+        pu8Id[u8Index] = '0' + ((u32Bcd >> (4 * (NVM_ID_LENGTH - 1 - u8Index))) & 0x0F);
+    }
+}
+
+static uint32_t u32FlashEndAddr(void)
+{
+#if (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    /* The host image has no code or bootloader to skip */
+    return nrf_fstorage_host_end_addr();
+#else
+    /* Application's flash space ends at the bootloader, if there is one, or at the end of flash */
+    return (BOOTLOADER_ADDRESS != 0xFFFFFFFF)?BOOTLOADER_ADDRESS:(NRF_FICR->CODESIZE * NRF_FICR->CODEPAGESIZE);
+#endif
+}
+
+static uint8_t u8CounterWordUses(uint32_t u32Word)
+{
+    uint8_t u8RetVal = 2;
+
+    /* Words torn by a reset are counted as fully used, over-counting is the safe side */
+    if(NVM_COUNTER_ERASED_WORD == u32Word)
+    {
+        u8RetVal = 0;
+    }
+    else if(NVM_COUNTER_HALF_WORD == u32Word)
+    {
+        u8RetVal = 1;
+    }
+
+    return u8RetVal;
+}
+
+static uint16_t u16CounterUses(uint32_t u32OwnerBcd, bool bFolding)
+{
+    uint16_t u16RetVal = 0;
+
+    for(uint16_t u16Slot = 0; u16Slot < u16CounterNextFree; u16Slot++)
+    {
+        if((strCounterSlot[u16Slot].u32OwnerBcd == u32OwnerBcd) &&
+           ((Nvm_CounterLive == strCounterSlot[u16Slot].enuState) ||
+            (bFolding && (Nvm_CounterFolding == strCounterSlot[u16Slot].enuState))))
+        {
+            u16RetVal += strCounterSlot[u16Slot].u8Uses;
+        }
+    }
+
+    return u16RetVal;
+}
+
+static void vidCounterRecover(void)
+{
+    Nvm_tstrFlashCounter const *pstrFlashCounter;
+
+    memset(strCounterSlot, 0, sizeof(strCounterSlot));
+    u16CounterNextFree = 0;
+
+    /* Slots are handed out in order, free ones are all found after the last one in use */
+    for(uint16_t u16Slot = 0; u16Slot < NVM_COUNTER_SLOTS; u16Slot++)
+    {
+        pstrFlashCounter = (Nvm_tstrFlashCounter const *)(uintptr_t)NVM_COUNTER_SLOT_ADDR(u16Slot);
+
+        if(NVM_COUNTER_ERASED_WORD != pstrFlashCounter->u32OwnerBcd)
+        {
+            strCounterSlot[u16Slot].u32OwnerBcd = pstrFlashCounter->u32OwnerBcd;
+            strCounterSlot[u16Slot].enuState = (NVM_COUNTER_ERASED_WORD == pstrFlashCounter->u32Folded)
+                                               ?Nvm_CounterLive
+                                               :Nvm_CounterFolded;
+            for(uint8_t u8Word = 0; u8Word < NVM_COUNTER_USE_WORDS; u8Word++)
+            {
+                strCounterSlot[u16Slot].u8Uses += u8CounterWordUses(pstrFlashCounter->u32Uses[u8Word]);
+            }
+            u16CounterNextFree = u16Slot + 1;
+        }
+    }
+}
+
+static void vidCounterFoldWrite(uint16_t u16Slot)
+{
+    /* Slot's uses are no longer counted whether or not the fold word makes it to flash. If it
+       doesn't, they are counted again after a reset, which over-counts */
+    strCounterSlot[u16Slot].enuState = Nvm_CounterFolded;
+
+    /* Operation is accounted for before being queued as it may complete right away */
+    u8CounterPendingOps++;
+    if(NRF_SUCCESS != nrf_fstorage_write(&strCounterFs,
+                                         NVM_COUNTER_SLOT_ADDR(u16Slot) + offsetof(Nvm_tstrFlashCounter, u32Folded),
+                                         &u32CounterWord[1], sizeof(uint32_t), NULL))
+    {
+        u8CounterPendingOps--;
+    }
+}
+
+static void vidCounterRetire(uint32_t u32Id)
+{
+    /* Slots left behind by a deleted user must not be counted against a new key of the same Id */
+    CRITICAL_REGION_ENTER();
+    for(uint16_t u16Slot = 0; u16Slot < u16CounterNextFree; u16Slot++)
+    {
+        if((u32BcdToInteger(strCounterSlot[u16Slot].u32OwnerBcd) == u32Id) &&
+           (Nvm_CounterLive == strCounterSlot[u16Slot].enuState))
+        {
+            vidCounterFoldWrite(u16Slot);
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static bool bCounterAdd(uint32_t u32OwnerBcd)
+{
+    bool bRetVal = false;
+    uint16_t u16Slot = NVM_COUNTER_NO_SLOT;
+    Nvm_tstrCounterSlot *pstrSlot;
+
+    CRITICAL_REGION_ENTER();
+    if(bCounterReady && !bCounterErasing)
+    {
+        /* Keep counting in owner's live slot if it has room left */
+        for(uint16_t u16Index = 0; (NVM_COUNTER_NO_SLOT == u16Slot) && (u16Index < u16CounterNextFree); u16Index++)
+        {
+            if((strCounterSlot[u16Index].u32OwnerBcd == u32OwnerBcd) &&
+               (Nvm_CounterLive == strCounterSlot[u16Index].enuState) &&
+               (strCounterSlot[u16Index].u8Uses < NVM_COUNTER_SLOT_USES))
+            {
+                u16Slot = u16Index;
+            }
+        }
+
+        /* Otherwise claim the next free slot by writing its owner word */
+        if((NVM_COUNTER_NO_SLOT == u16Slot) && (u16CounterNextFree < NVM_COUNTER_SLOTS))
+        {
+            pstrSlot = &strCounterSlot[u16CounterNextFree];
+            pstrSlot->u32OwnerBcd = u32OwnerBcd;
+            pstrSlot->u8Uses = 0;
+            u8CounterPendingOps++;
+            if(NRF_SUCCESS == nrf_fstorage_write(&strCounterFs, NVM_COUNTER_SLOT_ADDR(u16CounterNextFree),
+                                                 &pstrSlot->u32OwnerBcd, sizeof(uint32_t), NULL))
+            {
+                pstrSlot->enuState = Nvm_CounterLive;
+                u16Slot = u16CounterNextFree++;
+            }
+            else
+            {
+                u8CounterPendingOps--;
+            }
+        }
+
+        /* A use costs a single word write: the lower half of a use word, then the rest of it */
+        if(NVM_COUNTER_NO_SLOT != u16Slot)
+        {
+            pstrSlot = &strCounterSlot[u16Slot];
+            u8CounterPendingOps++;
+            bRetVal = (NRF_SUCCESS == nrf_fstorage_write(&strCounterFs,
+                                                         NVM_COUNTER_SLOT_ADDR(u16Slot) + offsetof(Nvm_tstrFlashCounter, u32Uses) +
+                                                         ((pstrSlot->u8Uses / 2) * sizeof(uint32_t)),
+                                                         &u32CounterWord[pstrSlot->u8Uses % 2], sizeof(uint32_t), NULL));
+            if(bRetVal)
+            {
+                pstrSlot->u8Uses++;
+            }
+            else
+            {
+                u8CounterPendingOps--;
+            }
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return bRetVal;
+}
+
+static void vidCounterEventHandler(nrf_fstorage_evt_t *pstrEvent)
+{
+    /* Make sure valid arguments are passed */
+    if(pstrEvent)
+    {
+        CRITICAL_REGION_ENTER();
+        u8CounterPendingOps--;
+
+        /* Pages are only erased once all slots are folded, every one of them is free again */
+        if(NRF_FSTORAGE_EVT_ERASE_RESULT == pstrEvent->id)
+        {
+            if(NRF_SUCCESS == pstrEvent->result)
+            {
+                memset(strCounterSlot, 0, sizeof(strCounterSlot));
+                u16CounterNextFree = 0;
+            }
+            bCounterErasing = false;
+        }
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+static void vidPackRecord(Nvm_tstrFlashRecord *pstrFlashRecord, Nvm_tstrRecord const *pstrRecord)
+{
+    memset(pstrFlashRecord, 0, sizeof(Nvm_tstrFlashRecord));
+
+    pstrFlashRecord->u8Version = NVM_RECORD_VERSION;
+    pstrFlashRecord->u8KeyInfo = (uint8_t)pstrRecord->enuKeyType & NVM_KEY_TYPE_MASK;
+    pstrFlashRecord->u32IdBcd = u32IdToBcd(pstrRecord->u8Id);
+    pstrFlashRecord->u32LastKnownUse = pstrRecord->u32LastKnownUse;
+    memcpy(pstrFlashRecord->u8Password, pstrRecord->u8Password, NVM_PWD_SIZE);
+
+    /* Only keep key quantifier fields relevant to user's key type */
+    switch(pstrRecord->enuKeyType)
+    {
+    case App_OneTimeKey:
+        pstrFlashRecord->u8KeyInfo |= pstrRecord->uKeyQuantifier.bOneTimeExpired?NVM_KEY_ONE_TIME_USED:0;
+        break;
+
+    case App_CountRestrictedKey:
+    {
+        /* Uses still held by live counter slots are not part of the record. Those of a slot being
+           folded are, the slot stops being counted once the record is written */
+        uint16_t u16SlotUses = u16CounterUses(pstrFlashRecord->u32IdBcd, false);
+
+        pstrFlashRecord->u16KeyParam = pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit;
+        pstrFlashRecord->u32KeyState = (pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount > u16SlotUses)
+                                       ?(pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount - u16SlotUses)
+                                       :0;
+    }
+    break;
+
+    case App_TimeRestrictedKey:
+        pstrFlashRecord->u8KeyInfo |= pstrRecord->uKeyQuantifier.strTimeRes.bIsKeyActive?NVM_KEY_TIME_ACTIVE:0;
+        pstrFlashRecord->u16KeyParam = pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout;
+        pstrFlashRecord->u32KeyState = pstrRecord->uKeyQuantifier.strTimeRes.u32ActivationTime;
+        break;
+
+    default:
+        /* Nothing to do */
+        break;
+    }
+}
+
+static void vidUnpackRecord(Nvm_tstrRecord *pstrRecord, void const *pvData)
+{
+    memset(pstrRecord, 0, sizeof(Nvm_tstrRecord));
+
+    if(NVM_RECORD_VERSION == *(uint8_t const *)pvData)
+    {
+        Nvm_tstrFlashRecord const *pstrFlashRecord = (Nvm_tstrFlashRecord const *)pvData;
+
+        vidBcdToId(pstrFlashRecord->u32IdBcd, pstrRecord->u8Id);
+        memcpy(pstrRecord->u8Password, pstrFlashRecord->u8Password, NVM_PWD_SIZE);
+        pstrRecord->u32LastKnownUse = pstrFlashRecord->u32LastKnownUse;
+        pstrRecord->enuKeyType = (App_tenuKeyTypes)(pstrFlashRecord->u8KeyInfo & NVM_KEY_TYPE_MASK);
+
+        switch(pstrRecord->enuKeyType)
+        {
+        case App_OneTimeKey:
+            pstrRecord->uKeyQuantifier.bOneTimeExpired = (pstrFlashRecord->u8KeyInfo & NVM_KEY_ONE_TIME_USED) != 0;
+            break;
+
+        case App_CountRestrictedKey:
+            pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit = pstrFlashRecord->u16KeyParam;
+            pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount = (uint16_t)pstrFlashRecord->u32KeyState;
+            break;
+
+        case App_TimeRestrictedKey:
+            pstrRecord->uKeyQuantifier.strTimeRes.bIsKeyActive = (pstrFlashRecord->u8KeyInfo & NVM_KEY_TIME_ACTIVE) != 0;
+            pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout = pstrFlashRecord->u16KeyParam;
+            pstrRecord->uKeyQuantifier.strTimeRes.u32ActivationTime = pstrFlashRecord->u32KeyState;
+            break;
+
+        default:
+            /* Nothing to do */
+            break;
+        }
+    }
+    else
+    {
+        /* Version 1 records start with an ASCII Id digit rather than a version tag */
+        Nvm_tstrRecordV1 strRecordV1;
+
+        memcpy(&strRecordV1, pvData, sizeof(Nvm_tstrRecordV1));
+        memcpy(pstrRecord->u8Id, strRecordV1.u8Id, NVM_ID_SIZE);
+        memcpy(pstrRecord->u8Password, strRecordV1.u8Password, NVM_PWD_SIZE);
+        memcpy(&pstrRecord->uKeyQuantifier, &strRecordV1.uKeyQuantifier, sizeof(pstrRecord->uKeyQuantifier));
+        pstrRecord->enuKeyType = strRecordV1.enuKeyType;
+
+        /* Keys that were never used hold a zeroed out date */
+        pstrRecord->u32LastKnownUse = strRecordV1.strLastKnownUse.day_date_time.date_time.year
+                                      ?u32TimeToEpoch(&strRecordV1.strLastKnownUse)
+                                      :0;
+    }
+
+    /* Uses counted since the record was last written are held by usage counter slots */
+    if(App_CountRestrictedKey == pstrRecord->enuKeyType)
+    {
+        pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount += u16CounterUses(u32IdToBcd(pstrRecord->u8Id), true);
+    }
+}
+
+static Nvm_tstrFlashRecord *pstrWriteBufferAcquire(void)
+{
+    Nvm_tstrFlashRecord *pstrRetVal = NULL;
+
+    /* Write buffers are shared between application tasks and the FDS event handler */
+    CRITICAL_REGION_ENTER();
+    if(u8WriteBufferCount < NVM_WRITE_BUFFER_COUNT)
+    {
+        uint8_t u8Slot = (u8WriteBufferHead + u8WriteBufferCount) % NVM_WRITE_BUFFER_COUNT;
+
+        enuWriteBufferState[u8Slot] = Nvm_BufferPending;
+        u8WriteBufferCount++;
+        pstrRetVal = &strWriteBuffer[u8Slot];
+    }
+    CRITICAL_REGION_EXIT();
+
+    return pstrRetVal;
+}
+
+static void vidWriteBufferRelease(Nvm_tstrFlashRecord const *pstrBuffer)
+{
+    CRITICAL_REGION_ENTER();
+    if(pstrBuffer)
+    {
+        /* Operation couldn't be queued. Buffer will be skipped once it reaches the head */
+        enuWriteBufferState[pstrBuffer - strWriteBuffer] = Nvm_BufferAbandoned;
+    }
+    else if(u8WriteBufferCount && (Nvm_BufferPending == enuWriteBufferState[u8WriteBufferHead]))
+    {
+        /* Oldest pending operation completed */
+        enuWriteBufferState[u8WriteBufferHead] = Nvm_BufferAbandoned;
+    }
+
+    /* Free buffers no longer needed */
+    while(u8WriteBufferCount && (Nvm_BufferAbandoned == enuWriteBufferState[u8WriteBufferHead]))
+    {
+        enuWriteBufferState[u8WriteBufferHead] = Nvm_BufferFree;
+        u8WriteBufferHead = (u8WriteBufferHead + 1) % NVM_WRITE_BUFFER_COUNT;
+        u8WriteBufferCount--;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void vidPendingOpStarted(void)
+{
+    CRITICAL_REGION_ENTER();
+    u8PendingOps++;
+    CRITICAL_REGION_EXIT();
+}
+
+static void vidPendingOpCompleted(void)
+{
+    bool bIdle;
+
+    CRITICAL_REGION_ENTER();
+    u8PendingOps -= u8PendingOps?1:0;
+    bIdle = (0 == u8PendingOps);
+    CRITICAL_REGION_EXIT();
+
+    if(bIdle)
+    {
+        /* Notify Ble_Service of flash storage having no operation left in flight */
+        vidFlashStorageIdleCallback();
+    }
+}
+
+static uint16_t u16RequestStarted(Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    uint16_t u16RetVal = NVM_INVALID_REQUEST;
+    Nvm_tstrRequest *pstrRequest;
+
+    /* Request is accounted for before its operation is queued as it may complete right away */
+    CRITICAL_REGION_ENTER();
+    if(u8RequestCount < NVM_REQUEST_QUEUE_SIZE)
+    {
+        /* Handles wrap around, skipping the invalid one */
+        u16LastRequest = (NVM_INVALID_REQUEST == (uint16_t)(u16LastRequest + 1))?(u16LastRequest + 2):(u16LastRequest + 1);
+        u16RetVal = u16LastRequest;
+
+        pstrRequest = &strRequestQueue[(u8RequestHead + u8RequestCount) % NVM_REQUEST_QUEUE_SIZE];
+        pstrRequest->u16Request = u16RetVal;
+        pstrRequest->pfComplete = pfComplete;
+        pstrRequest->pvContext = pvContext;
+        u8RequestCount++;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return u16RetVal;
+}
+
+static void vidRequestAbandoned(void)
+{
+    /* Operation couldn't be queued. Its request was the last one started */
+    CRITICAL_REGION_ENTER();
+    u8RequestCount -= u8RequestCount?1:0;
+    CRITICAL_REGION_EXIT();
+}
+
+static void vidRequestCompleted(ret_code_t xResult)
+{
+    Nvm_tstrRequest strRequest = {0};
+
+    CRITICAL_REGION_ENTER();
+    if(u8RequestCount)
+    {
+        memcpy(&strRequest, &strRequestQueue[u8RequestHead], sizeof(Nvm_tstrRequest));
+        u8RequestHead = (u8RequestHead + 1) % NVM_REQUEST_QUEUE_SIZE;
+        u8RequestCount--;
+    }
+    CRITICAL_REGION_EXIT();
+
+    /* Callback is invoked outside of the critical region, it may queue further requests */
+    if(strRequest.pfComplete)
+    {
+        strRequest.pfComplete(strRequest.u16Request,
+                              (NRF_SUCCESS == xResult)?Middleware_Success:Middleware_Failure,
+                              strRequest.pvContext);
+    }
+}
+
+static Nvm_tstrCacheEntry *pstrCacheLookup(uint8_t const *pu8Id)
+{
+    Nvm_tstrCacheEntry *pstrRetVal = NULL;
+
+    for(uint8_t u8Index = 0; u8Index < MID_NVM_CACHE_SIZE; u8Index++)
+    {
+        if(strRecordCache[u8Index].bDirty &&
+           (0 == memcmp(strRecordCache[u8Index].strRecord.u8Id, pu8Id, NVM_ID_SIZE)))
+        {
+            pstrRetVal = &strRecordCache[u8Index];
+            break;
+        }
+    }
+
+    return pstrRetVal;
+}
+
+static void vidCacheDrop(uint8_t const *pu8Id)
+{
+    CRITICAL_REGION_ENTER();
+    Nvm_tstrCacheEntry *pstrEntry = pstrCacheLookup(pu8Id);
+    if(pstrEntry)
+    {
+        pstrEntry->bDirty = false;
+        u8CacheDirtyCount--;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static bool bRecentLookup(uint32_t u32RecordId, Nvm_tstrFlashRecord *pstrRecord)
+{
+    bool bRetVal = false;
+
+    CRITICAL_REGION_ENTER();
+    for(uint8_t u8Index = 0; u8Index < MID_NVM_RECENT_USERS; u8Index++)
+    {
+        if(u32RecordId && (u32RecordId == strRecentUsers[u8Index].u32RecordId))
+        {
+            memcpy(pstrRecord, &strRecentUsers[u8Index].strRecord, sizeof(Nvm_tstrFlashRecord));
+            bRetVal = true;
+            break;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+
+    return bRetVal;
+}
+
+static void vidRecentAdd(uint32_t u32RecordId, Nvm_tstrFlashRecord const *pstrRecord)
+{
+    uint32_t u32Id = u32BcdToInteger(pstrRecord->u32IdBcd);
+    uint8_t u8Last = MID_NVM_RECENT_USERS - 1;
+
+    CRITICAL_REGION_ENTER();
+    /* User's own entry is reused if there's one, the least recent one is evicted otherwise */
+    for(uint8_t u8Index = 0; u8Index < MID_NVM_RECENT_USERS; u8Index++)
+    {
+        if(strRecentUsers[u8Index].u32RecordId && (u32Id == strRecentUsers[u8Index].u32Id))
+        {
+            u8Last = u8Index;
+            break;
+        }
+    }
+
+    memmove(&strRecentUsers[1], &strRecentUsers[0], u8Last * sizeof(Nvm_tstrRecentUser));
+    strRecentUsers[0].u32Id = u32Id;
+    strRecentUsers[0].u32RecordId = u32RecordId;
+    memcpy(&strRecentUsers[0].strRecord, pstrRecord, sizeof(Nvm_tstrFlashRecord));
+    CRITICAL_REGION_EXIT();
+}
+
+static void vidRecentDrop(uint32_t u32Id)
+{
+    /* Records written for a user supersede what was read before */
+    CRITICAL_REGION_ENTER();
+    for(uint8_t u8Index = 0; u8Index < MID_NVM_RECENT_USERS; u8Index++)
+    {
+        if(u32Id == strRecentUsers[u8Index].u32Id)
+        {
+            strRecentUsers[u8Index].u32RecordId = 0;
+        }
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static uint32_t u32IndexHash(uint32_t u32Id)
+{
+    /* Fibonacci hashing spreads consecutive Ids evenly across the table */
+    uint32_t u32Hash = u32Id * NVM_INDEX_HASH_MULTIPLIER;
+    return (u32Hash ^ (u32Hash >> 16)) & (MID_NVM_INDEX_SIZE - 1);
+}
+
+static void vidIndexInsert(uint32_t u32Id, uint32_t u32RecordId)
+{
+    uint32_t u32Slot = u32IndexHash(u32Id);
+    Nvm_tstrIndexEntry *pstrTarget = NULL;
+
+    /* Linear probing. An Id that is already indexed gets its record Id overwritten, which is how
+       record updates are accounted for. Otherwise the first reusable slot met along the probe
+       sequence is used. */
+    uint32_t u32Latest = u32RecordId;
+    for(uint32_t u32Probe = 0; u32Probe < MID_NVM_INDEX_SIZE; u32Probe++)
+    {
+        Nvm_tstrIndexEntry *pstrEntry = &strUserIndex[(u32Slot + u32Probe) & (MID_NVM_INDEX_SIZE - 1)];
+
+        if(u32Id == pstrEntry->u32Id)
+        {
+            /* FDS hands out record Ids in increasing order, so when an update was cut short before
+               the outdated record got deleted, the higher one wins whichever order records are
+               iterated in at boot */
+            pstrTarget = pstrEntry;
+            u32Latest = MAX(u32RecordId, pstrEntry->u32RecordId);
+            break;
+        }
+        else if(NVM_INDEX_EMPTY_SLOT == pstrEntry->u32Id)
+        {
+            pstrTarget = pstrTarget?pstrTarget:pstrEntry;
+            break;
+        }
+        else if((NVM_INDEX_DELETED_SLOT == pstrEntry->u32Id) && (NULL == pstrTarget))
+        {
+            pstrTarget = pstrEntry;
+        }
+    }
+
+    if(pstrTarget)
+    {
+        pstrTarget->u32Id = u32Id;
+        pstrTarget->u32RecordId = u32Latest;
+    }
+    else
+    {
+        /* Index is full. Lookups will fall back to searching flash storage */
+        bIndexOverflow = true;
+    }
+}
+
+static Nvm_tstrIndexEntry *pstrIndexLookup(uint32_t u32Id)
+{
+    Nvm_tstrIndexEntry *pstrRetVal = NULL;
+    uint32_t u32Slot = u32IndexHash(u32Id);
+
+    for(uint32_t u32Probe = 0; u32Probe < MID_NVM_INDEX_SIZE; u32Probe++)
+    {
+        Nvm_tstrIndexEntry *pstrEntry = &strUserIndex[(u32Slot + u32Probe) & (MID_NVM_INDEX_SIZE - 1)];
+
+        if(u32Id == pstrEntry->u32Id)
+        {
+            /* Id located in index */
+            pstrRetVal = pstrEntry;
+            break;
+        }
+        else if(NVM_INDEX_EMPTY_SLOT == pstrEntry->u32Id)
+        {
+            /* End of probe sequence. Id isn't indexed */
+            break;
+        }
+    }
+
+    return pstrRetVal;
+}
+
+static void vidIndexRemove(uint32_t u32Id, uint32_t u32RecordId)
+{
+    Nvm_tstrIndexEntry *pstrEntry = pstrIndexLookup(u32Id);
+
+    /* Make sure entry still points to the deleted record. Removed entries are turned into
+       tombstones so they don't break other entries' probe sequences. */
+    if(pstrEntry && (u32RecordId == pstrEntry->u32RecordId))
+    {
+        pstrEntry->u32Id = NVM_INDEX_DELETED_SLOT;
+    }
+}
+
+static void vidIndexRemoveRecord(uint32_t u32RecordId)
+{
+    /* Legacy records' keys don't carry the full user Id, so deleting one of them requires a plain
+       sweep through the index */
+    for(uint32_t u32Slot = 0; u32Slot < MID_NVM_INDEX_SIZE; u32Slot++)
+    {
+        if((strUserIndex[u32Slot].u32RecordId == u32RecordId) &&
+           (strUserIndex[u32Slot].u32Id < NVM_INDEX_DELETED_SLOT))
+        {
+            strUserIndex[u32Slot].u32Id = NVM_INDEX_DELETED_SLOT;
+            break;
+        }
+    }
+}
+
+static uint32_t u32FilterBit(uint32_t u32Id, uint32_t u32Hash)
+{
+    /* Double hashing derives every probe from two independent hashes of the Id */
+    uint32_t u32Bit = (u32Id * NVM_INDEX_HASH_MULTIPLIER) + (u32Hash * ((u32Id * NVM_BLOOM_HASH_MULTIPLIER) | 1));
+    return (u32Bit ^ (u32Bit >> 16)) & (MID_NVM_BLOOM_BITS - 1);
+}
+
+static void vidFilterAdd(uint32_t u32Id)
+{
+    for(uint32_t u32Hash = 0; u32Hash < NVM_BLOOM_HASH_COUNT; u32Hash++)
+    {
+        uint32_t u32Bit = u32FilterBit(u32Id, u32Hash);
+        u32UserFilter[u32Bit / 32] |= (1UL << (u32Bit % 32));
+    }
+}
+
+static bool bFilterMayHold(uint32_t u32Id)
+{
+    bool bRetVal = true;
+
+    for(uint32_t u32Hash = 0; bRetVal && (u32Hash < NVM_BLOOM_HASH_COUNT); u32Hash++)
+    {
+        uint32_t u32Bit = u32FilterBit(u32Id, u32Hash);
+        bRetVal = (0 != (u32UserFilter[u32Bit / 32] & (1UL << (u32Bit % 32))));
+    }
+
+    return bRetVal;
+}
+
+static void vidFilterRebuild(void)
+{
+    /* Bits can't be taken out of a Bloom filter. Removing users requires building it all over
+       again, which only the index allows without going through flash storage. An overflowed
+       index leaves removed users' bits set, which only costs lookups a few more trips to flash
+       until the filter is built again on next boot */
+    if(!bIndexOverflow)
+    {
+        CRITICAL_REGION_ENTER();
+        memset(u32UserFilter, 0, sizeof(u32UserFilter));
+        for(uint32_t u32Slot = 0; u32Slot < MID_NVM_INDEX_SIZE; u32Slot++)
+        {
+            if(strUserIndex[u32Slot].u32Id < NVM_INDEX_DELETED_SLOT)
+            {
+                vidFilterAdd(strUserIndex[u32Slot].u32Id);
+            }
+        }
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+static void vidIndexRecord(fds_record_desc_t *pstrRecordDesc)
+{
+    fds_flash_record_t strFlashRecord = {0};
+
+    if(NRF_SUCCESS == fds_record_open(pstrRecordDesc, &strFlashRecord))
+    {
+        strBootStats.u16RecordsIndexed++;
+        if(NVM_IS_APP_FILE(strFlashRecord.p_header->file_id))
+        {
+            vidRecentDrop(NVM_ID_FROM_KEYS(strFlashRecord.p_header->file_id,
+                                           strFlashRecord.p_header->record_key));
+            vidIndexInsert(NVM_ID_FROM_KEYS(strFlashRecord.p_header->file_id,
+                                            strFlashRecord.p_header->record_key),
+                           strFlashRecord.p_header->record_id);
+            vidFilterAdd(NVM_ID_FROM_KEYS(strFlashRecord.p_header->file_id,
+                                          strFlashRecord.p_header->record_key));
+        }
+        else if(NVM_IS_LEGACY_FILE(strFlashRecord.p_header->file_id))
+        {
+            /* Legacy records are indexed using the Id they hold until they're migrated */
+            vidIndexInsert(u32IdToInteger(((Nvm_tstrRecordV1 const *)strFlashRecord.p_data)->u8Id),
+                           strFlashRecord.p_header->record_id);
+            vidFilterAdd(u32IdToInteger(((Nvm_tstrRecordV1 const *)strFlashRecord.p_data)->u8Id));
+        }
+        (void)fds_record_close(pstrRecordDesc);
+    }
+}
+
+static void vidIndexBuild(void)
+{
+    fds_record_desc_t strRecordDesc = {0};
+    fds_find_token_t strToken = {0};
+
+    /* Mark all index slots as empty and clear the filter */
+    memset(strUserIndex, 0xFF, sizeof(strUserIndex));
+    memset(u32UserFilter, 0, sizeof(u32UserFilter));
+    bIndexOverflow = false;
+
+    /* Users are spread over as many file Ids as needed to carry their Ids. Go through all records
+       once and index every application record found */
+    while(NRF_SUCCESS == fds_record_iterate(&strRecordDesc, &strToken))
+    {
+        vidIndexRecord(&strRecordDesc);
+    }
+}
+
+static uint32_t u32Timestamp(void)
+{
+#if (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    struct timespec strNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+    return (uint32_t)(((uint64_t)strNow.tv_sec * NVM_US_IN_SECOND) + ((uint64_t)strNow.tv_nsec / 1000));
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+static uint32_t u32CheckpointCheck(void)
+{
+    /* CRC-32 catches every burst of up to 32 flipped bits and any odd number of them, wherever
+       they are in retained RAM */
+    return u32Crc32(&strCheckpoint, offsetof(Nvm_tstrCheckpoint, u32Check));
+}
+
+static void vidIndexReady(void)
+{
+    uint32_t u32LatestRecordId = 0;
+    fds_record_desc_t strRecordDesc = {0};
+    fds_find_token_t strToken = {0};
+
+    strBootStats.u16RecordsIndexed = 0;
+    strBootStats.bFromCheckpoint = bCheckpointUsable &&
+                                   (NRF_SUCCESS == fds_latest_record_id_get(&u32LatestRecordId)) &&
+                                   (u32LatestRecordId >= strCheckpoint.u32LatestRecordId);
+
+    if(strBootStats.bFromCheckpoint)
+    {
+        /* Restore index as it was before entering System OFF. Records written since, by peer
+           manager as it is, carry newer record Ids. Only those are opened and indexed */
+        memcpy(strUserIndex, strCheckpoint.strUserIndex, sizeof(strUserIndex));
+        memcpy(u32UserFilter, strCheckpoint.u32UserFilter, sizeof(u32UserFilter));
+        memcpy(strRecentUsers, strCheckpoint.strRecentUsers, sizeof(strRecentUsers));
+        bIndexOverflow = (0 != strCheckpoint.u32IndexOverflow);
+        bLegacyRecordsLeft = false;
+
+        while(NRF_SUCCESS == fds_record_iterate(&strRecordDesc, &strToken))
+        {
+            if(strRecordDesc.record_id > strCheckpoint.u32LatestRecordId)
+            {
+                vidIndexRecord(&strRecordDesc);
+            }
+        }
+    }
+    else
+    {
+        /* Build user index once so Id lookups no longer need to scan flash storage */
+        vidIndexBuild();
+    }
+
+    /* Checkpoint only holds for a single wake, index changes from now on aren't part of it */
+    strCheckpoint.u32Magic = 0;
+    bCheckpointUsable = false;
+
+    strBootStats.u32ReadyTimeUs = (u32Timestamp() - u32BootStart) / NVM_TIMESTAMP_PER_US;
+    bBootStatsReady = true;
+}
+
+static Mid_tenuStatus enuRecordRead(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord,
+                                    Nvm_tstrRecord *pstrData, bool bSignedIn)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    Nvm_tstrFlashRecord strRecentRecord;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmReadRecord);
+
+    /* Make sure valid parameters are passed and NVM_Service is initialized */
+    if(pstrRecordDesc && pstrRecord && bIsInitialized)
+    {
+        if(bRecentLookup(pstrRecordDesc->record_id, &strRecentRecord))
+        {
+            /* Recently signed-in user. Record is served without going through flash storage */
+            memset(pstrRecord, 0, sizeof(fds_flash_record_t));
+            vidUnpackRecord(pstrData, &strRecentRecord);
+            if(bSignedIn)
+            {
+                vidRecentAdd(pstrRecordDesc->record_id, &strRecentRecord);
+            }
+            enuRetVal = Middleware_Success;
+        }
+        /* Open record */
+        else if(NRF_SUCCESS == fds_record_open(pstrRecordDesc, pstrRecord))
+        {
+            /* Unpack data content out of NVM storage record */
+            vidUnpackRecord(pstrData, pstrRecord->p_data);
+
+            /* Keep signed-in user's record around. Records still in the version 1 format are
+               left to be migrated first */
+            if(bSignedIn && (NVM_RECORD_VERSION == *(uint8_t const *)pstrRecord->p_data))
+            {
+                vidRecentAdd(pstrRecordDesc->record_id, (Nvm_tstrFlashRecord const *)pstrRecord->p_data);
+            }
+
+            /* Close record when done reading to allow garbage collection to eventually reclaim
+               record's memory space in flash */
+            enuRetVal = (NRF_SUCCESS == fds_record_close(pstrRecordDesc))
+                                                        ?Middleware_Success
+                                                        :Middleware_Failure;
+        }
+
+        if(Middleware_Success == enuRetVal)
+        {
+            /* Changes yet to be written back take precedence over flash content */
+            CRITICAL_REGION_ENTER();
+            Nvm_tstrCacheEntry const *pstrEntry = pstrCacheLookup(pstrData->u8Id);
+            if(pstrEntry)
+            {
+                memcpy(pstrData, &pstrEntry->strRecord, sizeof(Nvm_tstrRecord));
+            }
+            CRITICAL_REGION_EXIT();
+        }
+    }
+
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmReadRecord);
+
+    return enuRetVal;
+}
+
+static bool bFindByKeys(uint32_t u32Id, fds_record_desc_t *pstrRecordDesc)
+{
+    fds_find_token_t strPersistentToken = {0};
+    fds_find_token_t strExpirableToken = {0};
+
+    /* Slow path only used once the index has overflowed. Ids are fully encoded in FDS keys so
+       there's at most one exact match */
+    return (NRF_SUCCESS == fds_record_find(NVM_FILE_ID(NVM_PERSISTENT_KEYS_FILE_BASE, u32Id),
+                                           NVM_RECORD_KEY(u32Id),
+                                           pstrRecordDesc,
+                                           &strPersistentToken)) ||
+           (NRF_SUCCESS == fds_record_find(NVM_FILE_ID(NVM_EXPIRABLE_KEYS_FILE_BASE, u32Id),
+                                           NVM_RECORD_KEY(u32Id),
+                                           pstrRecordDesc,
+                                           &strExpirableToken));
+}
+
+static bool bIdRegistered(uint32_t u32Id)
+{
+    fds_record_desc_t strRecordDesc;
+    bool bRetVal = false;
+
+    /* Same lookup as enuNVM_FindUser: filter first, then index, then flash keys once it overflowed */
+    if(bFilterMayHold(u32Id))
+    {
+        bRetVal = (NULL != pstrIndexLookup(u32Id)) || (bIndexOverflow && bFindByKeys(u32Id, &strRecordDesc));
+    }
+
+    return bRetVal;
+}
+
+static uint16_t u16SubmitPacked(fds_record_desc_t *pstrRcDesc, Nvm_tstrFlashRecord const *pstrFlashRecord, Nvm_tenuFiles enuFile,
+                                bool bUpdate, fds_reserve_token_t const *pstrToken,
+                                Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    uint16_t u16RetVal = NVM_INVALID_REQUEST;
+    Nvm_tstrFlashRecord *pstrBuffer = pstrWriteBufferAcquire();
+
+    /* Make sure a write buffer and a request entry are available */
+    if(pstrBuffer && (NVM_INVALID_REQUEST == (u16RetVal = u16RequestStarted(pfComplete, pvContext))))
+    {
+        vidWriteBufferRelease(pstrBuffer);
+    }
+    else if(pstrBuffer)
+    {
+        fds_record_t strFdsRecord;
+        uint32_t u32Id = u32BcdToInteger(pstrFlashRecord->u32IdBcd);
+
+        memcpy(pstrBuffer, pstrFlashRecord, sizeof(Nvm_tstrFlashRecord));
+
+        /* Note: FDS requires record keys to be distinct from 0x0000 and file Ids to be distinct
+           from 0xFFFF while Peer manager uses the 0xC000 -- 0xFFFE range. The 27 bits it takes to
+           hold an 8-digit user Id are therefore split between the file Id (upper bits, offset by
+           the file base of the key type) and the record key (lower 14 bits, offset by 1). This
+           makes every user's keys unique without having to look at record content. */
+        strFdsRecord.file_id = NVM_FILE_ID(enuFile?NVM_EXPIRABLE_KEYS_FILE_BASE:NVM_PERSISTENT_KEYS_FILE_BASE, u32Id);
+        strFdsRecord.key = NVM_RECORD_KEY(u32Id);
+        strFdsRecord.data.p_data = pstrBuffer;
+        strFdsRecord.data.length_words = NVM_RECORD_WORDS(Nvm_tstrFlashRecord);
+
+        /* Operation is accounted for before being queued as it may complete right away */
+        vidPendingOpStarted();
+        if(NRF_SUCCESS != (bUpdate  ?fds_record_update(pstrRcDesc, &strFdsRecord)
+                          :pstrToken?fds_record_write_reserved(pstrRcDesc, &strFdsRecord, pstrToken)
+                                    :fds_record_write(pstrRcDesc, &strFdsRecord)))
+        {
+            vidWriteBufferRelease(pstrBuffer);
+            vidRequestAbandoned();
+            vidPendingOpCompleted();
+            u16RetVal = NVM_INVALID_REQUEST;
+        }
+    }
+
+    return u16RetVal;
+}
+
+static uint16_t u16SubmitRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile,
+                                bool bUpdate, fds_reserve_token_t const *pstrToken,
+                                Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    Nvm_tstrFlashRecord strFlashRecord;
+
+    vidPackRecord(&strFlashRecord, pstrRecord);
+
+    return u16SubmitPacked(pstrRcDesc, &strFlashRecord, enuFile, bUpdate, pstrToken, pfComplete, pvContext);
+}
+
+static Mid_tenuStatus enuGcStart(uint8_t u8Threshold)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    fds_stat_t strFdsStats = {0};
+
+    /* Clear flag first so that records invalidated meanwhile trigger a new check */
+    bDirtinessChanged = false;
+
+    /* Retrieve NVM file system statistics */
+    if(!bGcRequested && !pstrBatchRecords && !NVM_TXN_IN_FLIGHT(enuTxnState) && !u8OpenViews &&
+       (NRF_SUCCESS == fds_stat(&strFdsStats)))
+    {
+        uint8_t u8DirtyRatio = NVM_DIRTY_RATIO(strFdsStats.freeable_words);
+
+        if(u8DirtyRatio >= u8Threshold)
+        {
+            /* Garbage collect to reclaim unused flash storage space */
+            bGcRequested = true;
+            vidPendingOpStarted();
+            enuRetVal = (NRF_SUCCESS == fds_gc())?Middleware_Success:Middleware_Failure;
+            if(Middleware_Success != enuRetVal)
+            {
+                bGcRequested = false;
+                vidPendingOpCompleted();
+            }
+            else if(pfGcProgress)
+            {
+                pfGcProgress(u8DirtyRatio);
+            }
+        }
+    }
+
+    return enuRetVal;
+}
+
+static bool bCacheEntryFlush(Nvm_tstrCacheEntry *pstrEntry)
+{
+    bool bRetVal = true;
+    fds_record_desc_t strRecordDesc;
+    fds_record_desc_t *pstrOwnerDesc;
+    Nvm_tstrRecord strRecord;
+    Nvm_tenuFiles enuFile;
+
+    /* Take entry out of the cache. Changes deferred while it's being written start a new entry */
+    CRITICAL_REGION_ENTER();
+    memcpy(&strRecord, &pstrEntry->strRecord, sizeof(Nvm_tstrRecord));
+    pstrOwnerDesc = pstrEntry->pstrRcDesc;
+    enuFile = pstrEntry->enuFile;
+    pstrEntry->bDirty = false;
+    u8CacheDirtyCount--;
+    CRITICAL_REGION_EXIT();
+
+    /* Users deleted in the meantime have nothing left to update */
+    if(Middleware_Success == enuNVM_FindUser(strRecord.u8Id, &strRecordDesc))
+    {
+        bRetVal = (NVM_INVALID_REQUEST != u16SubmitRecord(&strRecordDesc, &strRecord, enuFile, true, NULL, NULL, NULL));
+
+        /* FDS points the descriptor to the new record. Keep owner's copy in sync just like a
+           direct update would */
+        if(bRetVal)
+        {
+            memcpy(pstrOwnerDesc, &strRecordDesc, sizeof(fds_record_desc_t));
+        }
+    }
+
+    if(!bRetVal)
+    {
+        /* Flash storage is busy. Put update back in the cache unless it has been superseded */
+        CRITICAL_REGION_ENTER();
+        if(!pstrEntry->bDirty && !pstrCacheLookup(strRecord.u8Id))
+        {
+            pstrEntry->bDirty = true;
+            u8CacheDirtyCount++;
+        }
+        CRITICAL_REGION_EXIT();
+    }
+
+    return bRetVal;
+}
+
+static void vidMigrateNextRecord(void)
+{
+    fds_record_desc_t strRecordDesc = {0};
+    fds_find_token_t strToken = {0};
+    fds_flash_record_t strFlashRecord = {0};
+    bool bRecordFound = false;
+    Nvm_tenuFiles enuFile = Nvm_PersistentKeys;
+    Nvm_tstrRecord strRecord;
+
+    bMigrationInFlight = false;
+
+    /* Look for a record left in the legacy files or still in the version 1 format. Migrated
+       records are deleted by FDS as part of the update so searching always starts from scratch */
+    while(!bRecordFound && (NRF_SUCCESS == fds_record_iterate(&strRecordDesc, &strToken)))
+    {
+        if(NRF_SUCCESS == fds_record_open(&strRecordDesc, &strFlashRecord))
+        {
+            uint16_t u16FileId = strFlashRecord.p_header->file_id;
+
+            bRecordFound = NVM_IS_LEGACY_FILE(u16FileId) ||
+                           (NVM_IS_APP_FILE(u16FileId) &&
+                            (NVM_RECORD_VERSION != *(uint8_t const *)strFlashRecord.p_data));
+            if(bRecordFound)
+            {
+                vidUnpackRecord(&strRecord, strFlashRecord.p_data);
+                enuFile = ((NVM_LEGACY_EXPIRABLE_FILE_ID == u16FileId) ||
+                           (NVM_EXPIRABLE_KEYS_FILE_BASE == (u16FileId & NVM_FILE_BASE_MASK)))
+                          ?Nvm_ExpirableKeys
+                          :Nvm_PersistentKeys;
+            }
+            (void)fds_record_close(&strRecordDesc);
+        }
+    }
+
+    bLegacyRecordsLeft = bRecordFound;
+    if(bRecordFound)
+    {
+        uint32_t u32Id = u32IdToInteger(strRecord.u8Id);
+
+        /* Rewrite record packed and under its collision-free keys */
+        u16MigrationFileId = NVM_FILE_ID(enuFile?NVM_EXPIRABLE_KEYS_FILE_BASE:NVM_PERSISTENT_KEYS_FILE_BASE, u32Id);
+        u16MigrationRecordKey = NVM_RECORD_KEY(u32Id);
+        bMigrationInFlight = (NVM_INVALID_REQUEST != u16SubmitRecord(&strRecordDesc, &strRecord, enuFile, true, NULL, NULL, NULL));
+    }
+}
+
+static bool bRecordExpired(Nvm_tstrRecord const *pstrRecord, uint32_t u32Now)
+{
+    bool bRetVal = false;
+
+    switch(pstrRecord->enuKeyType)
+    {
+    case App_OneTimeKey:
+        bRetVal = pstrRecord->uKeyQuantifier.bOneTimeExpired;
+        break;
+
+    case App_CountRestrictedKey:
+        bRetVal = (pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount >=
+                   pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit);
+        break;
+
+    case App_TimeRestrictedKey:
+        /* Life span can only be checked against a known time, and never against one older than
+           the key's activation */
+        bRetVal = u32Now && pstrRecord->uKeyQuantifier.strTimeRes.bIsKeyActive &&
+                  (u32Now >= pstrRecord->uKeyQuantifier.strTimeRes.u32ActivationTime) &&
+                  ((u32Now - pstrRecord->uKeyQuantifier.strTimeRes.u32ActivationTime) >=
+                   (pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout * NVM_SECS_IN_MINUTE));
+        break;
+
+    default:
+        /* Persistent keys never expire */
+        break;
+    }
+
+    return bRetVal;
+}
+
+static bool bCounterFold(uint16_t u16Slot)
+{
+    bool bRetVal = false;
+    fds_record_desc_t strRecordDesc;
+    fds_flash_record_t strFlashRecord = {0};
+    Nvm_tstrRecord strRecord;
+    uint8_t u8Id[NVM_ID_SIZE];
+
+    for(uint8_t u8Index = 0; u8Index < NVM_ID_LENGTH; u8Index++)
+    {
+        u8Id[u8Index] = '0' + ((strCounterSlot[u16Slot].u32OwnerBcd >> (4 * (NVM_ID_LENGTH - 1 - u8Index))) & 0x0F);
+    }
+
+    if(Middleware_Success != enuNVM_FindUser(u8Id, &strRecordDesc))
+    {
+        /* Owner is gone, its uses have nowhere to go */
+        CRITICAL_REGION_ENTER();
+        vidCounterFoldWrite(u16Slot);
+        CRITICAL_REGION_EXIT();
+        bRetVal = true;
+    }
+    else if(Middleware_Success == enuNVM_ReadRecord(&strRecordDesc, &strFlashRecord, &strRecord))
+    {
+        /* Rewrite owner's record with the slot's uses in it. The slot is folded once the update
+           completes, until then its uses are still counted from the slot */
+        u16CounterFolding = u16Slot;
+        strCounterSlot[u16Slot].enuState = Nvm_CounterFolding;
+
+        bRetVal = (Middleware_Success == enuNVM_UpdateRecord(&strRecordDesc, &strRecord, Nvm_ExpirableKeys));
+        if(!bRetVal)
+        {
+            strCounterSlot[u16Slot].enuState = Nvm_CounterLive;
+            u16CounterFolding = NVM_COUNTER_NO_SLOT;
+        }
+    }
+
+    return bRetVal;
+}
+
+static void vidBatchCheckDone(void)
+{
+    Nvm_tpfBatchComplete pfComplete = pfBatchComplete;
+
+    /* Batch is over once every record was either written or given up on */
+    if(pstrBatchRecords && ((u16BatchAdded + u16BatchFailed) == u16BatchCount))
+    {
+        pstrBatchRecords = NULL;
+        u16BatchCount = 0;
+        if(pfComplete)
+        {
+            pfComplete(u16BatchAdded, u16BatchFailed, pvBatchContext);
+        }
+    }
+}
+
+static void vidBatchRecordCompleted(uint16_t u16Request, Mid_tenuStatus enuResult, void *pvContext)
+{
+    /* Records of a batch are only told apart by their outcome */
+    (void)u16Request;
+    (void)pvContext;
+
+    u8BatchInFlight--;
+    if(Middleware_Success == enuResult)
+    {
+        u16BatchAdded++;
+    }
+    else
+    {
+        u16BatchFailed++;
+    }
+
+    vidBatchCheckDone();
+}
 
-/*************************************   PRIVATE MACROS   ****************************************/
-/* Compute size in bytes of dirty flash storage records */
-#define NVM_DIRTY_RECORDS_SIZE(dirty_records) (dirty_records * sizeof(Nvm_tstrRecord))
+static void vidBatchPump(void)
+{
+    fds_record_desc_t strRecordDesc = {0};
+    Nvm_tstrRecord const *pstrRecord;
+    uint16_t u16Index;
+    bool bQueueFull = false;
 
-/************************************   GLOBAL VARIABLES   ***************************************/
-/* Global function used to propagate dispatchable events to other tasks */
-extern App_tenuStatus AppMgr_enuDispatchEvent(uint32_t u32Event, void *pvData);
+    /* Writes completing right away re-enter through the event handler, the outer loop carries on */
+    if(pstrBatchRecords && !bBatchPumping)
+    {
+        bBatchPumping = true;
+        while(!bQueueFull && pstrBatchRecords && (u16BatchNext < u16BatchCount) &&
+              (u8BatchInFlight < NVM_BATCH_IN_FLIGHT))
+        {
+            u16Index = u16BatchNext++;
+            pstrRecord = &pstrBatchRecords[u16Index];
 
-/************************************   PRIVATE VARIABLES   **************************************/
-/* Flag indicating whether NVM_Service is initialized */
-static bool bIsInitialized = false;
+            /* Usage counter slots of a previous user with the same Id don't carry over */
+            vidCounterRetire(u32IdToInteger(pstrRecord->u8Id));
 
-/* Flag indicating whether or not the current record update is a password registration operation */
-static bool bIsPwdRegistration = false;
+            u8BatchInFlight++;
+            if(NVM_INVALID_REQUEST == u16SubmitRecord(&strRecordDesc, pstrRecord,
+                                                      NVM_KEY_TYPE_FILE(pstrRecord->enuKeyType), false,
+                                                      &strBatchTokens[u16Index], vidBatchRecordCompleted, NULL))
+            {
+                u8BatchInFlight--;
+                if(u8PendingOps)
+                {
+                    /* Out of write buffers or FDS queue room. Record is retried once an operation
+                       in flight completes */
+                    u16BatchNext--;
+                    bQueueFull = true;
+                }
+                else
+                {
+                    /* Nothing in flight is ever going to make room, record can't be written */
+                    (void)fds_reserve_cancel(&strBatchTokens[u16Index]);
+                    u16BatchFailed++;
+                    vidBatchCheckDone();
+                }
+            }
+        }
+        bBatchPumping = false;
+    }
+}
+
+static void vidTxnTokenRelease(uint16_t u16Index)
+{
+    /* Tokens of deletions and of changes rolled forward on boot never held any space */
+    if(strTxnTokens[u16Index].length_words)
+    {
+        (void)fds_reserve_cancel(&strTxnTokens[u16Index]);
+        memset(&strTxnTokens[u16Index], 0, sizeof(fds_reserve_token_t));
+    }
+}
+
+static void vidTxnFinish(Mid_tenuStatus enuResult, Nvm_tenuTxnState enuNextState)
+{
+    Nvm_tpfTransactionComplete pfComplete = pfTxnComplete;
+
+    /* State is left first, the callback may begin another transaction */
+    enuTxnState = enuNextState;
+    pfTxnComplete = NULL;
+    if(pfComplete)
+    {
+        pfComplete(enuResult, pvTxnContext);
+    }
+}
+
+static void vidTxnOpCompleted(uint16_t u16Request, Mid_tenuStatus enuResult, void *pvContext)
+{
+    /* Operations of a transaction are only told apart by their outcome */
+    (void)u16Request;
+    (void)pvContext;
+
+    u8TxnInFlight--;
+    u16TxnDone++;
+    u16TxnFailed += (Middleware_Success == enuResult)?0:1;
+}
+
+static Nvm_tenuTxnStep enuTxnApply(uint16_t u16Index)
+{
+    Nvm_tenuTxnStep enuRetVal = Nvm_TxnOpRejected;
+    Nvm_tstrFlashRecord strRecord;
+    fds_record_desc_t strRecordDesc = {0};
+    fds_flash_record_t strFlashRecord = {0};
+    uint8_t u8Id[NVM_ID_SIZE];
+    bool bFound;
+    bool bApplied = false;
+
+    memcpy(&strRecord, &strTxnJournal.strOps[u16Index], sizeof(Nvm_tstrFlashRecord));
+    vidBcdToId(strRecord.u32IdBcd, u8Id);
+    bFound = (Middleware_Success == enuNVM_FindUser(u8Id, &strRecordDesc));
+
+    /* Updates deferred before the transaction would otherwise overwrite its changes */
+    vidCacheDrop(u8Id);
+
+    if(NVM_TXN_DELETE_VERSION == strRecord.u8Version)
+    {
+        enuRetVal = !bFound?Nvm_TxnOpSkipped
+                           :(NVM_INVALID_REQUEST != u16NVM_RequestDelete(&strRecordDesc, vidTxnOpCompleted, NULL))
+                           ?Nvm_TxnOpQueued
+                           :Nvm_TxnOpRejected;
+    }
+    else
+    {
+        /* Usage counter slots of a previous user with the same Id don't carry over */
+        if(!bFound)
+        {
+            vidCounterRetire(u32BcdToInteger(strRecord.u32IdBcd));
+        }
+
+        /* Uses still held by live counter slots are not part of the record */
+        if(App_CountRestrictedKey == (App_tenuKeyTypes)(strRecord.u8KeyInfo & NVM_KEY_TYPE_MASK))
+        {
+            uint16_t u16SlotUses = u16CounterUses(strRecord.u32IdBcd, false);
+
+            strRecord.u32KeyState = (strRecord.u32KeyState > u16SlotUses)?(strRecord.u32KeyState - u16SlotUses):0;
+        }
+
+        /* Changes rolled forward on boot may have been applied before the reset */
+        if(bFound && (NRF_SUCCESS == fds_record_open(&strRecordDesc, &strFlashRecord)))
+        {
+            bApplied = (NVM_RECORD_WORDS(Nvm_tstrFlashRecord) == strFlashRecord.p_header->length_words) &&
+                       (0 == memcmp(strFlashRecord.p_data, &strRecord, sizeof(Nvm_tstrFlashRecord)));
+            (void)fds_record_close(&strRecordDesc);
+        }
+
+        if(bApplied)
+        {
+            enuRetVal = Nvm_TxnOpSkipped;
+        }
+        else
+        {
+            /* Existing users are updated, which doesn't go through reserved space. Give it back
+               first so the update can use it */
+            if(bFound)
+            {
+                vidTxnTokenRelease(u16Index);
+            }
+
+            enuRetVal = (NVM_INVALID_REQUEST != u16SubmitPacked(&strRecordDesc, &strRecord,
+                                                                NVM_KEY_TYPE_FILE((App_tenuKeyTypes)(strRecord.u8KeyInfo & NVM_KEY_TYPE_MASK)),
+                                                                bFound,
+                                                                strTxnTokens[u16Index].length_words?&strTxnTokens[u16Index]:NULL,
+                                                                vidTxnOpCompleted, NULL))
+                                                                ?Nvm_TxnOpQueued
+                                                                :Nvm_TxnOpRejected;
+        }
+    }
+
+    return enuRetVal;
+}
+
+static void vidTxnCheckDone(void)
+{
+    /* Intent record is only deleted once every change made it to flash. Otherwise it is kept for
+       the transaction to be rolled forward on next boot */
+    if((Nvm_TxnApplying == enuTxnState) && (u16TxnDone == strTxnJournal.u32OpCount))
+    {
+        if(u16TxnFailed)
+        {
+            bTxnRecovering = false;
+            vidTxnFinish(Middleware_Failure, Nvm_TxnStalled);
+        }
+        else
+        {
+            /* Deletion is accounted for before being queued as it may complete right away */
+            enuTxnState = Nvm_TxnClosing;
+            vidPendingOpStarted();
+            if(NRF_SUCCESS != fds_record_delete(&strTxnIntentDesc))
+            {
+                enuTxnState = Nvm_TxnApplying;
+                vidPendingOpCompleted();
+                if(!u8PendingOps)
+                {
+                    /* Nothing in flight is ever going to make room. Changes are all applied, the
+                       intent record left behind is rolled forward to no effect */
+                    bTxnRecovering = false;
+                    vidTxnFinish(Middleware_Success, Nvm_TxnStalled);
+                }
+            }
+        }
+    }
+}
+
+static void vidTxnPump(void)
+{
+    uint16_t u16Index;
+    Nvm_tenuTxnStep enuStep;
+    bool bQueueFull = false;
+
+    /* Operations completing right away re-enter through the event handler, the outer loop
+       carries on */
+    if((Nvm_TxnApplying == enuTxnState) && !bTxnPumping)
+    {
+        bTxnPumping = true;
+        while(!bQueueFull && (u16TxnNext < strTxnJournal.u32OpCount) && (u8TxnInFlight < NVM_BATCH_IN_FLIGHT))
+        {
+            u16Index = u16TxnNext++;
+
+            u8TxnInFlight++;
+            enuStep = enuTxnApply(u16Index);
+            if(Nvm_TxnOpQueued != enuStep)
+            {
+                u8TxnInFlight--;
+            }
+
+            if(Nvm_TxnOpSkipped == enuStep)
+            {
+                vidTxnTokenRelease(u16Index);
+                u16TxnDone++;
+            }
+            else if((Nvm_TxnOpRejected == enuStep) && u8PendingOps)
+            {
+                /* Out of write buffers or FDS queue room. Change is retried once an operation in
+                   flight completes */
+                u16TxnNext--;
+                bQueueFull = true;
+            }
+            else if(Nvm_TxnOpRejected == enuStep)
+            {
+                /* Nothing in flight is ever going to make room, change can't be applied */
+                vidTxnTokenRelease(u16Index);
+                u16TxnDone++;
+                u16TxnFailed++;
+            }
+        }
+        vidTxnCheckDone();
+        bTxnPumping = false;
+    }
+}
+
+static void vidTxnRecover(void)
+{
+    fds_record_desc_t strRecordDesc = {0};
+    fds_find_token_t strToken = {0};
+    fds_flash_record_t strFlashRecord = {0};
+    uint32_t u32OpCount;
+
+    /* An intent record only exists in flash once written in full. Transactions interrupted
+       before that left flash storage untouched, others are rolled forward. Intent records that
+       can't be read are dropped */
+    bTxnRecovering = (NRF_SUCCESS == fds_record_find(NVM_TXN_FILE_ID, NVM_TXN_RECORD_KEY, &strRecordDesc, &strToken));
+    if(bTxnRecovering)
+    {
+        strTxnJournal.u32OpCount = 0;
+        if(NRF_SUCCESS == fds_record_open(&strRecordDesc, &strFlashRecord))
+        {
+            u32OpCount = *(uint32_t const *)strFlashRecord.p_data;
+            if((u32OpCount <= MID_NVM_TXN_SIZE) &&
+               (NVM_TXN_JOURNAL_WORDS(u32OpCount) == strFlashRecord.p_header->length_words))
+            {
+                memcpy(&strTxnJournal, strFlashRecord.p_data, NVM_TXN_JOURNAL_WORDS(u32OpCount) * sizeof(uint32_t));
+            }
+            (void)fds_record_close(&strRecordDesc);
+        }
+
+        memcpy(&strTxnIntentDesc, &strRecordDesc, sizeof(fds_record_desc_t));
+        memset(strTxnTokens, 0, sizeof(strTxnTokens));
+        u16TxnNext = 0;
+        u16TxnDone = 0;
+        u16TxnFailed = 0;
+        u8TxnInFlight = 0;
+        pfTxnComplete = NULL;
+        enuTxnState = Nvm_TxnApplying;
+    }
+}
+
+static Nvm_tstrFlashRecord *pstrTxnStage(uint32_t u32IdBcd)
+{
+    Nvm_tstrFlashRecord *pstrRetVal = NULL;
+    uint32_t u32Index = 0;
+
+    if(Nvm_TxnStaging == enuTxnState)
+    {
+        /* Changes to the same user are coalesced. Users therefore never have more than one
+           operation in flight while the transaction is applied */
+        while((u32Index < strTxnJournal.u32OpCount) && (strTxnJournal.strOps[u32Index].u32IdBcd != u32IdBcd))
+        {
+            u32Index++;
+        }
+
+        if(u32Index < MID_NVM_TXN_SIZE)
+        {
+            strTxnJournal.u32OpCount += (u32Index == strTxnJournal.u32OpCount)?1:0;
+            pstrRetVal = &strTxnJournal.strOps[u32Index];
+        }
+    }
+
+    return pstrRetVal;
+}
 
-/************************************   PRIVATE FUNCTIONS   **************************************/
 static void vidNvmEventHandler(fds_evt_t const *pstrEvent)
 {
     /* Make sure valid arguments are passed */
@@ -44,247 +1923,1000 @@ static void vidNvmEventHandler(fds_evt_t const *pstrEvent)
             {
                 /* File system successfully installed in flash */
                 bIsInitialized = true;
+
+                /* Restore user index from its checkpoint or build it from flash storage */
+                vidIndexReady();
+
+                /* Roll forward any transaction committed before the reset */
+                vidTxnRecover();
+
+                /* Move records written before Ids were fully encoded in keys. None are left
+                   when the checkpoint was taken */
+                if(bLegacyRecordsLeft)
+                {
+                    vidMigrateNextRecord();
+                }
+            }
+        }
+        break;
+
+        case FDS_EVT_WRITE:
+        {
+            /* Peer manager uses file Ids in the 0xC000 -- 0xFFFE range. It's therefore safe to
+               assume that records written to NVM_Service's file ranges are application records. */
+            if(NVM_IS_APP_FILE(pstrEvent->write.file_id))
+            {
+                /* Record data is no longer needed whatever the outcome */
+                vidWriteBufferRelease(NULL);
+                vidPendingOpCompleted();
+
+                if(NRF_SUCCESS == pstrEvent->result)
+                {
+                    /* Index newly added user */
+                    vidIndexInsert(NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key),
+                                   pstrEvent->write.record_id);
+                    vidFilterAdd(NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key));
+                    vidRecentDrop(NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key));
+                }
+
+                /* Let requester know of the outcome */
+                vidRequestCompleted(pstrEvent->result);
+            }
+            else if((NVM_TXN_FILE_ID == pstrEvent->write.file_id) && (Nvm_TxnJournaling == enuTxnState))
+            {
+                vidPendingOpCompleted();
+
+                /* Transaction is committed once its intent record is in flash. Otherwise flash
+                   storage was left untouched, reserved space is given back */
+                if(NRF_SUCCESS == pstrEvent->result)
+                {
+                    enuTxnState = Nvm_TxnApplying;
+                }
+                else
+                {
+                    for(uint16_t u16Index = 0; u16Index < strTxnJournal.u32OpCount; u16Index++)
+                    {
+                        vidTxnTokenRelease(u16Index);
+                    }
+                    vidTxnFinish(Middleware_Failure, Nvm_TxnIdle);
+                }
+            }
+        }
+        break;
+
+        case FDS_EVT_UPDATE:
+        {
+            if(NVM_IS_APP_FILE(pstrEvent->write.file_id))
+            {
+                /* Record data is no longer needed whatever the outcome */
+                vidWriteBufferRelease(NULL);
+                vidPendingOpCompleted();
+
+                /* Updated records are rewritten under a new record Id. Point user's index entry
+                   to it. The previous copy is left dirty */
+                if(NRF_SUCCESS == pstrEvent->result)
+                {
+                    bDirtinessChanged = true;
+                    vidIndexInsert(NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key),
+                                   pstrEvent->write.record_id);
+                    vidRecentDrop(NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key));
+                }
+
+                /* Usage counter slot being folded is done with once its owner's record holds its
+                   uses. Folds only start while no other operation is pending, this is its update */
+                if((NVM_COUNTER_NO_SLOT != u16CounterFolding) &&
+                   (u32BcdToInteger(strCounterSlot[u16CounterFolding].u32OwnerBcd) ==
+                    NVM_ID_FROM_KEYS(pstrEvent->write.file_id, pstrEvent->write.record_key)))
+                {
+                    CRITICAL_REGION_ENTER();
+                    if(NRF_SUCCESS == pstrEvent->result)
+                    {
+                        vidCounterFoldWrite(u16CounterFolding);
+                    }
+                    else
+                    {
+                        strCounterSlot[u16CounterFolding].enuState = Nvm_CounterLive;
+                    }
+                    u16CounterFolding = NVM_COUNTER_NO_SLOT;
+                    CRITICAL_REGION_EXIT();
+                }
+
+                /* Let requester know of the outcome */
+                vidRequestCompleted(pstrEvent->result);
+            }
+
+            if(bMigrationInFlight &&
+               (u16MigrationFileId == pstrEvent->write.file_id) &&
+               (u16MigrationRecordKey == pstrEvent->write.record_key))
+            {
+                /* Legacy record migrated. Carry on with the next one, unless flash storage is
+                   unable to take it in which case migration is retried on next boot */
+                bMigrationInFlight = false;
+                if(NRF_SUCCESS == pstrEvent->result)
+                {
+                    vidMigrateNextRecord();
+                }
+            }
+        }
+        break;
+
+        case FDS_EVT_DEL_RECORD:
+        {
+            if(NVM_IS_APP_FILE(pstrEvent->del.file_id) || NVM_IS_LEGACY_FILE(pstrEvent->del.file_id))
+            {
+                vidPendingOpCompleted();
+            }
+
+            if(NRF_SUCCESS == pstrEvent->result)
+            {
+                bDirtinessChanged = true;
+
+                /* Drop deleted user from index */
+                if(NVM_IS_APP_FILE(pstrEvent->del.file_id))
+                {
+                    vidIndexRemove(NVM_ID_FROM_KEYS(pstrEvent->del.file_id, pstrEvent->del.record_key),
+                                   pstrEvent->del.record_id);
+                    vidCounterRetire(NVM_ID_FROM_KEYS(pstrEvent->del.file_id, pstrEvent->del.record_key));
+                    vidRecentDrop(NVM_ID_FROM_KEYS(pstrEvent->del.file_id, pstrEvent->del.record_key));
+                }
+                else if(NVM_IS_LEGACY_FILE(pstrEvent->del.file_id))
+                {
+                    vidIndexRemoveRecord(pstrEvent->del.record_id);
+                }
+
+                /* Drop deleted user from filter */
+                if(NVM_IS_APP_FILE(pstrEvent->del.file_id) || NVM_IS_LEGACY_FILE(pstrEvent->del.file_id))
+                {
+                    vidFilterRebuild();
+                }
+            }
+
+            /* Let requester know of the outcome */
+            if(NVM_IS_APP_FILE(pstrEvent->del.file_id) || NVM_IS_LEGACY_FILE(pstrEvent->del.file_id))
+            {
+                vidRequestCompleted(pstrEvent->result);
+            }
+            else if((NVM_TXN_FILE_ID == pstrEvent->del.file_id) && (Nvm_TxnClosing == enuTxnState))
+            {
+                vidPendingOpCompleted();
+
+                /* Transaction is over. A leftover intent record would be rolled forward again on
+                   next boot, no other transaction may start before then */
+                if(NRF_SUCCESS != pstrEvent->result)
+                {
+                    bTxnRecovering = false;
+                    vidTxnFinish(Middleware_Success, Nvm_TxnStalled);
+                }
+                else if(bTxnRecovering)
+                {
+                    /* Roll forward any other transaction left behind */
+                    enuTxnState = Nvm_TxnIdle;
+                    vidTxnRecover();
+                }
+                else
+                {
+                    vidTxnFinish(Middleware_Success, Nvm_TxnIdle);
+                }
+            }
+        }
+        break;
+
+        case FDS_EVT_GC:
+        {
+            /* Moved records leave the expiry reaper's position meaningless, its pass starts over */
+            memset(&strReapToken, 0, sizeof(strReapToken));
+
+            /* Note: Garbage collection moves records around but preserves their record Ids, so
+               the user index remains valid. Peer manager may run garbage collection on its own,
+               only account for the ones NVM_Service requested. */
+            if(bGcRequested)
+            {
+                bGcRequested = false;
+                if(pfGcComplete)
+                {
+                    pfGcComplete((NRF_SUCCESS == pstrEvent->result)?Middleware_Success:Middleware_Failure);
+                }
+                vidPendingOpCompleted();
             }
         }
         break;
 
-        case FDS_EVT_WRITE:
+        default:
+            /* Nothing to do */
+            break;
+        }
+
+        /* Any completed operation may have made room for the batch being written and for the
+           transaction being applied */
+        vidBatchPump();
+        vidTxnPump();
+    }
+}
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+Mid_tenuStatus enuNvm_Init(void)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+#if (FDS_BACKEND != NRF_FSTORAGE_HOST)
+    /* Time taken to get the index ready is measured in CPU cycles */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    u32BootStart = u32Timestamp();
+
+    /* Index checkpoint is only trusted if RAM was retained and the checkpoint is whole */
+    bCheckpointUsable = bBleWokenFromSystemOff() &&
+                        (NVM_CHECKPOINT_MAGIC == strCheckpoint.u32Magic) &&
+                        (u32CheckpointCheck() == strCheckpoint.u32Check);
+
+    /* Usage counter pages sit right below FDS's pages. Records can't be read before counted uses
+       are known, which takes a single scan of the slots. Without them, uses rewrite records */
+    strCounterFs.end_addr = u32FlashEndAddr() - NVM_FDS_AREA_SIZE;
+    strCounterFs.start_addr = strCounterFs.end_addr - (MID_NVM_COUNTER_PAGES * NVM_COUNTER_PAGE_SIZE);
+
+#if   (FDS_BACKEND == NRF_FSTORAGE_SD)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strCounterFs, &nrf_fstorage_sd, NULL))
+#elif (FDS_BACKEND == NRF_FSTORAGE_NVMC)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strCounterFs, &nrf_fstorage_nvmc, NULL))
+#elif (FDS_BACKEND == NRF_FSTORAGE_HOST)
+    if(NRF_SUCCESS == nrf_fstorage_init(&strCounterFs, &nrf_fstorage_host, NULL))
+#endif
+    {
+        vidCounterRecover();
+        bCounterReady = true;
+    }
+
+    /* Register a Flash Data Storage event handler to receive FDS events */
+    if(NRF_SUCCESS == fds_register(vidNvmEventHandler))
+    {
+        /* Initialize FDS by installing file system in flash */
+        enuRetVal = (NRF_SUCCESS == fds_init())?Middleware_Success:Middleware_Failure;
+    }
+
+    return enuRetVal;
+}
+
+uint16_t u16NVM_RequestAdd(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile,
+                           Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    uint16_t u16RetVal = NVM_INVALID_REQUEST;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmRequestAdd);
+
+    /* Make sure valid parameters are passed, NVM_Service is initialized and the Id isn't taken. A
+       second record under the same keys would break the single match lookups rely on, existing
+       users are changed through u16NVM_RequestUpdate */
+    if(pstrRcDesc && pstrRecord && (enuFile < Nvm_MaxFiles) && bIsInitialized &&
+       !bIdRegistered(u32IdToInteger(pstrRecord->u8Id)))
+    {
+        /* Usage counter slots of a previous, since deleted, user with the same Id don't carry over */
+        vidCounterRetire(u32IdToInteger(pstrRecord->u8Id));
+
+        /* Add new record to NVM. We use seperate file ranges for expirable and persistent keys */
+        u16RetVal = u16SubmitRecord(pstrRcDesc, pstrRecord, enuFile, false, NULL, pfComplete, pvContext);
+    }
+
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmRequestAdd);
+
+    return u16RetVal;
+}
+
+Mid_tenuStatus enuNVM_AddNewRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile)
+{
+    return (NVM_INVALID_REQUEST != u16NVM_RequestAdd(pstrRcDesc, pstrRecord, enuFile, NULL, NULL))
+                                   ?Middleware_Success
+                                   :Middleware_Failure;
+}
+
+Mid_tenuStatus enuNVM_AddRecordBatch(Nvm_tstrRecord const *pstrRecords, uint16_t u16Count,
+                                    Nvm_tpfBatchComplete pfComplete, void *pvContext)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    uint16_t u16Reserved = 0;
+
+    /* Make sure valid parameters are passed, NVM_Service is initialized and no other batch,
+       transaction nor garbage collection is under way */
+    if(pstrRecords && u16Count && (u16Count <= MID_NVM_BATCH_SIZE) && bIsInitialized &&
+       !pstrBatchRecords && !NVM_TXN_IN_FLIGHT(enuTxnState) && !bGcRequested)
+    {
+        /* Space for the whole batch is reserved up front. The batch is either turned down right
+           away or never runs out of space halfway through */
+        while((u16Reserved < u16Count) &&
+              (NRF_SUCCESS == fds_reserve(&strBatchTokens[u16Reserved], NVM_RECORD_WORDS(Nvm_tstrFlashRecord))))
+        {
+            u16Reserved++;
+        }
+
+        if(u16Reserved < u16Count)
+        {
+            while(u16Reserved)
+            {
+                (void)fds_reserve_cancel(&strBatchTokens[--u16Reserved]);
+            }
+        }
+        else
+        {
+            u16BatchCount = u16Count;
+            u16BatchNext = 0;
+            u16BatchAdded = 0;
+            u16BatchFailed = 0;
+            u8BatchInFlight = 0;
+            pfBatchComplete = pfComplete;
+            pvBatchContext = pvContext;
+            pstrBatchRecords = pstrRecords;
+            enuRetVal = Middleware_Success;
+
+            /* Queue as many writes as there's room for, the rest follow as writes complete */
+            vidBatchPump();
+        }
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_BeginTransaction(void)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    /* Make sure NVM_Service is initialized and no other transaction is under way */
+    if(bIsInitialized && (Nvm_TxnIdle == enuTxnState))
+    {
+        strTxnJournal.u32OpCount = 0;
+        enuTxnState = Nvm_TxnStaging;
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_StageRecord(Nvm_tstrRecord const *pstrRecord)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    Nvm_tstrFlashRecord *pstrOp = pstrRecord?pstrTxnStage(u32IdToBcd(pstrRecord->u8Id)):NULL;
+
+    if(pstrOp)
+    {
+        vidPackRecord(pstrOp, pstrRecord);
+
+        /* Journal holds the total use count. Uses held by counter slots are only taken out once
+           the record is written, slots may change until then */
+        if(App_CountRestrictedKey == pstrRecord->enuKeyType)
+        {
+            pstrOp->u32KeyState = pstrRecord->uKeyQuantifier.strCountRes.u16UsedCount;
+        }
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_StageDelete(uint8_t const *pu8Id)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    Nvm_tstrFlashRecord *pstrOp = pu8Id?pstrTxnStage(u32IdToBcd(pu8Id)):NULL;
+
+    if(pstrOp)
+    {
+        memset(pstrOp, 0, sizeof(Nvm_tstrFlashRecord));
+        pstrOp->u8Version = NVM_TXN_DELETE_VERSION;
+        pstrOp->u32IdBcd = u32IdToBcd(pu8Id);
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_CommitTransaction(Nvm_tpfTransactionComplete pfComplete, void *pvContext)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    uint16_t u16Reserved = 0;
+    bool bReserved = true;
+
+    /* Make sure a transaction is being staged and no batch nor garbage collection is under way */
+    if((Nvm_TxnStaging == enuTxnState) && !pstrBatchRecords && !bGcRequested)
+    {
+        if(0 == strTxnJournal.u32OpCount)
         {
-            /* Peer manager uses the 0xC000 -- 0xFFFF address range and stores records with key
-               values that happen to fall in that integer range as a way of tagging them as Peer
-               manager records. It's therefore safe to assume that FDS records with key values
-               outside of the Peer manager's address range are application records. */
-            if((NRF_SUCCESS == pstrEvent->result) &&
-               (pstrEvent->write.record_key < NVM_PEER_MANAGER_ADDR_START))
+            /* Nothing to apply */
+            enuTxnState = Nvm_TxnIdle;
+            enuRetVal = Middleware_Success;
+            if(pfComplete)
             {
-                /* Notify Registration application of successful operation */
-                (void)AppMgr_enuDispatchEvent(NVM_ENTRY_ADDED, NULL);
+                pfComplete(Middleware_Success, pvContext);
             }
         }
-        break;
-
-        case FDS_EVT_UPDATE:
+        else if(NRF_SUCCESS == fds_reserve(&strTxnIntentToken, NVM_TXN_JOURNAL_WORDS(strTxnJournal.u32OpCount)))
         {
-            if((NRF_SUCCESS == pstrEvent->result) && bIsPwdRegistration)
+            /* Space for the intent record and every record written is reserved up front. The
+               transaction is either turned down right away or never runs out of space halfway
+               through */
+            while(bReserved && (u16Reserved < strTxnJournal.u32OpCount))
             {
-                /* Notify Registration application of successful operation */
-                (void)AppMgr_enuDispatchEvent(NVM_PASSWORD_REGISTERED, NULL);
+                memset(&strTxnTokens[u16Reserved], 0, sizeof(fds_reserve_token_t));
+                bReserved = (NVM_TXN_DELETE_VERSION == strTxnJournal.strOps[u16Reserved].u8Version) ||
+                            (NRF_SUCCESS == fds_reserve(&strTxnTokens[u16Reserved], NVM_RECORD_WORDS(Nvm_tstrFlashRecord)));
+                u16Reserved += bReserved?1:0;
             }
-        }
-        break;
 
-        case FDS_EVT_DEL_RECORD:
-        {
-            if(NRF_SUCCESS == pstrEvent->result)
+            if(bReserved)
             {
-                /* Added for debugging */
-                __NOP();
+                fds_record_t strFdsRecord;
+
+                strFdsRecord.file_id = NVM_TXN_FILE_ID;
+                strFdsRecord.key = NVM_TXN_RECORD_KEY;
+                strFdsRecord.data.p_data = &strTxnJournal;
+                strFdsRecord.data.length_words = NVM_TXN_JOURNAL_WORDS(strTxnJournal.u32OpCount);
+
+                u16TxnNext = 0;
+                u16TxnDone = 0;
+                u16TxnFailed = 0;
+                u8TxnInFlight = 0;
+                bTxnRecovering = false;
+                pfTxnComplete = pfComplete;
+                pvTxnContext = pvContext;
+                enuTxnState = Nvm_TxnJournaling;
+
+                /* Operation is accounted for before being queued as it may complete right away */
+                vidPendingOpStarted();
+                enuRetVal = (NRF_SUCCESS == fds_record_write_reserved(&strTxnIntentDesc, &strFdsRecord, &strTxnIntentToken))
+                                                                     ?Middleware_Success
+                                                                     :Middleware_Failure;
+                if(Middleware_Success != enuRetVal)
+                {
+                    vidPendingOpCompleted();
+                    pfTxnComplete = NULL;
+                    enuTxnState = Nvm_TxnStaging;
+                }
             }
-        }
-        break;
 
-        case FDS_EVT_GC:
-        {
-            if(NRF_SUCCESS == pstrEvent->result)
+            if(Middleware_Success != enuRetVal)
             {
-                /* Notify Ble_Service of flash storage being cleared */
-                vidFlashStorageClearCallback();
+                while(u16Reserved)
+                {
+                    vidTxnTokenRelease(--u16Reserved);
+                }
+                (void)fds_reserve_cancel(&strTxnIntentToken);
             }
         }
-        break;
-
-        default:
-            /* Nothing to do */
-            break;
-        }
     }
+
+    return enuRetVal;
 }
 
-/************************************   PUBLIC FUNCTIONS   ***************************************/
-Mid_tenuStatus enuNvm_Init(void)
+Mid_tenuStatus enuNVM_AbortTransaction(void)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
 
-    /* Register a Flash Data Storage event handler to receive FDS events */
-    if(NRF_SUCCESS == fds_register(vidNvmEventHandler))
+    if(Nvm_TxnStaging == enuTxnState)
     {
-        /* Initialize FDS by installing file system in flash */
-        enuRetVal = (NRF_SUCCESS == fds_init())?Middleware_Success:Middleware_Failure;
+        strTxnJournal.u32OpCount = 0;
+        enuTxnState = Nvm_TxnIdle;
+        enuRetVal = Middleware_Success;
     }
 
     return enuRetVal;
 }
 
-Mid_tenuStatus enuNVM_AddNewRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile)
+Mid_tenuStatus enuNVM_FindUser(uint8_t const *pu8Id, fds_record_desc_t *pstrRecordDesc)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
 
+    TRACE_POINT(Trace_NvmCall, Trace_NvmFindUser);
+
     /* Make sure valid parameters are passed and NVM_Service is initialized */
-    if(pstrRcDesc && pstrRecord && (enuFile < Nvm_MaxFiles) && bIsInitialized)
+    if(pu8Id && pstrRecordDesc && bIsInitialized)
     {
-        /* We use two seperate files for expirable and persistent keys.
-           Note: FDS imposes no major restrictions on file id and record key values (record keys
-           must be distinct from 0x0000 and file Ids must be distinct from 0xFFFF). However, we need
-           to particularly identify records with unique keys to be able to quickly find them between
-           softdevice events. To establish this uniqueness, we use the four first numbers of the
-           user Id. If this is not enough to distinguish between two entries that happen to have
-           the same first four numbers, we will use the second four numbers to tell those two users
-           apart. */
-
-        /* Create string out of the four first numbers of user's Id */
-        char *pchRecordKey = (char *)malloc((NVM_ID_LENGTH/2)+1);
-        memcpy(pchRecordKey, &pstrRecord->u8Id[4], NVM_ID_LENGTH/2);
-        pchRecordKey[NVM_ID_LENGTH/2] = '\0';
-
-        /* Make sure data length is 4-byte aligned */
-        fds_record_t const strFdsRecord =
-        {
-            .file_id = enuFile?NVM_EXPIRABLE_KEYS_FILE_ID:NVM_PERSISTENT_KEYS_FILE_ID,
-            .key = (uint16_t)atoi(pchRecordKey),
-            .data.p_data = pstrRecord,
-            .data.length_words = (sizeof(*pstrRecord)+3) / sizeof(uint32_t),
-        };
-
-        /* Free allocated memory */
-        free(pchRecordKey);
-
-        /* Add new record to NVM */
-        enuRetVal = (NRF_SUCCESS == fds_record_write(pstrRcDesc, &strFdsRecord))
-                                                    ?Middleware_Success
-                                                    :Middleware_Failure;
+        uint32_t u32Id = u32IdToInteger(pu8Id);
+        bool bMayHold = bFilterMayHold(u32Id);
+        Nvm_tstrIndexEntry const *pstrEntry = NULL;
+
+        memset(pstrRecordDesc, 0, sizeof(fds_record_desc_t));
+
+        /* Unregistered Ids are mostly turned down by the filter, without probing the index nor
+           going through flash storage. Others cost a single probe sequence in the RAM index */
+        if(bMayHold)
+        {
+            pstrEntry = pstrIndexLookup(u32Id);
+        }
+
+        if(pstrEntry)
+        {
+            enuRetVal = (NRF_SUCCESS == fds_descriptor_from_rec_id(pstrRecordDesc,
+                                                                   pstrEntry->u32RecordId))
+                                                                   ?Middleware_Success
+                                                                   :Middleware_Failure;
+        }
+        else if(bMayHold && bIndexOverflow)
+        {
+            /* User may have been left out of the index */
+            enuRetVal = bFindByKeys(u32Id, pstrRecordDesc)?Middleware_Success:Middleware_Failure;
+        }
     }
 
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmFindUser);
+
     return enuRetVal;
 }
 
-Mid_tenuStatus enuNVM_FindRecord(uint16_t u16RecordKey, fds_record_desc_t *pstrRecordDesc, fds_find_token_t *pstrPersistentKeyToken, fds_find_token_t *pstrExpirableKeyToken)
+bool bNVM_MayHoldUser(uint8_t const *pu8Id)
+{
+    /* Filter is empty until NVM_Service is initialized */
+    return pu8Id && bIsInitialized && bFilterMayHold(u32IdToInteger(pu8Id));
+}
+
+Mid_tenuStatus enuNVM_ReadRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord, Nvm_tstrRecord *pstrData)
+{
+    return enuRecordRead(pstrRecordDesc, pstrRecord, pstrData, false);
+}
+
+Mid_tenuStatus enuNVM_ReadSignedInRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord, Nvm_tstrRecord *pstrData)
+{
+    return enuRecordRead(pstrRecordDesc, pstrRecord, pstrData, true);
+}
+
+Mid_tenuStatus enuNVM_OpenView(fds_record_desc_t const *pstrRecordDesc, Nvm_tstrRecordView *pstrView)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
 
+    TRACE_POINT(Trace_NvmCall, Trace_NvmOpenView);
+
     /* Make sure valid parameters are passed and NVM_Service is initialized */
-    if(u16RecordKey && bIsInitialized)
+    if(pstrRecordDesc && pstrView && bIsInitialized)
     {
-        memset(pstrRecordDesc, 0, sizeof(fds_record_desc_t));
+        memcpy(&pstrView->strRecordDesc, pstrRecordDesc, sizeof(fds_record_desc_t));
 
-        /* Go through persistent keys in NVM records and try to find a match */
-        enuRetVal = (FDS_ERR_NOT_FOUND == fds_record_find(NVM_PERSISTENT_KEYS_FILE_ID,
-                                                          u16RecordKey,
-                                                          pstrRecordDesc,
-                                                          pstrPersistentKeyToken))
-                                                          ?Middleware_Failure
-                                                          :Middleware_Success;
-        if(Middleware_Failure == enuRetVal)
-        {
-            /* Go through expirable keys in NVM records and try to find a match */
-            enuRetVal = (NRF_SUCCESS == fds_record_find(NVM_EXPIRABLE_KEYS_FILE_ID,
-                                                        u16RecordKey,
-                                                        pstrRecordDesc,
-                                                        pstrExpirableKeyToken))
-                                                        ?Middleware_Success
-                                                        :Middleware_Failure;
+        /* Count view before opening its record, so that no garbage collection starts in between */
+        CRITICAL_REGION_ENTER();
+        u8OpenViews++;
+        CRITICAL_REGION_EXIT();
+
+        if(NRF_SUCCESS == fds_record_open(&pstrView->strRecordDesc, &pstrView->strFdsRecord))
+        {
+            enuRetVal = Middleware_Success;
+        }
+        else
+        {
+            memset(&pstrView->strFdsRecord, 0, sizeof(fds_flash_record_t));
+            CRITICAL_REGION_ENTER();
+            u8OpenViews--;
+            CRITICAL_REGION_EXIT();
         }
     }
 
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmOpenView);
+
     return enuRetVal;
 }
 
-Mid_tenuStatus enuNVM_ReadRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord, Nvm_tstrRecord *pstrData)
+Mid_tenuStatus enuNVM_CloseView(Nvm_tstrRecordView *pstrView)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
 
-    /* Make sure valid parameters are passed and NVM_Service is initialized */
-    if(pstrRecordDesc && pstrRecord && bIsInitialized)
+    /* Make sure an open view is passed */
+    if(pstrView && pstrView->strFdsRecord.p_data)
     {
-        /* Open record */
-        if(NRF_SUCCESS == fds_record_open(pstrRecordDesc, pstrRecord))
-        {
-            /* Copy data content out of NVM storage record */
-            memcpy(pstrData, pstrRecord->p_data, sizeof(Nvm_tstrRecord));
+        enuRetVal = (NRF_SUCCESS == fds_record_close(&pstrView->strRecordDesc))
+                                                    ?Middleware_Success
+                                                    :Middleware_Failure;
+        memset(&pstrView->strFdsRecord, 0, sizeof(fds_flash_record_t));
 
-            /* Close record when done reading to allow garbage collection to eventually reclaim
-               record's memory space in flash */
-            enuRetVal = (NRF_SUCCESS == fds_record_close(pstrRecordDesc))
-                                                        ?Middleware_Success
-                                                        :Middleware_Failure;
-        }
+        CRITICAL_REGION_ENTER();
+        u8OpenViews--;
+        CRITICAL_REGION_EXIT();
     }
 
     return enuRetVal;
 }
 
-Mid_tenuStatus enuNVM_UpdateRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile, bool bPwdReg)
+Nvm_tstrFlashRecord const *pstrNVM_ViewRecord(Nvm_tstrRecordView const *pstrView)
 {
-    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    Nvm_tstrFlashRecord const *pstrRetVal = NULL;
+
+    if(pstrView && pstrView->strFdsRecord.p_data &&
+       (NVM_RECORD_VERSION == *(uint8_t const *)pstrView->strFdsRecord.p_data))
+    {
+        pstrRetVal = (Nvm_tstrFlashRecord const *)pstrView->strFdsRecord.p_data;
+    }
+
+    return pstrRetVal;
+}
+
+bool bNVM_ViewIdMatches(Nvm_tstrRecordView const *pstrView, uint8_t const *pu8Id)
+{
+    bool bRetVal = false;
+    Nvm_tstrFlashRecord const *pstrFlashRecord = pstrNVM_ViewRecord(pstrView);
+
+    if(pstrFlashRecord && pu8Id)
+    {
+        bRetVal = (pstrFlashRecord->u32IdBcd == u32IdToBcd(pu8Id));
+    }
+    else if(pstrView && pstrView->strFdsRecord.p_data && pu8Id)
+    {
+        /* Version 1 records hold the Id as ASCII digits */
+        bRetVal = (0 == memcmp(((Nvm_tstrRecordV1 const *)pstrView->strFdsRecord.p_data)->u8Id, pu8Id, NVM_ID_SIZE));
+    }
+
+    return bRetVal;
+}
+
+bool bNVM_ViewPasswordMatches(Nvm_tstrRecordView const *pstrView, uint8_t const *pu8Password, uint8_t u8Length)
+{
+    bool bRetVal = false;
+    uint8_t const *pu8Stored = NULL;
+    Nvm_tstrFlashRecord const *pstrFlashRecord = pstrNVM_ViewRecord(pstrView);
+
+    if(pstrFlashRecord)
+    {
+        pu8Stored = pstrFlashRecord->u8Password;
+    }
+    else if(pstrView && pstrView->strFdsRecord.p_data)
+    {
+        pu8Stored = ((Nvm_tstrRecordV1 const *)pstrView->strFdsRecord.p_data)->u8Password;
+    }
+
+    /* Stored password must not go on past the given one */
+    if(pu8Stored && pu8Password && (u8Length <= NVM_PWD_SIZE))
+    {
+        bRetVal = (0 == memcmp(pu8Stored, pu8Password, u8Length)) &&
+                  ((NVM_PWD_SIZE == u8Length) || (0xFF == pu8Stored[u8Length]));
+    }
+
+    return bRetVal;
+}
+
+App_tenuKeyTypes enuNVM_ViewKeyType(Nvm_tstrRecordView const *pstrView)
+{
+    App_tenuKeyTypes enuRetVal = App_KeyLowerBound;
+    Nvm_tstrFlashRecord const *pstrFlashRecord = pstrNVM_ViewRecord(pstrView);
+
+    if(pstrFlashRecord)
+    {
+        enuRetVal = (App_tenuKeyTypes)(pstrFlashRecord->u8KeyInfo & NVM_KEY_TYPE_MASK);
+    }
+    else if(pstrView && pstrView->strFdsRecord.p_data)
+    {
+        enuRetVal = ((Nvm_tstrRecordV1 const *)pstrView->strFdsRecord.p_data)->enuKeyType;
+    }
+
+    return enuRetVal;
+}
+
+uint16_t u16NVM_RequestUpdate(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile,
+                              Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    uint16_t u16RetVal = NVM_INVALID_REQUEST;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmRequestUpdate);
 
     /* Make sure valid parameters are passed and NVM_Service is initialized */
     if(pstrRcDesc && pstrRecord && (enuFile < Nvm_MaxFiles) && bIsInitialized)
     {
-        /* Create string out of the four first numbers of user's Id */
-        char *pchRecordKey = (char *)malloc((NVM_ID_LENGTH/2)+1);
-        memcpy(pchRecordKey, &pstrRecord->u8Id[4], NVM_ID_LENGTH/2);
-        pchRecordKey[NVM_ID_LENGTH/2] = '\0';
+        /* Update record in NVM. It carries any change deferred for this user */
+        u16RetVal = u16SubmitRecord(pstrRcDesc, pstrRecord, enuFile, true, NULL, pfComplete, pvContext);
+        if(NVM_INVALID_REQUEST != u16RetVal)
+        {
+            vidCacheDrop(pstrRecord->u8Id);
+        }
+    }
+
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmRequestUpdate);
+
+    return u16RetVal;
+}
+
+Mid_tenuStatus enuNVM_UpdateRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile)
+{
+    return (NVM_INVALID_REQUEST != u16NVM_RequestUpdate(pstrRcDesc, pstrRecord, enuFile, NULL, NULL))
+                                   ?Middleware_Success
+                                   :Middleware_Failure;
+}
+
+Mid_tenuStatus enuNVM_DeferRecordUpdate(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmDeferUpdate);
+
+    /* Make sure valid parameters are passed and NVM_Service is initialized. Use counts are kept
+       by usage counter slots, count-restricted keys have no business in the cache */
+    if(pstrRcDesc && pstrRecord && (enuFile < Nvm_MaxFiles) && bIsInitialized &&
+       (App_CountRestrictedKey != pstrRecord->enuKeyType))
+    {
+        Nvm_tstrCacheEntry *pstrEntry;
+
+        CRITICAL_REGION_ENTER();
+        /* Coalesce with the user's pending update if there's one, otherwise take a free entry */
+        pstrEntry = pstrCacheLookup(pstrRecord->u8Id);
+        for(uint8_t u8Index = 0; !pstrEntry && (u8Index < MID_NVM_CACHE_SIZE); u8Index++)
+        {
+            if(!strRecordCache[u8Index].bDirty)
+            {
+                pstrEntry = &strRecordCache[u8Index];
+                pstrEntry->bDirty = true;
+                u8CacheDirtyCount++;
+            }
+        }
 
-        /* Make sure data length is 4-byte aligned */
-        fds_record_t const strFdsRecord =
+        if(pstrEntry)
         {
-            .file_id = enuFile?NVM_EXPIRABLE_KEYS_FILE_ID:NVM_PERSISTENT_KEYS_FILE_ID,
-            .key = (uint16_t)atoi(pchRecordKey),
-            .data.p_data = pstrRecord,
-            .data.length_words = (sizeof(*pstrRecord)+3) / sizeof(uint32_t),
-        };
+            memcpy(&pstrEntry->strRecord, pstrRecord, sizeof(Nvm_tstrRecord));
+            pstrEntry->pstrRcDesc = pstrRcDesc;
+            pstrEntry->enuFile = enuFile;
+            pstrEntry->xLastChange = xTaskGetTickCount();
+            enuRetVal = Middleware_Success;
+        }
+        CRITICAL_REGION_EXIT();
+    }
+
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmDeferUpdate);
+
+    return enuRetVal;
+}
 
-        /* Free allocated memory */
-        free(pchRecordKey);
+Mid_tenuStatus enuNVM_FlushRecords(bool bForce)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Success;
 
-        /* Set password registration flag if this update is to save a new password */
-        bIsPwdRegistration = bPwdReg;
+    /* Make sure NVM_Service is initialized and there's something to flush */
+    if(bIsInitialized && u8CacheDirtyCount)
+    {
+        TickType_t xNow = xTaskGetTickCount();
 
-        /* Add new record to NVM */
-        enuRetVal = (NRF_SUCCESS == fds_record_update(pstrRcDesc, &strFdsRecord))
-                                                      ?Middleware_Success
-                                                      :Middleware_Failure;
+        for(uint8_t u8Index = 0; u8Index < MID_NVM_CACHE_SIZE; u8Index++)
+        {
+            /* Unless forced, only flush entries that have settled */
+            if(strRecordCache[u8Index].bDirty &&
+               (bForce ||
+                ((xNow - strRecordCache[u8Index].xLastChange) >= pdMS_TO_TICKS(MID_NVM_CACHE_FLUSH_DELAY_MS))))
+            {
+                if(!bCacheEntryFlush(&strRecordCache[u8Index]))
+                {
+                    /* No write buffer left. Remaining entries will be flushed next time */
+                    enuRetVal = Middleware_Failure;
+                    break;
+                }
+            }
+        }
     }
 
     return enuRetVal;
 }
 
-Mid_tenuStatus enuNVM_DeleteRecord(fds_record_desc_t *pstrRcDesc)
+bool bNVM_IsIdle(void)
+{
+    return (0 == u8PendingOps);
+}
+
+Mid_tenuStatus enuNVM_SaveCheckpoint(void)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
+    uint32_t u32LatestRecordId = 0;
+
+    /* Index must not change past the stamp. Records still being migrated would be skipped on
+       wake, they are left for the next full build */
+    if(bIsInitialized && bNVM_IsIdle() && !bMigrationInFlight && !bLegacyRecordsLeft &&
+       !NVM_TXN_IN_FLIGHT(enuTxnState) &&
+       (NRF_SUCCESS == fds_latest_record_id_get(&u32LatestRecordId)))
+    {
+        CRITICAL_REGION_ENTER();
+        strCheckpoint.u32Magic = NVM_CHECKPOINT_MAGIC;
+        strCheckpoint.u32LatestRecordId = u32LatestRecordId;
+        strCheckpoint.u32IndexOverflow = bIndexOverflow?1:0;
+        memcpy(strCheckpoint.strUserIndex, strUserIndex, sizeof(strUserIndex));
+        memcpy(strCheckpoint.u32UserFilter, u32UserFilter, sizeof(u32UserFilter));
+        memcpy(strCheckpoint.strRecentUsers, strRecentUsers, sizeof(strRecentUsers));
+        CRITICAL_REGION_EXIT();
+
+        /* Check value is computed over the copy, no need to hold interrupts back meanwhile */
+        strCheckpoint.u32Check = u32CheckpointCheck();
+
+        vidBleRetainRam(&strCheckpoint, sizeof(strCheckpoint));
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
+
+uint16_t u16NVM_RequestDelete(fds_record_desc_t *pstrRcDesc, Nvm_tpfRequestComplete pfComplete, void *pvContext)
+{
+    uint16_t u16RetVal = NVM_INVALID_REQUEST;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmRequestDelete);
 
     /* Make sure valid arguments are passed and NVM_Service is initialized */
     if(pstrRcDesc && bIsInitialized)
     {
+        fds_flash_record_t strFlashRecord = {0};
+        Nvm_tstrRecord strRecord;
+
+        /* Discard any update deferred for this user */
+        if(Middleware_Success == enuNVM_ReadRecord(pstrRcDesc, &strFlashRecord, &strRecord))
+        {
+            vidCacheDrop(strRecord.u8Id);
+        }
+
         /* Delete record from NVM file system */
-        enuRetVal = (NRF_SUCCESS == fds_record_delete(pstrRcDesc))
-                                                      ?Middleware_Success
-                                                      :Middleware_Failure;
+        u16RetVal = u16RequestStarted(pfComplete, pvContext);
+        if(NVM_INVALID_REQUEST != u16RetVal)
+        {
+            vidPendingOpStarted();
+            if(NRF_SUCCESS != fds_record_delete(pstrRcDesc))
+            {
+                vidRequestAbandoned();
+                vidPendingOpCompleted();
+                u16RetVal = NVM_INVALID_REQUEST;
+            }
+        }
     }
 
-    return enuRetVal;
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmRequestDelete);
+
+    return u16RetVal;
+}
+
+Mid_tenuStatus enuNVM_DeleteRecord(fds_record_desc_t *pstrRcDesc)
+{
+    return (NVM_INVALID_REQUEST != u16NVM_RequestDelete(pstrRcDesc, NULL, NULL))
+                                   ?Middleware_Success
+                                   :Middleware_Failure;
 }
 
 Mid_tenuStatus enuNVM_ClearFlashStorage(void)
+{
+    /* Garbage collection normally happens while idle. Only proceed before going to sleep if more
+       than 2/3 of flash storage's data pages are dirty.
+       Note: WiPad in its default configuration uses 3 virtual FDS pages, one of which is the swap
+       page. This limits how long entering System OFF can be held back while still making sure
+       the device never wakes up to a full flash storage. */
+    return enuGcStart(MID_NVM_GC_SLEEP_THRESHOLD);
+}
+
+Mid_tenuStatus enuNVM_CollectGarbage(void)
 {
     Mid_tenuStatus enuRetVal = Middleware_Failure;
-    fds_stat_t strFdsStats = {0};
 
-    /* Retrieve NVM file system statistics */
-    if(NRF_SUCCESS == fds_stat(&strFdsStats))
+    /* Flash storage statistics are only worth looking at again once records were invalidated.
+       Garbage collection is held back until all other operations have completed and all cached
+       updates have been written back. */
+    if(bIsInitialized && bDirtinessChanged && bNVM_IsIdle() && !u8CacheDirtyCount && !u8OpenViews)
+    {
+        enuRetVal = enuGcStart(MID_NVM_GC_IDLE_THRESHOLD);
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_ReapExpiredKeys(uint32_t u32Now)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    fds_record_desc_t strRecordDesc = {0};
+    fds_flash_record_t strFlashRecord = {0};
+    Nvm_tstrRecord strRecord;
+    bool bBatchDone = false;
+
+    /* Passes are spaced out, they read through all of flash storage. Records are left alone
+       while garbage collection or migration moves them around */
+    if(bIsInitialized && !bGcRequested && !bMigrationInFlight &&
+       (bReapPassActive || ((xTaskGetTickCount() - xLastReapPass) >= pdMS_TO_TICKS(MID_NVM_REAP_PERIOD_MS))))
     {
-        /* If more than 2/3 of available flash storage space is dirty, proceed to garbage
-           collection.
-           Note: WiPad in its default configuartion uses 3 virtual FDS pages, each of which is
-           1024 bytes large. This means garbage collection will happen once 2048 bytes of flash
-           storage space have been soiled. This is done to minimize the amount of times garbage
-           collection is performed throughout the device's lifetime. */
-        if(NVM_DIRTY_RECORDS_SIZE(strFdsStats.dirty_records) >=
-           2*(FDS_VIRTUAL_PAGES*FDS_VIRTUAL_PAGE_SIZE)/3)
+        bReapPassActive = true;
+        enuRetVal = Middleware_Success;
+
+        for(uint8_t u8Record = 0; !bBatchDone && (u8Record < MID_NVM_REAP_BATCH); u8Record++)
         {
-            /* Garbage collect to reclaim unused flash storage space */
-            enuRetVal = (NRF_SUCCESS == fds_gc())?Middleware_Success:Middleware_Failure;
+            if(NRF_SUCCESS != fds_record_iterate(&strRecordDesc, &strReapToken))
+            {
+                /* Pass complete */
+                memset(&strReapToken, 0, sizeof(strReapToken));
+                xLastReapPass = xTaskGetTickCount();
+                bReapPassActive = false;
+                bBatchDone = true;
+            }
+            else if((NRF_SUCCESS == fds_record_open(&strRecordDesc, &strFlashRecord)) &&
+                    (NRF_SUCCESS == fds_record_close(&strRecordDesc)) &&
+                    NVM_IS_EXPIRABLE_FILE(strFlashRecord.p_header->file_id) &&
+                    (Middleware_Success == enuNVM_ReadRecord(&strRecordDesc, &strFlashRecord, &strRecord)) &&
+                    bRecordExpired(&strRecord, u32Now))
+            {
+                /* Record goes on to the next pass if FDS's queue can't take the deletion in */
+                bBatchDone = (Middleware_Success != enuNVM_DeleteRecord(&strRecordDesc));
+            }
+        }
+    }
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_CountUse(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    TRACE_POINT(Trace_NvmCall, Trace_NvmCountUse);
+
+    /* Make sure valid parameters are passed and NVM_Service is initialized */
+    if(pstrRcDesc && pstrRecord && bIsInitialized)
+    {
+        /* A use clears half a word in owner's usage counter slot. Record is rewritten instead if
+           no slot can take it */
+        if((App_CountRestrictedKey == pstrRecord->enuKeyType) && bCounterAdd(u32IdToBcd(pstrRecord->u8Id)))
+        {
+            enuRetVal = Middleware_Success;
+        }
+        else
+        {
+            enuRetVal = enuNVM_UpdateRecord(pstrRcDesc, pstrRecord, Nvm_ExpirableKeys);
+        }
+    }
+
+    TRACE_POINT(Trace_NvmReturn, Trace_NvmCountUse);
+
+    return enuRetVal;
+}
+
+Mid_tenuStatus enuNVM_CompactCounters(void)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+    uint16_t u16Slot = NVM_COUNTER_NO_SLOT;
+    bool bPagesFull = (u16CounterNextFree >= NVM_COUNTER_SLOTS);
+
+    /* One slot is folded at a time, once flash storage is done with all other operations */
+    if(bIsInitialized && bCounterReady && !bCounterErasing && !bMigrationInFlight &&
+       (NVM_COUNTER_NO_SLOT == u16CounterFolding) && bNVM_IsIdle())
+    {
+        /* Exhausted slots are folded as they come. All live slots are once there's no free one */
+        for(uint16_t u16Index = 0; (NVM_COUNTER_NO_SLOT == u16Slot) && (u16Index < u16CounterNextFree); u16Index++)
+        {
+            if((Nvm_CounterLive == strCounterSlot[u16Index].enuState) &&
+               (bPagesFull || (strCounterSlot[u16Index].u8Uses >= NVM_COUNTER_SLOT_USES)))
+            {
+                u16Slot = u16Index;
+            }
+        }
+
+        if(NVM_COUNTER_NO_SLOT != u16Slot)
+        {
+            enuRetVal = bCounterFold(u16Slot)?Middleware_Success:Middleware_Failure;
+        }
+        else if(bPagesFull && !u8CounterPendingOps)
+        {
+            /* Every slot is folded, hand them all out again */
+            CRITICAL_REGION_ENTER();
+            bCounterErasing = true;
+            u8CounterPendingOps++;
+            if(NRF_SUCCESS == nrf_fstorage_erase(&strCounterFs, strCounterFs.start_addr, MID_NVM_COUNTER_PAGES, NULL))
+            {
+                enuRetVal = Middleware_Success;
+            }
+            else
+            {
+                bCounterErasing = false;
+                u8CounterPendingOps--;
+            }
+            CRITICAL_REGION_EXIT();
         }
     }
 
     return enuRetVal;
-}
\ No newline at end of file
+}
+
+void vidNVM_RegisterGcHooks(Nvm_tpfGcProgress pfProgress, Nvm_tpfGcComplete pfComplete)
+{
+    /* Register garbage collection hooks */
+    pfGcProgress = pfProgress;
+    pfGcComplete = pfComplete;
+}
+
+Mid_tenuStatus enuNVM_GetBootStats(Nvm_tstrBootStats *pstrStats)
+{
+    Mid_tenuStatus enuRetVal = Middleware_Failure;
+
+    /* Make sure valid parameters are passed and the index was made ready */
+    if(pstrStats && bBootStatsReady)
+    {
+        *pstrStats = strBootStats;
+        enuRetVal = Middleware_Success;
+    }
+
+    return enuRetVal;
+}
@@ -11,7 +11,7 @@
 /****************************************   INCLUDES   *******************************************/
 #include "middleware_utils.h"
 #include "system_config.h"
-#include "App_types.h"
+#include "App_Types.h"
 #include "ble_cts_c.h"
 #include "fds.h"
 
@@ -19,9 +19,16 @@
 #define NVM_ID_SIZE  8U
 #define NVM_PWD_SIZE 12U
 
-/* Dispatchable events */
-#define NVM_ENTRY_ADDED         17U
-#define NVM_PASSWORD_REGISTERED 18U
+/* On-flash record format version */
+#define NVM_RECORD_VERSION 2U
+
+/* On-flash record key information bits */
+#define NVM_KEY_TYPE_MASK     0x07U     /* User's key type                 */
+#define NVM_KEY_ONE_TIME_USED (1 << 3)  /* One-time key used               */
+#define NVM_KEY_TIME_ACTIVE   (1 << 4)  /* Time-restricted key activated   */
+
+/* Handle never given to a queued request */
+#define NVM_INVALID_REQUEST 0U
 
 /**************************************   PUBLIC TYPES   *****************************************/
 /**
@@ -54,13 +61,16 @@ typedef struct
 }Nvm_tstrCountResKey;
 
 /**
- * Nvm_tstrRecord FDS record-defining structure.
+ * Nvm_tstrRecord User record as seen by the application.
+ *
+ * @note This is not the format records are stored in. NVM_Service packs it into an
+ *       Nvm_tstrFlashRecord before writing it to flash storage and unpacks it when reading.
 */
 typedef struct
 {
     uint8_t u8Id[NVM_ID_SIZE];           /* User Id                         */
     uint8_t u8Password[NVM_PWD_SIZE];    /* User password                   */
-    exact_time_256_t strLastKnownUse;    /* Last time this key was used     */
+    uint32_t u32LastKnownUse;            /* Last time this key was used     */
     App_tenuKeyTypes enuKeyType;         /* User's key type                 */
     union{
         Nvm_tstrCountResKey strCountRes; /* Count-restricted key quantifier */
@@ -70,13 +80,99 @@ typedef struct
 }Nvm_tstrRecord;
 
 /**
- * Nvm_tstrRecordDispatch Dispatchable record defining structure.
+ * Nvm_tstrFlashRecord Packed FDS record-defining structure (format version 2).
+ *
+ * @note The user Id is stored as 8 BCD digits, timestamps as Unix epochs and the key type along
+ *       with its flags in a single byte. Key parameter holds the count limit of count-restricted
+ *       keys or the timeout of time-restricted keys in minutes, while key state holds the used
+ *       count or the activation time respectively.
+*/
+typedef struct
+{
+    uint8_t u8Version;                /* Record format version, NVM_RECORD_VERSION */
+    uint8_t u8KeyInfo;                /* Key type and flags                        */
+    uint16_t u16KeyParam;             /* Key type-specific parameter               */
+    uint32_t u32IdBcd;                /* BCD-encoded user Id                       */
+    uint32_t u32LastKnownUse;         /* Last time this key was used               */
+    uint32_t u32KeyState;             /* Key type-specific state                   */
+    uint8_t u8Password[NVM_PWD_SIZE]; /* User password                             */
+}Nvm_tstrFlashRecord;
+
+/**
+ * Nvm_tpfGcProgress Garbage collection progress hook.
+ *
+ * @note Functions of this type are invoked whenever NVM_Service starts a garbage collection run.
+ *       They take one argument:
+ *         - uint8_t u8DirtyRatio: Share of data pages, in percent, about to be reclaimed.
+*/
+typedef void (*Nvm_tpfGcProgress)(uint8_t u8DirtyRatio);
+
+/**
+ * Nvm_tpfGcComplete Garbage collection completion hook.
+ *
+ * @note Functions of this type are invoked whenever a garbage collection run started by
+ *       NVM_Service completes. They take one argument:
+ *         - Mid_tenuStatus enuResult: Middleware_Success if flash storage space was reclaimed,
+ *           Middleware_Failure otherwise.
+*/
+typedef void (*Nvm_tpfGcComplete)(Mid_tenuStatus enuResult);
+
+/**
+ * Nvm_tpfRequestComplete Record request completion callback.
+ *
+ * @note Functions of this type are invoked from vidNvmEventHandler once the add, update or
+ *       delete request they were queued with completes. They take three arguments:
+ *         - uint16_t u16Request: Handle the request was given when queued.
+ *         - Mid_tenuStatus enuResult: Middleware_Success if flash storage holds the change,
+ *           Middleware_Failure otherwise.
+ *         - void *pvContext: Context pointer the request was queued with.
+*/
+typedef void (*Nvm_tpfRequestComplete)(uint16_t u16Request, Mid_tenuStatus enuResult, void *pvContext);
+
+/**
+ * Nvm_tpfBatchComplete Record batch completion callback.
+ *
+ * @note Functions of this type are invoked once every record of a batch queued through
+ *       enuNVM_AddRecordBatch was either written or given up on. They take three arguments:
+ *         - uint16_t u16Added: Number of records written to flash storage.
+ *         - uint16_t u16Failed: Number of records that couldn't be written.
+ *         - void *pvContext: Context pointer the batch was queued with.
+*/
+typedef void (*Nvm_tpfBatchComplete)(uint16_t u16Added, uint16_t u16Failed, void *pvContext);
+
+/**
+ * Nvm_tpfTransactionComplete Transaction completion callback.
+ *
+ * @note Functions of this type are invoked from vidNvmEventHandler once a transaction committed
+ *       through enuNVM_CommitTransaction is over. They take two arguments:
+ *         - Mid_tenuStatus enuResult: Middleware_Success if every staged change was applied,
+ *           Middleware_Failure if none was, or if the rest is left to be rolled forward on
+ *           next boot.
+ *         - void *pvContext: Context pointer the transaction was committed with.
+*/
+typedef void (*Nvm_tpfTransactionComplete)(Mid_tenuStatus enuResult, void *pvContext);
+
+/**
+ * Nvm_tstrRecordView Read-only view of a record, straight into memory-mapped flash.
+ *
+ * @note A view keeps its record open, which pins the flash page it sits in against garbage
+ *       collection. Views are meant to be closed before returning to the caller's event loop.
 */
 typedef struct
 {
-    fds_record_desc_t *pstrRecordDesc; /* Record descriptor                 */
-    Nvm_tstrRecord *pstrRecord;        /* Record as seen by the application */
-}Nvm_tstrRecordDispatch;
+    fds_record_desc_t strRecordDesc;   /* Descriptor the record was opened with */
+    fds_flash_record_t strFdsRecord;   /* Record as seen by FDS                 */
+}Nvm_tstrRecordView;
+
+/**
+ * Nvm_tstrBootStats Figures on how the user index was made ready at boot.
+*/
+typedef struct
+{
+    uint32_t u32ReadyTimeUs;      /* Time from enuNvm_Init to the index being ready, in us      */
+    uint16_t u16RecordsIndexed;   /* Records opened to build the index                          */
+    bool bFromCheckpoint;         /* Index restored from the checkpoint taken before System OFF */
+}Nvm_tstrBootStats;
 
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 /**
@@ -93,20 +189,42 @@ typedef struct
 Mid_tenuStatus enuNvm_Init(void);
 
 /**
- * @brief enuNVM_AddNewRecord Adds a new entry in the form of an FDS record to the NVM file system.
+ * @brief u16NVM_RequestAdd Adds a new entry in the form of an FDS record to the NVM file system.
  *
- * @note NVM_Service uses two seperate files to keep track of data entries depending on the provided
- *       user key type; expirable as in one-time, count-restricted and time-restricted keys and
- *       persistent as in unlimited and admin keys.
+ * @note NVM_Service uses two seperate file ranges to keep track of data entries depending on the
+ *       provided user key type; expirable as in one-time, count-restricted and time-restricted keys
+ *       and persistent as in unlimited and admin keys. User Ids are fully encoded in the FDS file Id
+ *       and record key a record is stored under, so no two users can ever share the same keys.
+ *       Adding an Id that's already registered is therefore turned down.
  *
- * @note This is an asynchronous call. Completion is reported through the FDS_EVT_WRITE event in
- *       vidNvmEventHandler.
+ * @note This is an asynchronous call. The record is packed into one of NVM_Service's write
+ *       buffers, so the passed structure doesn't need to outlive the call. Up to FDS_OP_QUEUE_SIZE
+ *       requests may be in flight, each completing through its own callback in the order they
+ *       were queued.
  *
  * @pre enuNvm_Init must be called before attempting any record write to NVM.
  *
  * @param pstrRcDesc Pointer to record descriptor structure.
  * @param pstrRecord Pointer to data record structure.
  * @param enuFile File to be used for record storage.
+ * @param pfComplete Pointer to completion callback, NULL if the outcome doesn't matter.
+ * @param pvContext Context pointer passed back to the completion callback.
+ *
+ * @return uint16_t Request handle if write operation request was successfully queued,
+ *         NVM_INVALID_REQUEST otherwise, Id already registered included, in which case the
+ *         callback is never invoked.
+ */
+uint16_t u16NVM_RequestAdd(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile,
+                           Nvm_tpfRequestComplete pfComplete, void *pvContext);
+
+/**
+ * @brief enuNVM_AddNewRecord Adds a new entry to the NVM file system, regardless of the outcome.
+ *
+ * @note Same as u16NVM_RequestAdd without a completion callback.
+ *
+ * @param pstrRcDesc Pointer to record descriptor structure.
+ * @param pstrRecord Pointer to data record structure.
+ * @param enuFile File to be used for record storage.
  *
  * @return Mid_tenuStatus Middleware_Success if write operation request was successfully queued,
  *         Middleware_Failure otherwise.
@@ -114,30 +232,140 @@ Mid_tenuStatus enuNvm_Init(void);
 Mid_tenuStatus enuNVM_AddNewRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile);
 
 /**
- * @brief enuNVM_FindRecord Goes through the NVM file system looking for a record identified by
- *        its key.
+ * @brief enuNVM_AddRecordBatch Adds a batch of new entries to the NVM file system.
+ *
+ * @note Flash space is reserved for the whole batch before any record is written, so a batch that
+ *       doesn't fit is turned down right away rather than running out of space halfway through.
+ *       Records are then written back to back, each write being queued as soon as an earlier one
+ *       completes. One request is always left to other requesters.
+ *
+ * @note This is an asynchronous call. Completion is reported once for the whole batch, possibly
+ *       before this function returns. Records are written to the file their key type maps to.
+ *
+ * @pre enuNvm_Init must be called before attempting any record write to NVM.
+ *
+ * @param pstrRecords Pointer to data record array. It must remain valid until the batch completes.
+ * @param u16Count Number of records in the array, MID_NVM_BATCH_SIZE at most.
+ * @param pfComplete Pointer to completion callback, NULL if the outcome doesn't matter.
+ * @param pvContext Context pointer passed back to the completion callback.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the batch was accepted, Middleware_Failure if it
+ *         doesn't fit in flash storage or another batch is still being written, in which case the
+ *         callback is never invoked.
+ */
+Mid_tenuStatus enuNVM_AddRecordBatch(Nvm_tstrRecord const *pstrRecords, uint16_t u16Count,
+                                    Nvm_tpfBatchComplete pfComplete, void *pvContext);
+
+/**
+ * @brief enuNVM_BeginTransaction Starts staging changes to be applied to several records at once.
+ *
+ * @note Staged changes are only kept in RAM until committed. A transaction either gets applied
+ *       as a whole or not at all, even across a reset. Only one transaction may be staged or
+ *       applied at a time.
+ *
+ * @pre enuNvm_Init must be called before starting any transaction.
+ *
+ * @return Mid_tenuStatus Middleware_Success if staging started, Middleware_Failure if another
+ *         transaction is still under way or was left to be rolled forward on next boot.
+ */
+Mid_tenuStatus enuNVM_BeginTransaction(void);
+
+/**
+ * @brief enuNVM_StageRecord Stages a user's record to be written as part of the transaction.
  *
- * @note This is a synchronous call. Both NVM_Service's files are looked through to find a match
- *       for the given record which could take a while depending on the number of records stored
- *       in the file system.
+ * @note The user is added if they aren't registered yet and their record is replaced otherwise.
+ *       Changes staged for the same user are coalesced, the last one wins. The record goes to the
+ *       file its key type maps to.
  *
- * @pre enuNvm_Init must be called before attempting to find any record in the file system.
+ * @param pstrRecord Pointer to data record structure. It is copied, it needn't outlive the call.
  *
- * @param u16RecordKey Record key to be looked for.
+ * @return Mid_tenuStatus Middleware_Success if the record was staged, Middleware_Failure if no
+ *         transaction is being staged or MID_NVM_TXN_SIZE users already are.
+ */
+Mid_tenuStatus enuNVM_StageRecord(Nvm_tstrRecord const *pstrRecord);
+
+/**
+ * @brief enuNVM_StageDelete Stages a user's deletion as part of the transaction.
+ *
+ * @param pu8Id Pointer to 8-digit user Id.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the deletion was staged, Middleware_Failure if no
+ *         transaction is being staged or MID_NVM_TXN_SIZE users already are.
+ */
+Mid_tenuStatus enuNVM_StageDelete(uint8_t const *pu8Id);
+
+/**
+ * @brief enuNVM_CommitTransaction Applies every staged change to the NVM file system.
+ *
+ * @note Flash space is reserved for the whole transaction first. Staged changes are then written
+ *       to a single intent record, which FDS writes atomically. Once it's in flash the
+ *       transaction is committed: changes are applied back to back, as many in flight as the
+ *       request queue allows, and the intent record is deleted once they all are.
+ *
+ * @note A reset before the intent record is written leaves flash storage untouched. A reset
+ *       after it has been written has enuNvm_Init roll the transaction forward, each change
+ *       being skipped if flash storage already holds it.
+ *
+ * @note This is an asynchronous call. Completion is reported once for the whole transaction,
+ *       possibly before this function returns.
+ *
+ * @param pfComplete Pointer to completion callback, NULL if the outcome doesn't matter.
+ * @param pvContext Context pointer passed back to the completion callback.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the transaction is being committed,
+ *         Middleware_Failure if it doesn't fit in flash storage or no transaction is being
+ *         staged, in which case the callback is never invoked and changes remain staged.
+ */
+Mid_tenuStatus enuNVM_CommitTransaction(Nvm_tpfTransactionComplete pfComplete, void *pvContext);
+
+/**
+ * @brief enuNVM_AbortTransaction Drops every staged change.
+ *
+ * @return Mid_tenuStatus Middleware_Success if staged changes were dropped, Middleware_Failure
+ *         if no transaction is being staged.
+ */
+Mid_tenuStatus enuNVM_AbortTransaction(void);
+
+/**
+ * @brief enuNVM_FindUser Looks up the record holding a given user's data.
+ *
+ * @note This is a synchronous call. NVM_Service keeps a RAM index mapping user Ids to FDS record
+ *       Ids. It is built once upon FDS_EVT_INIT and kept up to date on every write, update and
+ *       delete event, so a lookup costs a single probe sequence rather than a scan through both
+ *       of NVM_Service's files. Should the index ever overflow, the user's record is looked up
+ *       by the exact file Id and record key its Id maps to.
+ *
+ * @note A Bloom filter over registered Ids is checked first. Most unregistered Ids are turned
+ *       down by it without probing the index nor, once it has overflowed, searching flash.
+ *
+ * @pre enuNvm_Init must be called and FDS_EVT_INIT received before looking up any user.
+ *
+ * @param pu8Id Pointer to 8-digit user Id.
  * @param pstrRecordDesc Pointer to record descriptor structure.
- * @param pstrPersistentKeyToken Pointer to token structure for persistent key record.
- * @param pstrExpirableKeyToken Pointer to token structure for expirable key record.
  *
- * @return Mid_tenuStatus Middleware_Success if record was successfully found in NVM,
- *         Middleware_Failure otherwise.
+ * @return Mid_tenuStatus Middleware_Success if user's record was located, Middleware_Failure
+ *         otherwise.
+ */
+Mid_tenuStatus enuNVM_FindUser(uint8_t const *pu8Id, fds_record_desc_t *pstrRecordDesc);
+
+/**
+ * @brief bNVM_MayHoldUser Checks a user Id against NVM_Service's Bloom filter.
+ *
+ * @note The filter holds MID_NVM_BLOOM_BITS bits and is kept up to date along with the index. It
+ *       never turns down a registered Id but may let an unregistered one through.
+ *
+ * @param pu8Id Pointer to 8-digit user Id.
+ *
+ * @return bool false if the Id is definitely not registered, true if it may be.
  */
-Mid_tenuStatus enuNVM_FindRecord(uint16_t u16RecordKey, fds_record_desc_t *pstrRecordDesc, fds_find_token_t *pstrPersistentKeyToken, fds_find_token_t *pstrExpirableKeyToken);
+bool bNVM_MayHoldUser(uint8_t const *pu8Id);
 
 /**
  * @brief enuNVM_ReadRecord Extracts data record from NVM.
  *
- * @note This is a synchronous call. Every read operation involves opening a record, copying its
- *       content then closing it again.
+ * @note This is a synchronous call. Every read operation involves opening a record, unpacking
+ *       its content then closing it again. Records still in the version 1 format are converted on
+ *       the fly until they get migrated.
  *
  * @pre enuNvm_Init must be called before attempting to read any record.
  *
@@ -151,7 +379,102 @@ Mid_tenuStatus enuNVM_FindRecord(uint16_t u16RecordKey, fds_record_desc_t *pstrR
 Mid_tenuStatus enuNVM_ReadRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord, Nvm_tstrRecord *pstrData);
 
 /**
- * @brief enuNVM_UpdateRecord Updates an already existing record in the NVM file system.
+ * @brief enuNVM_ReadSignedInRecord Extracts a signed-in user's data record from NVM.
+ *
+ * @note Same as enuNVM_ReadRecord, except the record is also kept among the MID_NVM_RECENT_USERS
+ *       most recently signed-in users. Their records are served out of RAM, retained across
+ *       System OFF along with the user index, until they're updated or deleted. FDS's record
+ *       structure is left zeroed when the record doesn't come from flash.
+ *
+ * @pre enuNvm_Init must be called before attempting to read any record.
+ *
+ * @param pstrRecordDesc Pointer to record descriptor structure.
+ * @param pstrRecord Pointer to record structure as defined by FDS.
+ * @param pstrData Pointer to record structure as defined by NVM_Service.
+ *
+ * @return Mid_tenuStatus Middleware_Success if record was extracted and read successfully,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_ReadSignedInRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_record_t *pstrRecord, Nvm_tstrRecord *pstrData);
+
+/**
+ * @brief enuNVM_OpenView Opens a read-only view of a record, without copying it out of flash.
+ *
+ * @note This is a synchronous call. The record is opened through FDS, which won't reclaim the
+ *       flash page it sits in until it's closed again, and NVM_Service holds back garbage
+ *       collection altogether while any view is open. Record content is read in place through
+ *       pstrNVM_ViewRecord and the bNVM_View helpers.
+ *
+ * @note Views show what flash storage holds. Id, password and key type are never deferred
+ *       through enuNVM_DeferRecordUpdate, so they're always up to date. Other fields may not be,
+ *       use enuNVM_ReadRecord for those.
+ *
+ * @pre enuNvm_Init must be called before opening any view.
+ *
+ * @param pstrRecordDesc Pointer to record descriptor structure.
+ * @param pstrView Pointer to view to open.
+ *
+ * @return Mid_tenuStatus Middleware_Success if view was opened, Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_OpenView(fds_record_desc_t const *pstrRecordDesc, Nvm_tstrRecordView *pstrView);
+
+/**
+ * @brief enuNVM_CloseView Closes a view opened with enuNVM_OpenView.
+ *
+ * @note Pointers obtained through the view must not be used once it's closed.
+ *
+ * @param pstrView Pointer to open view.
+ *
+ * @return Mid_tenuStatus Middleware_Success if view was closed, Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_CloseView(Nvm_tstrRecordView *pstrView);
+
+/**
+ * @brief pstrNVM_ViewRecord Gets a view's record, as packed in flash.
+ *
+ * @param pstrView Pointer to open view.
+ *
+ * @return Nvm_tstrFlashRecord const * Pointer to the record in flash, NULL if the record is still
+ *         in the version 1 format. The bNVM_View helpers work with both formats.
+ */
+Nvm_tstrFlashRecord const *pstrNVM_ViewRecord(Nvm_tstrRecordView const *pstrView);
+
+/**
+ * @brief bNVM_ViewIdMatches Compares a view's user Id against a given one, in place.
+ *
+ * @param pstrView Pointer to open view.
+ * @param pu8Id Pointer to 8-digit user Id.
+ *
+ * @return bool true if both Ids are the same, false otherwise.
+ */
+bool bNVM_ViewIdMatches(Nvm_tstrRecordView const *pstrView, uint8_t const *pu8Id);
+
+/**
+ * @brief bNVM_ViewPasswordMatches Compares a view's password against a given one, in place.
+ *
+ * @note Passwords shorter than NVM_PWD_SIZE are stored followed by erased bytes (0xFF), so a
+ *       stored password only matches given ones of the very same length. An unregistered
+ *       password reads as erased bytes all along.
+ *
+ * @param pstrView Pointer to open view.
+ * @param pu8Password Pointer to password.
+ * @param u8Length Password length, NVM_PWD_SIZE at most.
+ *
+ * @return bool true if both passwords are the same, false otherwise.
+ */
+bool bNVM_ViewPasswordMatches(Nvm_tstrRecordView const *pstrView, uint8_t const *pu8Password, uint8_t u8Length);
+
+/**
+ * @brief enuNVM_ViewKeyType Gets a view's key type.
+ *
+ * @param pstrView Pointer to open view.
+ *
+ * @return App_tenuKeyTypes User's key type, App_KeyLowerBound if the view isn't open.
+ */
+App_tenuKeyTypes enuNVM_ViewKeyType(Nvm_tstrRecordView const *pstrView);
+
+/**
+ * @brief u16NVM_RequestUpdate Updates an already existing record in the NVM file system.
  *
  * @note NVM_Service relies on FDS to abstract away the lowel-level complexity of manipulating
  *       flash storage and is therefore unable to physically alter the content of a record
@@ -159,34 +482,161 @@ Mid_tenuStatus enuNVM_ReadRecord(fds_record_desc_t *pstrRecordDesc, fds_flash_re
  *       the update in the new copy and invalidates the original record, essentially allowing
  *       it to be freed when garbage is collected.
  *
- * @note This is an asynchronous call. Completion is reported through the FDS_EVT_UPDATE event in
- *       vidNvmEventHandler.
+ * @note This is an asynchronous call. The record is packed into one of NVM_Service's write
+ *       buffers, so the passed structure doesn't need to outlive the call. Completion is reported
+ *       the same way as for u16NVM_RequestAdd.
  *
  * @pre enuNvm_Init must be called before attempting any record update.
  *
  * @param pstrRcDesc Pointer to record descriptor structure.
  * @param pstrRecord Pointer to updated data record structure.
  * @param enuFile File to be used for record storage.
- * @param bPwdReg Flag indicating whether or not this is a password registration operation.
+ * @param pfComplete Pointer to completion callback, NULL if the outcome doesn't matter.
+ * @param pvContext Context pointer passed back to the completion callback.
+ *
+ * @return uint16_t Request handle if update operation request was successfully queued,
+ *         NVM_INVALID_REQUEST otherwise, in which case the callback is never invoked.
+ */
+uint16_t u16NVM_RequestUpdate(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile,
+                              Nvm_tpfRequestComplete pfComplete, void *pvContext);
+
+/**
+ * @brief enuNVM_UpdateRecord Updates an already existing record, regardless of the outcome.
+ *
+ * @note Same as u16NVM_RequestUpdate without a completion callback.
+ *
+ * @param pstrRcDesc Pointer to record descriptor structure.
+ * @param pstrRecord Pointer to updated data record structure.
+ * @param enuFile File to be used for record storage.
  *
  * @return Mid_tenuStatus Middleware_Success if update operation request was successfully queued,
  *         Middleware_Failure otherwise.
  */
-Mid_tenuStatus enuNVM_UpdateRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile, bool bPwdReg);
+Mid_tenuStatus enuNVM_UpdateRecord(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile);
+
+/**
+ * @brief enuNVM_DeferRecordUpdate Stores a record update in NVM_Service's write-behind cache
+ *        rather than writing it to flash right away.
+ *
+ * @note Successive deferred updates of the same user are coalesced into a single flash write.
+ *       Only use this for changes that can afford being lost on reset, such as last known use
+ *       timestamps. Security-relevant changes must go through enuNVM_UpdateRecord, which also
+ *       supersedes any update deferred for the same user.
+ *
+ * @note This is a synchronous call. Cached updates are visible to enuNVM_ReadRecord and written
+ *       back by enuNVM_FlushRecords.
+ *
+ * @pre enuNvm_Init must be called before deferring any record update.
+ *
+ * @param pstrRcDesc Pointer to record descriptor structure. It is refreshed when the update is
+ *        flushed and must therefore remain valid until then.
+ * @param pstrRecord Pointer to updated data record structure.
+ * @param enuFile File to be used for record storage.
+ *
+ * @return Mid_tenuStatus Middleware_Success if update was cached, Middleware_Failure if the
+ *         cache is full or the record holds a count-restricted key, in which case the update
+ *         should be written right away.
+ */
+Mid_tenuStatus enuNVM_DeferRecordUpdate(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord, Nvm_tenuFiles enuFile);
+
+/**
+ * @brief enuNVM_CountUse Persists a use of a count-restricted key.
+ *
+ * @note Uses are counted in usage counter slots kept in MID_NVM_COUNTER_PAGES flash pages right
+ *       below FDS's pages, rather than by rewriting the user's record. A use clears half of a
+ *       word in the user's 64-byte slot, which holds 28 uses. enuNVM_ReadRecord adds
+ *       slot uses to the count held by the record. Exhausted slots are folded back into their
+ *       owner's record by enuNVM_CompactCounters.
+ *
+ * @note This is an asynchronous call costing a single word write. Only the use count is
+ *       persisted, other changes to the record, such as its last known use, are not. The record
+ *       is updated through enuNVM_UpdateRecord instead if no slot can take the use in.
+ *
+ * @pre enuNvm_Init must be called before counting any use.
+ *
+ * @param pstrRcDesc Pointer to record descriptor structure.
+ * @param pstrRecord Pointer to data record structure, use count already incremented.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the use was queued for writing,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_CountUse(fds_record_desc_t *pstrRcDesc, Nvm_tstrRecord const *pstrRecord);
+
+/**
+ * @brief enuNVM_FlushRecords Writes cached record updates back to flash storage.
+ *
+ * @note This is an asynchronous call. Each flushed entry completes through an FDS_EVT_UPDATE
+ *       event in vidNvmEventHandler.
+ *
+ * @note This function is invoked on disconnection and before entering System OFF with bForce
+ *       set, and from idle housekeeping without it so that entries are only flushed once
+ *       they've been left untouched for MID_NVM_CACHE_FLUSH_DELAY_MS.
+ *
+ * @pre enuNvm_Init must be called before flushing any record.
+ *
+ * @param bForce Flag indicating whether all cached entries must be flushed regardless of age.
+ *
+ * @return Mid_tenuStatus Middleware_Success if all due entries were queued for writing,
+ *         Middleware_Failure if some are left in the cache for lack of write buffers.
+ */
+Mid_tenuStatus enuNVM_FlushRecords(bool bForce);
+
+/**
+ * @brief bNVM_IsIdle Checks whether NVM_Service has any flash operation in flight.
+ *
+ * @note Whenever the last operation in flight completes, NVM_Service calls
+ *       vidFlashStorageIdleCallback.
+ *
+ * @return bool true if all queued operations have completed, false otherwise.
+ */
+bool bNVM_IsIdle(void);
 
 /**
- * @brief enuNVM_DeleteRecord Deletes a record from the NVM file system.
+ * @brief enuNVM_SaveCheckpoint Saves a checkpoint of the user index before entering System OFF.
+ *
+ * @note The index, Bloom filter and recently signed-in users' records are copied to RAM left
+ *       alone by startup code, stamped with the latest FDS record Id, and the RAM sections
+ *       holding them are retained in System OFF. On wake, enuNvm_Init restores them and only
+ *       indexes records written after the stamp instead of opening every record in flash
+ *       storage. Retained RAM costs no flash wear, whereas a checkpoint in flash would take a
+ *       page erase on every sleep.
+ *
+ * @note The checkpoint is only valid for a single wake and is dropped by any other kind of reset.
+ *
+ * @pre This function must be invoked right before entering System OFF, once NVM_Service is idle.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the checkpoint was saved, Middleware_Failure if
+ *         operations are still in flight or legacy records are left to migrate.
+ */
+Mid_tenuStatus enuNVM_SaveCheckpoint(void);
+
+/**
+ * @brief u16NVM_RequestDelete Deletes a record from the NVM file system.
  *
  * @note This function does not actually delete records, rather it invalidates them so they can
  *       no longer be found nor opened. It essentially enables garbage collection to reclaim the
  *       flash storage space previously occupied by the invalidated record.
  *
- * @note This is an asynchronous call. Completion is reported through the FDS_EVT_DEL_RECORD event
- *       in vidNvmEventHandler.
+ * @note This is an asynchronous call. Completion is reported the same way as for
+ *       u16NVM_RequestAdd.
  *
  * @pre enuNvm_Init must be called before attempting any record deleting.
  *
  * @param pstrRcDesc Pointer to record descriptor structure.
+ * @param pfComplete Pointer to completion callback, NULL if the outcome doesn't matter.
+ * @param pvContext Context pointer passed back to the completion callback.
+ *
+ * @return uint16_t Request handle if delete operation request was successfully queued,
+ *         NVM_INVALID_REQUEST otherwise, in which case the callback is never invoked.
+ */
+uint16_t u16NVM_RequestDelete(fds_record_desc_t *pstrRcDesc, Nvm_tpfRequestComplete pfComplete, void *pvContext);
+
+/**
+ * @brief enuNVM_DeleteRecord Deletes a record from the NVM file system, regardless of the outcome.
+ *
+ * @note Same as u16NVM_RequestDelete without a completion callback.
+ *
+ * @param pstrRcDesc Pointer to record descriptor structure.
  *
  * @return Mid_tenuStatus Middleware_Success if delete operation request was successfully queued,
  *         Middleware_Failure otherwise.
@@ -195,7 +645,11 @@ Mid_tenuStatus enuNVM_DeleteRecord(fds_record_desc_t *pstrRcDesc);
 
 /**
  * @brief enuNVM_ClearFlashStorage Performs garbage collection to reclaim invalidated flash storage
- *        space.
+ *        space before going to sleep.
+ *
+ * @note Garbage collection is only requested if at least MID_NVM_GC_SLEEP_THRESHOLD percent of
+ *       flash storage's data pages would be reclaimed. Lower dirty ratios are dealt with by
+ *       enuNVM_CollectGarbage while the device is idle.
  *
  * @note This is an asynchronous call. Completion is reported through the FDS_EVT_GC event
  *       in vidNvmEventHandler.
@@ -207,4 +661,88 @@ Mid_tenuStatus enuNVM_DeleteRecord(fds_record_desc_t *pstrRcDesc);
  */
 Mid_tenuStatus enuNVM_ClearFlashStorage(void);
 
+/**
+ * @brief enuNVM_CollectGarbage Runs one step of NVM_Service's garbage collection scheduler.
+ *
+ * @note This function is meant to be invoked from idle housekeeping while no connection is active.
+ *       It only looks at flash storage statistics once records have been invalidated since the last
+ *       check, and only starts garbage collection once NVM_Service has no operation in flight, no
+ *       cached update left and at least MID_NVM_GC_IDLE_THRESHOLD percent of data pages can be
+ *       reclaimed.
+ *
+ * @note FDS collects all data pages within a single run. A run is a sequence of asynchronous
+ *       flash operations driven by SoC events, so it never blocks the calling task. Progress and
+ *       completion are reported through the hooks registered with vidNVM_RegisterGcHooks.
+ *
+ * @pre enuNvm_Init must be called before running the garbage collection scheduler.
+ *
+ * @return Mid_tenuStatus Middleware_Success if a garbage collection run was started,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_CollectGarbage(void);
+
+/**
+ * @brief enuNVM_ReapExpiredKeys Runs one step of NVM_Service's expiry reaper.
+ *
+ * @note Expired keys are otherwise only deleted when their holder next tries to use them, which
+ *       may never happen. The reaper goes through the expirable keys file and deletes records
+ *       whose one-time key was used, whose count limit was reached or whose time-restricted key
+ *       outlived its life span.
+ *
+ * @note This function is meant to be invoked from idle housekeeping while no connection is active.
+ *       Each call checks at most MID_NVM_REAP_BATCH records and queues their deletions. A pass
+ *       through flash storage is started every MID_NVM_REAP_PERIOD_MS at most and starts over
+ *       whenever garbage collection moves records around.
+ *
+ * @pre enuNvm_Init must be called before running the expiry reaper.
+ *
+ * @param u32Now Current time as a Unix epoch, carried forward from the last Current Time Service
+ *        reading. 0 if unknown, in which case time-restricted keys are left alone.
+ *
+ * @return Mid_tenuStatus Middleware_Success if a batch of records was checked,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_ReapExpiredKeys(uint32_t u32Now);
+
+/**
+ * @brief enuNVM_CompactCounters Runs one step of usage counter compaction.
+ *
+ * @note Exhausted usage counter slots are folded back into their owner's record, one record
+ *       update at a time. Once no slot is left free, every live slot is folded and the counter
+ *       pages are erased. Uses are rewritten into records meanwhile.
+ *
+ * @note This function is meant to be invoked from idle housekeeping. Folds only start while no
+ *       other flash operation is pending. A reset between a record update and its slot being marked
+ *       folded counts the slot's uses twice, never less than once.
+ *
+ * @pre enuNvm_Init must be called before compacting usage counters.
+ *
+ * @return Mid_tenuStatus Middleware_Success if a slot fold or the counter pages' erase was
+ *         started, Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_CompactCounters(void);
+
+/**
+ * @brief vidNVM_RegisterGcHooks Registers garbage collection progress and completion hooks.
+ *
+ * @note Hooks are invoked from the context that started the run and from vidNvmEventHandler
+ *       respectively. Either may be NULL.
+ *
+ * @param pfProgress Pointer to garbage collection progress hook.
+ * @param pfComplete Pointer to garbage collection completion hook.
+ *
+ * @return Nothing.
+ */
+void vidNVM_RegisterGcHooks(Nvm_tpfGcProgress pfProgress, Nvm_tpfGcComplete pfComplete);
+
+/**
+ * @brief enuNVM_GetBootStats Gets figures on how the user index was made ready at boot.
+ *
+ * @param pstrStats Pointer to the statistics structure to fill.
+ *
+ * @return Mid_tenuStatus Middleware_Success if the index is ready and statistics were filled,
+ *         Middleware_Failure otherwise.
+ */
+Mid_tenuStatus enuNVM_GetBootStats(Nvm_tstrBootStats *pstrStats);
+
 #endif /* _MID_NVM_H_ */
\ No newline at end of file
@@ -14,6 +14,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+/******************************************   MACROS   *******************************************/
+/* Place a variable in RAM startup code leaves alone. Its content survives System OFF as long as
+   the RAM sections holding it are retained, see vidBleRetainRam */
+#if defined(__ICCARM__)
+#define MID_RETAINED __no_init
+#else
+#define MID_RETAINED __attribute__((section(".noinit")))
+#endif
+
 /******************************************   TYPES   ********************************************/
 /**
  * Mid_tenuStatus Enumeration of the different possible middleware operation outcomes.
@@ -0,0 +1,373 @@
+/* ----------------------------   AppMgr benchmark for Linux   ---------------------------------- */
+/*  File      -  Application Manager event dispatch benchmark source file                        */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: This benchmark dispatches every event a number of times (-n) through
+   AppMgr_enuDispatchEvent, which looks events up in the routing table, and through a copy of the
+   dispatcher it replaced, which went through the pub/sub scheme list until it found the event and
+   computed its event group bit with s32Power. Applications are stood in for by notification
+   functions recording the bits they're posted. Both dispatchers must notify the same applications
+   with the same bits. Results are printed as CSV (default) or JSON (-f json), one line per event.
+
+   Built with tracing (see below), the trace ring holds the latest dispatches once done and is
+   dumped to a file with -t, to be read by Trace_Decoder.
+
+   Build from the repository root (INC being the IAR project's include directories as -I options):
+
+   gcc -std=gnu99 -O2 -no-pie -DNRF52832_XXAA -DNRF52 -DNRF_LOG_ENABLED=0                        \
+       -DSVCALL_AS_NORMAL_FUNCTION -IProject/Host $INC -IKernel/FreeRTOS/portable/GCC/nrf52      \
+       Project/Host/AppMgr_Benchmark.c Application/AppMgr.c Utilities/Math/Maths.c               \
+       Utilities/Trace/Trace.c Middleware/Libraries/util/app_util_platform.c -o appmgr_benchmark
+
+   adding -DUTIL_TRACE_ENABLED=1 -DUTIL_TRACE_HOST_CLOCK=1 -DNRF_ATOMIC_USE_BUILD_IN=1 and
+   Middleware/Libraries/atomic/nrf_atomic.c to trace dispatches. */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "AppMgr.h"
+#include "Trace.h"
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define BENCH_POWER_BASE         2U
+#define BENCH_DEFAULT_DISPATCHES 1000000U
+#define BENCH_MAX_DISPATCHES     100000000U
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Compute average of a total over a number of operations, 0 when there were none */
+#define BENCH_AVERAGE(total, count) ((count)?((double)(total) / (double)(count)):0.0)
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Bench_tenuFormat Enumeration of the different output formats.
+*/
+typedef enum
+{
+    Bench_Csv = 0, /* One comma separated line per event */
+    Bench_Json     /* Array of one object per event      */
+}Bench_tenuFormat;
+
+/**
+ * Bench_tstrEventSub Pub/sub scheme list entry, as laid out before events were routed through a
+ *                    table.
+*/
+typedef struct
+{
+    AppMgr_tenuEvents enuPublishedEvent;                   /* Dispatched event                  */
+    AppMgr_tenuAppId enuSubscribedApps[APPLICATION_COUNT]; /* List of subscribed applications   */
+    uint8_t u8SubCnt;                                      /* Number of subscribed applications */
+}Bench_tstrEventSub;
+
+/**
+ * Bench_tstrNotified Notifications received by the stand-in applications.
+*/
+typedef struct
+{
+    uint32_t u32Count[APPLICATION_COUNT]; /* Number of notifications per application */
+    uint32_t u32Bits[APPLICATION_COUNT];  /* Bits posted to each application, or'ed  */
+}Bench_tstrNotified;
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Notifications received since the last reset */
+static Bench_tstrNotified strNotified;
+
+/* Pub/sub scheme list the former dispatcher went through */
+static const Bench_tstrEventSub strEventSubscriptionList[] =
+{
+    {AppMgr_DisplayAdvertising   , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayConnected     , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayDisconnected  , {App_DisplayId, App_RegistrationId, App_AttributionId}, 3},
+    {AppMgr_DisplayValidInput    , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayInvalidInput  , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayAccessGranted , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayAccessDenied  , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayAdminAdd      , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayAdminCheck    , {App_DisplayId                                       }, 1},
+    {AppMgr_DisplayNotifsDisabled, {App_DisplayId                                       }, 1},
+    {AppMgr_RegNotifEnabled      , {App_RegistrationId                                  }, 1},
+    {AppMgr_RegNotifDisabled     , {App_RegistrationId                                  }, 1},
+    {AppMgr_RegUsrInputRx        , {App_RegistrationId                                  }, 1},
+    {AppMgr_AdmNotifEnabled      , {App_RegistrationId                                  }, 1},
+    {AppMgr_AdmNotifDisabled     , {App_RegistrationId                                  }, 1},
+    {AppMgr_AdmUsrInputRx        , {App_RegistrationId                                  }, 1},
+    {AppMgr_AdmUsrAddedToNvm     , {App_RegistrationId                                  }, 1},
+    {AppMgr_RegPasswordUpdated   , {App_RegistrationId                                  }, 1},
+    {AppMgr_AttNotifEnabled      , {App_AttributionId                                   }, 1},
+    {AppMgr_AttNotifDisabled     , {App_AttributionId                                   }, 1},
+    {AppMgr_AttUserSignedIn      , {App_AttributionId                                   }, 1},
+    {AppMgr_AttInputRx           , {App_AttributionId                                   }, 1},
+    {AppMgr_AdmExportRequest     , {App_RegistrationId                                  }, 1},
+    {AppMgr_AdmProvisionRequest  , {App_RegistrationId                                  }, 1},
+    {AppMgr_NvmHousekeeping      , {App_RegistrationId                                  }, 1}
+};
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static App_tenuStatus enuNotify(AppMgr_tenuAppId enuApp, uint32_t u32Event)
+{
+    strNotified.u32Count[enuApp]++;
+    strNotified.u32Bits[enuApp] |= u32Event;
+
+    return Application_Success;
+}
+
+/* Notification functions of the stand-in applications, in application Id order */
+static App_tenuStatus enuAttributionNotified(uint32_t u32Event, void *pvData)
+{
+    return enuNotify(App_AttributionId, u32Event);
+}
+
+static App_tenuStatus enuRegistrationNotified(uint32_t u32Event, void *pvData)
+{
+    return enuNotify(App_RegistrationId, u32Event);
+}
+
+static App_tenuStatus enuDisplayNotified(uint32_t u32Event, void *pvData)
+{
+    return enuNotify(App_DisplayId, u32Event);
+}
+
+static const AppMgrGetNotified pfNotifList[APPLICATION_COUNT] =
+{
+    enuAttributionNotified,
+    enuRegistrationNotified,
+    enuDisplayNotified
+};
+
+static App_tenuStatus enuScanDispatchEvent(uint32_t u32Event, void *pvData)
+{
+    App_tenuStatus enuRetVal = Application_Failure;
+
+    /* Former dispatcher, as it was */
+    if((u32Event > AppMgr_LowerBoundEvt) && (u32Event < AppMgr_UpperBoundEvt))
+    {
+        for(const Bench_tstrEventSub *pstrEvent = strEventSubscriptionList;
+            pstrEvent < strEventSubscriptionList + (sizeof(strEventSubscriptionList) / sizeof(Bench_tstrEventSub));
+            pstrEvent++)
+        {
+            if(u32Event == (uint32_t)pstrEvent->enuPublishedEvent)
+            {
+                enuRetVal = Application_Success;
+
+                for(uint8_t u8Index = 0; u8Index < pstrEvent->u8SubCnt; u8Index++)
+                {
+                    if(pfNotifList[pstrEvent->enuSubscribedApps[u8Index]])
+                    {
+                        pfNotifList[pstrEvent->enuSubscribedApps[u8Index]]((uint32_t)s32Power(BENCH_POWER_BASE,
+                                                                                              u32Event-1),
+                                                                           pvData);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return enuRetVal;
+}
+
+static uint64_t u64NowNs(void)
+{
+    struct timespec strNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+
+    return ((uint64_t)strNow.tv_sec * 1000000000ULL) + (uint64_t)strNow.tv_nsec;
+}
+
+static uint64_t u64TimeDispatches(App_tenuStatus (*pfDispatch)(uint32_t, void *), uint32_t u32Event,
+                                  uint32_t u32Dispatches, Bench_tstrNotified *pstrNotified)
+{
+    uint64_t u64Start;
+    uint64_t u64RetVal;
+
+    memset(&strNotified, 0, sizeof(strNotified));
+
+    u64Start = u64NowNs();
+    for(uint32_t u32Dispatch = 0; u32Dispatch < u32Dispatches; u32Dispatch++)
+    {
+        (void)pfDispatch(u32Event, NULL);
+    }
+    u64RetVal = u64NowNs() - u64Start;
+
+    memcpy(pstrNotified, &strNotified, sizeof(Bench_tstrNotified));
+
+    return u64RetVal;
+}
+
+static void vidRunEvent(uint32_t u32Event, uint32_t u32Dispatches, Bench_tenuFormat enuFormat)
+{
+    Bench_tstrNotified strScanNotified;
+    Bench_tstrNotified strTableNotified;
+    uint64_t u64ScanNs = u64TimeDispatches(enuScanDispatchEvent, u32Event, u32Dispatches, &strScanNotified);
+    uint64_t u64TableNs = u64TimeDispatches(AppMgr_enuDispatchEvent, u32Event, u32Dispatches, &strTableNotified);
+    uint8_t u8Subscribers = 0;
+    char const *pcFormat = (Bench_Csv == enuFormat)
+        ?"%u,%s,%u,%u,%.2f,%.2f\n"
+        :"  {\"event\": %u, \"status\": \"%s\", \"subscribers\": %u, \"dispatches\": %u, "
+         "\"scan_ns\": %.2f, \"table_ns\": %.2f}";
+
+    for(uint8_t u8Index = 0; u8Index < APPLICATION_COUNT; u8Index++)
+    {
+        u8Subscribers += strTableNotified.u32Count[u8Index]?1:0;
+    }
+
+    printf(pcFormat,
+           (unsigned)u32Event,
+           memcmp(&strScanNotified, &strTableNotified, sizeof(Bench_tstrNotified))?"mismatch":"ok",
+           (unsigned)u8Subscribers,
+           (unsigned)u32Dispatches,
+           BENCH_AVERAGE(u64ScanNs, u32Dispatches),
+           BENCH_AVERAGE(u64TableNs, u32Dispatches));
+}
+
+static bool bDumpTrace(char const *pcPath)
+{
+    bool bRetVal = false;
+    Trace_tstrRing const *pstrRing = pstrTraceGetRing();
+    FILE *pFile = pstrRing?fopen(pcPath, "wb"):NULL;
+
+    /* Dump ring as is, the way the debugger does on target */
+    if(pFile)
+    {
+        bRetVal = (1 == fwrite(pstrRing, sizeof(Trace_tstrRing), 1, pFile));
+        bRetVal &= (0 == fclose(pFile));
+    }
+
+    return bRetVal;
+}
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+/* Applications AppMgr.c dispatches to are the stand-ins */
+App_tenuStatus enuAttribution_Init(void)
+{
+    return Application_Success;
+}
+
+App_tenuStatus enuAttribution_GetNotified(uint32_t u32Event, void *pvData)
+{
+    return enuAttributionNotified(u32Event, pvData);
+}
+
+App_tenuStatus enuRegistration_Init(void)
+{
+    return Application_Success;
+}
+
+App_tenuStatus enuRegistration_GetNotified(uint32_t u32Event, void *pvData)
+{
+    return enuRegistrationNotified(u32Event, pvData);
+}
+
+App_tenuStatus enuDisplay_Init(void)
+{
+    return Application_Success;
+}
+
+App_tenuStatus enuDisplay_GetNotified(uint32_t u32Event, void *pvData)
+{
+    return enuDisplayNotified(u32Event, pvData);
+}
+
+/* Kernel calls AppMgr.c makes to run applications are stand-ins as well, only dispatching is
+   benchmarked */
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+                       const configSTACK_DEPTH_TYPE usStackDepth, void * const pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask)
+{
+    return pdPASS;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction,
+                              uint32_t *pulPreviousNotificationValue)
+{
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    return 0;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int iRetVal = EXIT_SUCCESS;
+    int iOption;
+    Bench_tenuFormat enuFormat = Bench_Csv;
+    uint32_t u32Dispatches = BENCH_DEFAULT_DISPATCHES;
+    char *pcEnd = NULL;
+    char const *pcTracePath = NULL;
+
+    vidTraceInit();
+
+    while((EXIT_SUCCESS == iRetVal) && (-1 != (iOption = getopt(argc, argv, "n:f:t:"))))
+    {
+        switch(iOption)
+        {
+        case 'n':
+            u32Dispatches = (uint32_t)strtoul(optarg, &pcEnd, 10);
+            iRetVal = ((*pcEnd == '\0') && u32Dispatches && (u32Dispatches <= BENCH_MAX_DISPATCHES))
+                      ?EXIT_SUCCESS
+                      :EXIT_FAILURE;
+            break;
+
+        case 'f':
+            enuFormat = (0 == strcmp(optarg, "json"))?Bench_Json:Bench_Csv;
+            iRetVal = ((Bench_Json == enuFormat) || (0 == strcmp(optarg, "csv")))?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        case 't':
+            pcTracePath = optarg;
+            break;
+
+        default:
+            iRetVal = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if((EXIT_SUCCESS != iRetVal) || (Application_Success != AppMgr_enuInit()))
+    {
+        fprintf(stderr, "usage: %s [-n dispatches] [-f csv|json] [-t trace_dump]\n", argv[0]);
+        iRetVal = EXIT_FAILURE;
+    }
+    else
+    {
+        printf((Bench_Csv == enuFormat)?"event,status,subscribers,dispatches,scan_ns,table_ns\n":"[\n");
+
+        for(uint32_t u32Event = AppMgr_LowerBoundEvt + 1; u32Event < AppMgr_UpperBoundEvt; u32Event++)
+        {
+            if((Bench_Json == enuFormat) && (u32Event > (AppMgr_LowerBoundEvt + 1)))
+            {
+                printf(",\n");
+            }
+            vidRunEvent(u32Event, u32Dispatches, enuFormat);
+        }
+
+        if(Bench_Json == enuFormat)
+        {
+            printf("\n]\n");
+        }
+
+        if(pcTracePath && !bDumpTrace(pcTracePath))
+        {
+            fprintf(stderr, "%s: trace not dumped, tracing may not be built in\n", pcTracePath);
+            iRetVal = EXIT_FAILURE;
+        }
+    }
+
+    return iRetVal;
+}
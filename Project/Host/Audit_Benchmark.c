@@ -0,0 +1,441 @@
+/* -----------------------------   Audit benchmark for Linux   --------------------------------- */
+/*  File      -  Audit_Service time query benchmark source file                                  */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: This benchmark fills an audit journal with synthetic access attempts, one every few
+   seconds (-s), then looks up random time ranges (-w seconds long, -q of them) in it. Each range
+   is looked up twice: through the per-page time summaries, the way the mkal admin command does
+   it, and by reading the whole journal and filtering entries, the way it would be done without
+   them. Both must return the same entries. The time it takes to recover the journal at boot,
+   summaries included, is reported as well.
+
+   Each scenario runs in a child process on a freshly erased image, Audit_Service state being
+   static. Scenarios cover every journal size (-n), given as a comma separated list of appended
+   entries. Journals wrap around once full, so sizes past the journal's capacity only move it
+   along. Results are printed as CSV (default) or JSON (-f json).
+
+   The journal page count is a build setting. Build once per page count to compare them, e.g.
+   from the repository root (INC being the IAR project's include directories as -I options):
+
+   gcc -std=gnu99 -O2 -no-pie -DNRF52832_XXAA -DNRF52 -DFDS_BACKEND=3 -DMID_AUDIT_PAGES=64      \
+       -DNRF_ATOMIC_USE_BUILD_IN=1 -DNRF_LOG_ENABLED=0 -DSVCALL_AS_NORMAL_FUNCTION               \
+       -IProject/Host $INC -IKernel/FreeRTOS/portable/GCC/nrf52                                  \
+       Project/Host/Audit_Benchmark.c Project/Host/Host_Stubs.c                                  \
+       Middleware/Services/Audit_Service/Audit_Service.c Utilities/Math/Maths.c                  \
+       Middleware/Libraries/fstorage/nrf_fstorage.c Middleware/Libraries/fstorage/nrf_fstorage_host.c \
+       Middleware/Libraries/atomic/nrf_atomic.c Middleware/Libraries/util/app_util_platform.c    \
+       -Wl,-T,Project/Host/host_sections.ld -o audit_benchmark
+
+   A journal page holds 256 entries, so the default 8 pages keep the last 1792 to 2048 access
+   attempts and 64 pages the last 16128 to 16384. */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Audit_Service.h"
+#include "sdk_config.h"
+#include "nrf_fstorage_host.h"
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define BENCH_FLASH_END_ADDR     0x00080000
+#define BENCH_PAGE_SIZE          4096U
+#define BENCH_IMAGE_SIZE         (((FDS_VIRTUAL_PAGES + FDS_VIRTUAL_PAGES_RESERVED) * FDS_VIRTUAL_PAGE_SIZE * sizeof(uint32_t)) + \
+                                  ((MID_NVM_COUNTER_PAGES + MID_AUDIT_PAGES) * BENCH_PAGE_SIZE))
+#define BENCH_FIRST_EPOCH        1790000000U
+#define BENCH_FIRST_USER_ID      10000000U
+#define BENCH_USER_ID_STRIDE     7919U
+#define BENCH_READ_CHUNK         32U
+#define BENCH_MAX_ENTRIES        1000000U
+#define BENCH_MAX_LIST_ENTRIES   16U
+#define BENCH_DEFAULT_ENTRIES    "100,500,1000,2000,5000,20000"
+#define BENCH_DEFAULT_SPACING    60U
+#define BENCH_DEFAULT_WINDOW     3600U
+#define BENCH_DEFAULT_QUERIES    200U
+#define BENCH_IMAGE_TEMPLATE     "/tmp/audit_benchmark_XXXXXX"
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Compute average of a total over a number of operations, 0 when there were none */
+#define BENCH_AVERAGE(total, count) ((count)?((double)(total) / (double)(count)):0.0)
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Bench_tenuFormat Enumeration of the different output formats.
+*/
+typedef enum
+{
+    Bench_Csv = 0, /* One comma separated line per scenario */
+    Bench_Json     /* Array of one object per scenario      */
+}Bench_tenuFormat;
+
+/**
+ * Bench_tstrSettings Benchmark settings shared by all scenarios.
+*/
+typedef struct
+{
+    uint32_t u32Spacing; /* Seconds between two appended entries */
+    uint32_t u32Window;  /* Length of the looked up time ranges  */
+    uint32_t u32Queries; /* Number of time ranges looked up      */
+}Bench_tstrSettings;
+
+/**
+ * Bench_tstrPhase Measurements of a benchmark phase.
+*/
+typedef struct
+{
+    uint32_t u32Count;       /* Number of operations performed */
+    uint64_t u64Nanoseconds; /* Total host latency             */
+}Bench_tstrPhase;
+
+/**
+ * Bench_tstrResult Benchmark scenario results.
+*/
+typedef struct
+{
+    char const *pcStatus;       /* Outcome of the scenario                     */
+    uint32_t u32Journal;        /* Entries left in the journal                 */
+    uint64_t u64Matches;        /* Entries matched over all time ranges        */
+    Bench_tstrPhase strAppend;  /* enuAudit_Append                             */
+    Bench_tstrPhase strRecover; /* enuAudit_Init on the filled journal         */
+    Bench_tstrPhase strIndexed; /* Time range looked up through page summaries */
+    Bench_tstrPhase strCount;   /* u32Audit_CountBetween                       */
+    Bench_tstrPhase strScan;    /* Time range looked up by reading everything  */
+}Bench_tstrResult;
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Scenario parameter list */
+static uint32_t u32EntryCounts[BENCH_MAX_LIST_ENTRIES];
+static uint8_t u8EntryCountsLen = 0;
+
+/* Entries read back by lookups */
+static Audit_tstrEntry strChunk[BENCH_READ_CHUNK];
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static uint64_t u64NowNs(void)
+{
+    struct timespec strNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+
+    return ((uint64_t)strNow.tv_sec * 1000000000ULL) + (uint64_t)strNow.tv_nsec;
+}
+
+static void vidPhaseStop(Bench_tstrPhase *pstrPhase, uint64_t u64Start)
+{
+    pstrPhase->u32Count++;
+    pstrPhase->u64Nanoseconds += u64NowNs() - u64Start;
+}
+
+static void vidFillJournal(uint32_t u32Entries, Bench_tstrSettings const *pstrSettings, Bench_tstrResult *pstrResult)
+{
+    for(uint32_t u32Entry = 0; u32Entry < u32Entries; u32Entry++)
+    {
+        char cId[AUDIT_ENTRY_SIZE];
+        uint64_t u64Start;
+
+        (void)snprintf(cId, sizeof(cId), "%08u",
+                       (unsigned)((BENCH_FIRST_USER_ID + ((u32Entry % 500) * BENCH_USER_ID_STRIDE)) % 100000000U));
+
+        /* Time is set before every entry so that timestamps don't depend on host speed */
+        vidAudit_SetTime(BENCH_FIRST_EPOCH + (u32Entry * pstrSettings->u32Spacing));
+
+        u64Start = u64NowNs();
+        if(Middleware_Success != enuAudit_Append((uint8_t const *)cId, App_UnlimitedKey,
+                                                 (Audit_tenuOutcome)(u32Entry % Audit_MaxOutcomes)))
+        {
+            pstrResult->pcStatus = "append";
+            break;
+        }
+        vidPhaseStop(&pstrResult->strAppend, u64Start);
+    }
+}
+
+static uint32_t u32QueryIndexed(uint32_t u32From, uint32_t u32To)
+{
+    uint32_t u32RetVal = 0;
+    uint32_t u32Sequence = u32Audit_FindSequence(u32From);
+    uint16_t u16Count;
+
+    while((u16Count = u16Audit_ReadBetween(&u32Sequence, u32From, u32To, strChunk, BENCH_READ_CHUNK)) > 0)
+    {
+        u32RetVal += u16Count;
+    }
+
+    return u32RetVal;
+}
+
+static uint32_t u32QueryScan(uint32_t u32From, uint32_t u32To)
+{
+    uint32_t u32RetVal = 0;
+    uint32_t u32Sequence = 0;
+    uint16_t u16Count;
+
+    while((u16Count = u16Audit_Read(&u32Sequence, strChunk, BENCH_READ_CHUNK)) > 0)
+    {
+        for(uint16_t u16Entry = 0; u16Entry < u16Count; u16Entry++)
+        {
+            u32RetVal += ((strChunk[u16Entry].u32Epoch >= u32From) && (strChunk[u16Entry].u32Epoch <= u32To));
+        }
+    }
+
+    return u32RetVal;
+}
+
+static void vidQueryJournal(uint32_t u32Entries, Bench_tstrSettings const *pstrSettings, Bench_tstrResult *pstrResult)
+{
+    uint32_t u32Oldest = u32Audit_GetOldestSequence();
+    uint32_t u32FirstEpoch = BENCH_FIRST_EPOCH + (u32Oldest * pstrSettings->u32Spacing);
+    uint32_t u32Span = (u32Entries - u32Oldest) * pstrSettings->u32Spacing;
+
+    /* Same ranges for every scenario, spread over whatever the journal still holds */
+    srand(1);
+
+    for(uint32_t u32Query = 0; u32Query < pstrSettings->u32Queries; u32Query++)
+    {
+        uint32_t u32From = u32FirstEpoch + (uint32_t)(((uint64_t)rand() * u32Span) / RAND_MAX);
+        uint32_t u32To = u32From + pstrSettings->u32Window - 1;
+        uint32_t u32Indexed;
+        uint32_t u32Counted;
+        uint32_t u32Scanned;
+        uint64_t u64Start;
+
+        u64Start = u64NowNs();
+        u32Indexed = u32QueryIndexed(u32From, u32To);
+        vidPhaseStop(&pstrResult->strIndexed, u64Start);
+
+        u64Start = u64NowNs();
+        u32Counted = u32Audit_CountBetween(u32From, u32To);
+        vidPhaseStop(&pstrResult->strCount, u64Start);
+
+        u64Start = u64NowNs();
+        u32Scanned = u32QueryScan(u32From, u32To);
+        vidPhaseStop(&pstrResult->strScan, u64Start);
+
+        if((u32Indexed != u32Scanned) || (u32Counted != u32Scanned))
+        {
+            pstrResult->pcStatus = "mismatch";
+        }
+        pstrResult->u64Matches += u32Scanned;
+    }
+}
+
+static void vidPrintResult(uint32_t u32Entries, Bench_tstrSettings const *pstrSettings, Bench_tstrResult const *pstrResult, Bench_tenuFormat enuFormat)
+{
+    char const *pcFormat = (Bench_Csv == enuFormat)
+        ?"%u,%u,%s,%u,%u,%.2f,%.1f,%u,%.1f,%.2f,%.2f,%.2f\n"
+        :"  {\"audit_pages\": %u, \"entries\": %u, \"status\": \"%s\", \"journal_entries\": %u, "
+         "\"queries\": %u, \"append_us\": %.2f, \"recover_us\": %.1f, \"window_s\": %u, "
+         "\"matches_avg\": %.1f, \"indexed_us\": %.2f, \"count_us\": %.2f, \"scan_us\": %.2f}";
+
+    printf(pcFormat,
+           (unsigned)MID_AUDIT_PAGES,
+           (unsigned)u32Entries,
+           pstrResult->pcStatus,
+           (unsigned)pstrResult->u32Journal,
+           (unsigned)pstrResult->strIndexed.u32Count,
+           BENCH_AVERAGE(pstrResult->strAppend.u64Nanoseconds / 1000.0, pstrResult->strAppend.u32Count),
+           pstrResult->strRecover.u64Nanoseconds / 1000.0,
+           (unsigned)pstrSettings->u32Window,
+           BENCH_AVERAGE(pstrResult->u64Matches, pstrResult->strScan.u32Count),
+           BENCH_AVERAGE(pstrResult->strIndexed.u64Nanoseconds / 1000.0, pstrResult->strIndexed.u32Count),
+           BENCH_AVERAGE(pstrResult->strCount.u64Nanoseconds / 1000.0, pstrResult->strCount.u32Count),
+           BENCH_AVERAGE(pstrResult->strScan.u64Nanoseconds / 1000.0, pstrResult->strScan.u32Count));
+}
+
+static void vidRunScenario(uint32_t u32Entries, Bench_tstrSettings const *pstrSettings, Bench_tenuFormat enuFormat)
+{
+    Bench_tstrResult strResult = {0};
+    char cImage[] = BENCH_IMAGE_TEMPLATE;
+    int iFd = mkstemp(cImage);
+
+    strResult.pcStatus = "ok";
+
+    /* Image ends at the end of the nRF52832's flash. It covers FDS's pages and the usage counter
+       pages, which the journal sits right below on target */
+    if(iFd < 0)
+    {
+        strResult.pcStatus = "image";
+    }
+    else if(NRF_SUCCESS != nrf_fstorage_host_image_open(cImage,
+                                                        BENCH_FLASH_END_ADDR - BENCH_IMAGE_SIZE,
+                                                        BENCH_IMAGE_SIZE))
+    {
+        strResult.pcStatus = "image";
+    }
+    else if(Middleware_Success != enuAudit_Init())
+    {
+        strResult.pcStatus = "init";
+    }
+    else
+    {
+        uint64_t u64Start;
+
+        vidFillJournal(u32Entries, pstrSettings, &strResult);
+
+        /* Recover the journal the way it's done at boot, summaries being rebuilt from flash */
+        u64Start = u64NowNs();
+        if(Middleware_Success == enuAudit_Init())
+        {
+            vidPhaseStop(&strResult.strRecover, u64Start);
+
+            strResult.u32Journal = u32Audit_GetNextSequence() - u32Audit_GetOldestSequence();
+            if(u32Audit_GetNextSequence() == u32Entries)
+            {
+                vidQueryJournal(u32Entries, pstrSettings, &strResult);
+            }
+            else
+            {
+                strResult.pcStatus = "lost";
+            }
+        }
+        else
+        {
+            strResult.pcStatus = "init";
+        }
+    }
+
+    vidPrintResult(u32Entries, pstrSettings, &strResult, enuFormat);
+
+    nrf_fstorage_host_image_close();
+    if(iFd >= 0)
+    {
+        (void)close(iFd);
+        (void)unlink(cImage);
+    }
+}
+
+static bool bParseList(char *pcList, uint32_t *pu32Values, uint8_t *pu8Len, uint32_t u32Max)
+{
+    bool bRetVal = true;
+    char *pcSavePtr = NULL;
+
+    *pu8Len = 0;
+    for(char *pcToken = strtok_r(pcList, ",", &pcSavePtr);
+        pcToken && bRetVal;
+        pcToken = strtok_r(NULL, ",", &pcSavePtr))
+    {
+        char *pcEnd = NULL;
+        unsigned long ulValue = strtoul(pcToken, &pcEnd, 10);
+
+        bRetVal = (*pcEnd == '\0') && (ulValue > 0) && (ulValue <= u32Max) && (*pu8Len < BENCH_MAX_LIST_ENTRIES);
+        if(bRetVal)
+        {
+            pu32Values[(*pu8Len)++] = (uint32_t)ulValue;
+        }
+    }
+
+    return bRetVal && *pu8Len;
+}
+
+static bool bParseValue(char const *pcValue, uint32_t *pu32Value)
+{
+    char *pcEnd = NULL;
+    unsigned long ulValue = strtoul(pcValue, &pcEnd, 10);
+
+    *pu32Value = (uint32_t)ulValue;
+
+    return (*pcEnd == '\0') && (ulValue > 0) && (ulValue <= UINT16_MAX);
+}
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+int main(int argc, char *argv[])
+{
+    int iRetVal = EXIT_SUCCESS;
+    int iOption;
+    Bench_tenuFormat enuFormat = Bench_Csv;
+    Bench_tstrSettings strSettings = {BENCH_DEFAULT_SPACING, BENCH_DEFAULT_WINDOW, BENCH_DEFAULT_QUERIES};
+    char cEntries[] = BENCH_DEFAULT_ENTRIES;
+    char *pcEntries = cEntries;
+
+    while((EXIT_SUCCESS == iRetVal) && (-1 != (iOption = getopt(argc, argv, "n:s:w:q:f:"))))
+    {
+        switch(iOption)
+        {
+        case 'n':
+            pcEntries = optarg;
+            break;
+
+        case 's':
+            iRetVal = bParseValue(optarg, &strSettings.u32Spacing)?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        case 'w':
+            iRetVal = bParseValue(optarg, &strSettings.u32Window)?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        case 'q':
+            iRetVal = bParseValue(optarg, &strSettings.u32Queries)?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        case 'f':
+            enuFormat = (0 == strcmp(optarg, "json"))?Bench_Json:Bench_Csv;
+            iRetVal = ((Bench_Json == enuFormat) || (0 == strcmp(optarg, "csv")))?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        default:
+            iRetVal = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if((EXIT_SUCCESS != iRetVal) ||
+       !bParseList(pcEntries, u32EntryCounts, &u8EntryCountsLen, BENCH_MAX_ENTRIES))
+    {
+        fprintf(stderr, "usage: %s [-n entries,...] [-s spacing_s] [-w window_s] [-q queries] [-f csv|json]\n", argv[0]);
+        iRetVal = EXIT_FAILURE;
+    }
+    else
+    {
+        printf((Bench_Csv == enuFormat)
+               ?"audit_pages,entries,status,journal_entries,queries,append_us,recover_us,window_s,"
+                "matches_avg,indexed_us,count_us,scan_us\n"
+               :"[\n");
+
+        for(uint8_t u8Entries = 0; u8Entries < u8EntryCountsLen; u8Entries++)
+        {
+            pid_t xChild;
+            int iStatus = 0;
+
+            if((Bench_Json == enuFormat) && u8Entries)
+            {
+                printf(",\n");
+            }
+
+            /* Pending output would otherwise be printed by both processes */
+            (void)fflush(stdout);
+
+            xChild = fork();
+            if(0 == xChild)
+            {
+                vidRunScenario(u32EntryCounts[u8Entries], &strSettings, enuFormat);
+                (void)fflush(stdout);
+                _exit(EXIT_SUCCESS);
+            }
+            else if((xChild < 0) ||
+                    (waitpid(xChild, &iStatus, 0) != xChild) ||
+                    !WIFEXITED(iStatus))
+            {
+                /* Report scenario anyway so results keep lining up */
+                Bench_tstrResult strResult = {0};
+
+                strResult.pcStatus = "crashed";
+                vidPrintResult(u32EntryCounts[u8Entries], &strSettings, &strResult, enuFormat);
+                iRetVal = EXIT_FAILURE;
+            }
+        }
+
+        if(Bench_Json == enuFormat)
+        {
+            printf("\n]\n");
+        }
+    }
+
+    return iRetVal;
+}
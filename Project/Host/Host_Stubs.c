@@ -0,0 +1,47 @@
+/* ---------------------------------   Host stubs for Linux   ---------------------------------- */
+/*  File      -  Firmware symbol stand-ins for host builds source file                           */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: Host tools link NVM_Service against FDS and the nrf_fstorage_host backend, without the
+   kernel, the Softdevice nor the other services and applications. This file provides the few
+   symbols NVM_Service expects from them. */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "BLE_Service.h"
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec strNow;
+
+    /* Derive kernel ticks from the host's monotonic clock */
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+
+    return (TickType_t)(((uint64_t)strNow.tv_sec * configTICK_RATE_HZ) +
+                        (((uint64_t)strNow.tv_nsec * configTICK_RATE_HZ) / 1000000000ULL));
+}
+
+void vidFlashStorageIdleCallback(void)
+{
+    /* No sleep to enter on the host */
+}
+
+bool bBleWokenFromSystemOff(void)
+{
+    /* Host processes have no reset reason. Retained RAM is whatever the tool put there */
+    return true;
+}
+
+void vidBleRetainRam(void const *pvAddr, uint32_t u32Size)
+{
+    /* Host RAM needs no retention */
+    (void)pvAddr;
+    (void)u32Size;
+}
@@ -0,0 +1,686 @@
+/* ------------------------------   NVM benchmark for Linux   ---------------------------------- */
+/*  File      -  NVM_Service storage benchmark source file                                       */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: This benchmark fills a flash image with synthetic users through NVM_Service, dirties it
+   with record updates, then measures user lookups, record reads and garbage collection. Every
+   phase reports its host latency per operation along with the flash operations it took, which
+   unlike host latency carry over to the device.
+
+   Each scenario runs in a child process on a freshly erased image, FDS and NVM_Service state
+   being static. Scenarios cover every combination of the user counts (-u), shares of expirable
+   users in percent (-e) and target dirty ratios in percent of data pages (-d) given as comma
+   separated lists. Results are printed as CSV (default) or JSON (-f json).
+
+   The FDS page count is a build setting. Build once per page count to compare them, e.g. from
+   the repository root (INC being the IAR project's include directories as -I options):
+
+   gcc -std=gnu99 -O2 -no-pie -DNRF52832_XXAA -DNRF52 -DFDS_BACKEND=3 -DFDS_VIRTUAL_PAGES=48    \
+       -DNRF_ATOMIC_USE_BUILD_IN=1 -DNRF_LOG_ENABLED=0 -DSVCALL_AS_NORMAL_FUNCTION               \
+       -IProject/Host $INC -IKernel/FreeRTOS/portable/GCC/nrf52                                  \
+       Project/Host/NVM_Benchmark.c Project/Host/Host_Stubs.c                                    \
+       Middleware/Services/NVM_Service/NVM_Service.c Utilities/Time/Time.c Utilities/Math/Maths.c \
+       Middleware/Libraries/fds/fds.c Middleware/Libraries/fstorage/nrf_fstorage.c               \
+       Middleware/Libraries/fstorage/nrf_fstorage_host.c Middleware/Libraries/atomic/nrf_atomic.c \
+       Middleware/Libraries/atomic_fifo/nrf_atfifo.c Middleware/Libraries/util/app_util_platform.c \
+       -Wl,-T,Project/Host/host_sections.ld -o nvm_benchmark
+
+   Unknown users are split between those NVM_Service's Bloom filter turns down and its false
+   positives, which go on to the index and, should it ever overflow, to flash storage. The
+   difference between both lookup times is what the filter saves on each unknown user it turns
+   down. Its size can be changed through -DMID_NVM_BLOOM_BITS.
+
+   Lookup time of registered users should stay flat however many are registered. Scenarios whose
+   last registered users take more than BENCH_FLAT_LOOKUP_RATIO times as long to look up as their
+   first ones, which users left out of an overflowed index would, report a "slow" status.
+
+   Count-restricted keys are then used BENCH_USES_PER_KEY times each, usage counter compaction
+   running after every use as it would from idle housekeeping. Words written per use include slot
+   folds and counter page erases, against the 10 words a record rewrite would take. Keys whose
+   use count doesn't read back right report a "miscount" status.
+
+   Users are then provisioned again, under Ids of their own, through transactions of
+   MID_NVM_BATCH_SIZE users, as ble_adm's Provision characteristic would. Provisioning rates of
+   both the one-by-one and batched paths are reported in users per second, the batched one intent
+   record included. Batches stop at the first one that doesn't fit in what's left of flash
+   storage.
+
+   Each user takes 10 words of flash (record header included), so 2000 users and their updates
+   need about 48 pages while the default 3 pages hold about 200. Scenarios that run out of flash
+   storage report a "full" status along with the figures gathered until then. */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "NVM_Service.h"
+#include "nrf_fstorage_host.h"
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define BENCH_FLASH_END_ADDR     0x00080000
+#define BENCH_PAGE_SIZE          4096U
+#define BENCH_IMAGE_SIZE         (((FDS_VIRTUAL_PAGES + FDS_VIRTUAL_PAGES_RESERVED) * FDS_VIRTUAL_PAGE_SIZE * sizeof(uint32_t)) + \
+                                  (MID_NVM_COUNTER_PAGES * BENCH_PAGE_SIZE))
+#define BENCH_DATA_WORDS         ((FDS_VIRTUAL_PAGES - 1) * FDS_VIRTUAL_PAGE_SIZE)
+#define BENCH_FIRST_USER_ID      10000000U
+#define BENCH_USER_ID_STRIDE     7919U
+#define BENCH_BATCH_ID_OFFSET    1U
+#define BENCH_MISSING_USER_ID    99999999U
+#define BENCH_MAX_USERS          10000U
+#define BENCH_USES_PER_KEY       60U
+#define BENCH_MAX_LIST_ENTRIES   16U
+#define BENCH_DEFAULT_USERS      "10,100,500,1000,2000"
+#define BENCH_DEFAULT_EXPIRABLE  "0,50,100"
+#define BENCH_DEFAULT_DIRTY      "0,25,50"
+#define BENCH_IMAGE_TEMPLATE     "/tmp/nvm_benchmark_XXXXXX"
+#define BENCH_FLAT_LOOKUP_RATIO  4U
+#define BENCH_FLAT_LOOKUP_USERS  32U
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Compute average of a total over a number of operations, 0 when there were none */
+#define BENCH_AVERAGE(total, count) ((count)?((double)(total) / (double)(count)):0.0)
+
+/* Compute a phase's operation rate in operations per second */
+#define BENCH_RATE(phase) BENCH_AVERAGE((phase).u32Count * 1000000000.0, (phase).u64Nanoseconds)
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Bench_tenuFormat Enumeration of the different output formats.
+*/
+typedef enum
+{
+    Bench_Csv = 0, /* One comma separated line per scenario */
+    Bench_Json     /* Array of one object per scenario      */
+}Bench_tenuFormat;
+
+/**
+ * Bench_tstrScenario Benchmark scenario defining structure.
+*/
+typedef struct
+{
+    uint16_t u16Users;      /* Number of users to register                   */
+    uint8_t u8ExpirablePct; /* Share of users holding expirable keys         */
+    uint8_t u8DirtyPct;     /* Share of data pages to dirty before collecting */
+}Bench_tstrScenario;
+
+/**
+ * Bench_tstrPhase Measurements of a benchmark phase.
+*/
+typedef struct
+{
+    uint32_t u32Count;                   /* Number of operations performed */
+    uint64_t u64Nanoseconds;             /* Total host latency             */
+    nrf_fstorage_host_stats_t strFlash;  /* Flash operations performed     */
+}Bench_tstrPhase;
+
+/**
+ * Bench_tstrResult Benchmark scenario results.
+*/
+typedef struct
+{
+    char const *pcStatus;      /* Outcome of the scenario                       */
+    Bench_tstrPhase strAdd;    /* enuNVM_AddNewRecord                           */
+    Bench_tstrPhase strBatch;  /* enuNVM_CommitTransaction, counted per user    */
+    Bench_tstrPhase strUpdate; /* enuNVM_UpdateRecord                           */
+    Bench_tstrPhase strFind;   /* enuNVM_FindUser on registered users           */
+    Bench_tstrPhase strFirst;  /* enuNVM_FindUser on the first quarter of those */
+    Bench_tstrPhase strLast;   /* enuNVM_FindUser on the last quarter of those  */
+    Bench_tstrPhase strReject; /* enuNVM_FindUser on unknown users filtered out */
+    Bench_tstrPhase strPass;   /* enuNVM_FindUser on unknown users let through  */
+    Bench_tstrPhase strRead;   /* enuNVM_ReadRecord                             */
+    Bench_tstrPhase strUse;    /* enuNVM_CountUse, counter compaction included  */
+    Bench_tstrPhase strGc;     /* fds_gc                                        */
+    uint8_t u8DirtyPct;        /* Share of data pages reclaimable before fds_gc */
+    uint32_t u32Overwrites;    /* Words programmed again before being erased    */
+}Bench_tstrResult;
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Scenario parameter lists */
+static uint16_t u16UserCounts[BENCH_MAX_LIST_ENTRIES];
+static uint16_t u16ExpirablePcts[BENCH_MAX_LIST_ENTRIES];
+static uint16_t u16DirtyPcts[BENCH_MAX_LIST_ENTRIES];
+static uint8_t u8UserCountsLen = 0;
+static uint8_t u8ExpirablePctsLen = 0;
+static uint8_t u8DirtyPctsLen = 0;
+
+/* Record descriptors of registered users */
+static fds_record_desc_t strUserDesc[BENCH_MAX_USERS];
+
+/* Outcome of the last provisioning transaction */
+static Mid_tenuStatus enuBatchResult = Middleware_Failure;
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static uint64_t u64NowNs(void)
+{
+    struct timespec strNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+
+    return ((uint64_t)strNow.tv_sec * 1000000000ULL) + (uint64_t)strNow.tv_nsec;
+}
+
+static void vidPhaseStart(nrf_fstorage_host_stats_t *pstrBefore, uint64_t *pu64Start)
+{
+    nrf_fstorage_host_stats_get(pstrBefore);
+    *pu64Start = u64NowNs();
+}
+
+static void vidPhaseStop(Bench_tstrPhase *pstrPhase, nrf_fstorage_host_stats_t const *pstrBefore, uint64_t u64Start)
+{
+    uint64_t u64Stop = u64NowNs();
+    nrf_fstorage_host_stats_t strAfter;
+
+    nrf_fstorage_host_stats_get(&strAfter);
+
+    pstrPhase->u32Count++;
+    pstrPhase->u64Nanoseconds += u64Stop - u64Start;
+    pstrPhase->strFlash.words_written += strAfter.words_written - pstrBefore->words_written;
+    pstrPhase->strFlash.pages_erased += strAfter.pages_erased - pstrBefore->pages_erased;
+}
+
+static uint8_t u8DirtyRatio(void)
+{
+    fds_stat_t strFdsStats = {0};
+
+    (void)fds_stat(&strFdsStats);
+
+    return (uint8_t)(((uint32_t)strFdsStats.freeable_words * 100) / BENCH_DATA_WORDS);
+}
+
+static void vidMakeUserId(uint32_t u32Id, uint8_t *pu8Id)
+{
+    char cDigits[NVM_ID_SIZE + 1];
+
+    (void)snprintf(cDigits, sizeof(cDigits), "%08u", (unsigned)(u32Id % 100000000U));
+    memcpy(pu8Id, cDigits, NVM_ID_SIZE);
+}
+
+static Nvm_tenuFiles enuMakeRecord(uint16_t u16User, uint8_t u8ExpirablePct, Nvm_tstrRecord *pstrRecord)
+{
+    Nvm_tenuFiles enuRetVal = Nvm_PersistentKeys;
+
+    memset(pstrRecord, 0, sizeof(Nvm_tstrRecord));
+    vidMakeUserId(BENCH_FIRST_USER_ID + (u16User * BENCH_USER_ID_STRIDE), pstrRecord->u8Id);
+    (void)snprintf((char *)pstrRecord->u8Password, NVM_PWD_SIZE, "Bench#%05u", (unsigned)u16User);
+
+    /* Spread expirable users evenly, rotating through expirable key types */
+    if((u16User % 100) < u8ExpirablePct)
+    {
+        enuRetVal = Nvm_ExpirableKeys;
+        switch(u16User % 3)
+        {
+        case 0:
+            pstrRecord->enuKeyType = App_OneTimeKey;
+            break;
+
+        case 1:
+            pstrRecord->enuKeyType = App_CountRestrictedKey;
+            pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit = 100;
+            break;
+
+        default:
+            pstrRecord->enuKeyType = App_TimeRestrictedKey;
+            pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout = 60;
+            break;
+        }
+    }
+    else
+    {
+        pstrRecord->enuKeyType = App_UnlimitedKey;
+    }
+
+    return enuRetVal;
+}
+
+static uint16_t u16FillStorage(Bench_tstrScenario const *pstrScenario, Bench_tstrResult *pstrResult)
+{
+    uint16_t u16RetVal = 0;
+
+    for(uint16_t u16User = 0; u16User < pstrScenario->u16Users; u16User++)
+    {
+        Nvm_tstrRecord strRecord;
+        Nvm_tenuFiles enuFile = enuMakeRecord(u16User, pstrScenario->u8ExpirablePct, &strRecord);
+        nrf_fstorage_host_stats_t strBefore;
+        uint64_t u64Start;
+
+        /* The host backend completes flash operations before returning, so the whole write is
+           accounted for */
+        vidPhaseStart(&strBefore, &u64Start);
+        if(Middleware_Success != enuNVM_AddNewRecord(&strUserDesc[u16User], &strRecord, enuFile))
+        {
+            pstrResult->pcStatus = "full";
+            break;
+        }
+        vidPhaseStop(&pstrResult->strAdd, &strBefore, u64Start);
+        u16RetVal++;
+    }
+
+    return u16RetVal;
+}
+
+static void vidBatchComplete(Mid_tenuStatus enuResult, void *pvContext)
+{
+    enuBatchResult = enuResult;
+}
+
+static void vidProvisionUsers(Bench_tstrScenario const *pstrScenario, Bench_tstrResult *pstrResult)
+{
+    uint16_t u16User = 0;
+    bool bFits = true;
+
+    while(bFits && (u16User < pstrScenario->u16Users))
+    {
+        uint16_t u16Count = MIN(MID_NVM_BATCH_SIZE, pstrScenario->u16Users - u16User);
+        nrf_fstorage_host_stats_t strBefore;
+        uint64_t u64Start;
+
+        /* Staging is part of provisioning, as decoding a Provision write into it would be */
+        enuBatchResult = Middleware_Failure;
+        vidPhaseStart(&strBefore, &u64Start);
+        bFits = (Middleware_Success == enuNVM_BeginTransaction());
+        for(uint16_t u16Index = 0; bFits && (u16Index < u16Count); u16Index++)
+        {
+            Nvm_tstrRecord strRecord;
+
+            (void)enuMakeRecord(u16User + u16Index, pstrScenario->u8ExpirablePct, &strRecord);
+            vidMakeUserId(BENCH_FIRST_USER_ID + BENCH_BATCH_ID_OFFSET + ((u16User + u16Index) * BENCH_USER_ID_STRIDE),
+                          strRecord.u8Id);
+            bFits = (Middleware_Success == enuNVM_StageRecord(&strRecord));
+        }
+
+        /* The host backend completes flash operations before returning, so the whole batch has
+           been applied by the time enuNVM_CommitTransaction returns */
+        bFits = bFits && (Middleware_Success == enuNVM_CommitTransaction(vidBatchComplete, NULL));
+        if(bFits && (Middleware_Success == enuBatchResult))
+        {
+            vidPhaseStop(&pstrResult->strBatch, &strBefore, u64Start);
+            pstrResult->strBatch.u32Count += u16Count - 1;
+        }
+        else
+        {
+            (void)enuNVM_AbortTransaction();
+        }
+        u16User += u16Count;
+    }
+}
+
+static void vidDirtyStorage(Bench_tstrScenario const *pstrScenario, Bench_tstrResult *pstrResult, uint16_t u16Users)
+{
+    uint32_t u32Update = 0;
+
+    /* Update users round-robin, every update leaving the previous copy of a record dirty */
+    while(u16Users && (u8DirtyRatio() < pstrScenario->u8DirtyPct))
+    {
+        uint16_t u16User = (uint16_t)(u32Update % u16Users);
+        Nvm_tstrRecord strRecord;
+        Nvm_tenuFiles enuFile = enuMakeRecord(u16User, pstrScenario->u8ExpirablePct, &strRecord);
+        nrf_fstorage_host_stats_t strBefore;
+        uint64_t u64Start;
+
+        strRecord.u32LastKnownUse = ++u32Update;
+
+        vidPhaseStart(&strBefore, &u64Start);
+        if(Middleware_Success != enuNVM_UpdateRecord(&strUserDesc[u16User], &strRecord, enuFile))
+        {
+            pstrResult->pcStatus = "full";
+            break;
+        }
+        vidPhaseStop(&pstrResult->strUpdate, &strBefore, u64Start);
+    }
+}
+
+static void vidLookUpUsers(Bench_tstrResult *pstrResult, uint16_t u16Users)
+{
+    for(uint16_t u16User = 0; u16User < u16Users; u16User++)
+    {
+        uint8_t u8Id[NVM_ID_SIZE];
+        fds_record_desc_t strRecordDesc;
+        fds_flash_record_t strFlashRecord;
+        Nvm_tstrRecord strRecord;
+        nrf_fstorage_host_stats_t strBefore;
+        uint64_t u64Start;
+        bool bPass;
+
+        /* Registered user */
+        vidMakeUserId(BENCH_FIRST_USER_ID + (u16User * BENCH_USER_ID_STRIDE), u8Id);
+        vidPhaseStart(&strBefore, &u64Start);
+        if(Middleware_Success == enuNVM_FindUser(u8Id, &strRecordDesc))
+        {
+            vidPhaseStop(&pstrResult->strFind, &strBefore, u64Start);
+            if(u16User < (u16Users / 4))
+            {
+                vidPhaseStop(&pstrResult->strFirst, &strBefore, u64Start);
+            }
+            else if(u16User >= (u16Users - (u16Users / 4)))
+            {
+                vidPhaseStop(&pstrResult->strLast, &strBefore, u64Start);
+            }
+
+            vidPhaseStart(&strBefore, &u64Start);
+            if(Middleware_Success == enuNVM_ReadRecord(&strRecordDesc, &strFlashRecord, &strRecord))
+            {
+                vidPhaseStop(&pstrResult->strRead, &strBefore, u64Start);
+            }
+        }
+        else
+        {
+            pstrResult->pcStatus = "lost";
+        }
+
+        /* Unknown user, which is what most rejected access attempts look like. Those the Bloom
+           filter lets through are false positives and go on to the index or flash storage */
+        vidMakeUserId(BENCH_MISSING_USER_ID - u16User, u8Id);
+        bPass = bNVM_MayHoldUser(u8Id);
+        vidPhaseStart(&strBefore, &u64Start);
+        (void)enuNVM_FindUser(u8Id, &strRecordDesc);
+        vidPhaseStop(bPass?&pstrResult->strPass:&pstrResult->strReject, &strBefore, u64Start);
+    }
+
+    /* Users registered last shouldn't take any longer to look up than those registered first */
+    if((u16Users >= BENCH_FLAT_LOOKUP_USERS) &&
+       (BENCH_AVERAGE(pstrResult->strLast.u64Nanoseconds, pstrResult->strLast.u32Count) >
+        (BENCH_FLAT_LOOKUP_RATIO * BENCH_AVERAGE(pstrResult->strFirst.u64Nanoseconds, pstrResult->strFirst.u32Count))))
+    {
+        pstrResult->pcStatus = "slow";
+    }
+}
+
+static void vidCountUses(Bench_tstrScenario const *pstrScenario, Bench_tstrResult *pstrResult, uint16_t u16Users)
+{
+    for(uint16_t u16User = 0; u16User < u16Users; u16User++)
+    {
+        Nvm_tstrRecord strRecord;
+        fds_record_desc_t strRecordDesc;
+        fds_flash_record_t strFlashRecord;
+        nrf_fstorage_host_stats_t strBefore;
+        uint64_t u64Start;
+
+        (void)enuMakeRecord(u16User, pstrScenario->u8ExpirablePct, &strRecord);
+        if(App_CountRestrictedKey == strRecord.enuKeyType)
+        {
+            /* Each use reads the record back first, just like an access attempt would */
+            for(uint16_t u16Use = 0; u16Use < BENCH_USES_PER_KEY; u16Use++)
+            {
+                if((Middleware_Success != enuNVM_FindUser(strRecord.u8Id, &strRecordDesc)) ||
+                   (Middleware_Success != enuNVM_ReadRecord(&strRecordDesc, &strFlashRecord, &strRecord)))
+                {
+                    pstrResult->pcStatus = "lost";
+                    break;
+                }
+
+                strRecord.uKeyQuantifier.strCountRes.u16UsedCount++;
+
+                vidPhaseStart(&strBefore, &u64Start);
+                if(Middleware_Success != enuNVM_CountUse(&strRecordDesc, &strRecord))
+                {
+                    pstrResult->pcStatus = "full";
+                    break;
+                }
+                (void)enuNVM_CompactCounters();
+                (void)enuNVM_CollectGarbage();
+                vidPhaseStop(&pstrResult->strUse, &strBefore, u64Start);
+            }
+
+            if((Middleware_Success == enuNVM_FindUser(strRecord.u8Id, &strRecordDesc)) &&
+               (Middleware_Success == enuNVM_ReadRecord(&strRecordDesc, &strFlashRecord, &strRecord)) &&
+               (BENCH_USES_PER_KEY != strRecord.uKeyQuantifier.strCountRes.u16UsedCount) &&
+               (0 == strcmp(pstrResult->pcStatus, "ok")))
+            {
+                pstrResult->pcStatus = "miscount";
+            }
+        }
+    }
+}
+
+static void vidCollectGarbage(Bench_tstrResult *pstrResult)
+{
+    nrf_fstorage_host_stats_t strBefore;
+    uint64_t u64Start;
+
+    pstrResult->u8DirtyPct = u8DirtyRatio();
+
+    vidPhaseStart(&strBefore, &u64Start);
+    if(NRF_SUCCESS == fds_gc())
+    {
+        vidPhaseStop(&pstrResult->strGc, &strBefore, u64Start);
+    }
+}
+
+static void vidPrintResult(Bench_tstrScenario const *pstrScenario, Bench_tstrResult const *pstrResult, Bench_tenuFormat enuFormat)
+{
+    char const *pcFormat = (Bench_Csv == enuFormat)
+        ?"%u,%u,%u,%u,%s,%u,%.2f,%.1f,%.0f,%u,%.2f,%.1f,%.0f,%u,%.2f,%.1f,%.2f,%.2f,%.1f,%.2f,%.2f,%.2f,%u,%.2f,%.2f,%.2f,%u,%.2f,%u,%u,%u\n"
+        :"  {\"fds_pages\": %u, \"users\": %u, \"expirable_pct\": %u, \"dirty_target_pct\": %u, "
+         "\"status\": \"%s\", \"users_added\": %u, \"add_us\": %.2f, \"add_words\": %.1f, "
+         "\"add_users_s\": %.0f, \"batch_users\": %u, \"batch_us\": %.2f, \"batch_words\": %.1f, "
+         "\"batch_users_s\": %.0f, "
+         "\"updates\": %u, \"update_us\": %.2f, \"update_words\": %.1f, \"find_us\": %.2f, "
+         "\"find_miss_us\": %.2f, \"filter_fp_pct\": %.1f, \"miss_rejected_us\": %.2f, "
+         "\"miss_passed_us\": %.2f, \"read_us\": %.2f, \"uses\": %u, \"use_us\": %.2f, "
+         "\"use_words\": %.2f, \"use_erases\": %.2f, \"dirty_pct\": %u, \"gc_us\": %.2f, "
+         "\"gc_words\": %u, \"gc_erases\": %u, \"words_overwritten\": %u}";
+
+    printf(pcFormat,
+           (unsigned)FDS_VIRTUAL_PAGES,
+           (unsigned)pstrScenario->u16Users,
+           (unsigned)pstrScenario->u8ExpirablePct,
+           (unsigned)pstrScenario->u8DirtyPct,
+           pstrResult->pcStatus,
+           (unsigned)pstrResult->strAdd.u32Count,
+           BENCH_AVERAGE(pstrResult->strAdd.u64Nanoseconds / 1000.0, pstrResult->strAdd.u32Count),
+           BENCH_AVERAGE(pstrResult->strAdd.strFlash.words_written, pstrResult->strAdd.u32Count),
+           BENCH_RATE(pstrResult->strAdd),
+           (unsigned)pstrResult->strBatch.u32Count,
+           BENCH_AVERAGE(pstrResult->strBatch.u64Nanoseconds / 1000.0, pstrResult->strBatch.u32Count),
+           BENCH_AVERAGE(pstrResult->strBatch.strFlash.words_written, pstrResult->strBatch.u32Count),
+           BENCH_RATE(pstrResult->strBatch),
+           (unsigned)pstrResult->strUpdate.u32Count,
+           BENCH_AVERAGE(pstrResult->strUpdate.u64Nanoseconds / 1000.0, pstrResult->strUpdate.u32Count),
+           BENCH_AVERAGE(pstrResult->strUpdate.strFlash.words_written, pstrResult->strUpdate.u32Count),
+           BENCH_AVERAGE(pstrResult->strFind.u64Nanoseconds / 1000.0, pstrResult->strFind.u32Count),
+           BENCH_AVERAGE((pstrResult->strReject.u64Nanoseconds + pstrResult->strPass.u64Nanoseconds) / 1000.0,
+                         pstrResult->strReject.u32Count + pstrResult->strPass.u32Count),
+           BENCH_AVERAGE(pstrResult->strPass.u32Count * 100.0, pstrResult->strReject.u32Count + pstrResult->strPass.u32Count),
+           BENCH_AVERAGE(pstrResult->strReject.u64Nanoseconds / 1000.0, pstrResult->strReject.u32Count),
+           BENCH_AVERAGE(pstrResult->strPass.u64Nanoseconds / 1000.0, pstrResult->strPass.u32Count),
+           BENCH_AVERAGE(pstrResult->strRead.u64Nanoseconds / 1000.0, pstrResult->strRead.u32Count),
+           (unsigned)pstrResult->strUse.u32Count,
+           BENCH_AVERAGE(pstrResult->strUse.u64Nanoseconds / 1000.0, pstrResult->strUse.u32Count),
+           BENCH_AVERAGE(pstrResult->strUse.strFlash.words_written, pstrResult->strUse.u32Count),
+           BENCH_AVERAGE(pstrResult->strUse.strFlash.pages_erased, pstrResult->strUse.u32Count),
+           (unsigned)pstrResult->u8DirtyPct,
+           pstrResult->strGc.u64Nanoseconds / 1000.0,
+           (unsigned)pstrResult->strGc.strFlash.words_written,
+           (unsigned)pstrResult->strGc.strFlash.pages_erased,
+           (unsigned)pstrResult->u32Overwrites);
+}
+
+static void vidRunScenario(Bench_tstrScenario const *pstrScenario, Bench_tenuFormat enuFormat)
+{
+    Bench_tstrResult strResult = {0};
+    char cImage[] = BENCH_IMAGE_TEMPLATE;
+    int iFd = mkstemp(cImage);
+
+    strResult.pcStatus = "ok";
+
+    /* Image is placed right below the end of the nRF52832's flash, where FDS pages sit on target.
+       Usage counter pages sit right below FDS's */
+    if(iFd < 0)
+    {
+        strResult.pcStatus = "image";
+    }
+    else if(NRF_SUCCESS != nrf_fstorage_host_image_open(cImage,
+                                                        BENCH_FLASH_END_ADDR - BENCH_IMAGE_SIZE,
+                                                        BENCH_IMAGE_SIZE))
+    {
+        strResult.pcStatus = "image";
+    }
+    else if(Middleware_Success != enuNvm_Init())
+    {
+        strResult.pcStatus = "init";
+    }
+    else
+    {
+        nrf_fstorage_host_stats_t strFlash;
+        uint16_t u16Users = u16FillStorage(pstrScenario, &strResult);
+
+        vidDirtyStorage(pstrScenario, &strResult, u16Users);
+        vidLookUpUsers(&strResult, u16Users);
+        vidCountUses(pstrScenario, &strResult, u16Users);
+        vidCollectGarbage(&strResult);
+        vidProvisionUsers(pstrScenario, &strResult);
+
+        nrf_fstorage_host_stats_get(&strFlash);
+        strResult.u32Overwrites = strFlash.words_overwritten;
+    }
+
+    vidPrintResult(pstrScenario, &strResult, enuFormat);
+
+    nrf_fstorage_host_image_close();
+    if(iFd >= 0)
+    {
+        (void)close(iFd);
+        (void)unlink(cImage);
+    }
+}
+
+static bool bParseList(char *pcList, uint16_t *pu16Values, uint8_t *pu8Len, uint32_t u32Max)
+{
+    bool bRetVal = true;
+    char *pcSavePtr = NULL;
+
+    *pu8Len = 0;
+    for(char *pcToken = strtok_r(pcList, ",", &pcSavePtr);
+        pcToken && bRetVal;
+        pcToken = strtok_r(NULL, ",", &pcSavePtr))
+    {
+        char *pcEnd = NULL;
+        unsigned long ulValue = strtoul(pcToken, &pcEnd, 10);
+
+        bRetVal = (*pcEnd == '\0') && (ulValue <= u32Max) && (*pu8Len < BENCH_MAX_LIST_ENTRIES);
+        if(bRetVal)
+        {
+            pu16Values[(*pu8Len)++] = (uint16_t)ulValue;
+        }
+    }
+
+    return bRetVal && *pu8Len;
+}
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+int main(int argc, char *argv[])
+{
+    int iRetVal = EXIT_SUCCESS;
+    int iOption;
+    Bench_tenuFormat enuFormat = Bench_Csv;
+    char cUsers[] = BENCH_DEFAULT_USERS;
+    char cExpirable[] = BENCH_DEFAULT_EXPIRABLE;
+    char cDirty[] = BENCH_DEFAULT_DIRTY;
+    char *pcUsers = cUsers;
+    char *pcExpirable = cExpirable;
+    char *pcDirty = cDirty;
+
+    while((EXIT_SUCCESS == iRetVal) && (-1 != (iOption = getopt(argc, argv, "u:e:d:f:"))))
+    {
+        switch(iOption)
+        {
+        case 'u':
+            pcUsers = optarg;
+            break;
+
+        case 'e':
+            pcExpirable = optarg;
+            break;
+
+        case 'd':
+            pcDirty = optarg;
+            break;
+
+        case 'f':
+            enuFormat = (0 == strcmp(optarg, "json"))?Bench_Json:Bench_Csv;
+            iRetVal = ((Bench_Json == enuFormat) || (0 == strcmp(optarg, "csv")))?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        default:
+            iRetVal = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if((EXIT_SUCCESS != iRetVal) ||
+       !bParseList(pcUsers, u16UserCounts, &u8UserCountsLen, BENCH_MAX_USERS) ||
+       !bParseList(pcExpirable, u16ExpirablePcts, &u8ExpirablePctsLen, 100) ||
+       !bParseList(pcDirty, u16DirtyPcts, &u8DirtyPctsLen, 100))
+    {
+        fprintf(stderr, "usage: %s [-u users,...] [-e expirable%%,...] [-d dirty%%,...] [-f csv|json]\n", argv[0]);
+        iRetVal = EXIT_FAILURE;
+    }
+    else
+    {
+        bool bFirst = true;
+
+        printf((Bench_Csv == enuFormat)
+               ?"fds_pages,users,expirable_pct,dirty_target_pct,status,users_added,add_us,add_words,"
+                "add_users_s,batch_users,batch_us,batch_words,batch_users_s,updates,update_us,update_words,find_us,find_miss_us,filter_fp_pct,miss_rejected_us,"
+                "miss_passed_us,read_us,uses,use_us,use_words,use_erases,dirty_pct,gc_us,gc_words,"
+                "gc_erases,words_overwritten\n"
+               :"[\n");
+
+        for(uint8_t u8User = 0; u8User < u8UserCountsLen; u8User++)
+        {
+            for(uint8_t u8Expirable = 0; u8Expirable < u8ExpirablePctsLen; u8Expirable++)
+            {
+                for(uint8_t u8Dirty = 0; u8Dirty < u8DirtyPctsLen; u8Dirty++)
+                {
+                    Bench_tstrScenario strScenario = {u16UserCounts[u8User],
+                                                      (uint8_t)u16ExpirablePcts[u8Expirable],
+                                                      (uint8_t)u16DirtyPcts[u8Dirty]};
+                    pid_t xChild;
+                    int iStatus = 0;
+
+                    if((Bench_Json == enuFormat) && !bFirst)
+                    {
+                        printf(",\n");
+                    }
+                    bFirst = false;
+
+                    /* Pending output would otherwise be printed by both processes */
+                    (void)fflush(stdout);
+
+                    xChild = fork();
+                    if(0 == xChild)
+                    {
+                        vidRunScenario(&strScenario, enuFormat);
+                        (void)fflush(stdout);
+                        _exit(EXIT_SUCCESS);
+                    }
+                    else if((xChild < 0) ||
+                            (waitpid(xChild, &iStatus, 0) != xChild) ||
+                            !WIFEXITED(iStatus))
+                    {
+                        /* Report scenario anyway so results keep lining up */
+                        Bench_tstrResult strResult = {0};
+
+                        strResult.pcStatus = "crashed";
+                        vidPrintResult(&strScenario, &strResult, enuFormat);
+                        iRetVal = EXIT_FAILURE;
+                    }
+                }
+            }
+        }
+
+        if(Bench_Json == enuFormat)
+        {
+            printf("\n]\n");
+        }
+    }
+
+    return iRetVal;
+}
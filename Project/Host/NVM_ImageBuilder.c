@@ -0,0 +1,339 @@
+/* ----------------------------   NVM image builder for Linux   -------------------------------- */
+/*  File      -  Pre-provisioned FDS image builder source file                                   */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: This tool builds a flash image holding a ready-made user database, so devices can be
+   provisioned at the factory rather than one user at a time over BLE. Users are read from a CSV
+   file and written through NVM_Service into a freshly erased image, FDS laying out page tags,
+   record headers and CRCs (when FDS_CRC_CHECK_ON_READ is set) exactly like the firmware would.
+
+   Each line of the CSV file describes one user as Id,key type,parameter:
+     - Id is the user's 8-digit Id.
+     - Key type goes from 1 to 5, as in the k1 to k5 suffixes of the Admin's add user command.
+     - Parameter is the count limit of count-restricted keys (k2) or the timeout in minutes of
+       time-restricted ones (k4). It can be left out for other key types.
+   Empty lines and lines starting with '#' are skipped. Users are given no password, they
+   register one upon their first interaction with the device. The file should hold at least one
+   Admin (k5), as nobody else can sign in to add users later on.
+
+   The image (-o, default nvm_image.bin) is a raw dump of the FDS pages followed by the pages
+   reserved through FDS_VIRTUAL_PAGES_RESERVED, ending at the given flash address (-a, default
+   the end of the nRF52832's flash). Those reserved pages are left erased. An Intel HEX file
+   (-x) can be written along with it for flash programmers, erased rows being left out of it.
+   FDS settings must match the firmware's, e.g. from the repository root (INC being the IAR
+   project's include directories as -I options):
+
+   gcc -std=gnu99 -O2 -no-pie -DNRF52832_XXAA -DNRF52 -DFDS_BACKEND=3                            \
+       -DNRF_ATOMIC_USE_BUILD_IN=1 -DNRF_LOG_ENABLED=0 -DSVCALL_AS_NORMAL_FUNCTION               \
+       -IProject/Host $INC -IKernel/FreeRTOS/portable/GCC/nrf52                                  \
+       Project/Host/NVM_ImageBuilder.c Project/Host/Host_Stubs.c                                 \
+       Middleware/Services/NVM_Service/NVM_Service.c Utilities/Time/Time.c Utilities/Math/Maths.c \
+       Middleware/Libraries/fds/fds.c Middleware/Libraries/fstorage/nrf_fstorage.c               \
+       Middleware/Libraries/fstorage/nrf_fstorage_host.c Middleware/Libraries/atomic/nrf_atomic.c \
+       Middleware/Libraries/atomic_fifo/nrf_atfifo.c Middleware/Libraries/util/app_util_platform.c \
+       -Wl,-T,Project/Host/host_sections.ld -o nvm_image_builder
+
+   then, for instance:
+
+   ./nvm_image_builder -o wipad.bin -x wipad.hex users.csv
+   nrfjprog --program wipad.hex --sectorerase --verify */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "NVM_Service.h"
+#include "nrf_fstorage_host.h"
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define BUILDER_FLASH_END_ADDR  0x00080000
+#define BUILDER_FLASH_PAGE_SIZE (FDS_VIRTUAL_PAGE_SIZE * sizeof(uint32_t))
+#define BUILDER_IMAGE_SIZE      ((FDS_VIRTUAL_PAGES + FDS_VIRTUAL_PAGES_RESERVED) * BUILDER_FLASH_PAGE_SIZE)
+#define BUILDER_DEFAULT_IMAGE   "nvm_image.bin"
+#define BUILDER_MAX_LINE_LENGTH 128U
+#define BUILDER_MAX_PARAMETER   0xFFFFU
+#define BUILDER_HEX_ROW_SIZE    16U
+#define BUILDER_HEX_DATA        0x00U
+#define BUILDER_HEX_EOF         0x01U
+#define BUILDER_HEX_LINEAR_ADDR 0x04U
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static bool bParseUser(char *pcLine, Nvm_tstrRecord *pstrRecord, Nvm_tenuFiles *penuFile)
+{
+    bool bRetVal = true;
+    char *pcSavePtr = NULL;
+    char *pcId = strtok_r(pcLine, ",", &pcSavePtr);
+    char *pcKeyType = strtok_r(NULL, ",", &pcSavePtr);
+    char *pcParameter = strtok_r(NULL, ",", &pcSavePtr);
+    char *pcEnd = NULL;
+    unsigned long ulKeyType = 0;
+    unsigned long ulParameter = 0;
+
+    memset(pstrRecord, 0, sizeof(Nvm_tstrRecord));
+
+    /* Id must be exactly 8 digits */
+    bRetVal = pcId && pcKeyType && (NVM_ID_SIZE == strlen(pcId));
+    for(uint8_t u8Index = 0; bRetVal && (u8Index < NVM_ID_SIZE); u8Index++)
+    {
+        bRetVal = (0 != isdigit((unsigned char)pcId[u8Index]));
+    }
+
+    if(bRetVal)
+    {
+        ulKeyType = strtoul(pcKeyType, &pcEnd, 10);
+        bRetVal = (pcEnd != pcKeyType) && ('\0' == *pcEnd) &&
+                  (App_KeyLowerBound < ulKeyType) && (ulKeyType < App_KeyUpperBound);
+    }
+
+    /* Only count-restricted and time-restricted keys need a parameter */
+    if(bRetVal && pcParameter)
+    {
+        ulParameter = strtoul(pcParameter, &pcEnd, 10);
+        bRetVal = (pcEnd != pcParameter) && ('\0' == *pcEnd) && (ulParameter <= BUILDER_MAX_PARAMETER);
+    }
+    else if(bRetVal)
+    {
+        bRetVal = (App_CountRestrictedKey != ulKeyType) && (App_TimeRestrictedKey != ulKeyType);
+    }
+
+    if(bRetVal)
+    {
+        /* Fill record the same way the Admin's add user command does */
+        memcpy(pstrRecord->u8Id, pcId, NVM_ID_SIZE);
+        memset(pstrRecord->u8Password, 0xFF, NVM_PWD_SIZE);
+        pstrRecord->enuKeyType = (App_tenuKeyTypes)ulKeyType;
+        *penuFile = Nvm_ExpirableKeys;
+        switch(pstrRecord->enuKeyType)
+        {
+        case App_CountRestrictedKey:
+            pstrRecord->uKeyQuantifier.strCountRes.u16CountLimit = (uint16_t)ulParameter;
+            break;
+
+        case App_TimeRestrictedKey:
+            pstrRecord->uKeyQuantifier.strTimeRes.u16Timeout = (uint16_t)ulParameter;
+            break;
+
+        case App_OneTimeKey:
+            pstrRecord->uKeyQuantifier.bOneTimeExpired = false;
+            break;
+
+        default:
+            *penuFile = Nvm_PersistentKeys;
+            break;
+        }
+    }
+
+    return bRetVal;
+}
+
+static bool bAddUsers(FILE *pxUsers, uint32_t *pu32Added)
+{
+    bool bRetVal = true;
+    char cLine[BUILDER_MAX_LINE_LENGTH];
+    uint32_t u32LineNumber = 0;
+
+    *pu32Added = 0;
+    while(bRetVal && fgets(cLine, sizeof(cLine), pxUsers))
+    {
+        Nvm_tstrRecord strRecord;
+        Nvm_tenuFiles enuFile = Nvm_PersistentKeys;
+        fds_record_desc_t strRecordDesc;
+
+        u32LineNumber++;
+        cLine[strcspn(cLine, "\r\n")] = '\0';
+
+        if(('\0' == cLine[0]) || ('#' == cLine[0]))
+        {
+            /* Nothing to add */
+        }
+        else if(!bParseUser(cLine, &strRecord, &enuFile))
+        {
+            fprintf(stderr, "line %u: expected Id,key type,parameter\n", (unsigned)u32LineNumber);
+            bRetVal = false;
+        }
+        else if(Middleware_Success == enuNVM_FindUser(strRecord.u8Id, &strRecordDesc))
+        {
+            fprintf(stderr, "line %u: Id %.8s listed twice\n", (unsigned)u32LineNumber, strRecord.u8Id);
+            bRetVal = false;
+        }
+        else if(Middleware_Success != enuNVM_AddNewRecord(&strRecordDesc, &strRecord, enuFile))
+        {
+            /* The host backend completes flash operations before returning, so a failure here
+               means storage ran out */
+            fprintf(stderr, "line %u: flash storage full after %u users, raise FDS_VIRTUAL_PAGES\n",
+                    (unsigned)u32LineNumber, (unsigned)*pu32Added);
+            bRetVal = false;
+        }
+        else
+        {
+            (*pu32Added)++;
+        }
+    }
+
+    return bRetVal;
+}
+
+static void vidHexRecord(FILE *pxHex, uint8_t u8Type, uint16_t u16Address, uint8_t const *pu8Data, uint8_t u8Length)
+{
+    uint8_t u8Checksum = u8Length + (uint8_t)(u16Address >> 8) + (uint8_t)u16Address + u8Type;
+
+    fprintf(pxHex, ":%02X%04X%02X", u8Length, u16Address, u8Type);
+    for(uint8_t u8Index = 0; u8Index < u8Length; u8Index++)
+    {
+        fprintf(pxHex, "%02X", pu8Data[u8Index]);
+        u8Checksum += pu8Data[u8Index];
+    }
+    fprintf(pxHex, "%02X\n", (uint8_t)(0x100 - u8Checksum));
+}
+
+static bool bWriteHex(char const *pcImage, char const *pcHex, uint32_t u32BaseAddress)
+{
+    bool bRetVal = false;
+    FILE *pxImage = fopen(pcImage, "rb");
+    FILE *pxHex = fopen(pcHex, "w");
+
+    if(pxImage && pxHex)
+    {
+        uint8_t u8Row[BUILDER_HEX_ROW_SIZE];
+        uint32_t u32Address = u32BaseAddress;
+        uint32_t u32Segment = UINT32_MAX;
+        uint8_t u8Erased[BUILDER_HEX_ROW_SIZE];
+
+        memset(u8Erased, 0xFF, sizeof(u8Erased));
+
+        /* Rows still erased are left out, programmers leave them erased anyway */
+        while(sizeof(u8Row) == fread(u8Row, 1, sizeof(u8Row), pxImage))
+        {
+            if(0 != memcmp(u8Row, u8Erased, sizeof(u8Row)))
+            {
+                if((u32Address >> 16) != u32Segment)
+                {
+                    uint8_t u8Segment[2];
+
+                    u32Segment = u32Address >> 16;
+                    u8Segment[0] = (uint8_t)(u32Segment >> 8);
+                    u8Segment[1] = (uint8_t)u32Segment;
+                    vidHexRecord(pxHex, BUILDER_HEX_LINEAR_ADDR, 0, u8Segment, sizeof(u8Segment));
+                }
+                vidHexRecord(pxHex, BUILDER_HEX_DATA, (uint16_t)u32Address, u8Row, sizeof(u8Row));
+            }
+            u32Address += sizeof(u8Row);
+        }
+        vidHexRecord(pxHex, BUILDER_HEX_EOF, 0, NULL, 0);
+
+        bRetVal = !ferror(pxImage) && !ferror(pxHex);
+    }
+
+    if(pxImage)
+    {
+        (void)fclose(pxImage);
+    }
+    if(pxHex)
+    {
+        bRetVal = (0 == fclose(pxHex)) && bRetVal;
+    }
+
+    return bRetVal;
+}
+
+/*************************************   PUBLIC FUNCTIONS   **************************************/
+int main(int argc, char *argv[])
+{
+    int iRetVal = EXIT_FAILURE;
+    char const *pcImage = BUILDER_DEFAULT_IMAGE;
+    char const *pcHex = NULL;
+    uint32_t u32FlashEnd = BUILDER_FLASH_END_ADDR;
+    FILE *pxUsers = NULL;
+    bool bUsage = false;
+    int iOption;
+
+    while(-1 != (iOption = getopt(argc, argv, "o:x:a:")))
+    {
+        switch(iOption)
+        {
+        case 'o':
+            pcImage = optarg;
+            break;
+
+        case 'x':
+            pcHex = optarg;
+            break;
+
+        case 'a':
+            u32FlashEnd = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+
+        default:
+            bUsage = true;
+            break;
+        }
+    }
+
+    if(bUsage || ((optind + 1) != argc) || (u32FlashEnd < BUILDER_IMAGE_SIZE))
+    {
+        fprintf(stderr, "usage: %s [-o image.bin] [-x image.hex] [-a flash_end] users.csv\n", argv[0]);
+    }
+    else if(NULL == (pxUsers = fopen(argv[optind], "r")))
+    {
+        perror(argv[optind]);
+    }
+    else
+    {
+        uint32_t u32BaseAddress = u32FlashEnd - BUILDER_IMAGE_SIZE;
+        uint32_t u32Added = 0;
+
+        /* Start out from erased flash, whatever the image file held before */
+        (void)unlink(pcImage);
+
+        if(NRF_SUCCESS != nrf_fstorage_host_image_open(pcImage, u32BaseAddress, BUILDER_IMAGE_SIZE))
+        {
+            fprintf(stderr, "%s: couldn't map image at 0x%08X\n", pcImage, (unsigned)u32BaseAddress);
+        }
+        else
+        {
+            if(Middleware_Success != enuNvm_Init())
+            {
+                fprintf(stderr, "couldn't initialize flash storage\n");
+            }
+            else if(bAddUsers(pxUsers, &u32Added))
+            {
+                iRetVal = EXIT_SUCCESS;
+            }
+            nrf_fstorage_host_image_close();
+
+            if((EXIT_SUCCESS == iRetVal) && pcHex && !bWriteHex(pcImage, pcHex, u32BaseAddress))
+            {
+                fprintf(stderr, "%s: couldn't write Intel HEX file\n", pcHex);
+                iRetVal = EXIT_FAILURE;
+            }
+
+            if(EXIT_SUCCESS == iRetVal)
+            {
+                printf("%u users, %u FDS pages at 0x%08X, image ends at 0x%08X\n",
+                       (unsigned)u32Added,
+                       (unsigned)FDS_VIRTUAL_PAGES,
+                       (unsigned)u32BaseAddress,
+                       (unsigned)u32FlashEnd);
+            }
+            else
+            {
+                /* Don't leave a partial database around to be flashed by mistake */
+                (void)unlink(pcImage);
+                if(pcHex)
+                {
+                    (void)unlink(pcHex);
+                }
+            }
+        }
+
+        (void)fclose(pxUsers);
+    }
+
+    return iRetVal;
+}
@@ -0,0 +1,365 @@
+/* ------------------------------   Trace decoder for Linux   ----------------------------------- */
+/*  File      -  Event trace ring dump decoder source file                                       */
+/*  target    -  Linux host                                                                      */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: This tool decodes a dump of the trace ring (Trace_tstrRing) recorded by firmware built
+   with UTIL_TRACE_ENABLED set. On target, the ring is dumped by the debugger with the trace_dump
+   command of Project/Host/Trace_Dump.gdb. Host tools built with tracing stamp points with the
+   monotonic clock instead of the cycle counter, AppMgr_Benchmark dumps its ring with -t.
+
+   Entries are put back in the order they were recorded, oldest first. Every pair of consecutive
+   entries is a hop, hops are grouped by the trace points they go from and to. NVM calls are told
+   apart by the call they enter or return from. The span from the latest Softdevice event interrupt
+   to each notification handed over is reported as well, it is the time an input takes to be
+   answered. Hops are printed as CSV (default) or JSON (-f json), with minimum, average and
+   maximum latencies in microseconds. With -e, entries are printed instead, one per line.
+
+   Build from the repository root (INC being the IAR project's include directories as -I options):
+
+   gcc -std=gnu99 -O2 -Wall -IProject/Host $INC Project/Host/Trace_Decoder.c -o trace_decoder
+
+   Dumps are read as laid out by a little endian target, the ring's size being taken from the
+   dump's size. */
+
+/****************************************   INCLUDES   *******************************************/
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Trace.h"
+
+/************************************   PRIVATE DEFINES   ****************************************/
+#define DECODER_HEADER_SIZE  offsetof(Trace_tstrRing, strEntries)
+#define DECODER_MAX_ENTRIES  65536U
+#define DECODER_MAX_HOPS     256U
+#define DECODER_LABEL_LENGTH 40U
+
+/*************************************   PRIVATE MACROS   ****************************************/
+/* Convert cycles to microseconds */
+#define DECODER_US(cycles, hz) (((double)(cycles) * 1000000.0) / (double)(hz))
+
+/* Get a dump's entries. Dumps may hold more entries than this build's ring */
+#define DECODER_ENTRIES(ring) ((Trace_tstrEntry const *)((uint8_t const *)(ring) + DECODER_HEADER_SIZE))
+
+/* Check whether a size is a non-zero power of 2 */
+#define DECODER_IS_POWER_OF_2(size) ((size) && (((size) & ((size) - 1)) == 0))
+
+/**************************************   PRIVATE TYPES   ****************************************/
+/**
+ * Decoder_tenuFormat Enumeration of the different output formats.
+*/
+typedef enum
+{
+    Decoder_Csv = 0, /* One comma separated line per hop */
+    Decoder_Json     /* Array of one object per hop      */
+}Decoder_tenuFormat;
+
+/**
+ * Decoder_tenuKind Enumeration of the different kinds of latencies reported.
+*/
+typedef enum
+{
+    Decoder_Hop = 0, /* Between two consecutive entries                              */
+    Decoder_Span     /* From the latest Softdevice event interrupt to a notification */
+}Decoder_tenuKind;
+
+/**
+ * Decoder_tstrHop Latencies between two trace points.
+*/
+typedef struct
+{
+    Decoder_tenuKind enuKind; /* Kind of latency                     */
+    uint16_t u16From;         /* Label Id of the point it goes from  */
+    uint16_t u16To;           /* Label Id of the point it goes to    */
+    uint32_t u32Count;        /* Number of times it was gone through */
+    uint64_t u64Total;        /* Cycles taken, added up              */
+    uint32_t u32Min;          /* Fewest cycles taken                 */
+    uint32_t u32Max;          /* Most cycles taken                   */
+}Decoder_tstrHop;
+
+/************************************   PRIVATE VARIABLES   **************************************/
+/* Trace point names, in Trace_tenuPoint order */
+static char const * const pcPointNames[Trace_MaxPoints] =
+{
+    "sd_event_irq",
+    "ble_event",
+    "appmgr_dispatch",
+    "attribution_process",
+    "registration_process",
+    "display_process",
+    "nvm_call",
+    "nvm_return",
+    "ble_notify"
+};
+
+/* NVM call names, in Trace_tenuNvmCall order */
+static char const * const pcNvmCallNames[Trace_NvmMaxCalls] =
+{
+    "find_user",
+    "read_record",
+    "open_view",
+    "request_add",
+    "request_update",
+    "defer_update",
+    "count_use",
+    "request_delete"
+};
+
+/* Hops found so far, in the order they were first gone through */
+static Decoder_tstrHop strHops[DECODER_MAX_HOPS];
+static uint16_t u16HopCount = 0;
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static bool bIsNvmPoint(uint8_t u8Point)
+{
+    return (Trace_NvmCall == u8Point) || (Trace_NvmReturn == u8Point);
+}
+
+static uint16_t u16LabelId(Trace_tstrEntry const *pstrEntry)
+{
+    /* Points are labelled by themselves, NVM points by the call as well */
+    return (uint16_t)((pstrEntry->u8Point << 8) |
+                      (bIsNvmPoint(pstrEntry->u8Point)?(uint8_t)pstrEntry->u32Arg:0));
+}
+
+static char const *pcLabel(uint16_t u16Id, char *pcBuffer)
+{
+    uint8_t u8Point = (uint8_t)(u16Id >> 8);
+    uint8_t u8Call = (uint8_t)u16Id;
+
+    if(u8Point >= Trace_MaxPoints)
+    {
+        snprintf(pcBuffer, DECODER_LABEL_LENGTH, "point_%u", (unsigned)u8Point);
+    }
+    else if(bIsNvmPoint(u8Point))
+    {
+        snprintf(pcBuffer, DECODER_LABEL_LENGTH, "%s:%s", pcPointNames[u8Point],
+                 (u8Call < Trace_NvmMaxCalls)?pcNvmCallNames[u8Call]:"unknown");
+    }
+    else
+    {
+        snprintf(pcBuffer, DECODER_LABEL_LENGTH, "%s", pcPointNames[u8Point]);
+    }
+
+    return pcBuffer;
+}
+
+static void vidAddLatency(Decoder_tenuKind enuKind, uint16_t u16From, uint16_t u16To, uint32_t u32Cycles)
+{
+    Decoder_tstrHop *pstrHop = NULL;
+
+    for(uint16_t u16Index = 0; (u16Index < u16HopCount) && !pstrHop; u16Index++)
+    {
+        if((strHops[u16Index].enuKind == enuKind) &&
+           (strHops[u16Index].u16From == u16From) && (strHops[u16Index].u16To == u16To))
+        {
+            pstrHop = &strHops[u16Index];
+        }
+    }
+
+    /* Hops past the table's capacity are left out */
+    if(!pstrHop && (u16HopCount < DECODER_MAX_HOPS))
+    {
+        pstrHop = &strHops[u16HopCount++];
+        pstrHop->enuKind = enuKind;
+        pstrHop->u16From = u16From;
+        pstrHop->u16To = u16To;
+        pstrHop->u32Min = UINT32_MAX;
+    }
+
+    if(pstrHop)
+    {
+        pstrHop->u32Count++;
+        pstrHop->u64Total += u32Cycles;
+        pstrHop->u32Min = (u32Cycles < pstrHop->u32Min)?u32Cycles:pstrHop->u32Min;
+        pstrHop->u32Max = (u32Cycles > pstrHop->u32Max)?u32Cycles:pstrHop->u32Max;
+    }
+}
+
+static Trace_tstrRing *pstrReadDump(char const *pcPath, uint32_t *pu32Size)
+{
+    Trace_tstrRing *pstrRetVal = NULL;
+    FILE *pFile = fopen(pcPath, "rb");
+    long lLength = -1;
+
+    if(pFile && (0 == fseek(pFile, 0, SEEK_END)))
+    {
+        lLength = ftell(pFile);
+        rewind(pFile);
+    }
+
+    /* Dump must hold the header and a power of 2 number of entries */
+    if((lLength > (long)DECODER_HEADER_SIZE) &&
+       (0 == ((lLength - DECODER_HEADER_SIZE) % sizeof(Trace_tstrEntry))))
+    {
+        *pu32Size = (uint32_t)((lLength - DECODER_HEADER_SIZE) / sizeof(Trace_tstrEntry));
+        if(DECODER_IS_POWER_OF_2(*pu32Size) && (*pu32Size <= DECODER_MAX_ENTRIES))
+        {
+            pstrRetVal = malloc((size_t)lLength);
+        }
+    }
+
+    if(pstrRetVal && ((1 != fread(pstrRetVal, (size_t)lLength, 1, pFile)) ||
+                      (TRACE_RING_MAGIC != pstrRetVal->u32Magic) || !pstrRetVal->u32ClockHz))
+    {
+        free(pstrRetVal);
+        pstrRetVal = NULL;
+    }
+
+    if(pFile)
+    {
+        fclose(pFile);
+    }
+
+    return pstrRetVal;
+}
+
+static void vidPrintEntries(Trace_tstrRing const *pstrRing, uint32_t u32Size)
+{
+    uint32_t u32Recorded = (pstrRing->u32Count < u32Size)?pstrRing->u32Count:u32Size;
+    uint32_t u32First = pstrRing->u32Count - u32Recorded;
+    Trace_tstrEntry const *pstrPrevious = NULL;
+    char chLabel[DECODER_LABEL_LENGTH];
+
+    printf("sequence,cycles,delta_us,point,arg\n");
+
+    for(uint32_t u32Index = 0; u32Index < u32Recorded; u32Index++)
+    {
+        Trace_tstrEntry const *pstrEntry = &DECODER_ENTRIES(pstrRing)[(u32First + u32Index) & (u32Size - 1)];
+
+        /* Cycle counter wraps around, differences don't */
+        uint32_t u32Delta = pstrPrevious?(pstrEntry->u32Cycles - pstrPrevious->u32Cycles):0;
+
+        printf("%u,%u,%.3f,%s,%u\n",
+               (unsigned)(u32First + u32Index),
+               (unsigned)pstrEntry->u32Cycles,
+               DECODER_US(u32Delta, pstrRing->u32ClockHz),
+               pcLabel(u16LabelId(pstrEntry), chLabel),
+               (unsigned)pstrEntry->u32Arg);
+        pstrPrevious = pstrEntry;
+    }
+}
+
+static void vidPrintHops(Trace_tstrRing const *pstrRing, uint32_t u32Size, Decoder_tenuFormat enuFormat)
+{
+    uint32_t u32Recorded = (pstrRing->u32Count < u32Size)?pstrRing->u32Count:u32Size;
+    uint32_t u32First = pstrRing->u32Count - u32Recorded;
+    Trace_tstrEntry const *pstrPrevious = NULL;
+    Trace_tstrEntry const *pstrInterrupt = NULL;
+    char chFrom[DECODER_LABEL_LENGTH];
+    char chTo[DECODER_LABEL_LENGTH];
+    char const *pcFormat = (Decoder_Csv == enuFormat)
+        ?"%s,%s,%s,%u,%.3f,%.3f,%.3f\n"
+        :"  {\"kind\": \"%s\", \"from\": \"%s\", \"to\": \"%s\", \"count\": %u, "
+         "\"min_us\": %.3f, \"avg_us\": %.3f, \"max_us\": %.3f}";
+
+    for(uint32_t u32Index = 0; u32Index < u32Recorded; u32Index++)
+    {
+        Trace_tstrEntry const *pstrEntry = &DECODER_ENTRIES(pstrRing)[(u32First + u32Index) & (u32Size - 1)];
+
+        if(pstrPrevious)
+        {
+            vidAddLatency(Decoder_Hop, u16LabelId(pstrPrevious), u16LabelId(pstrEntry),
+                          pstrEntry->u32Cycles - pstrPrevious->u32Cycles);
+        }
+
+        if(Trace_SdEventIrq == pstrEntry->u8Point)
+        {
+            pstrInterrupt = pstrEntry;
+        }
+        else if((Trace_BleNotify == pstrEntry->u8Point) && pstrInterrupt)
+        {
+            vidAddLatency(Decoder_Span, u16LabelId(pstrInterrupt), u16LabelId(pstrEntry),
+                          pstrEntry->u32Cycles - pstrInterrupt->u32Cycles);
+        }
+
+        pstrPrevious = pstrEntry;
+    }
+
+    printf((Decoder_Csv == enuFormat)?"kind,from,to,count,min_us,avg_us,max_us\n":"[\n");
+
+    for(uint16_t u16Index = 0; u16Index < u16HopCount; u16Index++)
+    {
+        Decoder_tstrHop const *pstrHop = &strHops[u16Index];
+
+        if((Decoder_Json == enuFormat) && u16Index)
+        {
+            printf(",\n");
+        }
+
+        printf(pcFormat,
+               (Decoder_Hop == pstrHop->enuKind)?"hop":"span",
+               pcLabel(pstrHop->u16From, chFrom),
+               pcLabel(pstrHop->u16To, chTo),
+               (unsigned)pstrHop->u32Count,
+               DECODER_US(pstrHop->u32Min, pstrRing->u32ClockHz),
+               DECODER_US((double)pstrHop->u64Total / pstrHop->u32Count, pstrRing->u32ClockHz),
+               DECODER_US(pstrHop->u32Max, pstrRing->u32ClockHz));
+    }
+
+    if(Decoder_Json == enuFormat)
+    {
+        printf("%s]\n", u16HopCount?"\n":"");
+    }
+}
+
+/**************************************   MAIN FUNCTION   ****************************************/
+int main(int argc, char *argv[])
+{
+    int iRetVal = EXIT_SUCCESS;
+    int iOption;
+    Decoder_tenuFormat enuFormat = Decoder_Csv;
+    bool bEntries = false;
+    Trace_tstrRing *pstrRing = NULL;
+    uint32_t u32Size = 0;
+
+    while((EXIT_SUCCESS == iRetVal) && (-1 != (iOption = getopt(argc, argv, "ef:"))))
+    {
+        switch(iOption)
+        {
+        case 'e':
+            bEntries = true;
+            break;
+
+        case 'f':
+            enuFormat = (0 == strcmp(optarg, "json"))?Decoder_Json:Decoder_Csv;
+            iRetVal = ((Decoder_Json == enuFormat) || (0 == strcmp(optarg, "csv")))?EXIT_SUCCESS:EXIT_FAILURE;
+            break;
+
+        default:
+            iRetVal = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if((EXIT_SUCCESS != iRetVal) || (optind != (argc - 1)))
+    {
+        fprintf(stderr, "usage: %s [-e] [-f csv|json] dump\n", argv[0]);
+        iRetVal = EXIT_FAILURE;
+    }
+    else if(NULL == (pstrRing = pstrReadDump(argv[optind], &u32Size)))
+    {
+        fprintf(stderr, "%s: not a trace ring dump\n", argv[optind]);
+        iRetVal = EXIT_FAILURE;
+    }
+    else
+    {
+        if(bEntries)
+        {
+            vidPrintEntries(pstrRing, u32Size);
+        }
+        else
+        {
+            vidPrintHops(pstrRing, u32Size, enuFormat);
+        }
+
+        free(pstrRing);
+    }
+
+    return iRetVal;
+}
@@ -0,0 +1,88 @@
+/* ------------------------------   CMSIS host stand-in for Linux   ----------------------------- */
+/*  File      -  CMSIS compiler intrinsics header file for host builds                           */
+/*  target    -  Linux x86-64 / AArch64 host                                                     */
+/*  toolchain -  GCC                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/* Note: Host builds compile a subset of the firmware (FDS, fstorage and NVM_Service) to run storage
+   simulations and tools on a development machine. Those modules only rely on CMSIS for attribute
+   macros and a handful of core intrinsics which have no meaning outside of a Cortex-M core.
+   cmsis_compiler.h picks this header up for GCC builds when Project/Host is first in the include
+   path. */
+
+#ifndef _HOST_CMSIS_GCC_H_
+#define _HOST_CMSIS_GCC_H_
+
+/****************************************   INCLUDES   *******************************************/
+#include <stdint.h>
+
+/*************************************   PUBLIC DEFINES   ****************************************/
+#ifndef __ASM
+#define __ASM                   __asm
+#endif
+#ifndef __INLINE
+#define __INLINE                inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE         static inline
+#endif
+#ifndef __STATIC_FORCEINLINE
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#endif
+#ifndef __NO_RETURN
+#define __NO_RETURN             __attribute__((__noreturn__))
+#endif
+#ifndef __USED
+#define __USED                  __attribute__((used))
+#endif
+#ifndef __WEAK
+#define __WEAK                  __attribute__((weak))
+#endif
+#ifndef __PACKED
+#define __PACKED                __attribute__((packed, aligned(1)))
+#endif
+#ifndef __PACKED_STRUCT
+#define __PACKED_STRUCT         struct __attribute__((packed, aligned(1)))
+#endif
+#ifndef __PACKED_UNION
+#define __PACKED_UNION          union __attribute__((packed, aligned(1)))
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#endif
+#ifndef __RESTRICT
+#define __RESTRICT              __restrict
+#endif
+#ifndef __UNALIGNED_UINT32
+#define __UNALIGNED_UINT32(x)   (*(uint32_t *)(x))
+#endif
+#ifndef __COMPILER_BARRIER
+#define __COMPILER_BARRIER()    __asm volatile("" ::: "memory")
+#endif
+
+/**************************************   PUBLIC MACROS   ****************************************/
+/* Core intrinsics. Interrupts don't exist on the host, so masking them is a no-op */
+__STATIC_INLINE void __NOP(void) {}
+__STATIC_INLINE void __WFI(void) {}
+__STATIC_INLINE void __WFE(void) {}
+__STATIC_INLINE void __SEV(void) {}
+__STATIC_INLINE void __ISB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __DSB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __DMB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __enable_irq(void) {}
+__STATIC_INLINE void __disable_irq(void) {}
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return 0; }
+__STATIC_INLINE void __set_PRIMASK(uint32_t u32Mask) { (void)u32Mask; }
+__STATIC_INLINE uint32_t __get_BASEPRI(void) { return 0; }
+__STATIC_INLINE void __set_BASEPRI(uint32_t u32Priority) { (void)u32Priority; }
+__STATIC_INLINE uint32_t __get_IPSR(void) { return 0; }
+__STATIC_INLINE uint32_t __get_CONTROL(void) { return 0; }
+__STATIC_INLINE uint32_t __get_MSP(void) { return 0; }
+__STATIC_INLINE uint32_t __get_PSP(void) { return 0; }
+__STATIC_INLINE uint32_t __get_FPSCR(void) { return 0; }
+__STATIC_INLINE void __set_FPSCR(uint32_t u32Fpscr) { (void)u32Fpscr; }
+__STATIC_INLINE uint32_t __REV(uint32_t u32Value) { return __builtin_bswap32(u32Value); }
+__STATIC_INLINE uint8_t __CLZ(uint32_t u32Value) { return u32Value?(uint8_t)__builtin_clz(u32Value):32U; }
+
+#endif /* _HOST_CMSIS_GCC_H_ */
@@ -13,11 +13,25 @@
 #include "AppMgr.h"
 #include "BLE_Service.h"
 #include "NVM_Service.h"
+#include "Audit_Service.h"
+#include "Pool.h"
+#include "Trace.h"
 
 /************************************   PRIVATE FUNCTIONS   **************************************/
 void vApplicationIdleHook( void )
 {
+    static TickType_t xLastHousekeeping = 0;
+    TickType_t xNow = xTaskGetTickCount();
 
+    /* Nothing else to run. NVM housekeeping is handed over to User Registration, on the
+       Application Manager's task, as the idle task's stack is too small for it and it would race
+       with tasks preempting the idle task. The idle task only runs once the Application Manager
+       has gone through its messages, so at most one request is ever pending */
+    if((xNow - xLastHousekeeping) >= pdMS_TO_TICKS(APP_USEREG_HOUSEKEEPING_PERIOD_MS))
+    {
+        xLastHousekeeping = xNow;
+        (void)AppMgr_enuDispatchEvent(AppMgr_NvmHousekeeping, NULL);
+    }
 }
 
 /**************************************   MAIN FUNCTION   ****************************************/
@@ -29,6 +43,12 @@ int main(void)
     /* Initialize buttons */
     bsp_init(BSP_INIT_BUTTONS, NULL);
 
+    /* Start cycle counter and clear event trace, when enabled */
+    vidTraceInit();
+
+    /* Initialize pools handing event-related data over between tasks */
+    (void)bPoolInit();
+
     /* Initialize application tasks */
     (void)AppMgr_enuInit();
 
@@ -38,6 +58,9 @@ int main(void)
     /* Initialize NVM middleware service */
     (void)enuNvm_Init();
 
+    /* Initialize Audit middleware service */
+    (void)enuAudit_Init();
+
     /* Start scheduler */
     vTaskStartScheduler();
 
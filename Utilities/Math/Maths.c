@@ -12,6 +12,14 @@
 #define S32_UPPER_BOUND 0x7FFFFFFF
 #define INVALID_RETURN  0xFFFFFFFF
 
+/************************************   PRIVATE VARIABLES   **************************************/
+/* CRC-32 of every nibble value, reflected 0x04C11DB7 polynomial */
+static const uint32_t u32Crc32Nibbles[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
 /************************************   PUBLIC FUNCTIONS   ***************************************/
 int32_t s32Power(uint8_t u8Base, uint8_t u8Exponent)
 {
@@ -48,4 +56,19 @@ uint8_t u8DigitCount(uint32_t u32Integer)
     }
 
     return u8RetVal;
+}
+
+uint32_t u32Crc32(void const *pvData, uint32_t u32Size)
+{
+    uint8_t const *pu8Data = (uint8_t const *)pvData;
+    uint32_t u32Crc = 0xFFFFFFFF;
+
+    /* Reflected, low nibble first */
+    for(uint32_t u32Index = 0; pu8Data && (u32Index < u32Size); u32Index++)
+    {
+        u32Crc = u32Crc32Nibbles[(u32Crc ^ pu8Data[u32Index]) & 0x0F] ^ (u32Crc >> 4);
+        u32Crc = u32Crc32Nibbles[(u32Crc ^ (pu8Data[u32Index] >> 4)) & 0x0F] ^ (u32Crc >> 4);
+    }
+
+    return ~u32Crc;
 }
\ No newline at end of file
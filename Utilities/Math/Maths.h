@@ -39,4 +39,16 @@ int32_t s32Power(uint8_t u8Base, uint8_t u8Exponent);
  */
 uint8_t u8DigitCount(uint32_t u32Integer);
 
+/**
+ * @brief u32Crc32 Computes the CRC-32 (IEEE 802.3, as used by zlib) of a block of data.
+ *
+ * @note Processes data 4 bits at a time through a 16-entry table, trading speed for flash space.
+ *
+ * @param pvData Pointer to data block.
+ * @param u32Size Data block size in bytes.
+ *
+ * @return uint32_t CRC-32 of the data block, 0 for an empty or missing block.
+ */
+uint32_t u32Crc32(void const *pvData, uint32_t u32Size);
+
 #endif /* _UTIL_MATH_H_ */
\ No newline at end of file
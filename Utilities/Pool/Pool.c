@@ -0,0 +1,89 @@
+/* -----------------------------   Pool utilities for nRF52832   ------------------------------- */
+/*  File      -  Fixed-size block pool utilities source file                                     */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/***************************************   INCLUDES   ********************************************/
+#include "Pool.h"
+#include "nrf_balloc.h"
+
+/************************************   PRIVATE MACROS   *****************************************/
+/* Check whether a block lies within a pool's memory */
+#define POOL_OWNS_BLOCK(pool, block)                                                             \
+(                                                                                                \
+    ((uint8_t *)(block) >= (uint8_t *)(pool)->p_memory_begin) &&                                 \
+    ((uint8_t *)(block) <  (uint8_t *)(pool)->p_memory_begin +                                   \
+                           ((pool)->block_size * ((pool)->p_stack_limit - (pool)->p_stack_base)))  \
+)
+
+/************************************   PRIVATE VARIABLES   **************************************/
+NRF_BALLOC_DEF(PoolSmallBlocks, UTIL_POOL_SMALL_BLOCK_SIZE, UTIL_POOL_SMALL_BLOCK_COUNT);
+NRF_BALLOC_DEF(PoolLargeBlocks, UTIL_POOL_LARGE_BLOCK_SIZE, UTIL_POOL_LARGE_BLOCK_COUNT);
+
+/* Pools, in size class order */
+static nrf_balloc_t const * const pstrPoolList[Pool_MaxClasses] =
+{
+    &PoolSmallBlocks,
+    &PoolLargeBlocks
+};
+
+/* Pools' block sizes, in size class order */
+static const uint16_t u16BlockSizeList[Pool_MaxClasses] =
+{
+    UTIL_POOL_SMALL_BLOCK_SIZE,
+    UTIL_POOL_LARGE_BLOCK_SIZE
+};
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+bool bPoolInit(void)
+{
+    bool bRetVal = true;
+
+    for(uint8_t u8Index = 0; u8Index < Pool_MaxClasses; u8Index++)
+    {
+        bRetVal &= (NRF_SUCCESS == nrf_balloc_init(pstrPoolList[u8Index]));
+    }
+
+    return bRetVal;
+}
+
+void *pvPoolAlloc(uint16_t u16Size)
+{
+    void *pvRetVal = NULL;
+
+    /* Size classes are sorted by block size, the first one fitting is the smallest */
+    for(uint8_t u8Index = 0; u8Index < Pool_MaxClasses; u8Index++)
+    {
+        if(u16Size <= u16BlockSizeList[u8Index])
+        {
+            pvRetVal = nrf_balloc_alloc(pstrPoolList[u8Index]);
+            break;
+        }
+    }
+
+    return pvRetVal;
+}
+
+void vidPoolFree(void *pvBlock)
+{
+    /* Make sure valid arguments are passed */
+    if(pvBlock)
+    {
+        /* Pools' memory areas don't overlap, the one holding the block is the one it came from */
+        for(uint8_t u8Index = 0; u8Index < Pool_MaxClasses; u8Index++)
+        {
+            if(POOL_OWNS_BLOCK(pstrPoolList[u8Index], pvBlock))
+            {
+                nrf_balloc_free(pstrPoolList[u8Index], pvBlock);
+                break;
+            }
+        }
+    }
+}
+
+uint8_t u8PoolGetHighWater(Pool_tenuClass enuClass)
+{
+    return (enuClass < Pool_MaxClasses)?nrf_balloc_max_utilization_get(pstrPoolList[enuClass]):0;
+}
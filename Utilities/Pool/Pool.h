@@ -0,0 +1,74 @@
+/* -----------------------------   Pool utilities for nRF52832   ------------------------------- */
+/*  File      -  Fixed-size block pool utilities header file                                     */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+#ifndef _UTIL_POOL_H_
+#define _UTIL_POOL_H_
+
+/******************************************   INCLUDES   *****************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "system_config.h"
+
+/***************************************   PUBLIC TYPES   ****************************************/
+/**
+ * Pool_tenuClass Enumeration of the pools' block size classes.
+*/
+typedef enum
+{
+    Pool_SmallBlocks = 0, /* Blocks of UTIL_POOL_SMALL_BLOCK_SIZE bytes */
+    Pool_LargeBlocks,     /* Blocks of UTIL_POOL_LARGE_BLOCK_SIZE bytes */
+    Pool_MaxClasses       /* Max number of size classes                 */
+}Pool_tenuClass;
+
+/*************************************   PUBLIC FUNCTIONS   **************************************/
+/**
+ * @brief bPoolInit Initializes all block pools.
+ *
+ * @note Pools hold the data events carry from one task to another. Blocks are taken from and
+ *       given back to statically allocated pools in constant time, within a critical region, so
+ *       they can be used from any context including Softdevice event handlers.
+ *
+ * @pre This function must be invoked before any task or Softdevice handler allocates a block.
+ *
+ * @return bool true if all pools were initialized, false otherwise.
+ */
+bool bPoolInit(void);
+
+/**
+ * @brief pvPoolAlloc Allocates a block from the smallest size class fitting a given size.
+ *
+ * @note A size class running dry doesn't fall back on a larger one, so that large payloads always
+ *       find room regardless of how many small ones are pending.
+ *
+ * @param u16Size Number of bytes needed.
+ *
+ * @return void* Pointer to the block, word aligned, NULL if no block fits or none is left.
+ */
+void *pvPoolAlloc(uint16_t u16Size);
+
+/**
+ * @brief vidPoolFree Gives a block back to the pool it was allocated from.
+ *
+ * @param pvBlock Pointer to the block, as returned by pvPoolAlloc. NULL is ignored.
+ *
+ * @return Nothing.
+ */
+void vidPoolFree(void *pvBlock);
+
+/**
+ * @brief u8PoolGetHighWater Gets the highest number of blocks a size class had in use at once.
+ *
+ * @note A high-water mark equal to the size class' block count means allocations were turned
+ *       down at least once since boot.
+ *
+ * @param enuClass Size class.
+ *
+ * @return uint8_t Highest number of blocks in use since boot, 0 for invalid size classes.
+ */
+uint8_t u8PoolGetHighWater(Pool_tenuClass enuClass);
+
+#endif /* _UTIL_POOL_H_ */
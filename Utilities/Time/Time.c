@@ -97,4 +97,11 @@ uint32_t u32TimeToEpoch(exact_time_256_t *pstrTime)
     }
 
     return u32RetVal;
-}
\ No newline at end of file
+}
+
+uint32_t u32TimeLocalDayStart(uint32_t u32Epoch)
+{
+    /* Time zones are configured as hours ahead of UTC modulo a day, which is all it takes to
+       compute the time elapsed since local midnight */
+    return u32Epoch - ((u32Epoch + (UTIL_UTC_TIME_ZONE * SECS_IN_HOUR)) % DAY_SECONDS_COUNT);
+}
@@ -30,4 +30,16 @@
  */
 uint32_t u32TimeToEpoch(exact_time_256_t *pstrTime);
 
+/**
+ * @brief u32TimeLocalDayStart Computes the Unix timestamp of the local midnight preceding a given
+ *        Unix timestamp.
+ *
+ * @note Local time is UTC shifted by the time zone configured in system_config.h.
+ *
+ * @param u32Epoch Unix timestamp.
+ *
+ * @return uint32_t Unix timestamp of the start of the local day the given timestamp falls in.
+ */
+uint32_t u32TimeLocalDayStart(uint32_t u32Epoch);
+
 #endif /* _UTIL_TIME_H_ */
\ No newline at end of file
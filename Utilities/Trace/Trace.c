@@ -0,0 +1,88 @@
+/* -----------------------------   Trace utilities for nRF52832   ------------------------------ */
+/*  File      -  Cycle-stamped event trace utilities source file                                 */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+/***************************************   INCLUDES   ********************************************/
+#include <string.h>
+#include "Trace.h"
+#include "nrf_atomic.h"
+#include "app_util.h"
+
+#if UTIL_TRACE_HOST_CLOCK
+#include <time.h>
+#else
+#include "nrf.h"
+#endif
+
+/************************************   PRIVATE MACROS   *****************************************/
+/* Ring size must be a power of 2 for slots to follow on from one another when the count wraps */
+#define TRACE_SIZE_IS_POWER_OF_2 ((UTIL_TRACE_SIZE & (UTIL_TRACE_SIZE - 1)) == 0)
+
+#if UTIL_TRACE_ENABLED
+STATIC_ASSERT(TRACE_SIZE_IS_POWER_OF_2);
+
+/************************************   PRIVATE VARIABLES   **************************************/
+Trace_tstrRing strTraceRing; /* Not static, the debugger dumps it by name */
+
+/************************************   PRIVATE FUNCTIONS   **************************************/
+static uint32_t u32TraceGetCycles(void)
+{
+#if UTIL_TRACE_HOST_CLOCK
+    struct timespec strNow;
+
+    /* Host builds have no cycle counter. Derive cycles from the host's monotonic clock */
+    (void)clock_gettime(CLOCK_MONOTONIC, &strNow);
+
+    return (uint32_t)(((uint64_t)strNow.tv_sec * UTIL_TRACE_CLOCK_HZ) +
+                      (((uint64_t)strNow.tv_nsec * UTIL_TRACE_CLOCK_HZ) / 1000000000ULL));
+#else
+    return DWT->CYCCNT;
+#endif
+}
+#endif
+
+/************************************   PUBLIC FUNCTIONS   ***************************************/
+void vidTraceInit(void)
+{
+#if UTIL_TRACE_ENABLED
+#if !UTIL_TRACE_HOST_CLOCK
+    /* Cycle counter only runs with trace enabled, which the debugger doesn't do when detached */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    memset(&strTraceRing, 0, sizeof(strTraceRing));
+    strTraceRing.u32ClockHz = UTIL_TRACE_CLOCK_HZ;
+    strTraceRing.u32Magic = TRACE_RING_MAGIC;
+#endif
+}
+
+void vidTraceRecord(uint8_t u8Point, uint32_t u32Arg)
+{
+#if UTIL_TRACE_ENABLED
+    /* Stamp first, the time taken to find a slot isn't part of the hop */
+    uint32_t u32Cycles = u32TraceGetCycles();
+    uint32_t u32Slot = nrf_atomic_u32_fetch_add((nrf_atomic_u32_t *)&strTraceRing.u32Count, 1);
+    Trace_tstrEntry *pstrEntry = &strTraceRing.strEntries[u32Slot & (UTIL_TRACE_SIZE - 1)];
+
+    pstrEntry->u32Cycles = u32Cycles;
+    pstrEntry->u32Arg = u32Arg;
+    pstrEntry->u8Point = u8Point;
+#else
+    (void)u8Point;
+    (void)u32Arg;
+#endif
+}
+
+Trace_tstrRing const *pstrTraceGetRing(void)
+{
+#if UTIL_TRACE_ENABLED
+    return &strTraceRing;
+#else
+    return NULL;
+#endif
+}
@@ -0,0 +1,122 @@
+/* -----------------------------   Trace utilities for nRF52832   ------------------------------ */
+/*  File      -  Cycle-stamped event trace utilities header file                                 */
+/*  target    -  nRF52832                                                                        */
+/*  toolchain -  IAR                                                                             */
+/*  created   -  October, 2026                                                                   */
+/* --------------------------------------------------------------------------------------------- */
+
+#ifndef _UTIL_TRACE_H_
+#define _UTIL_TRACE_H_
+
+/******************************************   INCLUDES   *****************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "system_config.h"
+
+/****************************************   PUBLIC DEFINES   *************************************/
+#define TRACE_RING_MAGIC 0x45435254UL /* "TRCE", marks a valid trace ring in a memory dump */
+
+/****************************************   PUBLIC MACROS   **************************************/
+/* Record a trace point. Expands to nothing unless tracing is enabled, so trace points cost
+   neither time nor RAM in regular builds */
+#if UTIL_TRACE_ENABLED
+#define TRACE_POINT(point, arg) vidTraceRecord((point), (uint32_t)(arg))
+#else
+#define TRACE_POINT(point, arg)
+#endif
+
+/***************************************   PUBLIC TYPES   ****************************************/
+/**
+ * Trace_tenuPoint Enumeration of the different trace points, in the order an input usually goes
+ *                 through them.
+*/
+typedef enum
+{
+    Trace_SdEventIrq = 0,      /* Softdevice event interrupt, no argument                    */
+    Trace_BleEvent,            /* BLE stack event handled, argument is its event Id          */
+    Trace_AppMgrDispatch,      /* Event dispatched, argument is its AppMgr_tenuEvents        */
+    Trace_AttributionProcess,  /* Key Attribution message handled, argument is trigger       */
+    Trace_RegistrationProcess, /* User Registration message handled, argument is trigger     */
+    Trace_DisplayProcess,      /* Display message handled, argument is trigger               */
+    Trace_NvmCall,             /* NVM call entered, argument is its Trace_tenuNvmCall        */
+    Trace_NvmReturn,           /* NVM call returned, argument is its Trace_tenuNvmCall       */
+    Trace_BleNotify,           /* Notification handed over, argument is its Ble_tenuServices */
+    Trace_MaxPoints            /* Max number of trace points                                 */
+}Trace_tenuPoint;
+
+/**
+ * Trace_tenuNvmCall Enumeration of the NVM calls traced on entry and on return.
+*/
+typedef enum
+{
+    Trace_NvmFindUser = 0,  /* enuNVM_FindUser                                 */
+    Trace_NvmReadRecord,    /* enuNVM_ReadRecord and enuNVM_ReadSignedInRecord */
+    Trace_NvmOpenView,      /* enuNVM_OpenView                                 */
+    Trace_NvmRequestAdd,    /* u16NVM_RequestAdd                               */
+    Trace_NvmRequestUpdate, /* u16NVM_RequestUpdate                            */
+    Trace_NvmDeferUpdate,   /* enuNVM_DeferRecordUpdate                        */
+    Trace_NvmCountUse,      /* enuNVM_CountUse                                 */
+    Trace_NvmRequestDelete, /* u16NVM_RequestDelete                            */
+    Trace_NvmMaxCalls       /* Max number of traced NVM calls                  */
+}Trace_tenuNvmCall;
+
+/**
+ * Trace_tstrEntry Trace ring entry.
+*/
+typedef struct
+{
+    uint32_t u32Cycles; /* Cycle counter when point was reached, wraps around */
+    uint32_t u32Arg;    /* Point-specific argument                            */
+    uint8_t u8Point;    /* Trace point, as a Trace_tenuPoint                  */
+}Trace_tstrEntry;
+
+/**
+ * Trace_tstrRing Trace ring, laid out the way it is dumped.
+*/
+typedef struct
+{
+    uint32_t u32Magic;                           /* TRACE_RING_MAGIC once initialized           */
+    uint32_t u32ClockHz;                         /* Cycle counter frequency                     */
+    volatile uint32_t u32Count;                  /* Points recorded since boot, wraps around    */
+    Trace_tstrEntry strEntries[UTIL_TRACE_SIZE]; /* Latest entries, at u32Count modulo the size */
+}Trace_tstrRing;
+
+/*************************************   PUBLIC FUNCTIONS   **************************************/
+/**
+ * @brief vidTraceInit Starts the cycle counter and clears the trace ring.
+ *
+ * @note Does nothing unless UTIL_TRACE_ENABLED is set.
+ *
+ * @pre This function must be invoked before the scheduler is started and before any interrupt
+ *      with a trace point is enabled.
+ *
+ * @return Nothing.
+ */
+void vidTraceInit(void);
+
+/**
+ * @brief vidTraceRecord Records a trace point along with the cycle counter.
+ *
+ * @note Slots are taken with an atomic increment, without masking interrupts, so trace points
+ *       can be placed in interrupt handlers and tasks alike. The oldest entries are overwritten
+ *       once the ring is full. Trace points should go through TRACE_POINT rather than calling
+ *       this function directly.
+ *
+ * @param u8Point Trace point, as a Trace_tenuPoint.
+ * @param u32Arg Point-specific argument.
+ *
+ * @return Nothing.
+ */
+void vidTraceRecord(uint8_t u8Point, uint32_t u32Arg);
+
+/**
+ * @brief pstrTraceGetRing Gets the trace ring, to be dumped as is and decoded off target.
+ *
+ * @note On target, the ring is dumped by the debugger through the strTraceRing symbol, see
+ *       Project/Host/Trace_Dump.gdb.
+ *
+ * @return Trace_tstrRing const* Pointer to the trace ring, NULL unless tracing is enabled.
+ */
+Trace_tstrRing const *pstrTraceGetRing(void);
+
+#endif /* _UTIL_TRACE_H_ */